@@ -10,6 +10,51 @@
  *      recebida. Útil para redirecionar todos os domínios
  *      acessados por um cliente para um IP específico,
  *      como em portais cativos.
+ *
+ *      Uma tabela de nomes (hash do nome em formato wire minúsculo,
+ *      com entradas curinga "*.dominio") define o endereço de nomes
+ *      como `alarme.lan` ou os nomes que não devem ser sequestrados
+ *      (NXDOMAIN). Os demais nomes seguem o fallback configurável, que
+ *      por padrão responde o IP local.
+ *
+ *      Com o Pico W também conectado como estação, os nomes marcados
+ *      para repasse (DNS_ACTION_FORWARD) vão ao servidor DNS da rede:
+ *      o ID é trocado e guardado numa tabela de pendentes até a resposta
+ *      ou o timeout, e as respostas ficam num cache LRU de tamanho fixo
+ *      que respeita e desconta os TTLs.
+ *
+ *      Consultas com EDNS(0) podem receber respostas UDP de até o
+ *      payload anunciado (limitado a DNS_EDNS_PAYLOAD_MAX), com OPT na
+ *      resposta. Respostas que não cabem em UDP levam TC; a mesma lógica de
+ *      resposta atende também DNS over TCP na porta 53, com várias
+ *      consultas por conexão.
+ *
+ *      Cada IP tem um limite de consultas UDP por janela deslizante
+ *      (RRL), verificado antes de qualquer análise. Acima dele as
+ *      consultas são descartadas, e uma a cada DNS_RRL_SLIP recebe uma
+ *      resposta truncada.
+ *
+ *      Uma lista de domínios bloqueados (`blocklist.h`), lida da flash,
+ *      responde NXDOMAIN para rastreadores e atualizações que
+ *      desperdiçariam o Wi-Fi compartilhado.
+ *
+ *      Cada consulta é contada num count-min sketch sobre o hash do
+ *      QNAME, com um heap dos DNS_TOP_MAX nomes mais consultados
+ *      (`dns_server_top`): memória fixa, qualquer que seja o número de
+ *      nomes distintos.
+ *
+ *      As mensagens são lidas e escritas com acesso sempre conferido
+ *      contra o tamanho (`dns_reader_t`/`dns_writer_t`). Nomes
+ *      comprimidos são aceitos, uma consulta pode ter até
+ *      DNS_QUESTIONS_MAX perguntas, e o nome de cada registro da
+ *      resposta é um ponteiro para a sua pergunta.
+ *
+ *      Só consultas do tipo A recebem endereço. Os demais tipos (AAAA,
+ *      HTTPS, PTR...) recebem NOERROR sem dados com um SOA de cache
+ *      negativo, para o cliente não repetir a pergunta.
+ *
+ *      A resposta é escrita sobre a própria consulta, no pbuf recebido,
+ *      e esse mesmo pbuf é enviado de volta.
  */
 
 #include <stdio.h>
@@ -17,9 +62,14 @@
 #include <errno.h>
 #include <assert.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "dnsserver.h"
 #include "lwip/udp.h"
+#include "lwip/tcp.h"
+#include "lwip/pbuf.h"
+#include "lwip/mem.h"
+#include "lwip/dns.h"
 
 #define PORT_DNS_SERVER 53
 #define DUMP_DATA 0
@@ -36,7 +86,57 @@ typedef struct dns_header_t_ {
     uint16_t additional_record_count;
 } dns_header_t;
 
-#define MAX_DNS_MSG_SIZE 300
+#define DNS_NAME_MAX 255        // Nome em formato wire descomprimido, com o 0 final
+#define DNS_SOA_RDATA_SIZE 22   // MNAME e RNAME raiz + 5 campos de 32 bits
+#define DNS_OPT_RR_SIZE 11      // Nome raiz + tipo, tamanho UDP, TTL e tamanho (sem opções)
+
+#define DNS_ANSWER_TTL 60       // Validade da resposta A (s)
+#define DNS_NEGATIVE_TTL 300    // Validade das respostas sem dados (s), via SOA
+
+#define DNS_TYPE_A 1
+#define DNS_TYPE_SOA 6
+#define DNS_TYPE_OPT 41
+#define DNS_TYPE_ANY 255
+#define DNS_CLASS_IN 1
+#define DNS_CLASS_ANY 255
+
+#define DNS_RCODE_NOERROR 0
+#define DNS_RCODE_SERVFAIL 2
+#define DNS_RCODE_NXDOMAIN 3
+#define DNS_RCODE_NOTIMP 4
+#define DNS_RCODE_REFUSED 5
+#define DNS_RCODE_BADVERS 16    // Estendido: 4 bits no cabeçalho + 8 bits no OPT
+
+#define DNS_FLAG_TC (0x1 << 9)
+
+// Leitor de mensagem: todo acesso é conferido contra o tamanho
+typedef struct {
+    const uint8_t *msg;
+    size_t len;
+    size_t off;
+    bool error;                 // Leitura além do fim ou nome inválido (persistente)
+} dns_reader_t;
+
+// Escritor de mensagem sobre um buffer fixo
+typedef struct {
+    uint8_t *msg;
+    size_t cap;
+    size_t off;
+    bool overflow;              // Escrita além de `cap` (persistente); nada é escrito
+} dns_writer_t;
+
+// Primeira pergunta de uma consulta, extraída por `dns_build_reply`
+typedef struct {
+    uint16_t qtype;
+    uint16_t qclass;
+    uint32_t hash;              // `dns_name_hash` do QNAME
+    size_t end;                 // Fim da seção de perguntas na mensagem
+    bool forward;               // Deve ir ao upstream
+    bool edns;                  // A consulta trouxe OPT (EDNS(0))
+    size_t opt_off;             // Início do OPT na consulta (se `edns`)
+    uint16_t udp_payload;       // Payload UDP anunciado no OPT
+    uint8_t edns_version;
+} dns_question_t;
 
 /**
  * [Descrição]: Cria um novo socket UDP e registra o callback.
@@ -104,73 +204,999 @@ static void dump_bytes(const uint8_t *bptr, uint32_t len) {
 }
 #endif
 
+// Acesso big endian byte a byte: o payload do pbuf não tem alinhamento garantido
+static uint16_t dns_get16(const uint8_t *p) {
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static void dns_put16(uint8_t *p, uint16_t v) {
+    p[0] = v >> 8;
+    p[1] = v & 0xff;
+}
+
+static uint32_t dns_get32(const uint8_t *p) {
+    return (uint32_t)dns_get16(p) << 16 | dns_get16(p + 2);
+}
+
+static uint8_t *dns_put32(uint8_t *p, uint32_t v) {
+    dns_put16(p, v >> 16);
+    dns_put16(p + 2, v & 0xffff);
+    return p + 4;
+}
+
 /**
- * [Descrição]: Envia uma mensagem DNS para o endereço e porta indicados.
+ * [Descrição]: Confere se ainda há `n` bytes a ler.
  * [Parâmetros]: 
- *  - struct udp_pcb **udp: ponteiro para o socket UDP;
- *  - const void *buf: buffer de dados a ser enviado;
- *  - size_t len: tamanho do buffer;
- *  - const ip_addr_t *dest: endereço IP de destino;
- *  - uint16_t port: porta de destino;
- * [Notas]: Retorna o número de bytes enviados ou erro.
+ *  - dns_reader_t *r: leitor;
+ *  - size_t n: bytes pedidos;
+ * [Notas]: Sem espaço, marca o erro (persistente) e retorna false.
  */
-static int dns_socket_sendto(struct udp_pcb **udp, const void *buf, size_t len, const ip_addr_t *dest, uint16_t port) {
-    if (len > 0xffff) {
-        len = 0xffff;
+static bool dns_read_ok(dns_reader_t *r, size_t n) {
+    if (r->error || n > r->len - r->off) {
+        r->error = true;
+        return false;
     }
+    return true;
+}
 
-    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
-    if (p == NULL) {
-        ERROR_printf("DNS: Failed to send message out of memory\n");
-        return -ENOMEM;
+static uint16_t dns_read16(dns_reader_t *r) {
+    if (!dns_read_ok(r, 2)) {
+        return 0;
     }
+    uint16_t v = dns_get16(r->msg + r->off);
+    r->off += 2;
+    return v;
+}
 
-    memcpy(p->payload, buf, len);
-    err_t err = udp_sendto(*udp, p, dest, port);
+static uint32_t dns_read32(dns_reader_t *r) {
+    if (!dns_read_ok(r, 4)) {
+        return 0;
+    }
+    uint32_t v = dns_get32(r->msg + r->off);
+    r->off += 4;
+    return v;
+}
 
-    pbuf_free(p);
+static void dns_read_skip(dns_reader_t *r, size_t n) {
+    if (dns_read_ok(r, n)) {
+        r->off += n;
+    }
+}
 
-    if (err != ERR_OK) {
-        ERROR_printf("DNS: Failed to send message %d\n", err);
-        return err;
+/**
+ * [Descrição]: Lê um nome, seguindo ponteiros de compressão.
+ * [Parâmetros]: 
+ *  - dns_reader_t *r: leitor, posicionado no nome; avança até depois dele;
+ *  - uint8_t *name: recebe o nome descomprimido (DNS_NAME_MAX bytes), ou NULL para só pular;
+ * [Notas]: 
+ *  - Retorna o tamanho do nome descomprimido (com o 0 final), ou 0 em erro.
+ *  - Um ponteiro deve apontar para antes do trecho em que está, e depois
+ *    do cabeçalho, e o trecho apontado deve terminar antes do ponteiro:
+ *    cada salto volta na mensagem, então não há laços, e o nome nunca
+ *    usa bytes depois dele (que uma resposta pode descartar).
+ *  - Rótulos maiores que 63, tipos de rótulo reservados e nomes maiores
+ *    que DNS_NAME_MAX são erros.
+ */
+static size_t dns_read_name(dns_reader_t *r, uint8_t *name) {
+    if (r->error) {
+        return 0;
     }
+    size_t pos = r->off;
+    size_t segment = r->off;    // Início do trecho atual: limite dos ponteiros
+    size_t limit = r->len;      // Fim do trecho atual: o último ponteiro seguido
+    size_t name_len = 0;
+    bool jumped = false;
 
-#if DUMP_DATA
-    dump_bytes(buf, len);
-#endif
+    for (;;) {
+        if (pos >= limit) {
+            break;
+        }
+        uint8_t label = r->msg[pos];
+        if ((label & 0xc0) == 0xc0) {
+            if (pos + 1 >= limit) {
+                break;
+            }
+            size_t target = (size_t)(label & 0x3f) << 8 | r->msg[pos + 1];
+            if (target >= segment || target < sizeof(dns_header_t)) {
+                break;
+            }
+            if (!jumped) {
+                r->off = pos + 2;
+                jumped = true;
+            }
+            limit = pos;
+            segment = pos = target;
+            continue;
+        }
+        if (label > 63 || name_len + label + 1 > DNS_NAME_MAX || label + 1 > limit - pos) {
+            break;
+        }
+        if (name) {
+            memcpy(name + name_len, r->msg + pos, label + 1);
+        }
+        name_len += label + 1;
+        pos += label + 1;
+        if (label == 0) {
+            if (!jumped) {
+                r->off = pos;
+            }
+            return name_len;
+        }
+    }
+    r->error = true;
+    return 0;
+}
+
+/**
+ * [Descrição]: Confere se ainda cabem `n` bytes.
+ * [Parâmetros]: 
+ *  - dns_writer_t *w: escritor;
+ *  - size_t n: bytes a escrever;
+ * [Notas]: Sem espaço, marca o estouro (persistente) e retorna false.
+ */
+static bool dns_write_ok(dns_writer_t *w, size_t n) {
+    if (w->overflow || n > w->cap - w->off) {
+        w->overflow = true;
+        return false;
+    }
+    return true;
+}
+
+static void dns_write8(dns_writer_t *w, uint8_t v) {
+    if (dns_write_ok(w, 1)) {
+        w->msg[w->off++] = v;
+    }
+}
+
+static void dns_write16(dns_writer_t *w, uint16_t v) {
+    if (dns_write_ok(w, 2)) {
+        dns_put16(w->msg + w->off, v);
+        w->off += 2;
+    }
+}
+
+static void dns_write32(dns_writer_t *w, uint32_t v) {
+    if (dns_write_ok(w, 4)) {
+        dns_put32(w->msg + w->off, v);
+        w->off += 4;
+    }
+}
+
+static void dns_write_bytes(dns_writer_t *w, const void *data, size_t n) {
+    if (dns_write_ok(w, n)) {
+        memcpy(w->msg + w->off, data, n);
+        w->off += n;
+    }
+}
+
+/**
+ * [Descrição]: Escreve o cabeçalho de um registro de resposta.
+ * [Parâmetros]: 
+ *  - dns_writer_t *w: escritor;
+ *  - uint16_t name_offset: posição do nome na mensagem, escrito como ponteiro de compressão;
+ *  - uint16_t type: tipo do registro;
+ *  - uint32_t ttl: validade em segundos;
+ *  - uint16_t rdlength: tamanho dos dados que o chamador escreve em seguida;
+ * [Notas]: O nome do registro ocupa sempre 2 bytes, qualquer que seja a pergunta.
+ */
+static void dns_write_rr_header(dns_writer_t *w, uint16_t name_offset, uint16_t type, uint32_t ttl, uint16_t rdlength) {
+    dns_write16(w, 0xc000 | name_offset); // pointer
+    dns_write16(w, type);
+    dns_write16(w, DNS_CLASS_IN);
+    dns_write32(w, ttl);
+    dns_write16(w, rdlength);
+}
+
+/**
+ * [Descrição]: Escreve o SOA de cache negativo (NXDOMAIN e NODATA).
+ * [Parâmetros]: 
+ *  - dns_writer_t *w: escritor;
+ *  - uint16_t name_offset: posição do nome na mensagem;
+ * [Notas]: Nenhuma.
+ */
+static void dns_write_soa(dns_writer_t *w, uint16_t name_offset) {
+    static const uint32_t soa_times[] = { 1, DNS_NEGATIVE_TTL, DNS_NEGATIVE_TTL, DNS_NEGATIVE_TTL, DNS_NEGATIVE_TTL };
+    dns_write_rr_header(w, name_offset, DNS_TYPE_SOA, DNS_NEGATIVE_TTL, DNS_SOA_RDATA_SIZE);
+    dns_write8(w, 0); // MNAME = root
+    dns_write8(w, 0); // RNAME = root
+    for (size_t i = 0; i < sizeof(soa_times) / sizeof(soa_times[0]); i++) {
+        dns_write32(w, soa_times[i]); // serial, refresh, retry, expire, minimum
+    }
+}
+
+// Minúscula ASCII; bytes de tamanho de rótulo (<= 63) não são afetados
+static uint8_t dns_fold(uint8_t c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+/**
+ * [Descrição]: Calcula o hash (FNV-1a) de um nome em formato wire, sem distinguir maiúsculas.
+ * [Parâmetros]: 
+ *  - const uint8_t *name: nome em formato wire;
+ *  - size_t len: tamanho, com o 0 final;
+ * [Notas]: Nenhuma.
+ */
+static uint32_t dns_name_hash(const uint8_t *name, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ dns_fold(name[i])) * 16777619u;
+    }
+    return h;
+}
+
+/**
+ * [Descrição]: Procura uma entrada da tabela de nomes.
+ * [Parâmetros]: 
+ *  - const dns_server_t *d: servidor;
+ *  - const uint8_t *name: nome em formato wire (qualquer caixa);
+ *  - size_t len: tamanho, com o 0 final;
+ *  - bool wildcard: procura entradas curinga em vez de exatas;
+ * [Notas]: Um hash e, em média, uma comparação por busca.
+ */
+static const dns_host_t *dns_host_find(const dns_server_t *d, const uint8_t *name, size_t len, bool wildcard) {
+    uint32_t h = dns_name_hash(name, len);
+    for (int i = d->buckets[h & (DNS_HOSTS_BUCKETS - 1)]; i >= 0; i = d->hosts[i].next) {
+        const dns_host_t *host = &d->hosts[i];
+        if (host->hash != h || host->name_len != len || host->wildcard != wildcard) {
+            continue;
+        }
+        size_t j = 0;
+        while (j < len && dns_fold(name[j]) == host->name[j]) {
+            j++;
+        }
+        if (j == len) {
+            return host;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * [Descrição]: Resolve um nome da consulta pela tabela de nomes.
+ * [Parâmetros]: 
+ *  - const dns_server_t *d: servidor;
+ *  - const uint8_t *name: QNAME em formato wire, já validado;
+ *  - size_t len: tamanho, com o 0 final;
+ * [Notas]: 
+ *  - Tenta o nome exato; depois as entradas curinga dos sufixos, do mais
+ *    longo ao mais curto ("*.lan" vale para "a.lan" e "b.a.lan").
+ *  - Retorna NULL se nada casar (vale o fallback).
+ */
+static const dns_host_t *dns_host_lookup(const dns_server_t *d, const uint8_t *name, size_t len) {
+    const dns_host_t *host = dns_host_find(d, name, len, false);
+    while (!host && len > 1) {
+        size_t label = name[0] + 1;
+        name += label;
+        len -= label;
+        host = dns_host_find(d, name, len, true);
+    }
+    return host;
+}
+
+/**
+ * [Descrição]: Converte um nome em texto para formato wire minúsculo.
+ * [Parâmetros]: 
+ *  - const char *text: nome (ex: "alarme.lan", "*.lan");
+ *  - uint8_t *wire: destino, com DNS_HOST_NAME_MAX bytes;
+ *  - bool *wildcard: recebe se o nome começa com "*.";
+ * [Notas]: Retorna o tamanho em formato wire, ou 0 se o nome for inválido.
+ */
+static size_t dns_name_from_text(const char *text, uint8_t *wire, bool *wildcard) {
+    *wildcard = text[0] == '*' && text[1] == '.';
+    if (*wildcard) {
+        text += 2;
+    }
+    size_t len = 0;
+    while (*text) {
+        const char *dot = strchr(text, '.');
+        size_t label = dot ? (size_t)(dot - text) : strlen(text);
+        if (label == 0 || label > 63 || len + 1 + label + 1 > DNS_HOST_NAME_MAX) {
+            return 0;
+        }
+        wire[len++] = label;
+        for (size_t i = 0; i < label; i++) {
+            wire[len++] = dns_fold(text[i]);
+        }
+        text += label + (dot ? 1 : 0);
+    }
+    wire[len++] = 0;
     return len;
 }
 
 /**
- * [Descrição]: Callback que processa mensagens DNS recebidas e envia uma resposta.
+ * [Descrição]: Procura no cache a resposta para a pergunta.
+ * [Parâmetros]: 
+ *  - dns_server_t *d: servidor;
+ *  - const uint8_t *msg: consulta;
+ *  - const dns_question_t *q: pergunta da consulta;
+ *  - uint32_t now_ms: instante atual;
+ * [Notas]: Entradas vencidas são liberadas ao serem encontradas.
+ */
+static dns_cache_entry_t *dns_cache_find(dns_server_t *d, const uint8_t *msg, const dns_question_t *q, uint32_t now_ms) {
+    for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+        dns_cache_entry_t *e = &d->cache[i];
+        if (e->qhash != q->hash || e->qtype != q->qtype || e->qclass != q->qclass
+            || e->question_end != q->end) {
+            continue;
+        }
+        size_t j = sizeof(dns_header_t);
+        while (j < q->end - 4 && dns_fold(msg[j]) == dns_fold(e->msg[j])) {
+            j++;
+        }
+        if (j < q->end - 4) {
+            continue;
+        }
+        if ((int32_t)(now_ms - e->expires_ms) >= 0) {
+            e->qhash = 0;
+            return NULL;
+        }
+        return e;
+    }
+    return NULL;
+}
+
+/**
+ * [Descrição]: Responde a consulta com uma resposta do cache, escrita sobre ela.
+ * [Parâmetros]: 
+ *  - dns_server_t *d: servidor;
+ *  - uint8_t *msg: consulta, reescrita com a resposta;
+ *  - size_t cap: bytes disponíveis em `msg`;
+ *  - const dns_question_t *q: pergunta da consulta;
+ * [Notas]: 
+ *  - Mantém o ID e a pergunta do cliente (inclusive a caixa das letras)
+ *    e desconta dos TTLs o tempo que a resposta passou no cache.
+ *  - Se a resposta passar de `cap`, devolve só a pergunta com TC.
+ *  - Retorna o tamanho da resposta, ou 0 se não houver entrada válida.
+ */
+static size_t dns_cache_reply(dns_server_t *d, uint8_t *msg, size_t cap, const dns_question_t *q) {
+    uint32_t now_ms = sys_now();
+    dns_cache_entry_t *e = dns_cache_find(d, msg, q, now_ms);
+    if (!e) {
+        return 0;
+    }
+    e->last_used = ++d->cache_clock;
+
+    memcpy(msg + 2, e->msg + 2, sizeof(dns_header_t) - 2);
+    if (e->len > cap) {
+        // Não cabe: só a pergunta, com TC, e o cliente repete via TCP
+        dns_put16(msg + offsetof(dns_header_t, flags), dns_get16(e->msg + offsetof(dns_header_t, flags)) | DNS_FLAG_TC);
+        memset(msg + offsetof(dns_header_t, answer_record_count), 0, 6);
+        return q->end;
+    }
+    memcpy(msg + e->question_end, e->msg + e->question_end, e->len - e->question_end);
+    uint32_t elapsed_s = (now_ms - e->stored_ms) / 1000;
+    for (int i = 0; i < e->ttl_count; i++) {
+        uint8_t *ttl = msg + e->ttl_offset[i];
+        dns_put32(ttl, dns_get32(e->msg + e->ttl_offset[i]) - elapsed_s);
+    }
+    return e->len;
+}
+
+/**
+ * [Descrição]: Guarda no cache uma resposta do upstream.
+ * [Parâmetros]: 
+ *  - dns_server_t *d: servidor;
+ *  - const uint8_t *msg: resposta completa;
+ *  - size_t len: tamanho da resposta;
+ *  - const dns_pending_t *pending: consulta que ela responde;
+ *  - size_t question_end: fim da pergunta na resposta;
+ * [Notas]: 
+ *  - Só guarda NOERROR e NXDOMAIN não truncados com ao menos um registro;
+ *    a validade é o menor TTL (limitado a DNS_CACHE_MAX_TTL).
+ *  - O OPT (EDNS) do upstream, que deve ser o último registro, não é
+ *    guardado; a resposta do cache leva o OPT do próprio servidor.
+ *  - Guarda só até o fim do último registro: bytes a mais na resposta
+ *    não chegam aos clientes atendidos pelo cache.
+ *  - Substitui uma entrada livre ou vencida, senão a usada há mais tempo.
+ */
+static void dns_cache_store(dns_server_t *d, const uint8_t *msg, size_t len, const dns_pending_t *pending, size_t question_end) {
+    uint16_t flags = dns_get16(msg + offsetof(dns_header_t, flags));
+    uint16_t rcode = flags & 0xf;
+    if (len > DNS_CACHE_MSG_MAX || (flags & DNS_FLAG_TC) || (rcode != DNS_RCODE_NOERROR && rcode != DNS_RCODE_NXDOMAIN)) {
+        return;
+    }
+
+    uint16_t ttl_offset[DNS_CACHE_RRS];
+    uint8_t ttl_count = 0;
+    bool opt_removed = false;
+    size_t opt_start = 0;
+    uint32_t min_ttl = DNS_CACHE_MAX_TTL;
+    unsigned records = dns_get16(msg + offsetof(dns_header_t, answer_record_count))
+                     + dns_get16(msg + offsetof(dns_header_t, authority_record_count))
+                     + dns_get16(msg + offsetof(dns_header_t, additional_record_count));
+    dns_reader_t r = { .msg = msg, .len = len, .off = question_end };
+    for (unsigned i = 0; i < records && !r.error; i++) {
+        size_t name = r.off;
+        dns_read_name(&r, NULL);
+        size_t rr = r.off;
+        uint16_t type = dns_read16(&r);
+        dns_read16(&r); // class
+        uint32_t ttl = dns_read32(&r);
+        dns_read_skip(&r, dns_read16(&r));
+        if (r.error) {
+            return;
+        }
+        if (type == DNS_TYPE_OPT) {
+            // O OPT é do salto upstream: sai do cache, e cada cliente recebe o seu
+            if (i != records - 1 || rr != name + 1) {
+                return;
+            }
+            opt_start = name;
+            opt_removed = true;
+        } else {
+            if (ttl_count == DNS_CACHE_RRS) {
+                return;
+            }
+            ttl_offset[ttl_count++] = rr + 4;
+            if (ttl < min_ttl) {
+                min_ttl = ttl;
+            }
+        }
+    }
+    if (r.error || ttl_count == 0 || min_ttl == 0) {
+        return;
+    }
+    // Bytes depois do último registro não são guardados
+    len = opt_removed ? opt_start : r.off;
+
+    uint32_t now_ms = sys_now();
+    dns_cache_entry_t *slot = &d->cache[0];
+    for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+        dns_cache_entry_t *e = &d->cache[i];
+        if (e->qhash == 0 || (int32_t)(now_ms - e->expires_ms) >= 0) {
+            slot = e;
+            break;
+        }
+        if (e->last_used < slot->last_used) {
+            slot = e;
+        }
+    }
+
+    slot->qhash = pending->qhash;
+    slot->qtype = pending->qtype;
+    slot->qclass = pending->qclass;
+    slot->stored_ms = now_ms;
+    slot->expires_ms = now_ms + min_ttl * 1000;
+    slot->last_used = ++d->cache_clock;
+    slot->len = len;
+    slot->question_end = question_end;
+    slot->ttl_count = ttl_count;
+    memcpy(slot->ttl_offset, ttl_offset, ttl_count * sizeof(ttl_offset[0]));
+    memcpy(slot->msg, msg, len);
+    if (opt_removed) {
+        uint8_t *arcount = slot->msg + offsetof(dns_header_t, additional_record_count);
+        dns_put16(arcount, dns_get16(arcount) - 1);
+    }
+}
+
+/**
+ * [Descrição]: Repassa a consulta ao upstream, no próprio pbuf recebido.
+ * [Parâmetros]: 
+ *  - dns_server_t *d: servidor;
+ *  - struct pbuf *p: consulta do cliente (não é liberado aqui);
+ *  - const dns_question_t *q: pergunta da consulta;
+ *  - dns_tcp_conn_t *tcp: conexão do cliente via TCP, ou NULL para UDP;
+ *  - const ip_addr_t *client: endereço do cliente;
+ *  - u16_t client_port: porta do cliente;
+ * [Notas]: 
+ *  - O repasse é sempre via UDP, inclusive para clientes TCP, cuja
+ *    consulta leva um OPT próprio (`dns_tcp_forward_query`); o que foi
+ *    acrescentado por ele sai da resposta (`strip_opt`).
+ *  - O ID é trocado por um aleatório, para respostas forjadas não
+ *    acertarem o ID escolhido pelo cliente, e restaurado na volta.
+ *  - Retorna false se a tabela de pendentes estiver cheia ou o envio falhar.
+ */
+static bool dns_forward(dns_server_t *d, struct pbuf *p, const dns_question_t *q, dns_tcp_conn_t *tcp,
+                        const ip_addr_t *client, u16_t client_port) {
+    dns_pending_t *pending = NULL;
+    for (int i = 0; i < DNS_PENDING_MAX && !pending; i++) {
+        if (!d->pending[i].used) {
+            pending = &d->pending[i];
+        }
+    }
+    if (!pending) {
+        return false;
+    }
+
+    uint8_t *msg = p->payload;
+    uint16_t upstream_id;
+    bool taken;
+    do {
+        upstream_id = (uint16_t)LWIP_RAND();
+        taken = false;
+        for (int i = 0; i < DNS_PENDING_MAX; i++) {
+            taken |= d->pending[i].used && d->pending[i].upstream_id == upstream_id;
+        }
+    } while (taken);
+
+    pending->client_id = dns_get16(msg);
+    pending->upstream_id = upstream_id;
+    pending->tcp = tcp;
+    pending->strip_opt = tcp && !q->edns;
+    ip_addr_copy(pending->client, *client);
+    pending->client_port = client_port;
+    pending->qhash = q->hash;
+    pending->qtype = q->qtype;
+    pending->qclass = q->qclass;
+    pending->deadline_ms = sys_now() + DNS_FORWARD_TIMEOUT_MS;
+
+    dns_put16(msg, upstream_id);
+    err_t err = udp_sendto(d->upstream_udp, p, &d->upstream, PORT_DNS_SERVER);
+    if (err != ERR_OK) {
+        ERROR_printf("DNS: Failed to forward query %d\n", err);
+        dns_put16(msg, pending->client_id);
+        return false;
+    }
+    pending->used = true;
+    return true;
+}
+
+// Mensagem DNS over TCP em montagem, depois dos 2 bytes do prefixo de tamanho
+// (o lwIP atende um callback por vez)
+static uint8_t dns_tcp_frame[2 + DNS_TCP_MSG_MAX];
+static uint8_t *const dns_tcp_msg = dns_tcp_frame + 2;
+
+static err_t dns_tcp_close(dns_tcp_conn_t *c, bool abort);
+
+/**
+ * [Descrição]: Diz se uma mensagem e o seu prefixo cabem na fila de envio.
+ * [Parâmetros]: 
+ *  - struct tcp_pcb *pcb: conexão;
+ *  - size_t len: tamanho da mensagem;
+ * [Notas]: Confere os bytes (`tcp_sndbuf`) e os segmentos (TCP_SND_QUEUELEN): faltando qualquer um, o tcp_write falha.
+ */
+static bool dns_tcp_writable(struct tcp_pcb *pcb, size_t len) {
+    return tcp_sndbuf(pcb) >= len + 2
+        && tcp_sndqueuelen(pcb) + (len + 2 + TCP_MSS - 1) / TCP_MSS <= TCP_SND_QUEUELEN;
+}
+
+/**
+ * [Descrição]: Envia uma mensagem por uma conexão DNS over TCP.
+ * [Parâmetros]: 
+ *  - dns_tcp_conn_t *c: conexão;
+ *  - uint8_t *frame: 2 bytes livres para o prefixo de tamanho, seguidos da mensagem;
+ *  - size_t len: tamanho da mensagem;
+ * [Notas]: 
+ *  - Prefixo e mensagem vão num único tcp_write, que enfileira tudo ou
+ *    nada: um prefixo nunca fica na fila sem a mensagem inteira.
+ *  - Sem espaço de envio a conexão é abortada, já que o cliente ficaria
+ *    esperando uma resposta perdida, e retorna false.
+ */
+static bool dns_tcp_send(dns_tcp_conn_t *c, uint8_t *frame, size_t len) {
+    dns_put16(frame, len);
+    if (!dns_tcp_writable(c->pcb, len) || tcp_write(c->pcb, frame, len + 2, TCP_WRITE_FLAG_COPY) != ERR_OK) {
+        ERROR_printf("DNS: TCP send queue full, aborting connection\n");
+        dns_tcp_close(c, true);
+        return false;
+    }
+    tcp_output(c->pcb);
+    return true;
+}
+
+/**
+ * [Descrição]: Envia ao cliente uma resposta SERVFAIL só com o cabeçalho.
+ * [Parâmetros]: 
+ *  - dns_server_t *d: servidor;
+ *  - uint16_t id: ID da consulta do cliente;
+ *  - dns_tcp_conn_t *tcp: conexão do cliente via TCP, ou NULL para UDP;
+ *  - const ip_addr_t *client: endereço do cliente;
+ *  - u16_t client_port: porta do cliente;
+ * [Notas]: 
+ *  - O cliente desiste na hora em vez de esperar o próprio timeout.
+ *  - Retorna false se a conexão TCP foi abortada (`dns_tcp_send`).
+ */
+static bool dns_send_servfail(dns_server_t *d, uint16_t id, dns_tcp_conn_t *tcp, const ip_addr_t *client, u16_t client_port) {
+    uint8_t frame[2 + sizeof(dns_header_t)] = { 0 };
+    uint8_t *msg = frame + 2;
+    dns_put16(msg, id);
+    dns_put16(msg + offsetof(dns_header_t, flags), 0x1 << 15 | 0x1 << 8 | 0x1 << 7 | DNS_RCODE_SERVFAIL);
+    if (tcp) {
+        return dns_tcp_send(tcp, frame, sizeof(dns_header_t));
+    }
+
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, sizeof(dns_header_t), PBUF_RAM);
+    if (p == NULL) {
+        return true;
+    }
+    memcpy(p->payload, msg, sizeof(dns_header_t));
+    udp_sendto(d->udp, p, client, client_port);
+    pbuf_free(p);
+    return true;
+}
+
+/**
+ * [Descrição]: Retira o OPT (EDNS) do fim de uma resposta.
+ * [Parâmetros]: 
+ *  - uint8_t *msg: resposta;
+ *  - size_t len: tamanho da resposta;
+ *  - size_t question_end: fim da pergunta na resposta;
+ * [Notas]: 
+ *  - Só um OPT na raiz como último registro, como em `dns_cache_store`;
+ *    fora disso a resposta fica como está.
+ *  - Retorna o novo tamanho.
+ */
+static size_t dns_strip_opt(uint8_t *msg, size_t len, size_t question_end) {
+    unsigned records = dns_get16(msg + offsetof(dns_header_t, answer_record_count))
+                     + dns_get16(msg + offsetof(dns_header_t, authority_record_count))
+                     + dns_get16(msg + offsetof(dns_header_t, additional_record_count));
+    dns_reader_t r = { .msg = msg, .len = len, .off = question_end };
+    size_t last = question_end;
+    uint16_t type = 0;
+    for (unsigned i = 0; i < records && !r.error; i++) {
+        last = r.off;
+        dns_read_name(&r, NULL);
+        type = dns_read16(&r);
+        dns_read_skip(&r, 6); // class (tamanho UDP no OPT) e TTL
+        dns_read_skip(&r, dns_read16(&r));
+    }
+    uint8_t *arcount = msg + offsetof(dns_header_t, additional_record_count);
+    if (r.error || type != DNS_TYPE_OPT || msg[last] != 0 || dns_get16(arcount) == 0) {
+        return len;
+    }
+    dns_put16(arcount, dns_get16(arcount) - 1);
+    return last;
+}
+
+/**
+ * [Descrição]: Envia um pbuf (resposta do upstream) por uma conexão DNS over TCP.
+ * [Parâmetros]: 
+ *  - dns_tcp_conn_t *c: conexão;
+ *  - const struct pbuf *p: mensagem, possivelmente encadeada, já com o ID do cliente;
+ *  - size_t question_end: fim da pergunta na resposta;
+ *  - bool strip_opt: retirar o OPT, acrescentado pelo repasse;
+ * [Notas]: 
+ *  - A mensagem é copiada para `dns_tcp_frame`, atrás do prefixo, e
+ *    segue num único tcp_write (`dns_tcp_send`).
+ *  - Respostas maiores que DNS_TCP_MSG_MAX viram SERVFAIL, assim como
+ *    as truncadas (TC): o cliente já está no TCP e não tem para onde
+ *    repetir a consulta.
+ */
+static void dns_tcp_send_pbuf(dns_tcp_conn_t *c, const struct pbuf *p, size_t question_end, bool strip_opt) {
+    uint16_t flags = (uint16_t)(pbuf_get_at(p, 2) << 8 | pbuf_get_at(p, 3));
+    if (p->tot_len > DNS_TCP_MSG_MAX || (flags & DNS_FLAG_TC)) {
+        dns_send_servfail(c->server, (uint16_t)(pbuf_get_at(p, 0) << 8 | pbuf_get_at(p, 1)), c, NULL, 0);
+        return;
+    }
+    pbuf_copy_partial(p, dns_tcp_msg, p->tot_len, 0);
+    size_t len = strip_opt ? dns_strip_opt(dns_tcp_msg, p->tot_len, question_end) : p->tot_len;
+    dns_tcp_send(c, dns_tcp_frame, len);
+}
+
+/**
+ * [Descrição]: Callback das respostas do upstream.
  * [Parâmetros]: 
  *  - void *arg: ponteiro para `dns_server_t`;
- *  - struct udp_pcb *upcb: ponteiro para socket UDP;
- *  - struct pbuf *p: buffer com os dados recebidos;
- *  - const ip_addr_t *src_addr: endereço IP do remetente;
- *  - u16_t src_port: porta de origem do remetente;
- * [Notas]: Responde com o IP local a todas as requisições DNS válidas.
+ *  - struct udp_pcb *upcb: socket do upstream;
+ *  - struct pbuf *p: resposta recebida;
+ *  - const ip_addr_t *src_addr: remetente;
+ *  - u16_t src_port: porta do remetente;
+ * [Notas]: 
+ *  - Só aceita respostas (QR) do upstream, com ID pendente e a mesma
+ *    pergunta (nome, tipo e classe) da consulta repassada.
+ *  - Restaura o ID do cliente e devolve o próprio pbuf pela porta 53;
+ *    clientes TCP recebem uma cópia com o prefixo de tamanho (ou
+ *    SERVFAIL, se o upstream truncou mesmo assim).
  */
-static void dns_server_process(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_t *src_addr, u16_t src_port) {
+static void dns_upstream_recv(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_t *src_addr, u16_t src_port) {
     dns_server_t *d = arg;
-    DEBUG_printf("dns_server_process %u\n", p->tot_len);
+    uint8_t buf[DNS_CACHE_MSG_MAX];
+    u16_t view_len = LWIP_MIN(p->tot_len, sizeof(buf));
+    const uint8_t *msg = pbuf_get_contiguous(p, buf, sizeof(buf), view_len, 0);
+
+    if (msg == NULL || view_len < sizeof(dns_header_t) || src_port != PORT_DNS_SERVER
+        || !ip_addr_cmp(src_addr, &d->upstream) || !(dns_get16(msg + offsetof(dns_header_t, flags)) & 0x1 << 15)
+        || dns_get16(msg + offsetof(dns_header_t, question_count)) != 1) {
+        pbuf_free(p);
+        return;
+    }
+
+    uint16_t upstream_id = dns_get16(msg);
+    uint8_t name[DNS_NAME_MAX];
+    dns_reader_t r = { .msg = msg, .len = view_len, .off = sizeof(dns_header_t) };
+    size_t name_len = dns_read_name(&r, name);
+    uint16_t qtype = dns_read16(&r);
+    uint16_t qclass = dns_read16(&r);
+    if (r.error) {
+        pbuf_free(p);
+        return;
+    }
+    uint32_t qhash = dns_name_hash(name, name_len);
+
+    for (int i = 0; i < DNS_PENDING_MAX; i++) {
+        dns_pending_t *pending = &d->pending[i];
+        if (!pending->used || pending->upstream_id != upstream_id || pending->qhash != qhash
+            || pending->qtype != qtype || pending->qclass != qclass) {
+            continue;
+        }
+        pending->used = false;
+        if (p->tot_len <= sizeof(buf)) {
+            dns_cache_store(d, msg, p->tot_len, pending, r.off);
+        }
+        pbuf_put_at(p, 0, pending->client_id >> 8);
+        pbuf_put_at(p, 1, pending->client_id & 0xff);
+        if (pending->tcp) {
+            dns_tcp_send_pbuf(pending->tcp, p, r.off, pending->strip_opt);
+        } else {
+            udp_sendto(d->udp, p, &pending->client, pending->client_port);
+        }
+        break;
+    }
+    pbuf_free(p);
+}
+
+/**
+ * [Descrição]: Procura o OPT (EDNS(0)) entre os registros que seguem a pergunta.
+ * [Parâmetros]: 
+ *  - const uint8_t *msg: consulta;
+ *  - size_t len: tamanho da consulta;
+ *  - dns_question_t *q: pergunta já lida; recebe `edns`, `udp_payload` e `edns_version`;
+ * [Notas]: Retorna false se os registros estiverem malformados ou houver mais de um OPT.
+ */
+static bool dns_parse_edns(const uint8_t *msg, size_t len, dns_question_t *q) {
+    unsigned records = dns_get16(msg + offsetof(dns_header_t, answer_record_count))
+                     + dns_get16(msg + offsetof(dns_header_t, authority_record_count))
+                     + dns_get16(msg + offsetof(dns_header_t, additional_record_count));
+    dns_reader_t r = { .msg = msg, .len = len, .off = q->end };
+    q->edns = false;
+    q->udp_payload = 0;
+    q->edns_version = 0;
+    for (unsigned i = 0; i < records && !r.error; i++) {
+        size_t name = r.off;
+        dns_read_name(&r, NULL);
+        bool root = r.off == name + 1;
+        uint16_t type = dns_read16(&r);
+        uint16_t udp_payload = dns_read16(&r);
+        uint32_t ttl = dns_read32(&r);
+        dns_read_skip(&r, dns_read16(&r));
+        if (type == DNS_TYPE_OPT && !r.error) {
+            if (q->edns || !root) {
+                return false;
+            }
+            q->edns = true;
+            q->opt_off = name;
+            q->udp_payload = udp_payload;
+            q->edns_version = ttl >> 16 & 0xff;
+        }
+    }
+    return !r.error;
+}
+
+/**
+ * [Descrição]: Escreve o OPT da resposta, anunciando DNS_EDNS_PAYLOAD_MAX.
+ * [Parâmetros]: 
+ *  - dns_writer_t *w: escritor, com DNS_OPT_RR_SIZE bytes livres;
+ *  - uint16_t rcode: RCODE completo; os 8 bits altos vão no OPT;
+ * [Notas]: Nenhuma.
+ */
+static void dns_write_opt(dns_writer_t *w, uint16_t rcode) {
+    dns_write8(w, 0); // root
+    dns_write16(w, DNS_TYPE_OPT);
+    dns_write16(w, DNS_EDNS_PAYLOAD_MAX);
+    dns_write32(w, (uint32_t)(rcode >> 4) << 24); // extended RCODE, version 0, no DO
+    dns_write16(w, 0);
+}
+
+/**
+ * [Descrição]: Monta a consulta de um cliente TCP a repassar ao upstream via UDP.
+ * [Parâmetros]: 
+ *  - const uint8_t *msg: consulta do cliente;
+ *  - size_t len: tamanho da consulta;
+ *  - const dns_question_t *q: pergunta, com o OPT já procurado (`dns_parse_edns`);
+ * [Notas]: 
+ *  - O OPT anuncia DNS_TCP_MSG_MAX: sem ele o upstream trunca em 512
+ *    bytes, e o TC não serve a um cliente que já está no TCP.
+ *  - O OPT do cliente tem o tamanho reescrito; sem OPT, um é acrescentado
+ *    ao fim (o último registro é sempre da seção adicional).
+ *  - Retorna NULL sem memória.
+ */
+static struct pbuf *dns_tcp_forward_query(const uint8_t *msg, size_t len, const dns_question_t *q) {
+    size_t opt_size = q->edns ? 0 : DNS_OPT_RR_SIZE;
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, len + opt_size, PBUF_RAM);
+    if (!p) {
+        return NULL;
+    }
+    uint8_t *out = p->payload;
+    memcpy(out, msg, len);
+    size_t opt = q->opt_off;
+    if (!q->edns) {
+        uint8_t *arcount = out + offsetof(dns_header_t, additional_record_count);
+        dns_put16(arcount, dns_get16(arcount) + 1);
+        dns_writer_t w = { .msg = out, .cap = len + opt_size, .off = len };
+        dns_write_opt(&w, 0);
+        opt = len;
+    }
+    dns_put16(out + opt + 3, DNS_TCP_MSG_MAX); // Depois do nome raiz e do tipo
+    return p;
+}
+
+/**
+ * [Descrição]: Divide pela metade as contagens do sketch e do top-K.
+ * [Parâmetros]: 
+ *  - dns_sketch_t *s: sketch;
+ * [Notas]: Mantém a ordem do heap; nomes que deixaram de ser consultados perdem peso.
+ */
+static void dns_sketch_halve(dns_sketch_t *s) {
+    for (int row = 0; row < DNS_SKETCH_DEPTH; row++) {
+        for (int i = 0; i < DNS_SKETCH_WIDTH; i++) {
+            s->rows[row][i] >>= 1;
+        }
+    }
+    for (int i = 0; i < s->top_count; i++) {
+        s->top[i].count >>= 1;
+    }
+}
+
+// Troca duas entradas do heap
+static void dns_top_swap(dns_top_entry_t *a, dns_top_entry_t *b) {
+    dns_top_entry_t t = *a;
+    *a = *b;
+    *b = t;
+}
+
+// Desce a entrada i do heap (mínimo na raiz) até a posição certa
+static void dns_top_sift_down(dns_sketch_t *s, int i) {
+    for (;;) {
+        int smallest = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < s->top_count && s->top[left].count < s->top[smallest].count) {
+            smallest = left;
+        }
+        if (right < s->top_count && s->top[right].count < s->top[smallest].count) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            return;
+        }
+        dns_top_swap(&s->top[i], &s->top[smallest]);
+        i = smallest;
+    }
+}
+
+// Sobe a entrada i do heap até a posição certa
+static void dns_top_sift_up(dns_sketch_t *s, int i) {
+    while (i > 0 && s->top[(i - 1) / 2].count > s->top[i].count) {
+        dns_top_swap(&s->top[i], &s->top[(i - 1) / 2]);
+        i = (i - 1) / 2;
+    }
+}
+
+/**
+ * [Descrição]: Conta uma consulta no count-min sketch e atualiza o top-K.
+ * [Parâmetros]: 
+ *  - dns_sketch_t *s: sketch;
+ *  - const uint8_t *name: QNAME em formato wire (qualquer caixa);
+ *  - size_t len: tamanho, com o 0 final;
+ *  - uint32_t hash: `dns_name_hash` do nome;
+ * [Notas]: 
+ *  - As DNS_SKETCH_DEPTH posições vêm do hash já calculado (hash duplo),
+ *    sem percorrer o nome de novo.
+ *  - Atualização conservadora: só os contadores no mínimo sobem, o que
+ *    reduz a superestimação por colisões.
+ *  - O top-K é um heap de mínimo: um nome novo só entra se sua estimativa
+ *    passar a do menos consultado. Nomes maiores que DNS_HOST_NAME_MAX
+ *    são contados mas não entram no top-K.
+ */
+static void dns_sketch_add(dns_sketch_t *s, const uint8_t *name, size_t len, uint32_t hash) {
+    uint32_t step = (hash >> 16 | hash << 16) | 1;
+    uint16_t *cells[DNS_SKETCH_DEPTH];
+    uint16_t min = UINT16_MAX;
+
+    s->queries++;
+    for (int row = 0; row < DNS_SKETCH_DEPTH; row++) {
+        cells[row] = &s->rows[row][(hash + row * step) & (DNS_SKETCH_WIDTH - 1)];
+        if (*cells[row] < min) {
+            min = *cells[row];
+        }
+    }
+    if (min == UINT16_MAX) {
+        dns_sketch_halve(s);
+        min >>= 1;
+    }
+    for (int row = 0; row < DNS_SKETCH_DEPTH; row++) {
+        if (*cells[row] == min) {
+            *cells[row] = min + 1;
+        }
+    }
+    uint16_t estimate = min + 1;
 
-    uint8_t dns_msg[MAX_DNS_MSG_SIZE];
-    dns_header_t *dns_hdr = (dns_header_t*)dns_msg;
+    for (int i = 0; i < s->top_count; i++) {
+        dns_top_entry_t *e = &s->top[i];
+        if (e->hash == hash && e->name_len == len) {
+            e->count = estimate;
+            dns_top_sift_down(s, i);
+            return;
+        }
+    }
+    if (len > DNS_HOST_NAME_MAX) {
+        return;
+    }
 
-    size_t msg_len = pbuf_copy_partial(p, dns_msg, sizeof(dns_msg), 0);
-    if (msg_len < sizeof(dns_header_t)) {
-        goto ignore_request;
+    int i;
+    if (s->top_count < DNS_TOP_MAX) {
+        i = s->top_count++;
+    } else if (estimate > s->top[0].count) {
+        i = 0;
+    } else {
+        return;
+    }
+    dns_top_entry_t *e = &s->top[i];
+    e->hash = hash;
+    e->count = estimate;
+    e->name_len = len;
+    for (size_t j = 0; j < len; j++) {
+        e->name[j] = dns_fold(name[j]);
+    }
+    if (i == 0) {
+        dns_top_sift_down(s, 0);
+    }
+    dns_top_sift_up(s, i);
+}
+
+/**
+ * [Descrição]: Decide o que responder para um nome.
+ * [Parâmetros]: 
+ *  - dns_server_t *d: servidor;
+ *  - const uint8_t *name: nome em formato wire descomprimido (qualquer caixa);
+ *  - size_t len: tamanho, com o 0 final;
+ *  - ip4_addr_t *addr: recebe o endereço, para DNS_ACTION_ADDRESS;
+ * [Notas]: 
+ *  - Nomes da tabela recebem a ação da entrada; os demais, o fallback.
+ *  - Domínios da lista de bloqueio recebem NXDOMAIN, salvo se a tabela
+ *    tiver o nome exato.
+ */
+static dns_action_t dns_resolve(dns_server_t *d, const uint8_t *name, size_t len, ip4_addr_t *addr) {
+    const dns_host_t *host = dns_host_lookup(d, name, len);
+    if ((!host || host->wildcard) && d->blocklist && blocklist_contains(d->blocklist, name, len)) {
+        d->blocked++;
+        return DNS_ACTION_NXDOMAIN;
+    }
+    if (host) {
+        ip4_addr_copy(*addr, host->addr);
+        return host->action;
+    }
+    ip4_addr_copy(*addr, *ip_2_ip4(&d->ip));
+    return d->fallback;
+}
+
+/**
+ * [Descrição]: Monta a resposta sobre a própria consulta.
+ * [Parâmetros]: 
+ *  - dns_server_t *d: ponteiro para `dns_server_t`;
+ *  - uint8_t *msg: mensagem recebida, reescrita com a resposta;
+ *  - size_t len: tamanho da consulta;
+ *  - size_t cap: bytes disponíveis em `msg`;
+ *  - bool udp: aplica o limite de tamanho do UDP;
+ *  - dns_question_t *q: recebe a primeira pergunta da consulta;
+ * [Notas]: 
+ *  - Retorna o tamanho da resposta, ou 0 se a consulta deve ser ignorada.
+ *  - Aceita até DNS_QUESTIONS_MAX perguntas, com nomes comprimidos; a
+ *    seção de perguntas é devolvida como veio e cada registro aponta
+ *    (ponteiro de 2 bytes) para o nome da sua pergunta. O RCODE é o da
+ *    primeira pergunta.
+ *  - Em UDP, o limite é DNS_UDP_MSG_MAX, ou o payload anunciado no OPT do
+ *    cliente até DNS_EDNS_PAYLOAD_MAX. Registros que não cabem ficam de
+ *    fora e a resposta leva TC, para o cliente repetir via TCP.
+ *  - Consultas com OPT recebem OPT na resposta.
+ *  - Retorna 0 com `q->forward` se a consulta deve ir ao upstream (não
+ *    havia resposta no cache). Só consultas de uma pergunta são
+ *    repassadas; com mais de uma, nomes de repasse dão NOTIMP.
+ *  - Não depende do transporte: só lê e escreve `msg`.
+ */
+static size_t dns_build_reply(dns_server_t *d, uint8_t *msg, size_t len, size_t cap, bool udp, dns_question_t *q) {
+    q->forward = false;
+    if (len < sizeof(dns_header_t)) {
+        return 0;
     }
 
 #if DUMP_DATA
-    dump_bytes(dns_msg, msg_len);
+    dump_bytes(msg, len);
 #endif
 
-    uint16_t flags = lwip_ntohs(dns_hdr->flags);
-    uint16_t question_count = lwip_ntohs(dns_hdr->question_count);
+    uint16_t flags = dns_get16(msg + offsetof(dns_header_t, flags));
+    uint16_t question_count = dns_get16(msg + offsetof(dns_header_t, question_count));
 
-    DEBUG_printf("len %d\n", msg_len);
+    DEBUG_printf("len %d\n", len);
     DEBUG_printf("dns flags 0x%x\n", flags);
     DEBUG_printf("dns question count 0x%x\n", question_count);
 
@@ -182,100 +1208,549 @@ static void dns_server_process(void *arg, struct udp_pcb *upcb, struct pbuf *p,
     // Check QR indicates a query
     if (((flags >> 15) & 0x1) != 0) {
         DEBUG_printf("Ignoring non-query\n");
-        goto ignore_request;
+        return 0;
     }
 
     // Check for standard query
     if (((flags >> 11) & 0xf) != 0) {
         DEBUG_printf("Ignoring non-standard query\n");
-        goto ignore_request;
+        return 0;
     }
 
     // Check question count
-    if (question_count < 1) {
+    if (question_count < 1 || question_count > DNS_QUESTIONS_MAX) {
         DEBUG_printf("Invalid question count\n");
-        goto ignore_request;
+        return 0;
     }
 
-    // Print the question
-    DEBUG_printf("question: ");
-    const uint8_t *question_ptr_start = dns_msg + sizeof(dns_header_t);
-    const uint8_t *question_ptr_end = dns_msg + msg_len;
-    const uint8_t *question_ptr = question_ptr_start;
-    while(question_ptr < question_ptr_end) {
-        if (*question_ptr == 0) {
-            question_ptr++;
-            break;
-        } else {
-            if (question_ptr > question_ptr_start) {
-                DEBUG_printf(".");
-            }
-            int label_len = *question_ptr++;
-            if (label_len > 63) {
-                DEBUG_printf("Invalid label\n");
-                goto ignore_request;
-            }
-            DEBUG_printf("%.*s", label_len, question_ptr);
-            question_ptr += label_len;
+    // Read every question (names may be compressed) and decide its answer
+    // before anything is written over the message
+    struct {
+        uint16_t name_offset;
+        uint16_t qtype;
+        uint16_t qclass;
+        dns_action_t action;
+        ip4_addr_t addr;
+    } questions[DNS_QUESTIONS_MAX];
+    uint8_t name[DNS_NAME_MAX];
+    bool refused = false;
+    bool forward = false;
+    dns_reader_t r = { .msg = msg, .len = len, .off = sizeof(dns_header_t) };
+    for (uint16_t i = 0; i < question_count; i++) {
+        questions[i].name_offset = r.off;
+        size_t name_len = dns_read_name(&r, name);
+        questions[i].qtype = dns_read16(&r);
+        questions[i].qclass = dns_read16(&r);
+        if (r.error) {
+            DEBUG_printf("Malformed question\n");
+            return 0;
+        }
+        DEBUG_printf("qtype %u qclass %u\n", questions[i].qtype, questions[i].qclass);
+
+        uint32_t hash = dns_name_hash(name, name_len);
+        dns_sketch_add(&d->sketch, name, name_len, hash);
+        questions[i].action = dns_resolve(d, name, name_len, &questions[i].addr);
+        refused |= questions[i].qclass != DNS_CLASS_IN && questions[i].qclass != DNS_CLASS_ANY;
+        forward |= questions[i].action == DNS_ACTION_FORWARD;
+        if (i == 0) {
+            q->qtype = questions[i].qtype;
+            q->qclass = questions[i].qclass;
+            q->hash = hash;
         }
     }
-    DEBUG_printf("\n");
+    q->end = r.off;
 
-    // Check question length
-    if (question_ptr - question_ptr_start > 255) {
-        DEBUG_printf("Invalid question length\n");
-        goto ignore_request;
+    // EDNS(0): the client's UDP payload size raises the limit, and its OPT is answered with ours
+    if (!dns_parse_edns(msg, len, q)) {
+        DEBUG_printf("Malformed records\n");
+        return 0;
     }
+    if (udp) {
+        size_t limit = DNS_UDP_MSG_MAX;
+        if (q->edns && q->udp_payload > limit) {
+            limit = LWIP_MIN(q->udp_payload, DNS_EDNS_PAYLOAD_MAX);
+        }
+        cap = LWIP_MIN(cap, limit);
+    }
+    size_t opt_size = q->edns ? DNS_OPT_RR_SIZE : 0;
+    if (q->end + opt_size > cap) {
+        return 0;
+    }
+    dns_writer_t w = { .msg = msg, .cap = cap - opt_size, .off = q->end };
 
-    // Skip QNAME and QTYPE
-    question_ptr += 4;
+    // Forwarded names are answered from the cache or sent upstream; with
+    // no upstream (AP only) they fall back to our address
+    bool upstream = !ip_addr_isany(&d->upstream);
+    if (forward && upstream && question_count == 1 && q->edns_version == 0) {
+        size_t reply_len = dns_cache_reply(d, msg, w.cap, q);
+        q->forward = reply_len == 0;
+        if (reply_len > 0 && q->edns) {
+            uint8_t *arcount = msg + offsetof(dns_header_t, additional_record_count);
+            dns_put16(arcount, dns_get16(arcount) + 1);
+            w.off = reply_len;
+            w.cap = cap;
+            dns_write_opt(&w, 0);
+            reply_len = w.off;
+        }
+        return reply_len;
+    }
+    for (uint16_t i = 0; i < question_count && !upstream; i++) {
+        if (questions[i].action == DNS_ACTION_FORWARD) {
+            questions[i].action = DNS_ACTION_ADDRESS;
+            ip4_addr_copy(questions[i].addr, *ip_2_ip4(&d->ip));
+        }
+    }
 
-    // Generate answer
-    uint8_t *answer_ptr = dns_msg + (question_ptr - dns_msg);
-    *answer_ptr++ = 0xc0; // pointer
-    *answer_ptr++ = question_ptr_start - dns_msg; // pointer to question
-    
-    *answer_ptr++ = 0;
-    *answer_ptr++ = 1; // host address
+    // The answers go right after the questions, dropping anything that followed them
+    uint16_t rcode = DNS_RCODE_NOERROR;
+    uint16_t answers = 0;
+    uint16_t authorities = 0;
+    uint16_t truncated = 0;
 
-    *answer_ptr++ = 0;
-    *answer_ptr++ = 1; // Internet class
+    if (q->edns && q->edns_version != 0) {
+        rcode = DNS_RCODE_BADVERS;
+    } else if (refused) {
+        rcode = DNS_RCODE_REFUSED;
+    } else if (forward && upstream) {
+        rcode = DNS_RCODE_NOTIMP;
+    } else {
+        if (questions[0].action == DNS_ACTION_NXDOMAIN) {
+            rcode = DNS_RCODE_NXDOMAIN;
+        }
 
-    *answer_ptr++ = 0;
-    *answer_ptr++ = 0;
-    *answer_ptr++ = 0;
-    *answer_ptr++ = 60; // ttl 60s
+        // Answer section first: an A record for each address question
+        for (uint16_t i = 0; i < question_count && !truncated; i++) {
+            if (questions[i].action != DNS_ACTION_ADDRESS
+                || (questions[i].qtype != DNS_TYPE_A && questions[i].qtype != DNS_TYPE_ANY)) {
+                continue;
+            }
+            size_t mark = w.off;
+            dns_write_rr_header(&w, questions[i].name_offset, DNS_TYPE_A, DNS_ANSWER_TTL, 4);
+            dns_write_bytes(&w, &questions[i].addr.addr, 4);
+            if (w.overflow) {
+                w.off = mark;
+                truncated = DNS_FLAG_TC;
+            } else {
+                answers++;
+            }
+        }
 
-    *answer_ptr++ = 0;
-    *answer_ptr++ = 4; // length
-    memcpy(answer_ptr, &d->ip.addr, 4); // use our address
-    answer_ptr += 4;
+        // Then NXDOMAIN, or NODATA (the name exists but has no record of
+        // this type). The SOA lets the client cache the negative answer
+        // instead of retrying.
+        for (uint16_t i = 0; i < question_count && !truncated; i++) {
+            if (questions[i].action == DNS_ACTION_ADDRESS
+                && (questions[i].qtype == DNS_TYPE_A || questions[i].qtype == DNS_TYPE_ANY)) {
+                continue;
+            }
+            size_t mark = w.off;
+            dns_write_soa(&w, questions[i].name_offset);
+            if (w.overflow) {
+                w.off = mark;
+                truncated = DNS_FLAG_TC;
+            } else {
+                authorities++;
+            }
+        }
+    }
 
-    dns_hdr->flags = lwip_htons(
+    dns_put16(msg + offsetof(dns_header_t, flags),
                 0x1 << 15 | // QR = response
                 0x1 << 10 | // AA = authoritative
-                0x1 << 7);   // RA = authenticated
-    dns_hdr->question_count = lwip_htons(1);
-    dns_hdr->answer_record_count = lwip_htons(1);
-    dns_hdr->authority_record_count = 0;
-    dns_hdr->additional_record_count = 0;
+                truncated | // TC = the records did not fit
+                (flags & 0x1 << 8) | // RD copied from the query
+                0x1 << 7 |  // RA = recursion available
+                (rcode & 0xf));
+    dns_put16(msg + offsetof(dns_header_t, answer_record_count), answers);
+    dns_put16(msg + offsetof(dns_header_t, authority_record_count), authorities);
+    dns_put16(msg + offsetof(dns_header_t, additional_record_count), q->edns ? 1 : 0);
+    if (q->edns) {
+        w.overflow = false;
+        w.cap = cap;
+        dns_write_opt(&w, rcode);
+    }
+
+    return w.off;
+}
 
-    // Send the reply
-    DEBUG_printf("Sending %d byte reply to %s:%d\n", answer_ptr - dns_msg, ipaddr_ntoa(src_addr), src_port);
-    dns_socket_sendto(&d->udp, &dns_msg, answer_ptr - dns_msg, src_addr, src_port);
+/**
+ * [Descrição]: Aplica o limite de consultas por cliente (RRL).
+ * [Parâmetros]: 
+ *  - dns_server_t *d: servidor;
+ *  - const ip_addr_t *src: endereço do cliente;
+ *  - uint32_t now_ms: instante atual;
+ *  - bool *slip: recebe, se recusada, se a consulta deve receber TC;
+ * [Notas]: 
+ *  - Tabela de mapeamento direto pelo hash do IP: sem busca nem alocação.
+ *    Um IP que colide com outro reinicia a entrada.
+ *  - A taxa é a contagem da janela atual mais a da anterior, ponderada
+ *    pelo quanto dela ainda cabe na janela deslizante.
+ *  - Acima do limite, 1 a cada DNS_RRL_SLIP consultas recebe uma resposta
+ *    truncada: um cliente legítimo repete via TCP, um falsificado não
+ *    ganha amplificação.
+ */
+static bool dns_rrl_allow(dns_server_t *d, const ip_addr_t *src, uint32_t now_ms, bool *slip) {
+    uint32_t key = ip4_addr_get_u32(ip_2_ip4(src));
+    dns_rrl_entry_t *e = &d->rrl[((key * 2654435761u) >> 24) & (DNS_RRL_CLIENTS - 1)];
+    *slip = false;
+
+    uint32_t elapsed = now_ms - e->window_start;
+    if (e->ip != key || elapsed >= 2 * DNS_RRL_WINDOW_MS) {
+        e->ip = key;
+        e->window_start = now_ms;
+        e->count = 0;
+        e->prev = 0;
+        elapsed = 0;
+    } else if (elapsed >= DNS_RRL_WINDOW_MS) {
+        e->prev = e->count;
+        e->count = 0;
+        e->window_start += DNS_RRL_WINDOW_MS;
+        elapsed -= DNS_RRL_WINDOW_MS;
+    }
+
+    uint32_t rate = e->prev * (DNS_RRL_WINDOW_MS - elapsed) / DNS_RRL_WINDOW_MS + e->count;
+    if (rate < DNS_RRL_LIMIT) {
+        e->count++;
+        return true;
+    }
+    if (DNS_RRL_SLIP > 0 && ++e->slip >= DNS_RRL_SLIP) {
+        e->slip = 0;
+        *slip = true;
+    }
+    return false;
+}
+
+/**
+ * [Descrição]: Transforma a consulta numa resposta vazia com TC.
+ * [Parâmetros]: 
+ *  - uint8_t *msg: consulta, reescrita;
+ *  - size_t len: tamanho da consulta;
+ * [Notas]: Retorna o tamanho da resposta (cabeçalho e perguntas), ou 0 se a consulta for inválida.
+ */
+static size_t dns_truncated_reply(uint8_t *msg, size_t len) {
+    if (len < sizeof(dns_header_t) || (dns_get16(msg + offsetof(dns_header_t, flags)) & 0xf800) != 0) {
+        return 0;
+    }
+    uint16_t question_count = dns_get16(msg + offsetof(dns_header_t, question_count));
+    dns_reader_t r = { .msg = msg, .len = len, .off = sizeof(dns_header_t) };
+    for (uint16_t i = 0; i < question_count; i++) {
+        dns_read_name(&r, NULL);
+        dns_read_skip(&r, 4);
+    }
+    if (question_count < 1 || question_count > DNS_QUESTIONS_MAX || r.error) {
+        return 0;
+    }
+    uint16_t flags = dns_get16(msg + offsetof(dns_header_t, flags));
+    dns_put16(msg + offsetof(dns_header_t, flags), 0x1 << 15 | DNS_FLAG_TC | (flags & 0x1 << 8) | 0x1 << 7);
+    memset(msg + offsetof(dns_header_t, answer_record_count), 0, 6);
+    return r.off;
+}
+
+/**
+ * [Descrição]: Retorna quantos bytes cabem a partir do payload do pbuf recebido.
+ * [Parâmetros]: 
+ *  - const struct pbuf *p: pbuf recebido;
+ * [Notas]: 
+ *  - Um pbuf único da pool tem o buffer inteiro (PBUF_POOL_BUFSIZE) além
+ *    dos dados recebidos; é o caso normal do driver Wi-Fi.
+ *  - Pbufs encadeados retornam 0 (a mensagem não é contígua).
+ */
+static size_t dns_pbuf_capacity(const struct pbuf *p) {
+    if (p->next != NULL) {
+        return 0;
+    }
+    if (pbuf_get_allocsrc(p) == PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL) {
+        const uint8_t *end = (const uint8_t *)p + LWIP_MEM_ALIGN_SIZE(sizeof(struct pbuf))
+                           + LWIP_MEM_ALIGN_SIZE(PBUF_POOL_BUFSIZE);
+        return end - (const uint8_t *)p->payload;
+    }
+    return p->len;
+}
+
+/**
+ * [Descrição]: Callback que processa mensagens DNS recebidas e envia uma resposta.
+ * [Parâmetros]: 
+ *  - void *arg: ponteiro para `dns_server_t`;
+ *  - struct udp_pcb *upcb: ponteiro para socket UDP;
+ *  - struct pbuf *p: buffer com os dados recebidos;
+ *  - const ip_addr_t *src_addr: endereço IP do remetente;
+ *  - u16_t src_port: porta de origem do remetente;
+ * [Notas]: 
+ *  - Responde às consultas A válidas pela tabela de nomes ou pelo fallback.
+ *  - A resposta é montada no próprio pbuf recebido e enviado de volta,
+ *    sem alocar nem copiar. O `udp_sendto` usa o espaço de cabeçalho que
+ *    a recepção deixou livre à frente do payload.
+ *  - Sem espaço no pbuf recebido, copia a consulta para um pbuf novo.
+ *  - Consultas repassadas ao upstream também seguem no mesmo pbuf.
+ *  - O limite por cliente (`dns_rrl_allow`) vem antes de qualquer cópia
+ *    ou análise: uma consulta descartada não aloca nada, e a que recebe
+ *    TC só é copiada se não for contígua.
+ */
+static void dns_server_process(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_t *src_addr, u16_t src_port) {
+    dns_server_t *d = arg;
+    DEBUG_printf("dns_server_process %u\n", p->tot_len);
+
+    // Clients over the limit cost one hash: dropped, or answered with TC (slip)
+    bool slip;
+    bool allowed = dns_rrl_allow(d, src_addr, sys_now(), &slip);
+    if (!allowed && !slip) {
+        d->rrl_dropped++;
+        pbuf_free(p);
+        return;
+    }
+
+    // The TC reply only shrinks the query; a full reply may grow up to DNS_UDP_MSG_MAX
+    size_t cap = dns_pbuf_capacity(p);
+    if (cap < (allowed ? DNS_UDP_MSG_MAX : p->tot_len)) {
+        struct pbuf *copy = pbuf_alloc(PBUF_TRANSPORT, DNS_UDP_MSG_MAX, PBUF_RAM);
+        if (copy == NULL) {
+            ERROR_printf("DNS: Failed to send message out of memory\n");
+            pbuf_free(p);
+            return;
+        }
+        copy->len = copy->tot_len = pbuf_copy_partial(p, copy->payload, DNS_UDP_MSG_MAX, 0);
+        pbuf_free(p);
+        p = copy;
+        cap = DNS_UDP_MSG_MAX;
+    }
+
+    dns_question_t q = { .forward = false };
+    size_t query_len = p->len;
+    size_t reply_len;
+    if (allowed) {
+        reply_len = dns_build_reply(d, p->payload, p->len, cap, true, &q);
+    } else {
+        reply_len = dns_truncated_reply(p->payload, p->len);
+        d->rrl_slipped++;
+    }
+    if (q.forward) {
+        p->len = p->tot_len = query_len;
+        if (!dns_forward(d, p, &q, NULL, src_addr, src_port)) {
+            dns_send_servfail(d, dns_get16(p->payload), NULL, src_addr, src_port);
+        }
+    } else if (reply_len > 0) {
+        // Pbuf único: ajustar len/tot_len basta, inclusive para crescer dentro de `cap`
+        p->len = p->tot_len = reply_len;
+        DEBUG_printf("Sending %d byte reply to %s:%d\n", reply_len, ipaddr_ntoa(src_addr), src_port);
+        err_t err = udp_sendto(upcb, p, src_addr, src_port);
+        if (err != ERR_OK) {
+            ERROR_printf("DNS: Failed to send message %d\n", err);
+        }
+#if DUMP_DATA
+        dump_bytes(p->payload, reply_len);
+#endif
+    }
 
-ignore_request:
     pbuf_free(p);
 }
 
+/**
+ * [Descrição]: Libera a vaga de uma conexão DNS over TCP.
+ * [Parâmetros]: 
+ *  - dns_tcp_conn_t *c: conexão;
+ * [Notas]: Repasses pendentes da conexão são descartados.
+ */
+static void dns_tcp_release(dns_tcp_conn_t *c) {
+    dns_server_t *d = c->server;
+    for (int i = 0; i < DNS_PENDING_MAX; i++) {
+        if (d->pending[i].used && d->pending[i].tcp == c) {
+            d->pending[i].used = false;
+        }
+    }
+    if (c->rx) {
+        pbuf_free(c->rx);
+        c->rx = NULL;
+    }
+    c->pcb = NULL;
+}
+
+/**
+ * [Descrição]: Fecha uma conexão DNS over TCP e libera a vaga.
+ * [Parâmetros]: 
+ *  - dns_tcp_conn_t *c: conexão;
+ *  - bool abort: aborta (RST) em vez de fechar;
+ * [Notas]: Retorna ERR_ABRT se a conexão foi abortada, para os callbacks repassarem ao lwIP.
+ */
+static err_t dns_tcp_close(dns_tcp_conn_t *c, bool abort) {
+    struct tcp_pcb *pcb = c->pcb;
+    tcp_arg(pcb, NULL);
+    tcp_recv(pcb, NULL);
+    tcp_sent(pcb, NULL);
+    tcp_poll(pcb, NULL, 0);
+    tcp_err(pcb, NULL);
+    dns_tcp_release(c);
+    if (abort || tcp_close(pcb) != ERR_OK) {
+        tcp_abort(pcb);
+        return ERR_ABRT;
+    }
+    return ERR_OK;
+}
+
+/**
+ * [Descrição]: Responde as mensagens completas recebidas numa conexão TCP.
+ * [Parâmetros]: 
+ *  - dns_tcp_conn_t *c: conexão;
+ * [Notas]: 
+ *  - Várias consultas podem chegar na mesma conexão, em sequência.
+ *  - Para quando falta espaço de envio (bytes ou segmentos) para a maior
+ *    resposta; o callback `sent` retoma.
+ *  - Mensagens maiores que DNS_TCP_MSG_MAX derrubam a conexão.
+ *  - Retorna false se a conexão foi abortada.
+ */
+static bool dns_tcp_process(dns_tcp_conn_t *c) {
+    dns_server_t *d = c->server;
+    while (c->rx && c->rx->tot_len >= 2) {
+        size_t len = (size_t)pbuf_get_at(c->rx, 0) << 8 | pbuf_get_at(c->rx, 1);
+        if (len < sizeof(dns_header_t) || len > DNS_TCP_MSG_MAX) {
+            dns_tcp_close(c, true);
+            return false;
+        }
+        if (c->rx->tot_len < len + 2 || !dns_tcp_writable(c->pcb, DNS_TCP_MSG_MAX)) {
+            break;
+        }
+
+        pbuf_copy_partial(c->rx, dns_tcp_msg, len, 2);
+        dns_question_t q;
+        size_t reply_len = dns_build_reply(d, dns_tcp_msg, len, DNS_TCP_MSG_MAX, false, &q);
+        bool sent = true;
+        if (q.forward) {
+            struct pbuf *p = dns_tcp_forward_query(dns_tcp_msg, len, &q);
+            if (!p || !dns_forward(d, p, &q, c, &c->pcb->remote_ip, c->pcb->remote_port)) {
+                sent = dns_send_servfail(d, dns_get16(dns_tcp_msg), c, NULL, 0);
+            }
+            if (p) {
+                pbuf_free(p);
+            }
+        } else if (reply_len > 0) {
+            sent = dns_tcp_send(c, dns_tcp_frame, reply_len);
+        }
+        if (!sent) {
+            return false;
+        }
+
+        c->rx = pbuf_free_header(c->rx, len + 2);
+        tcp_recved(c->pcb, len + 2);
+    }
+    return true;
+}
+
+static err_t dns_tcp_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err) {
+    dns_tcp_conn_t *c = arg;
+    if (p == NULL) {
+        return dns_tcp_close(c, false);
+    }
+    c->idle = 0;
+    if (c->rx) {
+        pbuf_cat(c->rx, p);
+    } else {
+        c->rx = p;
+    }
+    return dns_tcp_process(c) ? ERR_OK : ERR_ABRT;
+}
+
+static err_t dns_tcp_sent(void *arg, struct tcp_pcb *pcb, u16_t len) {
+    dns_tcp_conn_t *c = arg;
+    c->idle = 0;
+    return dns_tcp_process(c) ? ERR_OK : ERR_ABRT;
+}
+
+static err_t dns_tcp_poll(void *arg, struct tcp_pcb *pcb) {
+    dns_tcp_conn_t *c = arg;
+    if (++c->idle >= DNS_TCP_IDLE_POLLS) {
+        return dns_tcp_close(c, false);
+    }
+    return ERR_OK;
+}
+
+static void dns_tcp_err(void *arg, err_t err) {
+    dns_tcp_conn_t *c = arg;
+    if (c) {
+        dns_tcp_release(c);
+    }
+}
+
+/**
+ * [Descrição]: Aceita uma conexão DNS over TCP.
+ * [Parâmetros]: 
+ *  - void *arg: ponteiro para `dns_server_t`;
+ *  - struct tcp_pcb *pcb: nova conexão;
+ *  - err_t err: erro do lwIP;
+ * [Notas]: Acima de DNS_TCP_MAX conexões, a nova é recusada com RST.
+ */
+static err_t dns_tcp_accept(void *arg, struct tcp_pcb *pcb, err_t err) {
+    dns_server_t *d = arg;
+    if (err != ERR_OK || pcb == NULL) {
+        return ERR_VAL;
+    }
+
+    dns_tcp_conn_t *c = NULL;
+    for (int i = 0; i < DNS_TCP_MAX && !c; i++) {
+        if (d->tcp[i].pcb == NULL) {
+            c = &d->tcp[i];
+        }
+    }
+    if (!c) {
+        tcp_abort(pcb);
+        return ERR_ABRT;
+    }
+
+    c->pcb = pcb;
+    c->server = d;
+    c->rx = NULL;
+    c->idle = 0;
+    tcp_arg(pcb, c);
+    tcp_recv(pcb, dns_tcp_recv);
+    tcp_sent(pcb, dns_tcp_sent);
+    tcp_poll(pcb, dns_tcp_poll, 1);
+    tcp_err(pcb, dns_tcp_err);
+    return ERR_OK;
+}
+
 /**
  * [Descrição]: Inicializa o servidor DNS.
  * [Parâmetros]: 
  *  - dns_server_t *d: ponteiro para a estrutura do servidor DNS;
  *  - ip_addr_t *ip: endereço IP a ser utilizado como resposta;
- * [Notas]: Associa o socket à porta 53 e registra o callback.
+ * [Notas]: Associa os sockets UDP e TCP à porta 53 e registra os callbacks.
  */
 void dns_server_init(dns_server_t *d, ip_addr_t *ip) {
+    memset(d->hosts, 0, sizeof(d->hosts));
+    memset(d->buckets, -1, sizeof(d->buckets));
+    d->fallback = DNS_ACTION_ADDRESS;
+    memset(d->pending, 0, sizeof(d->pending));
+    memset(d->cache, 0, sizeof(d->cache));
+    ip_addr_set_zero(&d->upstream);
+    memset(d->tcp, 0, sizeof(d->tcp));
+    d->tcp_listen = NULL;
+    memset(d->rrl, 0, sizeof(d->rrl));
+    d->rrl_dropped = 0;
+    d->rrl_slipped = 0;
+    memset(&d->sketch, 0, sizeof(d->sketch));
+    d->blocklist = NULL;
+    d->blocked = 0;
+
+    // DNS over TCP, para respostas que não cabem em UDP (TC)
+    struct tcp_pcb *pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+    if (pcb != NULL && tcp_bind(pcb, ip, PORT_DNS_SERVER) == ERR_OK) {
+        d->tcp_listen = tcp_listen_with_backlog(pcb, DNS_TCP_MAX);
+    }
+    if (d->tcp_listen != NULL) {
+        tcp_arg(d->tcp_listen, d);
+        tcp_accept(d->tcp_listen, dns_tcp_accept);
+    } else {
+        ERROR_printf("dns server: failed to create tcp listener\n");
+        if (pcb != NULL) {
+            tcp_close(pcb);
+        }
+    }
+
+    // Porta efêmera para as consultas repassadas ao upstream
+    if (dns_socket_new_dgram(&d->upstream_udp, d, dns_upstream_recv) != ERR_OK
+        || udp_bind(d->upstream_udp, IP_ANY_TYPE, 0) != ERR_OK) {
+        ERROR_printf("dns server: failed to create upstream socket\n");
+        dns_socket_free(&d->upstream_udp);
+    }
+
     if (dns_socket_new_dgram(&d->udp, d, dns_server_process) != ERR_OK) {
         ERROR_printf("dns server: failed to create socket\n");
         return;
@@ -294,8 +1769,216 @@ void dns_server_init(dns_server_t *d, ip_addr_t *ip) {
  * [Descrição]: Finaliza o servidor DNS e libera recursos.
  * [Parâmetros]: 
  *  - dns_server_t *d: ponteiro para a estrutura do servidor DNS;
- * [Notas]: Libera o socket UDP.
+ * [Notas]: Libera os sockets UDP.
  */
 void dns_server_deinit(dns_server_t *d) {
     dns_socket_free(&d->udp);
+    dns_socket_free(&d->upstream_udp);
+    for (int i = 0; i < DNS_TCP_MAX; i++) {
+        if (d->tcp[i].pcb != NULL) {
+            dns_tcp_close(&d->tcp[i], true);
+        }
+    }
+    if (d->tcp_listen != NULL) {
+        tcp_close(d->tcp_listen);
+        d->tcp_listen = NULL;
+    }
+}
+
+/**
+ * [Descrição]: Adiciona ou altera um nome na tabela do servidor DNS.
+ * [Parâmetros]: 
+ *  - dns_server_t *d: ponteiro para a estrutura do servidor DNS;
+ *  - const char *name: nome em texto; "*.dominio" vale para os subdomínios;
+ *  - dns_action_t action: resposta para o nome;
+ *  - const ip4_addr_t *addr: endereço, com DNS_ACTION_ADDRESS (NULL = IP do servidor);
+ * [Notas]: 
+ *  - Retorna 0, -EINVAL para nome inválido ou -ENOMEM com a tabela cheia.
+ *  - Pode ser chamada a qualquer momento, no contexto do lwIP.
+ */
+int dns_server_set_host(dns_server_t *d, const char *name, dns_action_t action, const ip4_addr_t *addr) {
+    uint8_t wire[DNS_HOST_NAME_MAX];
+    bool wildcard;
+    size_t len = dns_name_from_text(name, wire, &wildcard);
+    if (len == 0) {
+        return -EINVAL;
+    }
+
+    dns_host_t *host = (dns_host_t *)dns_host_find(d, wire, len, wildcard);
+    if (!host) {
+        for (int i = 0; i < DNS_HOSTS_MAX && !host; i++) {
+            if (d->hosts[i].name_len == 0) {
+                host = &d->hosts[i];
+            }
+        }
+        if (!host) {
+            return -ENOMEM;
+        }
+        memcpy(host->name, wire, len);
+        host->name_len = len;
+        host->wildcard = wildcard;
+        host->hash = dns_name_hash(wire, len);
+        int8_t *bucket = &d->buckets[host->hash & (DNS_HOSTS_BUCKETS - 1)];
+        host->next = *bucket;
+        *bucket = host - d->hosts;
+    }
+
+    host->action = action;
+    ip4_addr_copy(host->addr, addr ? *addr : *ip_2_ip4(&d->ip));
+    return 0;
+}
+
+/**
+ * [Descrição]: Remove um nome da tabela do servidor DNS.
+ * [Parâmetros]: 
+ *  - dns_server_t *d: ponteiro para a estrutura do servidor DNS;
+ *  - const char *name: nome como passado a `dns_server_set_host`;
+ * [Notas]: Retorna false se o nome não estiver na tabela.
+ */
+bool dns_server_remove_host(dns_server_t *d, const char *name) {
+    uint8_t wire[DNS_HOST_NAME_MAX];
+    bool wildcard;
+    size_t len = dns_name_from_text(name, wire, &wildcard);
+    const dns_host_t *host = len ? dns_host_find(d, wire, len, wildcard) : NULL;
+    if (!host) {
+        return false;
+    }
+
+    int index = host - d->hosts;
+    int8_t *link = &d->buckets[host->hash & (DNS_HOSTS_BUCKETS - 1)];
+    while (*link != index) {
+        link = &d->hosts[*link].next;
+    }
+    *link = host->next;
+    d->hosts[index].name_len = 0;
+    return true;
+}
+
+/**
+ * [Descrição]: Define a resposta para nomes fora da tabela.
+ * [Parâmetros]: 
+ *  - dns_server_t *d: ponteiro para a estrutura do servidor DNS;
+ *  - dns_action_t action: DNS_ACTION_ADDRESS (IP do servidor, portal cativo) ou DNS_ACTION_NXDOMAIN;
+ * [Notas]: Nenhuma.
+ */
+void dns_server_set_fallback(dns_server_t *d, dns_action_t action) {
+    d->fallback = action;
+}
+
+/**
+ * [Descrição]: Define o servidor DNS para onde vão os nomes repassados.
+ * [Parâmetros]: 
+ *  - dns_server_t *d: ponteiro para a estrutura do servidor DNS;
+ *  - const ip_addr_t *upstream: servidor upstream (NULL ou IP_ANY desliga o repasse);
+ * [Notas]: Trocar o upstream esvazia o cache.
+ */
+void dns_server_set_upstream(dns_server_t *d, const ip_addr_t *upstream) {
+    ip_addr_t next;
+    if (upstream == NULL || ip_addr_isany(upstream)) {
+        ip_addr_set_zero(&next);
+    } else {
+        ip_addr_copy(next, *upstream);
+    }
+    if (ip_addr_cmp(&next, &d->upstream)) {
+        return;
+    }
+    ip_addr_copy(d->upstream, next);
+    memset(d->cache, 0, sizeof(d->cache));
+}
+
+/**
+ * [Descrição]: Define a lista de domínios bloqueados.
+ * [Parâmetros]: 
+ *  - dns_server_t *d: ponteiro para a estrutura do servidor DNS;
+ *  - const blocklist_t *blocklist: lista montada (NULL desliga o bloqueio);
+ * [Notas]: 
+ *  - Nomes da lista e seus subdomínios recebem NXDOMAIN, antes do
+ *    fallback e das entradas curinga; só uma entrada exata da tabela de
+ *    nomes tem precedência.
+ *  - A lista não é copiada: deve continuar válida enquanto estiver em uso.
+ */
+void dns_server_set_blocklist(dns_server_t *d, const blocklist_t *blocklist) {
+    d->blocklist = blocklist;
+}
+
+/**
+ * [Descrição]: Tarefas periódicas do servidor DNS.
+ * [Parâmetros]: 
+ *  - dns_server_t *d: ponteiro para a estrutura do servidor DNS;
+ *  - uint32_t now_ms: instante atual em ms;
+ * [Notas]: 
+ *  - Chamada no laço principal, no contexto do lwIP.
+ *  - Acompanha o servidor DNS que a estação recebeu do DHCP (o mesmo do
+ *    resolvedor do lwIP) como upstream.
+ *  - Consultas sem resposta até DNS_FORWARD_TIMEOUT_MS recebem SERVFAIL.
+ */
+void dns_server_poll(dns_server_t *d, uint32_t now_ms) {
+    if (d->upstream_udp != NULL) {
+        dns_server_set_upstream(d, dns_getserver(0));
+    }
+
+    for (int i = 0; i < DNS_PENDING_MAX; i++) {
+        dns_pending_t *pending = &d->pending[i];
+        if (pending->used && (int32_t)(now_ms - pending->deadline_ms) >= 0) {
+            pending->used = false;
+            dns_send_servfail(d, pending->client_id, pending->tcp, &pending->client, pending->client_port);
+        }
+    }
+
+    if (now_ms - d->sketch.decay_ms >= DNS_SKETCH_DECAY_MS) {
+        dns_sketch_halve(&d->sketch);
+        d->sketch.decay_ms = now_ms;
+    }
+}
+
+/**
+ * [Descrição]: Copia os nomes mais consultados, do mais para o menos consultado.
+ * [Parâmetros]: 
+ *  - const dns_server_t *d: ponteiro para a estrutura do servidor DNS;
+ *  - dns_top_t *top: recebe os nomes e as estimativas;
+ *  - size_t max: entradas disponíveis em `top`;
+ * [Notas]: 
+ *  - Retorna quantas entradas foram escritas (até DNS_TOP_MAX).
+ *  - As contagens são do count-min sketch: podem superestimar, nunca
+ *    subestimar, e caem pela metade a cada DNS_SKETCH_DECAY_MS.
+ */
+size_t dns_server_top(const dns_server_t *d, dns_top_t *top, size_t max) {
+    const dns_sketch_t *s = &d->sketch;
+    size_t count = 0;
+
+    if (max == 0) {
+        return 0;
+    }
+    for (int i = 0; i < s->top_count; i++) {
+        const dns_top_entry_t *e = &s->top[i];
+
+        // Ordenação por inserção: no máximo DNS_TOP_MAX entradas
+        size_t pos;
+        if (count < max) {
+            pos = count++;
+        } else if (top[max - 1].count < e->count) {
+            pos = max - 1;
+        } else {
+            continue;
+        }
+        while (pos > 0 && top[pos - 1].count < e->count) {
+            top[pos] = top[pos - 1];
+            pos--;
+        }
+
+        char *text = top[pos].name;
+        size_t off = 0;
+        while (off < e->name_len && e->name[off] != 0) {
+            uint8_t label_len = e->name[off];
+            if (text != top[pos].name) {
+                *text++ = '.';
+            }
+            memcpy(text, e->name + off + 1, label_len);
+            text += label_len;
+            off += label_len + 1;
+        }
+        *text = '\0';
+        top[pos].count = e->count;
+    }
+    return count;
 }
@@ -7,14 +7,157 @@
 #ifndef _DNSSERVER_H_
 #define _DNSSERVER_H_
 
+#include <stdbool.h>
 #include "lwip/ip_addr.h"
+#include "blocklist.h"
+
+#define DNS_UDP_MSG_MAX     512 // Limite UDP sem EDNS (RFC 1035)
+#define DNS_EDNS_PAYLOAD_MAX 1232 // Maior payload UDP aceito via EDNS(0); anunciado no OPT
+
+#define DNS_QUESTIONS_MAX   4   // Perguntas respondidas numa mesma consulta
+
+#define DNS_HOSTS_MAX       16  // Entradas da tabela de nomes
+#define DNS_HOSTS_BUCKETS   32  // Potência de 2
+#define DNS_HOST_NAME_MAX   64  // Nome em formato wire, com o 0 final
+
+#define DNS_PENDING_MAX     8   // Consultas aguardando o servidor upstream
+#define DNS_FORWARD_TIMEOUT_MS 2000
+#define DNS_CACHE_ENTRIES   8   // Respostas do upstream guardadas (LRU)
+#define DNS_CACHE_MSG_MAX   256 // Respostas maiores não entram no cache
+#define DNS_CACHE_RRS       12  // Registros (TTLs) por resposta em cache
+#define DNS_CACHE_MAX_TTL   3600
+
+#define DNS_RRL_CLIENTS     16  // Entradas do limite por cliente (potência de 2, até 256)
+#define DNS_RRL_WINDOW_MS   1000
+#define DNS_RRL_LIMIT       20  // Consultas por janela, por IP
+#define DNS_RRL_SLIP        2   // Acima do limite, 1 a cada N recebe TC (0 = só descarta)
+
+#define DNS_SKETCH_DEPTH    4   // Linhas (hashes) do count-min sketch
+#define DNS_SKETCH_WIDTH    256 // Contadores por linha (potência de 2)
+#define DNS_TOP_MAX         8   // Nomes mais consultados mantidos com o nome
+#define DNS_SKETCH_DECAY_MS (10 * 60 * 1000) // Contagens caem pela metade a cada intervalo
+
+#define DNS_TCP_MAX         2   // Conexões DNS over TCP simultâneas
+#define DNS_TCP_MSG_MAX     1024 // Maior consulta e resposta montada via TCP
+#define DNS_TCP_IDLE_POLLS  10  // Ciclos de poll (500 ms) sem atividade até fechar
+
+// O que responder para um nome
+typedef enum {
+    DNS_ACTION_ADDRESS = 0,     // Responde A com o endereço configurado
+    DNS_ACTION_NXDOMAIN,        // Nome inexistente (não sequestrado)
+    DNS_ACTION_FORWARD,         // Consulta o upstream (sem upstream, vale ADDRESS)
+} dns_action_t;
+
+typedef struct dns_host_t_ {
+    uint8_t name[DNS_HOST_NAME_MAX];    // Formato wire, minúsculo; sem o "*." se curinga
+    uint8_t name_len;                   // 0 = entrada livre
+    uint8_t action;                     // dns_action_t
+    bool wildcard;                      // "*.nome": vale para os subdomínios
+    int8_t next;                        // Próxima entrada do mesmo balde (-1 = fim)
+    uint32_t hash;
+    ip4_addr_t addr;
+} dns_host_t;
+
+// Janela deslizante de um cliente (duas janelas fixas ponderadas)
+typedef struct dns_rrl_entry_t_ {
+    uint32_t ip;
+    uint32_t window_start;
+    uint16_t count;                     // Consultas na janela atual
+    uint16_t prev;                      // Consultas na janela anterior
+    uint8_t slip;
+} dns_rrl_entry_t;
+
+// Nome do top-K; o heap mantém o menos consultado na raiz
+typedef struct dns_top_entry_t_ {
+    uint32_t hash;
+    uint16_t count;
+    uint8_t name_len;
+    uint8_t name[DNS_HOST_NAME_MAX];    // Formato wire, minúsculo
+} dns_top_entry_t;
+
+// Contagem aproximada de consultas por nome, em memória fixa
+typedef struct dns_sketch_t_ {
+    uint16_t rows[DNS_SKETCH_DEPTH][DNS_SKETCH_WIDTH];
+    dns_top_entry_t top[DNS_TOP_MAX];
+    uint8_t top_count;
+    uint32_t queries;                   // Consultas contadas desde o boot
+    uint32_t decay_ms;                  // Último decaimento
+} dns_sketch_t;
+
+// Nome mais consultado, para relatórios
+typedef struct dns_top_t_ {
+    char name[DNS_HOST_NAME_MAX];       // Texto, sem o ponto final
+    uint32_t count;                     // Estimativa: nunca abaixo do real (desde o decaimento)
+} dns_top_t;
+
+// Conexão DNS over TCP: mensagens com prefixo de 2 bytes de tamanho
+typedef struct dns_tcp_conn_t_ {
+    struct tcp_pcb *pcb;                // NULL = livre
+    struct dns_server_t_ *server;
+    struct pbuf *rx;                    // Bytes recebidos ainda não processados
+    uint8_t idle;
+} dns_tcp_conn_t;
+
+// Consulta repassada ao upstream, com o ID trocado
+typedef struct dns_pending_t_ {
+    bool used;
+    dns_tcp_conn_t *tcp;                // Cliente via TCP (NULL = UDP)
+    bool strip_opt;                     // OPT acrescentado no repasse: sai da resposta
+    uint16_t client_id;
+    uint16_t upstream_id;
+    uint16_t client_port;
+    ip_addr_t client;
+    uint32_t qhash;
+    uint16_t qtype;
+    uint16_t qclass;
+    uint32_t deadline_ms;
+} dns_pending_t;
+
+// Resposta do upstream guardada como recebida; os TTLs são descontados na saída
+typedef struct dns_cache_entry_t_ {
+    uint32_t qhash;                     // 0 = entrada livre
+    uint16_t qtype;
+    uint16_t qclass;
+    uint32_t stored_ms;
+    uint32_t expires_ms;
+    uint32_t last_used;
+    uint16_t len;
+    uint16_t question_end;              // Fim da pergunta (início dos registros)
+    uint8_t ttl_count;
+    uint16_t ttl_offset[DNS_CACHE_RRS];
+    uint8_t msg[DNS_CACHE_MSG_MAX];
+} dns_cache_entry_t;
 
 typedef struct dns_server_t_ {
     struct udp_pcb *udp;
      ip_addr_t ip;
+    dns_action_t fallback;              // Ação para nomes fora da tabela
+    dns_host_t hosts[DNS_HOSTS_MAX];
+    int8_t buckets[DNS_HOSTS_BUCKETS];
+    struct udp_pcb *upstream_udp;
+    ip_addr_t upstream;                 // IP_ANY = sem upstream
+    dns_pending_t pending[DNS_PENDING_MAX];
+    dns_cache_entry_t cache[DNS_CACHE_ENTRIES];
+    uint32_t cache_clock;
+    struct tcp_pcb *tcp_listen;
+    dns_tcp_conn_t tcp[DNS_TCP_MAX];
+    dns_rrl_entry_t rrl[DNS_RRL_CLIENTS];
+    uint32_t rrl_dropped;               // Consultas descartadas pelo limite
+    uint32_t rrl_slipped;               // Consultas respondidas só com TC
+    dns_sketch_t sketch;
+    const blocklist_t *blocklist;       // NULL = sem lista de bloqueio
+    uint32_t blocked;                   // Consultas respondidas com NXDOMAIN pela lista
 } dns_server_t;
 
 void dns_server_init(dns_server_t *d, ip_addr_t *ip);
 void dns_server_deinit(dns_server_t *d);
 
+int dns_server_set_host(dns_server_t *d, const char *name, dns_action_t action, const ip4_addr_t *addr);
+bool dns_server_remove_host(dns_server_t *d, const char *name);
+void dns_server_set_fallback(dns_server_t *d, dns_action_t action);
+void dns_server_set_upstream(dns_server_t *d, const ip_addr_t *upstream);
+void dns_server_set_blocklist(dns_server_t *d, const blocklist_t *blocklist);
+void dns_server_poll(dns_server_t *d, uint32_t now_ms);
+size_t dns_server_top(const dns_server_t *d, dns_top_t *top, size_t max);
+
 #endif
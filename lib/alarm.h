@@ -0,0 +1,15 @@
+#ifndef ALARM_H
+#define ALARM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+void alarm_set_active(bool active);
+
+void alarm_activate_for(uint32_t duration_s);
+
+uint32_t alarm_remaining_s(void);
+
+bool alarm_is_active(void);
+
+#endif // ALARM_H
@@ -0,0 +1,55 @@
+#ifndef BLOCKLIST_H
+#define BLOCKLIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Formato da imagem gerada por tools/mkblocklist.py (little-endian):
+//  - blocklist_header_t;
+//  - filtro de Bloom com `bloom_bits` bits (múltiplo de 32);
+//  - `bucket_count + 1` deslocamentos u32: os nomes do balde b ficam
+//    entre offsets[b] e offsets[b + 1];
+//  - nomes em formato wire minúsculo, agrupados por balde.
+// Posições do filtro e balde vêm do FNV-1a de 32 bits do nome em formato
+// wire: g_i = h + i * ((h >> 17 | h << 15) | 1), mapeado para [0, n) por
+// (g * n) >> 32.
+#define BLOCKLIST_MAGIC     "BLK1"
+#define BLOCKLIST_VERSION   1
+#define BLOCKLIST_MAX_HASHES 16
+#define BLOCKLIST_NAME_MAX  255         // Nome em formato wire, com o 0 final
+
+enum {
+    BLOCKLIST_OK = 0,
+    BLOCKLIST_ERR_MAGIC = -1,           // Região vazia ou imagem de outro formato
+    BLOCKLIST_ERR_VERSION = -2,
+    BLOCKLIST_ERR_BOUNDS = -3           // Tabela ou nome fora da imagem
+};
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint8_t hash_count;                 // Posições do filtro por nome
+    uint8_t reserved;
+    uint32_t count;                     // Nomes bloqueados
+    uint32_t bloom_bits;
+    uint32_t bucket_count;
+    uint32_t image_size;
+} blocklist_header_t;
+
+// Imagem montada: aponta para a flash (XIP) ou para um arquivo mapeado
+typedef struct {
+    const uint8_t *base;
+    const uint32_t *bloom;
+    const uint32_t *buckets;
+    uint32_t bloom_bits;
+    uint32_t bucket_count;
+    uint32_t count;
+    uint8_t hash_count;
+} blocklist_t;
+
+int blocklist_mount(blocklist_t *bl, const void *image, size_t size);
+
+bool blocklist_contains(const blocklist_t *bl, const uint8_t *name, size_t len);
+
+#endif // BLOCKLIST_H
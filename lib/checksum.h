@@ -0,0 +1,30 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CRC32_INIT 0xFFFFFFFFu
+
+#define SHA256_DIGEST_SIZE 32
+
+// Estado do SHA-256 incremental (~108 bytes)
+typedef struct {
+    uint32_t state[8];
+    uint64_t total;                 // Bytes processados
+    uint8_t block[64];              // Bloco parcial
+} sha256_t;
+
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t len);
+
+uint32_t crc32_final(uint32_t crc);
+
+uint32_t crc32_mpeg2(const uint8_t *data, size_t len);
+
+void sha256_init(sha256_t *sha);
+
+void sha256_update(sha256_t *sha, const uint8_t *data, size_t len);
+
+void sha256_final(sha256_t *sha, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+#endif // CHECKSUM_H
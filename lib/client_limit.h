@@ -0,0 +1,40 @@
+#ifndef CLIENT_LIMIT_H
+#define CLIENT_LIMIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lwip/ip_addr.h"
+#include "dhcpserver.h"
+
+#define CLIENT_OFFNET_BUCKETS 4     // Entradas dos IPs fora do bloco do DHCP, por hash (potência de 2)
+#define CLIENT_LIMIT_ENTRIES (DHCPS_MAX_IP + CLIENT_OFFNET_BUCKETS)
+
+// Classes com balde próprio por cliente
+typedef enum {
+    CLIENT_CLASS_CONNECT = 0,   // Conexões aceitas
+    CLIENT_CLASS_PROBE,         // Requisições sem rota (ex: testes de portal cativo)
+    CLIENT_CLASS_ASSET,         // Páginas, arquivos e leituras da API
+    CLIENT_CLASS_CONTROL,       // Rotas de administração e porta de controle
+    CLIENT_CLASS_COUNT
+} client_class_t;
+
+// Taxa sustentada (fichas/s) e rajada máxima de uma classe
+typedef struct {
+    uint16_t per_s;
+    uint16_t burst;
+} client_rate_t;
+
+void client_limit_set_dhcp(const dhcp_server_t *dhcp);
+
+unsigned client_limit_index(const ip_addr_t *remote);
+
+void client_limit_open(unsigned client);
+
+void client_limit_close(unsigned client);
+
+unsigned client_limit_connections(unsigned client);
+
+bool client_limit_take(const ip_addr_t *remote, client_class_t cls, const client_rate_t *rate,
+                       uint32_t now_ms, uint32_t *retry_after_s);
+
+#endif // CLIENT_LIMIT_H
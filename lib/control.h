@@ -0,0 +1,11 @@
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include "routes.h"
+
+#define CONTROL_MAX_BODY    256     // Maior comando JSON aceito
+#define CONTROL_MAX_TOKENS  16      // Tokens do comando (pilha: ~160 bytes)
+
+body_route_result_t control_begin(const char *request, http_body_handler_t *handler, http_response_t *response);
+
+#endif // CONTROL_H
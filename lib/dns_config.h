@@ -0,0 +1,20 @@
+#ifndef DNS_CONFIG_H
+#define DNS_CONFIG_H
+
+// Nomes respondidos com o IP do Pico W
+#define DNS_LOCAL_NAMES     "alarme.lan", "admin.lan"
+
+// Nomes que não devem ser sequestrados (NXDOMAIN). Os "canários" desligam
+// o DNS over HTTPS do Firefox e o Private Relay da Apple, que ignorariam
+// este servidor; "wpad" evita que o navegador pegue um proxy da rede.
+#define DNS_UNHIJACKED_NAMES "use-application-dns.net", "mask.icloud.com", "mask-h2.icloud.com", "wpad", "wpad.lan"
+
+// Nomes repassados ao servidor DNS da rede quando o Pico W também está
+// conectado como estação (AP+STA); só no modo AP, recebem o IP do Pico W
+#define DNS_FORWARD_NAMES   "gov.br", "*.gov.br"
+
+// Resposta para os demais nomes: DNS_ACTION_ADDRESS (portal cativo),
+// DNS_ACTION_NXDOMAIN ou DNS_ACTION_FORWARD (repassa tudo)
+#define DNS_FALLBACK        DNS_ACTION_ADDRESS
+
+#endif // DNS_CONFIG_H
@@ -0,0 +1,24 @@
+#ifndef FLASH_BACKEND_H
+#define FLASH_BACKEND_H
+
+#include <stdint.h>
+
+#define FLASH_BACKEND_SECTOR    4096    // Unidade de apagamento
+#define FLASH_BACKEND_PAGE      256     // Unidade de gravação
+
+// Região de flash gravável (deslocamentos relativos ao início da região).
+// No Pico é a área de staging (flash_pico.c); em um computador pode ser
+// um arquivo, para exercitar a OTA sem o hardware.
+typedef struct {
+    uint32_t size;                      // Tamanho da região (múltiplo de FLASH_BACKEND_SECTOR)
+    // Apaga setores inteiros (offset e len alinhados a FLASH_BACKEND_SECTOR)
+    int (*erase)(void *ctx, uint32_t offset, uint32_t len);
+    // Grava páginas já apagadas (offset e len alinhados a FLASH_BACKEND_PAGE)
+    int (*program)(void *ctx, uint32_t offset, const uint8_t *data, uint32_t len);
+    int (*read)(void *ctx, uint32_t offset, uint8_t *data, uint32_t len);
+    // Instala a imagem verificada de `size` bytes; normalmente não retorna
+    int (*install)(void *ctx, uint32_t size);
+    void *ctx;
+} flash_backend_t;
+
+#endif // FLASH_BACKEND_H
@@ -0,0 +1,37 @@
+#ifndef FLASH_LAYOUT_H
+#define FLASH_LAYOUT_H
+
+// Divisão da flash de 2 MiB do Pico W (deslocamentos a partir do início da flash)
+//
+//  0x000000 +-----------------------------+
+//           | Firmware (XIP)              |
+//  0x0B0000 +-----------------------------+
+//           | Área de staging da OTA      |
+//  0x160000 +-----------------------------+
+//           | Domínios bloqueados no DNS  |
+//           | (tools/mkblocklist)         |
+//  0x1C0000 +-----------------------------+
+//           | Imagem ROMFS (tools/mkromfs)|
+//  0x200000 +-----------------------------+
+
+#ifndef FLASH_TOTAL_SIZE
+#define FLASH_TOTAL_SIZE        (2u * 1024 * 1024)
+#endif
+
+#define FLASH_ROMFS_SIZE        (256u * 1024)
+#define FLASH_ROMFS_OFFSET      (FLASH_TOTAL_SIZE - FLASH_ROMFS_SIZE)
+
+#define FLASH_BLOCKLIST_SIZE    (384u * 1024)   // ~12 mil domínios (tools/mkblocklist.py)
+#define FLASH_BLOCKLIST_OFFSET  (FLASH_ROMFS_OFFSET - FLASH_BLOCKLIST_SIZE)
+
+// Firmware e staging têm o mesmo tamanho: a imagem recebida é copiada por cima
+#define FLASH_APP_OFFSET        0u
+#define FLASH_APP_SIZE          (FLASH_BLOCKLIST_OFFSET / 2)
+#define FLASH_OTA_OFFSET        (FLASH_APP_OFFSET + FLASH_APP_SIZE)
+#define FLASH_OTA_SIZE          FLASH_APP_SIZE
+
+// Endereço da imagem no mapa XIP (somente leitura, acessada direto da flash)
+#define FLASH_ROMFS_XIP_ADDR    (XIP_BASE + FLASH_ROMFS_OFFSET)
+#define FLASH_BLOCKLIST_XIP_ADDR (XIP_BASE + FLASH_BLOCKLIST_OFFSET)
+
+#endif // FLASH_LAYOUT_H
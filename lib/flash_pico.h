@@ -0,0 +1,9 @@
+#ifndef FLASH_PICO_H
+#define FLASH_PICO_H
+
+#include "flash_backend.h"
+
+// Área de staging da OTA na flash do Pico (ver flash_layout.h)
+extern const flash_backend_t flash_pico_ota;
+
+#endif // FLASH_PICO_H
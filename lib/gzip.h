@@ -0,0 +1,30 @@
+#ifndef GZIP_H
+#define GZIP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define GZIP_WINDOW_SIZE    1024    // Histórico para referências (metade do buffer)
+#define GZIP_HASH_BITS      9
+#define GZIP_MIN_INPUT      256     // Abaixo disso a compressão não compensa o cabeçalho
+
+// Compressor deflate (Huffman fixo) com cabeçalho e trailer gzip; ~3 KiB de RAM
+typedef struct {
+    uint8_t buf[2 * GZIP_WINDOW_SIZE];      // Histórico + dados da chamada atual
+    uint16_t head[1 << GZIP_HASH_BITS];     // Última posição (+1) de cada hash de 3 bytes
+    uint16_t fill;                          // Bytes válidos em `buf`
+    uint32_t bitbuf;
+    uint8_t bitcount;
+    bool started;                           // Cabeçalho gzip já emitido
+    uint32_t crc;
+    uint32_t total_in;
+} gzip_stream_t;
+
+void gzip_init(gzip_stream_t *gz);
+
+size_t gzip_bound(size_t len);
+
+size_t gzip_compress(gzip_stream_t *gz, const uint8_t *in, size_t len, uint8_t *out, bool finish);
+
+#endif // GZIP_H
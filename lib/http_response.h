@@ -2,6 +2,9 @@
 #define HTTP_RESPONSES_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include "http_stream.h"
+#include "template.h"
 
 #define MAX_HEADERS_SIZE 1024
 
@@ -12,6 +15,14 @@ typedef struct {
     size_t headers_len;
     char *body;
     size_t body_len;
+    const char *borrowed_body;          // Corpo de outro dono (ex: cache), enviado sem cópia
+    void (*body_release)(void *ctx);    // Devolve o corpo emprestado ao fim do envio
+    void *body_release_ctx;
+    http_stream_fill_fn stream_fill;    // Se definido, o corpo é gerado sob demanda
+    void *stream_ctx;
+    uint32_t stream_key;                // Se diferente de 0, requisições idênticas compartilham o stream
+    const template_t *tpl;              // Se definido, o corpo é o template compilado
+    template_value_t tpl_values[TEMPLATE_MAX_SLOTS];
 } http_response_t;
 
 void init_http_response(http_response_t *response);
@@ -22,6 +33,15 @@ void add_response_header(http_response_t *response, const char *key, const char
 
 void set_response_body(http_response_t *response, const char *body);
 
+void set_response_borrowed_body(http_response_t *response, const char *body, size_t len,
+                                void (*release)(void *ctx), void *ctx);
+
+void set_response_stream(http_response_t *response, http_stream_fill_fn fill, void *ctx);
+
+void set_response_stream_key(http_response_t *response, uint32_t key);
+
+template_value_t *set_response_template(http_response_t *response, const template_t *tpl);
+
 void free_http_response(http_response_t *response);
 
 
@@ -5,6 +5,16 @@
 #include "lwip/tcp.h"
 #include "http_response.h"
 
+// Contadores do escalonamento de envio sob pressão de memória
+typedef struct {
+    uint32_t deferrals;         // Vezes que uma resposta bulk foi adiada
+    uint32_t resumes;           // Respostas adiadas retomadas
+    uint16_t min_headroom;      // Menor folga de segmentos TCP observada
+    uint16_t min_heap_headroom; // Menor folga do heap do lwIP observada (bytes)
+} http_send_stats_t;
+
 void http_server_start(void);
 
+const http_send_stats_t *http_server_send_stats(void);
+
 #endif // HTTP_SERVER_H
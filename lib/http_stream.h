@@ -0,0 +1,43 @@
+#ifndef HTTP_STREAM_H
+#define HTTP_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HTTP_STREAM_BUFFER_SIZE 512     // Maior bloco gerado por vez (vira um chunk)
+#define HTTP_STREAM_HEADROOM    6       // Espaço para o tamanho do chunk ("200\r\n")
+#define HTTP_STREAM_TAILROOM    2       // Espaço para o CRLF que fecha o chunk
+
+typedef struct http_stream_t_ {
+    char frame[HTTP_STREAM_HEADROOM + HTTP_STREAM_BUFFER_SIZE + HTTP_STREAM_TAILROOM];
+    size_t len;             // Bytes de dados pendentes em `frame`
+    uintptr_t cursor;       // Posição livre para o gerador retomar de onde parou
+    bool chunked;           // false: HTTP/1.0, corpo delimitado pelo fechamento
+} http_stream_t;
+
+/**
+ * Gerador de conteúdo: escreve o que couber com `http_stream_write` /
+ * `http_stream_printf` e retorna true quando não há mais nada a gerar.
+ * Retornar false sem escrever nada indica que ainda não há dados
+ * disponíveis; o servidor chamará o gerador novamente mais tarde.
+ */
+typedef bool (*http_stream_fill_fn)(http_stream_t *stream, void *ctx);
+
+void http_stream_init(http_stream_t *stream, bool chunked);
+
+size_t http_stream_space(const http_stream_t *stream);
+
+bool http_stream_write(http_stream_t *stream, const void *data, size_t len);
+
+bool http_stream_printf(http_stream_t *stream, const char *format, ...);
+
+char *http_stream_reserve(http_stream_t *stream, size_t *space);
+
+void http_stream_commit(http_stream_t *stream, size_t len);
+
+const char *http_stream_frame(http_stream_t *stream, size_t *frame_len);
+
+void http_stream_consume(http_stream_t *stream);
+
+#endif // HTTP_STREAM_H
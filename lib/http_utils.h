@@ -2,7 +2,14 @@
 #define HTTP_UTILS_H
 
 #include <stddef.h>
+#include <stdbool.h>
 
 int build_http_headers(char *buffer, size_t max_len, int status_code, const char *content_type, size_t content_length);
 
+const char *http_find_header(const char *request, const char *name, size_t *value_len);
+
+long http_content_length(const char *request);
+
+bool http_accepts_encoding(const char *request, const char *encoding);
+
 #endif // HTTP_UTILS_H
@@ -0,0 +1,51 @@
+#ifndef JSON_PARSER_H
+#define JSON_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define JSON_ERR_NOMEM      -1      // Tokens insuficientes
+#define JSON_ERR_INVAL      -2      // Caractere ou estrutura inválida
+#define JSON_ERR_PART       -3      // Documento incompleto
+#define JSON_ERR_SIZE       -4      // Texto maior que o suportado (64 KiB)
+
+typedef enum {
+    JSON_UNDEFINED = 0,
+    JSON_OBJECT,
+    JSON_ARRAY,
+    JSON_STRING,                    // Sem as aspas; escapes preservados
+    JSON_PRIMITIVE                  // Número, true, false ou null
+} json_type_t;
+
+/**
+ * Token sobre o texto original: nada é copiado. Em objetos, `size`
+ * conta as chaves; cada chave é um JSON_STRING com `size` 1, seguido
+ * do seu valor. Em arrays, `size` conta os elementos.
+ */
+typedef struct {
+    uint8_t type;
+    uint16_t start;
+    uint16_t end;
+    uint16_t size;
+    int16_t parent;
+} json_token_t;
+
+int json_parse(const char *js, size_t len, json_token_t *tokens, unsigned max_tokens);
+
+int json_skip(const json_token_t *tokens, int count, int index);
+
+bool json_token_equals(const char *js, const json_token_t *token, const char *str);
+
+int json_find_key(const char *js, const json_token_t *tokens, int count, int object, const char *key);
+
+bool json_get_int(const char *js, const json_token_t *tokens, int count, int object,
+                  const char *key, int32_t *out);
+
+bool json_get_bool(const char *js, const json_token_t *tokens, int count, int object,
+                   const char *key, bool *out);
+
+int json_get_string(const char *js, const json_token_t *tokens, int count, int object,
+                    const char *key, char *out, size_t out_size);
+
+#endif // JSON_PARSER_H
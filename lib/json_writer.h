@@ -0,0 +1,48 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define JSON_WRITER_MAX_DEPTH 8     // Níveis de objetos/arrays aninhados
+
+// Escritor JSON sobre um buffer fixo; nunca aloca memória
+typedef struct {
+    char *buf;
+    size_t cap;
+    size_t len;
+    uint8_t depth;
+    uint8_t has_items;              // Bit por nível: já existe item (exige vírgula)
+    uint8_t in_object;              // Bit por nível: 1 = objeto, 0 = array
+    bool after_key;                 // Próximo valor completa um par chave/valor
+    bool error;                     // Estouro do buffer ou uso inválido (persistente)
+} json_writer_t;
+
+void json_writer_init(json_writer_t *w, char *buf, size_t cap);
+
+size_t json_writer_finish(json_writer_t *w);
+
+void json_begin_object(json_writer_t *w);
+
+void json_end_object(json_writer_t *w);
+
+void json_begin_array(json_writer_t *w);
+
+void json_end_array(json_writer_t *w);
+
+void json_key(json_writer_t *w, const char *key);
+
+void json_string(json_writer_t *w, const char *str);
+
+void json_int(json_writer_t *w, int32_t value);
+
+void json_uint(json_writer_t *w, uint32_t value);
+
+void json_bool(json_writer_t *w, bool value);
+
+void json_null(json_writer_t *w);
+
+void json_raw(json_writer_t *w, const char *text, size_t len);
+
+#endif // JSON_WRITER_H
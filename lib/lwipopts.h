@@ -24,9 +24,13 @@
 // =============================================
 #define MEM_SIZE                    4000        // Tamanho total do heap de memória
 #define MEMP_NUM_TCP_SEG            32          // Número de segmentos TCP em buffer
+#define MEMP_NUM_TCP_PCB            10          // Conexões TCP simultâneas (porta 80 + controle + DNS)
 #define MEMP_NUM_ARP_QUEUE          10          // Tamanho da fila ARP
 #define PBUF_POOL_SIZE              24          // Número de buffers na pool PBUF
-#define LWIP_NETIF_TX_SINGLE_PBUF   1           // Usa single PBUF para transmissão
+// Desligado: com 1 o tcp_write copia tudo para o heap (MEM_SIZE), inclusive
+// o que o servidor envia sem cópia da flash. O driver cyw43 aceita cadeias
+// de pbufs (copia a cadeia para o buffer SPI com pbuf_copy_partial)
+#define LWIP_NETIF_TX_SINGLE_PBUF   0           // Segmentos em cadeia: dados sem cópia
 
 // =============================================
 // 3. Protocolos Habilitados/Desabilitados
@@ -104,11 +108,11 @@
 #define DHCP_DEBUG                  LWIP_DBG_OFF
 
 // =============================================
-// 8. Configurações de Monitoramento (Desativadas)
+// 8. Configurações de Monitoramento
 // =============================================
-#define MEM_STATS                   0           // Desabilita estatísticas de memória
+#define MEM_STATS                   1           // Uso do heap: o servidor HTTP adia envios sem folga
 #define SYS_STATS                   0           // Desabilita estatísticas do sistema
-#define MEMP_STATS                  0           // Desabilita estatísticas de mem pools
+#define MEMP_STATS                  1           // Uso dos pools: segmentos TCP livres
 #define LINK_STATS                  0           // Desabilita estatísticas de link
 
 #endif // __LWIPOPTS_H__
\ No newline at end of file
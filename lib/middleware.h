@@ -0,0 +1,66 @@
+#ifndef MIDDLEWARE_H
+#define MIDDLEWARE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lwip/ip_addr.h"
+#include "middleware_config.h"
+#include "routes.h"
+
+#define MIDDLEWARE_ENABLED (MIDDLEWARE_ACCESS_LOG || MIDDLEWARE_ADMIN_AUTH || \
+                            MIDDLEWARE_METRICS || MIDDLEWARE_RATE_LIMIT)
+
+// Dados da requisição compartilhados pelas etapas pré e pós
+typedef struct {
+    const char *request;            // Linha inicial e cabeçalhos
+    route_id_t route;
+    const ip_addr_t *remote;
+    bool control;                   // Recebida na porta de controle
+    uint32_t start_us;              // Chegada do primeiro byte da requisição
+} http_context_t;
+
+// Etapa pré: retorna false se já definiu a resposta (a rota não é chamada)
+typedef bool (*middleware_pre_fn)(http_context_t *ctx, http_response_t *response);
+
+// Etapa pós: observa a resposta pronta, antes do envio
+typedef void (*middleware_post_fn)(const http_context_t *ctx, const http_response_t *response);
+
+typedef struct {
+    uint32_t requests;
+    uint32_t errors;                // Respostas 4xx e 5xx
+    uint32_t total_us;
+    uint32_t max_us;
+} route_metrics_t;
+
+#if MIDDLEWARE_RATE_LIMIT
+bool middleware_accept(const ip_addr_t *remote);
+#else
+static inline bool middleware_accept(const ip_addr_t *remote) {
+    (void)remote;
+    return true;
+}
+#endif
+
+#if MIDDLEWARE_ENABLED
+bool middleware_pre(http_context_t *ctx, http_response_t *response);
+
+void middleware_post(const http_context_t *ctx, const http_response_t *response);
+#else
+// Sem etapas habilitadas o pipeline some do binário
+static inline bool middleware_pre(http_context_t *ctx, http_response_t *response) {
+    (void)ctx;
+    (void)response;
+    return true;
+}
+
+static inline void middleware_post(const http_context_t *ctx, const http_response_t *response) {
+    (void)ctx;
+    (void)response;
+}
+#endif
+
+#if MIDDLEWARE_METRICS
+const route_metrics_t *middleware_metrics(route_id_t route);
+#endif
+
+#endif // MIDDLEWARE_H
@@ -0,0 +1,34 @@
+#ifndef MIDDLEWARE_CONFIG_H
+#define MIDDLEWARE_CONFIG_H
+
+// Etapas do middleware HTTP (0 remove a etapa do binário); podem vir
+// também das definições de compilação (ex: -DMIDDLEWARE_ACCESS_LOG=0)
+#ifndef MIDDLEWARE_ACCESS_LOG
+#define MIDDLEWARE_ACCESS_LOG   1       // Uma linha de log por requisição
+#endif
+#ifndef MIDDLEWARE_ADMIN_AUTH
+#define MIDDLEWARE_ADMIN_AUTH   1       // Basic auth nas rotas com ROUTE_FLAG_ADMIN
+#endif
+#ifndef MIDDLEWARE_METRICS
+#define MIDDLEWARE_METRICS      1       // Contadores e tempos por rota
+#endif
+#ifndef MIDDLEWARE_RATE_LIMIT
+#define MIDDLEWARE_RATE_LIMIT   1       // Limite de conexões e requisições por cliente (IP)
+#endif
+
+// Credenciais das rotas de administração
+#define ADMIN_USER      "admin"
+#define ADMIN_PASS      "password"
+#define ADMIN_REALM     "pico"
+
+// Limite por cliente: taxa sustentada (por segundo) e rajada máxima de cada classe
+#define RATE_LIMIT_CONNECT_PER_S    8
+#define RATE_LIMIT_CONNECT_BURST    16
+#define RATE_LIMIT_PROBE_PER_S      2
+#define RATE_LIMIT_PROBE_BURST      6
+#define RATE_LIMIT_ASSET_PER_S      10
+#define RATE_LIMIT_ASSET_BURST      30
+#define RATE_LIMIT_CONTROL_PER_S    2
+#define RATE_LIMIT_CONTROL_BURST    5
+
+#endif // MIDDLEWARE_CONFIG_H
@@ -0,0 +1,63 @@
+#ifndef MULTIPART_H
+#define MULTIPART_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MULTIPART_MAX_BOUNDARY      70      // Limite da RFC 2046
+#define MULTIPART_MAX_HEADER_LINE   256     // Maior linha de cabeçalho aceita por parte
+
+#define MULTIPART_OK                0
+#define MULTIPART_ERR_BOUNDARY      -1      // Boundary ausente ou longo demais
+#define MULTIPART_ERR_SYNTAX        -2      // Corpo fora do formato multipart
+#define MULTIPART_ERR_HEADER        -3      // Linha de cabeçalho longa demais
+#define MULTIPART_ERR_ABORTED       -4      // Callback solicitou o cancelamento
+
+/**
+ * Callbacks chamados conforme o corpo é consumido. Um retorno diferente
+ * de zero interrompe o parser (ex: falha de escrita no destino).
+ */
+typedef struct {
+    int (*on_header)(void *ctx, const char *name, const char *value);
+    int (*on_part_begin)(void *ctx);
+    int (*on_part_data)(void *ctx, const uint8_t *data, size_t len);
+    int (*on_part_end)(void *ctx);
+} multipart_callbacks_t;
+
+typedef enum {
+    MULTIPART_STATE_PREAMBLE,
+    MULTIPART_STATE_BOUNDARY_TAIL,
+    MULTIPART_STATE_HEADERS,
+    MULTIPART_STATE_DATA,
+    MULTIPART_STATE_DONE,
+    MULTIPART_STATE_ERROR
+} multipart_state_t;
+
+typedef struct {
+    multipart_state_t state;
+    const multipart_callbacks_t *cb;
+    void *ctx;
+    uint8_t delim[MULTIPART_MAX_BOUNDARY + 4];      // "\r\n--" + boundary
+    uint8_t fail[MULTIPART_MAX_BOUNDARY + 5];       // Tabela de falhas (KMP)
+    uint8_t delim_len;
+    uint8_t match;                                  // Bytes do delimitador já casados
+    uint8_t tail_len;
+    char tail[2];
+    char line[MULTIPART_MAX_HEADER_LINE];
+    uint16_t line_len;
+    bool in_part;
+} multipart_parser_t;
+
+int multipart_init(multipart_parser_t *mp, const char *boundary, size_t boundary_len,
+                   const multipart_callbacks_t *cb, void *ctx);
+
+int multipart_feed(multipart_parser_t *mp, const uint8_t *data, size_t len);
+
+bool multipart_is_done(const multipart_parser_t *mp);
+
+const char *multipart_find_boundary(const char *content_type, size_t len, size_t *boundary_len);
+
+size_t multipart_header_param(const char *value, const char *param, char *out, size_t out_size);
+
+#endif // MULTIPART_H
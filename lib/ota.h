@@ -0,0 +1,18 @@
+#ifndef OTA_H
+#define OTA_H
+
+#include <stdint.h>
+#include "routes.h"
+#include "flash_backend.h"
+
+#define OTA_ERASE_AHEAD         (4 * FLASH_BACKEND_SECTOR)  // Apagado à frente da gravação
+#define OTA_INSTALL_DELAY_MS    1000                        // Tempo para a resposta chegar ao cliente
+#define OTA_HASH_HEADER         "X-Firmware-SHA256"
+
+void ota_set_backend(const flash_backend_t *flash);
+
+body_route_result_t ota_begin(const char *request, http_body_handler_t *handler, http_response_t *response);
+
+void ota_poll(uint32_t now_ms);
+
+#endif // OTA_H
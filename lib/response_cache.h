@@ -0,0 +1,25 @@
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "http_response.h"
+#include "routes.h"
+
+#define RESPONSE_CACHE_BYTES    1024    // Orçamento fixo para os corpos em cache
+#define RESPONSE_CACHE_ENTRIES  6
+#define RESPONSE_CACHE_MAX_QUERY_PARAMS 8
+
+// Marcadores de invalidação: o que cada resposta em cache exibe
+#define CACHE_TAG_ALARM     0x01
+
+uint32_t response_cache_key(route_id_t route, const char *request);
+
+bool response_cache_serve(route_id_t route, const char *request, http_response_t *response);
+
+bool response_cache_store(route_id_t route, const char *request, uint8_t tags, uint32_t ttl_ms,
+                          const char *content_type, const http_response_t *response);
+
+void response_cache_invalidate(uint8_t tags);
+
+#endif // RESPONSE_CACHE_H
@@ -0,0 +1,66 @@
+#ifndef ROMFS_H
+#define ROMFS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Formato da imagem gerada por tools/mkromfs.py (little-endian):
+//  - romfs_header_t;
+//  - `count` entradas romfs_entry_t, ordenadas pelo nome (memcmp);
+//  - nomes (sem '/' inicial, terminados em '\0');
+//  - dados dos arquivos, alinhados a ROMFS_ALIGN bytes.
+#define ROMFS_MAGIC         "RFS1"
+#define ROMFS_VERSION       1
+#define ROMFS_ALIGN         4
+#define ROMFS_MAX_PATH      128
+
+#define ROMFS_FLAG_GZIP     0x01        // Dados já comprimidos com gzip
+
+enum {
+    ROMFS_OK = 0,
+    ROMFS_ERR_MAGIC = -1,               // Região vazia ou imagem de outro formato
+    ROMFS_ERR_VERSION = -2,
+    ROMFS_ERR_BOUNDS = -3,              // Entrada aponta para fora da imagem
+    ROMFS_ERR_ORDER = -4                // Diretório fora de ordem (busca binária falharia)
+};
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t count;
+    uint32_t image_size;
+    uint32_t reserved;
+} romfs_header_t;
+
+typedef struct {
+    uint32_t name_offset;
+    uint16_t name_len;                  // Sem o '\0'
+    uint8_t mime;                       // Índice em `romfs_mime_type`
+    uint8_t flags;                      // ROMFS_FLAG_*
+    uint32_t data_offset;
+    uint32_t data_size;
+} romfs_entry_t;
+
+// Imagem montada: aponta para a flash (XIP) ou para um arquivo mapeado
+typedef struct {
+    const uint8_t *base;
+    uint32_t size;
+    uint16_t count;
+    const romfs_entry_t *dir;
+} romfs_t;
+
+typedef struct {
+    const uint8_t *data;                // Direto na imagem, sem cópia
+    uint32_t size;
+    uint8_t mime;
+    uint8_t flags;
+} romfs_file_t;
+
+int romfs_mount(romfs_t *fs, const void *image, size_t size);
+
+bool romfs_find(const romfs_t *fs, const char *path, size_t path_len, romfs_file_t *file);
+
+const char *romfs_mime_type(uint8_t mime);
+
+#endif // ROMFS_H
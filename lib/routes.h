@@ -1,14 +1,58 @@
 #ifndef ROUTES_H
 #define ROUTES_H
 
+#include <stdint.h>
 #include "http_utils.h"
 #include "http_response.h"
 
+#define ROUTE_FLAG_ADMIN    0x01    // Exige autenticação (middleware de admin)
+
+typedef enum {
+    ROUTE_NOT_FOUND = 0,
+    ROUTE_ROOT,
+    ROUTE_ALARM_ON,
+    ROUTE_ALARM_OFF,
+    ROUTE_CLIENTS,
+    ROUTE_API_STATUS,
+    ROUTE_API_CLIENTS,
+    ROUTE_API_METRICS,
+    ROUTE_API_SEND_METRICS,
+    ROUTE_API_DNS_METRICS,
+    ROUTE_API_ALARM,
+    ROUTE_UPLOAD,
+    ROUTE_OTA,
+    ROUTE_STATIC,           // Arquivo da ROMFS (sem entrada fixa na tabela)
+    ROUTE_COUNT
+} route_id_t;
+
 typedef struct{
     const char *path;
     size_t length;
+    uint8_t flags;
 } route_info_t;
 
-void handle_route(const char *request, http_response_t *response);
+// Consumidor do corpo de uma requisição, alimentado pedaço a pedaço
+typedef struct {
+    int (*on_data)(void *ctx, const uint8_t *data, size_t len);
+    void (*on_end)(void *ctx, int status, http_response_t *response);
+    void (*on_abort)(void *ctx);
+    void *ctx;
+} http_body_handler_t;
+
+typedef enum {
+    BODY_ROUTE_NONE,        // Rota sem corpo: usar handle_route
+    BODY_ROUTE_ACCEPTED,    // Corpo será entregue ao handler
+    BODY_ROUTE_REJECTED     // Resposta de erro já definida
+} body_route_result_t;
+
+route_id_t route_match(const char *request);
+
+route_id_t route_match_control(const char *request);
+
+const route_info_t *route_get_info(route_id_t route);
+
+void handle_route(route_id_t route, const char *request, http_response_t *response);
+
+body_route_result_t handle_body_route(route_id_t route, const char *request, http_body_handler_t *handler, http_response_t *response);
 
 #endif // ROUTES_H
@@ -3,10 +3,14 @@
 
 #include "dhcpserver.h"
 #include "dnsserver.h"
+#include "blocklist.h"
+#include "romfs.h"
 #include "lwip/ip_addr.h"
 
 extern dhcp_server_t dhcp_server;
 extern dns_server_t dns_server;
+extern romfs_t romfs;
+extern blocklist_t blocklist;
 
 int network_setup(void);
 
@@ -0,0 +1,36 @@
+#ifndef SINGLE_FLIGHT_H
+#define SINGLE_FLIGHT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "http_stream.h"
+
+#define SINGLE_FLIGHT_MAX           2       // Gerações compartilhadas simultâneas
+#define SINGLE_FLIGHT_MAX_SEGMENTS  4       // Blocos guardados por geração (~2 KiB); além disso, em janela
+
+// Bloco imutável produzido pelo gerador, compartilhado pelas conexões
+typedef struct flight_segment_t_ {
+    struct flight_segment_t_ *next;
+    uint16_t seq;                   // Posição na resposta (0, 1, ...)
+    uint8_t released;               // Conexões que já o devolveram
+    uint16_t len;
+    char data[];
+} flight_segment_t;
+
+typedef struct flight_t_ flight_t;
+
+flight_t *single_flight_join(uint32_t key, http_stream_fill_fn fill, void *ctx, bool gzip);
+
+const flight_segment_t *single_flight_next(flight_t *flight, uint16_t seq);
+
+void single_flight_release(flight_t *flight, uint16_t from, uint16_t to);
+
+bool single_flight_finished(const flight_t *flight);
+
+bool single_flight_failed(const flight_t *flight);
+
+bool single_flight_compressed(flight_t *flight);
+
+void single_flight_leave(flight_t *flight, uint16_t released);
+
+#endif // SINGLE_FLIGHT_H
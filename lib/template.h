@@ -0,0 +1,57 @@
+#ifndef TEMPLATE_H
+#define TEMPLATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TEMPLATE_MAX_SLOTS      8       // Slots distintos por template
+#define TEMPLATE_SLOT_BUFFER    160     // Bytes para os valores formatados dos slots
+
+typedef enum {
+    TEMPLATE_SEGMENT_STATIC,            // Texto fixo, referenciado direto da flash
+    TEMPLATE_SLOT_STR,                  // const char*, com escape HTML
+    TEMPLATE_SLOT_RAW,                  // const char*, sem escape
+    TEMPLATE_SLOT_INT,                  // int32_t
+    TEMPLATE_SLOT_UINT                  // uint32_t
+} template_segment_type_t;
+
+// Gerados por tools/compile_templates.py a partir de pages/*.html
+typedef struct {
+    const char *data;
+    uint16_t len;
+    uint8_t type;                       // template_segment_type_t
+    uint8_t slot;                       // Índice do slot (segmentos dinâmicos)
+} template_segment_t;
+
+typedef struct {
+    const template_segment_t *segments;
+    uint16_t segment_count;
+    uint8_t slot_count;
+    const uint8_t *slot_types;
+    uint32_t static_len;
+} template_t;
+
+typedef union {
+    const char *str;                    // Deve continuar válido até o envio (ex: literal)
+    int32_t i;
+    uint32_t u;
+} template_value_t;
+
+// Estado de envio de um template; os slots são formatados uma única vez
+typedef struct {
+    const template_t *tpl;
+    uint16_t segment;
+    uint16_t offset;
+    uint16_t slot_start[TEMPLATE_MAX_SLOTS + 1];
+    char slots[TEMPLATE_SLOT_BUFFER];
+} template_render_t;
+
+long template_render_begin(template_render_t *render, const template_t *tpl, const template_value_t *values);
+
+bool template_render_peek(const template_render_t *render, size_t max_len,
+                          const char **data, size_t *len, bool *copy);
+
+void template_render_advance(template_render_t *render, size_t len);
+
+#endif // TEMPLATE_H
@@ -0,0 +1,21 @@
+#ifndef UPLOAD_H
+#define UPLOAD_H
+
+#include <stdbool.h>
+#include "routes.h"
+
+#define UPLOAD_MAX_FILENAME 64
+
+// Destino dos dados de cada parte recebida (gravação em flash, checksum, ...)
+typedef struct {
+    int (*open)(void *ctx, const char *field, const char *filename);
+    int (*write)(void *ctx, const uint8_t *data, size_t len);
+    int (*close)(void *ctx, bool ok);
+    void *ctx;
+} upload_sink_t;
+
+body_route_result_t upload_begin(const char *request, http_body_handler_t *handler, http_response_t *response);
+
+void upload_set_sink(const upload_sink_t *sink);
+
+#endif // UPLOAD_H
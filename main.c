@@ -6,6 +6,7 @@
 #include "pico/stdlib.h"
 #include "pico/cyw43_arch.h"
 #include "setup.h"
+#include "ota.h"
 
 
 int main() {
@@ -19,6 +20,14 @@ int main() {
     if(network_setup()) return 1;
 
     while (true) {
+        // Apagamentos à frente e instalação da OTA, fora dos callbacks de rede;
+        // timeouts e upstream do repasse DNS
+        uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+        cyw43_arch_lwip_begin();
+        ota_poll(now_ms);
+        dns_server_poll(&dns_server, now_ms);
+        cyw43_arch_lwip_end();
+
         tight_loop_contents();
         sleep_ms(1);
     }
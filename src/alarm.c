@@ -0,0 +1,79 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: alarm.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Este módulo mantém o estado do alarme de evacuação,
+ *      alterado pelas rotas de controle e exibido na página inicial.
+ *      O alarme pode ser ligado por tempo determinado; o desligamento
+ *      automático é verificado sempre que o estado é consultado.
+ */
+#include "alarm.h"
+#include "response_cache.h"
+#include "pico/time.h"
+#include <stdio.h>
+
+static bool alarm_active = false;
+static bool alarm_timed = false;            // Há prazo para desligar
+static absolute_time_t alarm_off_at;
+
+/**
+ * [Descrição]: Liga ou desliga o alarme.
+ * [Parâmetros]:
+ *  - bool active: true para ligar, false para desligar;
+ * [Notas]: 
+ *  - Registra no log apenas as mudanças de estado.
+ *  - Invalida as respostas em cache que exibem o alarme.
+ */
+void alarm_set_active(bool active) {
+    alarm_timed = false;
+    if (alarm_active != active) {
+        alarm_active = active;
+        response_cache_invalidate(CACHE_TAG_ALARM);
+        printf("Alarme %s\n", active ? "ligado" : "desligado");
+    }
+}
+
+/**
+ * [Descrição]: Liga o alarme por um tempo determinado.
+ * [Parâmetros]:
+ *  - uint32_t duration_s: duração em segundos; 0 liga sem prazo;
+ * [Notas]: Substitui qualquer prazo anterior.
+ */
+void alarm_activate_for(uint32_t duration_s) {
+    alarm_set_active(true);
+    if (duration_s > 0) {
+        alarm_timed = true;
+        alarm_off_at = make_timeout_time_ms(duration_s * 1000ull);
+    }
+}
+
+/**
+ * [Descrição]: Informa se o alarme está ligado.
+ * [Parâmetros]:
+ *  - nenhum
+ * [Notas]: Desliga o alarme se o prazo definido em `alarm_activate_for` já passou.
+ */
+bool alarm_is_active(void) {
+    if (alarm_timed && time_reached(alarm_off_at)) {
+        alarm_set_active(false);
+    }
+    return alarm_active;
+}
+
+/**
+ * [Descrição]: Informa quantos segundos faltam para o alarme desligar sozinho.
+ * [Parâmetros]:
+ *  - nenhum
+ * [Notas]: Retorna 0 se o alarme estiver desligado ou ligado sem prazo.
+ */
+uint32_t alarm_remaining_s(void) {
+    if (!alarm_is_active() || !alarm_timed) {
+        return 0;
+    }
+    int64_t remaining_us = absolute_time_diff_us(get_absolute_time(), alarm_off_at);
+    return remaining_us > 0 ? (uint32_t)((remaining_us + 999999) / 1000000) : 0;
+}
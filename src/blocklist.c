@@ -0,0 +1,187 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: blocklist.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Este módulo lê a lista de domínios bloqueados gerada por
+ *      `tools/mkblocklist.py` e gravada na flash (ver `flash_layout.h`).
+ *      A imagem é usada no lugar, pelo mapa XIP, e nada vai para a RAM.
+ *
+ *      Um filtro de Bloom responde quase todas as consultas de nomes
+ *      fora da lista lendo poucos bits. Só quando todos os bits estão
+ *      ligados o nome é confirmado contra os nomes do seu balde (em
+ *      média 4), então um falso positivo do filtro nunca bloqueia.
+ *
+ *      Bloquear um domínio bloqueia também seus subdomínios: cada sufixo
+ *      do nome consultado é verificado.
+ *
+ *      O módulo não depende do SDK; a imagem pode vir de qualquer
+ *      região de memória (ex: um arquivo mapeado no computador).
+ */
+#include "blocklist.h"
+#include <string.h>
+
+// Minúscula ASCII; bytes de tamanho de rótulo (<= 63) não são afetados
+static uint8_t fold(uint8_t c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+// FNV-1a de 32 bits, sem distinguir maiúsculas (mesmo de tools/mkblocklist.py)
+static uint32_t name_hash(const uint8_t *name, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ fold(name[i])) * 16777619u;
+    }
+    return h;
+}
+
+// Mapeia um hash para [0, n) sem divisão
+static uint32_t hash_range(uint32_t h, uint32_t n) {
+    return (uint32_t)(((uint64_t)h * n) >> 32);
+}
+
+/**
+ * [Descrição]: Retorna o tamanho de um nome em formato wire.
+ * [Parâmetros]:
+ *  - const uint8_t *name: início do nome;
+ *  - size_t max: bytes disponíveis;
+ * [Notas]: Retorna 0 se o nome for inválido ou não terminar em `max` bytes.
+ */
+static size_t wire_name_len(const uint8_t *name, size_t max) {
+    size_t off = 0;
+    while (off < max && off < BLOCKLIST_NAME_MAX) {
+        uint8_t label_len = name[off];
+        if (label_len == 0) {
+            return off + 1;
+        }
+        if (label_len > 63) {
+            return 0;
+        }
+        off += label_len + 1;
+    }
+    return 0;
+}
+
+/**
+ * [Descrição]: Valida uma imagem e prepara a estrutura para buscas.
+ * [Parâmetros]:
+ *  - blocklist_t *bl: estrutura a preencher;
+ *  - const void *image: início da imagem (alinhado a 4 bytes);
+ *  - size_t size: tamanho da região que contém a imagem;
+ * [Notas]:
+ *  - Retorna BLOCKLIST_OK ou um BLOCKLIST_ERR_*; em erro, `bl` fica
+ *    vazio e nenhum nome é bloqueado.
+ *  - Baldes e nomes são conferidos aqui, uma vez; as buscas seguintes
+ *    não precisam revalidar limites.
+ */
+int blocklist_mount(blocklist_t *bl, const void *image, size_t size) {
+    const blocklist_header_t *header = image;
+    memset(bl, 0, sizeof(*bl));
+
+    if (size < sizeof(*header) || memcmp(header->magic, BLOCKLIST_MAGIC, sizeof(header->magic)) != 0) {
+        return BLOCKLIST_ERR_MAGIC;
+    }
+    if (header->version != BLOCKLIST_VERSION) {
+        return BLOCKLIST_ERR_VERSION;
+    }
+
+    uint64_t names_offset = sizeof(*header) + (uint64_t)header->bloom_bits / 8 +
+                            ((uint64_t)header->bucket_count + 1) * sizeof(uint32_t);
+    if (header->image_size > size || names_offset > header->image_size ||
+        header->hash_count == 0 || header->hash_count > BLOCKLIST_MAX_HASHES ||
+        header->bloom_bits == 0 || header->bloom_bits % 32 != 0 || header->bucket_count == 0) {
+        return BLOCKLIST_ERR_BOUNDS;
+    }
+
+    const uint8_t *base = image;
+    const uint32_t *buckets = (const uint32_t *)(base + sizeof(*header) + header->bloom_bits / 8);
+    if (buckets[0] != names_offset || buckets[header->bucket_count] != header->image_size) {
+        return BLOCKLIST_ERR_BOUNDS;
+    }
+    for (uint32_t b = 0; b < header->bucket_count; b++) {
+        if (buckets[b + 1] < buckets[b]) {
+            return BLOCKLIST_ERR_BOUNDS;
+        }
+        for (uint32_t off = buckets[b]; off < buckets[b + 1];) {
+            size_t len = wire_name_len(base + off, buckets[b + 1] - off);
+            if (len == 0) {
+                return BLOCKLIST_ERR_BOUNDS;
+            }
+            off += len;
+        }
+    }
+
+    bl->base = base;
+    bl->bloom = (const uint32_t *)(base + sizeof(*header));
+    bl->buckets = buckets;
+    bl->bloom_bits = header->bloom_bits;
+    bl->bucket_count = header->bucket_count;
+    bl->count = header->count;
+    bl->hash_count = header->hash_count;
+    return BLOCKLIST_OK;
+}
+
+/**
+ * [Descrição]: Verifica se um nome exato está na lista.
+ * [Parâmetros]:
+ *  - const blocklist_t *bl: imagem montada;
+ *  - const uint8_t *name: nome em formato wire (qualquer caixa);
+ *  - size_t len: tamanho, com o 0 final;
+ * [Notas]: Para no primeiro bit desligado do filtro.
+ */
+static bool blocklist_contains_exact(const blocklist_t *bl, const uint8_t *name, size_t len) {
+    uint32_t h = name_hash(name, len);
+    uint32_t step = (h >> 17 | h << 15) | 1;
+
+    uint32_t g = h;
+    for (uint8_t i = 0; i < bl->hash_count; i++, g += step) {
+        uint32_t bit = hash_range(g, bl->bloom_bits);
+        if (!(bl->bloom[bit >> 5] >> (bit & 31) & 1)) {
+            return false;
+        }
+    }
+
+    uint32_t b = hash_range(h, bl->bucket_count);
+    for (uint32_t off = bl->buckets[b]; off < bl->buckets[b + 1];) {
+        const uint8_t *stored = bl->base + off;
+        size_t stored_len = wire_name_len(stored, bl->buckets[b + 1] - off);
+        if (stored_len == len) {
+            size_t i = 0;
+            while (i < len && stored[i] == fold(name[i])) {
+                i++;
+            }
+            if (i == len) {
+                return true;
+            }
+        }
+        off += stored_len;
+    }
+    return false;
+}
+
+/**
+ * [Descrição]: Verifica se um nome, ou um domínio acima dele, está bloqueado.
+ * [Parâmetros]:
+ *  - const blocklist_t *bl: imagem montada (ou vazia);
+ *  - const uint8_t *name: nome em formato wire, já validado (qualquer caixa);
+ *  - size_t len: tamanho, com o 0 final;
+ * [Notas]:
+ *  - `a.b.exemplo.com` testa `a.b.exemplo.com`, `b.exemplo.com`,
+ *    `exemplo.com` e `com`; a raiz não é testada.
+ *  - Um nome fora da lista custa, por sufixo, um hash e em geral um ou
+ *    dois bits do filtro lidos da flash.
+ */
+bool blocklist_contains(const blocklist_t *bl, const uint8_t *name, size_t len) {
+    if (bl->count == 0) {
+        return false;
+    }
+    for (size_t off = 0; off + 1 < len; off += name[off] + 1) {
+        if (blocklist_contains_exact(bl, name + off, len - off)) {
+            return true;
+        }
+    }
+    return false;
+}
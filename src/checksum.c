@@ -0,0 +1,197 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: checksum.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Este módulo implementa o CRC-32 (IEEE 802.3) e o SHA-256
+ *      (FIPS 180-4) de forma incremental, para verificar dados
+ *      recebidos em pedaços sem precisar armazená-los.
+ *
+ *      Também calcula o CRC-32/MPEG-2, que a ROM de boot do RP2040
+ *      usa para validar o boot2 de uma imagem de firmware.
+ */
+#include "checksum.h"
+#include <string.h>
+
+/**
+ * [Descrição]: Atualiza um CRC-32 com mais um bloco de dados.
+ * [Parâmetros]:
+ *  - uint32_t crc: valor acumulado (inicie com CRC32_INIT);
+ *  - const uint8_t *data: bloco de dados;
+ *  - size_t len: tamanho do bloco;
+ * [Notas]:
+ *  - Usa tabela de 16 entradas (64 bytes) em vez de 256 para
+ *    economizar memória, processando meio byte por vez.
+ */
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t len) {
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+        0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+
+    while (len--) {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+    }
+    return crc;
+}
+
+/**
+ * [Descrição]: Finaliza o cálculo do CRC-32.
+ * [Parâmetros]:
+ *  - uint32_t crc: valor acumulado por `crc32_update`;
+ * [Notas]: Retorna o CRC no formato padrão (complementado).
+ */
+uint32_t crc32_final(uint32_t crc) {
+    return crc ^ 0xFFFFFFFFu;
+}
+
+/**
+ * [Descrição]: Calcula o CRC-32/MPEG-2 de um bloco.
+ * [Parâmetros]:
+ *  - const uint8_t *data: bloco de dados;
+ *  - size_t len: tamanho do bloco;
+ * [Notas]:
+ *  - Mesmo polinômio do CRC-32, mas sem reflexão e sem complemento no fim.
+ *  - Bit a bit: é usado só sobre os 252 bytes do boot2, uma vez por OTA.
+ */
+uint32_t crc32_mpeg2(const uint8_t *data, size_t len) {
+    uint32_t crc = CRC32_INIT;
+
+    while (len--) {
+        crc ^= (uint32_t)*data++ << 24;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = crc & 0x80000000u ? (crc << 1) ^ 0x04C11DB7u : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static uint32_t rotr(uint32_t x, unsigned n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+/**
+ * [Descrição]: Processa um bloco de 64 bytes.
+ * [Parâmetros]:
+ *  - sha256_t *sha: estado;
+ *  - const uint8_t *block: bloco;
+ * [Notas]: Agenda de mensagem em janela de 16 palavras (64 bytes de pilha).
+ */
+static void sha256_block(sha256_t *sha, const uint8_t *block) {
+    uint32_t w[16];
+    uint32_t a = sha->state[0], b = sha->state[1], c = sha->state[2], d = sha->state[3];
+    uint32_t e = sha->state[4], f = sha->state[5], g = sha->state[6], h = sha->state[7];
+
+    for (int i = 0; i < 64; i++) {
+        uint32_t word;
+        if (i < 16) {
+            word = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 |
+                   (uint32_t)block[4 * i + 2] << 8 | block[4 * i + 3];
+        } else {
+            uint32_t w15 = w[(i - 15) & 15], w2 = w[(i - 2) & 15];
+            uint32_t s0 = rotr(w15, 7) ^ rotr(w15, 18) ^ (w15 >> 3);
+            uint32_t s1 = rotr(w2, 17) ^ rotr(w2, 19) ^ (w2 >> 10);
+            word = w[i & 15] + s0 + w[(i - 7) & 15] + s1;
+        }
+        w[i & 15] = word;
+
+        uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + sha256_k[i] + word;
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+
+    sha->state[0] += a; sha->state[1] += b; sha->state[2] += c; sha->state[3] += d;
+    sha->state[4] += e; sha->state[5] += f; sha->state[6] += g; sha->state[7] += h;
+}
+
+/**
+ * [Descrição]: Inicia um cálculo de SHA-256.
+ * [Parâmetros]:
+ *  - sha256_t *sha: estado;
+ * [Notas]: Nenhuma.
+ */
+void sha256_init(sha256_t *sha) {
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(sha->state, initial, sizeof(initial));
+    sha->total = 0;
+}
+
+/**
+ * [Descrição]: Acrescenta dados ao SHA-256.
+ * [Parâmetros]:
+ *  - sha256_t *sha: estado;
+ *  - const uint8_t *data: bloco de dados;
+ *  - size_t len: tamanho do bloco;
+ * [Notas]: Blocos completos são processados direto da entrada, sem cópia.
+ */
+void sha256_update(sha256_t *sha, const uint8_t *data, size_t len) {
+    size_t used = sha->total % 64;
+    sha->total += len;
+
+    if (used > 0) {
+        size_t n = 64 - used < len ? 64 - used : len;
+        memcpy(sha->block + used, data, n);
+        data += n;
+        len -= n;
+        if (used + n < 64) {
+            return;
+        }
+        sha256_block(sha, sha->block);
+    }
+    for (; len >= 64; data += 64, len -= 64) {
+        sha256_block(sha, data);
+    }
+    memcpy(sha->block, data, len);
+}
+
+/**
+ * [Descrição]: Finaliza o SHA-256.
+ * [Parâmetros]:
+ *  - sha256_t *sha: estado (não pode mais ser atualizado);
+ *  - uint8_t digest[]: recebe os 32 bytes do resumo;
+ * [Notas]: Aplica o preenchimento com o tamanho total em bits.
+ */
+void sha256_final(sha256_t *sha, uint8_t digest[SHA256_DIGEST_SIZE]) {
+    uint64_t bits = sha->total * 8;
+    size_t used = sha->total % 64;
+
+    sha->block[used++] = 0x80;
+    if (used > 56) {
+        memset(sha->block + used, 0, 64 - used);
+        sha256_block(sha, sha->block);
+        used = 0;
+    }
+    memset(sha->block + used, 0, 56 - used);
+    for (int i = 0; i < 8; i++) {
+        sha->block[56 + i] = (uint8_t)(bits >> (56 - 8 * i));
+    }
+    sha256_block(sha, sha->block);
+
+    for (int i = 0; i < 8; i++) {
+        digest[4 * i] = (uint8_t)(sha->state[i] >> 24);
+        digest[4 * i + 1] = (uint8_t)(sha->state[i] >> 16);
+        digest[4 * i + 2] = (uint8_t)(sha->state[i] >> 8);
+        digest[4 * i + 3] = (uint8_t)sha->state[i];
+    }
+}
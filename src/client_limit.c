@@ -0,0 +1,140 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: client_limit.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Este módulo mantém um token bucket por cliente e por classe de
+ *      requisição, para que um único celular ou script não esgote o
+ *      servidor para os demais.
+ *
+ *      Os clientes recebem IP do servidor DHCP, em um bloco fixo de
+ *      DHCPS_MAX_IP endereços da sub-rede dele; o último octeto indexa
+ *      a tabela direto (O(1), sem hash nem colisões). Endereços fora do
+ *      bloco (outra sub-rede, IP fixo, IPv6) vão, por hash, para uma de
+ *      CLIENT_OFFNET_BUCKETS entradas próprias: não dividem a vaga de
+ *      uma concessão nem ficam todos num só balde. A memória é fixa:
+ *      CLIENT_LIMIT_ENTRIES clientes x CLIENT_CLASS_COUNT classes x 8 bytes.
+ *
+ *      A mesma tabela conta as conexões abertas de cada cliente, usadas
+ *      pelo servidor para limitar conexões paralelas por IP.
+ */
+#include "client_limit.h"
+
+// Fichas em milésimos, para reposição sem arredondamento
+#define TOKEN_UNIT 1000u
+
+// Guarda o consumo (déficit) em vez do saldo: zerado equivale a balde cheio
+typedef struct {
+    uint32_t last_ms;
+    uint32_t deficit;
+} client_bucket_t;
+
+static client_bucket_t buckets[CLIENT_LIMIT_ENTRIES][CLIENT_CLASS_COUNT];
+static uint8_t open_connections[CLIENT_LIMIT_ENTRIES];
+static const dhcp_server_t *dhcp_server_ref;    // NULL = nenhum IP é de concessão
+
+/**
+ * [Descrição]: Define o servidor DHCP cujas concessões têm entrada própria.
+ * [Parâmetros]:
+ *  - const dhcp_server_t *dhcp: servidor já iniciado (IP e máscara definidos);
+ * [Notas]: Sem ele, todos os clientes caem nas entradas por hash.
+ */
+void client_limit_set_dhcp(const dhcp_server_t *dhcp) {
+    dhcp_server_ref = dhcp;
+}
+
+/**
+ * [Descrição]: Converte o IP do cliente no índice da tabela.
+ * [Parâmetros]:
+ *  - const ip_addr_t *remote: endereço do cliente;
+ * [Notas]: 
+ *  - Só um IP da sub-rede do DHCP (IP e máscara do servidor), dentro
+ *    do bloco de concessões, usa o último octeto: 192.168.7.16 não é a
+ *    concessão de 192.168.4.16.
+ *  - Os demais vão para DHCPS_MAX_IP + hash do endereço.
+ */
+unsigned client_limit_index(const ip_addr_t *remote) {
+    if (!remote || !IP_IS_V4(remote)) {
+        return DHCPS_MAX_IP;
+    }
+    const ip4_addr_t *addr = ip_2_ip4(remote);
+    if (dhcp_server_ref) {
+        const ip4_addr_t *ip = ip_2_ip4(&dhcp_server_ref->ip);
+        const ip4_addr_t *nm = ip_2_ip4(&dhcp_server_ref->nm);
+        unsigned last = ip4_addr4(addr);
+        if (ip4_addr_netcmp(addr, ip, nm) && last >= DHCPS_BASE_IP && last < DHCPS_BASE_IP + DHCPS_MAX_IP) {
+            return last - DHCPS_BASE_IP;
+        }
+    }
+    // Fibonacci hashing: os bits altos do produto misturam todos os octetos
+    uint32_t hash = ip4_addr_get_u32(addr) * 2654435761u;
+    return DHCPS_MAX_IP + (hash >> 16) % CLIENT_OFFNET_BUCKETS;
+}
+
+/**
+ * [Descrição]: Registra uma conexão aberta pelo cliente.
+ * [Parâmetros]:
+ *  - unsigned client: índice retornado por `client_limit_index`;
+ * [Notas]: Cada chamada deve ter um `client_limit_close` correspondente.
+ */
+void client_limit_open(unsigned client) {
+    if (open_connections[client] < UINT8_MAX) {
+        open_connections[client]++;
+    }
+}
+
+/**
+ * [Descrição]: Registra o fechamento de uma conexão do cliente.
+ * [Parâmetros]:
+ *  - unsigned client: índice retornado por `client_limit_index`;
+ * [Notas]: Nenhuma.
+ */
+void client_limit_close(unsigned client) {
+    if (open_connections[client] > 0) {
+        open_connections[client]--;
+    }
+}
+
+/**
+ * [Descrição]: Retorna quantas conexões o cliente mantém abertas.
+ * [Parâmetros]:
+ *  - unsigned client: índice retornado por `client_limit_index`;
+ * [Notas]: Nenhuma.
+ */
+unsigned client_limit_connections(unsigned client) {
+    return open_connections[client];
+}
+
+/**
+ * [Descrição]: Consome uma ficha do balde do cliente na classe dada.
+ * [Parâmetros]:
+ *  - const ip_addr_t *remote: endereço do cliente;
+ *  - client_class_t cls: classe da conexão ou requisição;
+ *  - const client_rate_t *rate: taxa e rajada da classe;
+ *  - uint32_t now_ms: instante atual em ms;
+ *  - uint32_t *retry_after_s: recebe, se recusado, a espera até a próxima ficha;
+ * [Notas]: Retorna false se o cliente estiver acima do limite.
+ */
+bool client_limit_take(const ip_addr_t *remote, client_class_t cls, const client_rate_t *rate,
+                       uint32_t now_ms, uint32_t *retry_after_s) {
+    client_bucket_t *b = &buckets[client_limit_index(remote)][cls];
+    uint32_t capacity = (uint32_t)rate->burst * TOKEN_UNIT;
+
+    uint64_t refill = (uint64_t)(now_ms - b->last_ms) * rate->per_s;
+    b->deficit = refill >= b->deficit ? 0 : b->deficit - (uint32_t)refill;
+    b->last_ms = now_ms;
+
+    if (b->deficit + TOKEN_UNIT <= capacity) {
+        b->deficit += TOKEN_UNIT;
+        return true;
+    }
+    if (retry_after_s) {
+        uint32_t missing = b->deficit + TOKEN_UNIT - capacity;
+        uint32_t per_s = rate->per_s ? rate->per_s : 1;
+        *retry_after_s = (missing + per_s * TOKEN_UNIT - 1) / (per_s * TOKEN_UNIT);
+    }
+    return false;
+}
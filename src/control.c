@@ -0,0 +1,153 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: control.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Este módulo recebe comandos JSON da API de controle do alarme
+ *      (`POST /api/alarme`). O corpo é acumulado em um buffer fixo,
+ *      tokenizado no próprio buffer e lido pelos acessores do
+ *      `json_parser`, sem alocação. Exemplo de comando:
+ *          {"siren": 1, "duration": 30}
+ */
+#include "control.h"
+#include "alarm.h"
+#include "json_parser.h"
+#include "json_writer.h"
+#include <string.h>
+
+#define CONTROL_ERR_TOO_LARGE   -1
+
+typedef struct {
+    bool busy;
+    char body[CONTROL_MAX_BODY];
+    size_t len;
+    char reply[64];
+} control_state_t;
+
+// Comandos são curtos: um único buffer atende uma requisição por vez
+static control_state_t control;
+
+static void set_error(http_response_t *response, int code, const char *reason, const char *message) {
+    set_response_status(response, code, reason);
+    add_response_header(response, "Content-Type", "text/plain; charset=utf-8");
+    set_response_body(response, message);
+}
+
+static int control_on_data(void *ctx, const uint8_t *data, size_t len) {
+    control_state_t *cs = ctx;
+    if (len > sizeof(cs->body) - cs->len) {
+        return CONTROL_ERR_TOO_LARGE;
+    }
+    memcpy(cs->body + cs->len, data, len);
+    cs->len += len;
+    return 0;
+}
+
+/**
+ * [Descrição]: Interpreta o comando e aplica ao alarme.
+ * [Parâmetros]:
+ *  - control_state_t *cs: estado com o corpo completo;
+ *  - http_response_t *response: resposta a preencher;
+ * [Notas]:
+ *  - `siren` (obrigatório) aceita 0/1 ou false/true.
+ *  - `duration` (opcional) é o tempo em segundos; 0 ou ausente liga sem prazo.
+ */
+static void apply_command(control_state_t *cs, http_response_t *response) {
+    json_token_t tokens[CONTROL_MAX_TOKENS];
+    int count = json_parse(cs->body, cs->len, tokens, CONTROL_MAX_TOKENS);
+    if (count < 1 || tokens[0].type != JSON_OBJECT) {
+        set_error(response, 400, "Bad Request", "JSON invalido.");
+        return;
+    }
+
+    bool siren;
+    int32_t value;
+    if (json_get_int(cs->body, tokens, count, 0, "siren", &value)) {
+        siren = value != 0;
+    } else if (!json_get_bool(cs->body, tokens, count, 0, "siren", &siren)) {
+        set_error(response, 400, "Bad Request", "Campo 'siren' ausente ou invalido.");
+        return;
+    }
+
+    int32_t duration = 0;
+    if (json_find_key(cs->body, tokens, count, 0, "duration") >= 0 &&
+        (!json_get_int(cs->body, tokens, count, 0, "duration", &duration) || duration < 0)) {
+        set_error(response, 400, "Bad Request", "Campo 'duration' invalido.");
+        return;
+    }
+
+    if (siren) {
+        alarm_activate_for((uint32_t)duration);
+    } else {
+        alarm_set_active(false);
+    }
+
+    json_writer_t w;
+    json_writer_init(&w, cs->reply, sizeof(cs->reply) - 1);
+    json_begin_object(&w);
+    json_key(&w, "alarme");
+    json_bool(&w, alarm_is_active());
+    json_key(&w, "restante_s");
+    json_uint(&w, alarm_remaining_s());
+    json_end_object(&w);
+    size_t len = json_writer_finish(&w);
+    if (len == 0) {
+        set_error(response, 500, "Internal Server Error", "Erro ao gerar a resposta.");
+        return;
+    }
+    cs->reply[len] = '\0';
+
+    set_response_status(response, 200, "OK");
+    add_response_header(response, "Content-Type", "application/json");
+    set_response_body(response, cs->reply);
+}
+
+static void control_on_end(void *ctx, int status, http_response_t *response) {
+    control_state_t *cs = ctx;
+    if (status == CONTROL_ERR_TOO_LARGE) {
+        set_error(response, 413, "Payload Too Large", "Comando grande demais.");
+    } else if (status != 0) {
+        set_error(response, 400, "Bad Request", "Corpo incompleto.");
+    } else {
+        apply_command(cs, response);
+    }
+    cs->busy = false;
+}
+
+static void control_on_abort(void *ctx) {
+    ((control_state_t *)ctx)->busy = false;
+}
+
+/**
+ * [Descrição]: Prepara o recebimento de um comando JSON.
+ * [Parâmetros]:
+ *  - const char *request: linha inicial e cabeçalhos da requisição;
+ *  - http_body_handler_t *handler: recebe os callbacks do corpo;
+ *  - http_response_t *response: resposta de erro, se recusado;
+ * [Notas]:
+ *  - Recusa com 413 se o Content-Length exceder CONTROL_MAX_BODY.
+ *  - Recusa com 503 se outro comando ainda estiver sendo recebido.
+ */
+body_route_result_t control_begin(const char *request, http_body_handler_t *handler, http_response_t *response) {
+    if (http_content_length(request) > CONTROL_MAX_BODY) {
+        set_error(response, 413, "Payload Too Large", "Comando grande demais.");
+        return BODY_ROUTE_REJECTED;
+    }
+    if (control.busy) {
+        set_error(response, 503, "Service Unavailable", "Outro comando em andamento.");
+        add_response_header(response, "Retry-After", "1");
+        return BODY_ROUTE_REJECTED;
+    }
+
+    control.busy = true;
+    control.len = 0;
+
+    handler->on_data = control_on_data;
+    handler->on_end = control_on_end;
+    handler->on_abort = control_on_abort;
+    handler->ctx = &control;
+    return BODY_ROUTE_ACCEPTED;
+}
@@ -0,0 +1,105 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: flash_pico.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Este módulo implementa o `flash_backend_t` da área de staging
+ *      da OTA sobre a flash do RP2040. Apagar e gravar desligam o XIP,
+ *      então rodam em `flash_safe_execute` (interrupções desabilitadas
+ *      e o outro núcleo parado, se estiver em uso).
+ *
+ *      A instalação copia a imagem do staging para o início da flash
+ *      e reinicia. Como o próprio firmware é sobrescrito, a cópia roda
+ *      inteira da RAM e não chama nenhuma função que esteja na flash.
+ */
+#include "flash_pico.h"
+#include "flash_layout.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "hardware/structs/watchdog.h"
+#include "pico/flash.h"
+#include <string.h>
+
+#define FLASH_SAFE_TIMEOUT_MS 100
+
+typedef struct {
+    uint32_t offset;
+    uint32_t len;
+    const uint8_t *data;
+} flash_op_t;
+
+static void do_erase(void *param) {
+    const flash_op_t *op = param;
+    flash_range_erase(FLASH_OTA_OFFSET + op->offset, op->len);
+}
+
+static void do_program(void *param) {
+    const flash_op_t *op = param;
+    flash_range_program(FLASH_OTA_OFFSET + op->offset, op->data, op->len);
+}
+
+static int pico_erase(void *ctx, uint32_t offset, uint32_t len) {
+    flash_op_t op = { .offset = offset, .len = len };
+    return flash_safe_execute(do_erase, &op, FLASH_SAFE_TIMEOUT_MS) == PICO_OK ? 0 : -1;
+}
+
+static int pico_program(void *ctx, uint32_t offset, const uint8_t *data, uint32_t len) {
+    flash_op_t op = { .offset = offset, .len = len, .data = data };
+    return flash_safe_execute(do_program, &op, FLASH_SAFE_TIMEOUT_MS) == PICO_OK ? 0 : -1;
+}
+
+static int pico_read(void *ctx, uint32_t offset, uint8_t *data, uint32_t len) {
+    memcpy(data, (const uint8_t *)(XIP_BASE + FLASH_OTA_OFFSET + offset), len);
+    return 0;
+}
+
+/**
+ * [Descrição]: Copia a imagem do staging sobre o firmware e reinicia.
+ * [Parâmetros]:
+ *  - uint32_t size: tamanho da imagem;
+ * [Notas]:
+ *  - Roda da RAM com interrupções desabilitadas e não retorna.
+ *  - `flash_range_erase/program` também ficam na RAM e religam o XIP
+ *    ao terminar, então o staging é lido pelo mapa XIP entre as operações.
+ *  - Uma queda de energia durante a cópia deixa o firmware incompleto;
+ *    a gravação por USB (BOOTSEL) continua disponível.
+ */
+static void __no_inline_not_in_flash_func(copy_and_reboot)(uint32_t size) {
+    uint8_t page[FLASH_PAGE_SIZE];
+
+    for (uint32_t sector = 0; sector < size; sector += FLASH_SECTOR_SIZE) {
+        flash_range_erase(FLASH_APP_OFFSET + sector, FLASH_SECTOR_SIZE);
+        for (uint32_t offset = sector; offset < sector + FLASH_SECTOR_SIZE && offset < size; offset += FLASH_PAGE_SIZE) {
+            const volatile uint8_t *src = (const volatile uint8_t *)(XIP_BASE + FLASH_OTA_OFFSET + offset);
+            for (uint32_t i = 0; i < FLASH_PAGE_SIZE; i++) {
+                page[i] = src[i];
+            }
+            flash_range_program(FLASH_APP_OFFSET + offset, page, FLASH_PAGE_SIZE);
+        }
+    }
+
+    watchdog_hw->ctrl = WATCHDOG_CTRL_TRIGGER_BITS;
+    for (;;) {
+    }
+}
+
+static int pico_install(void *ctx, uint32_t size) {
+    if (size == 0 || size > FLASH_APP_SIZE) {
+        return -1;
+    }
+    save_and_disable_interrupts();
+    copy_and_reboot(size);
+    return 0;
+}
+
+const flash_backend_t flash_pico_ota = {
+    .size = FLASH_OTA_SIZE,
+    .erase = pico_erase,
+    .program = pico_program,
+    .read = pico_read,
+    .install = pico_install,
+    .ctx = NULL
+};
@@ -0,0 +1,250 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: gzip.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Este módulo comprime respostas geradas em tempo de execução
+ *      no formato gzip (RFC 1952), usando deflate com Huffman fixo
+ *      (RFC 1951). A compressão é incremental: cada bloco recebido
+ *      é comprimido e liberado na hora, e as repetições são buscadas
+ *      em uma janela de GZIP_WINDOW_SIZE bytes dos blocos anteriores.
+ *
+ *      A busca usa apenas a última ocorrência de cada hash de 3 bytes
+ *      (sem cadeias), trocando um pouco de taxa de compressão por
+ *      tempo constante por byte e memória fixa.
+ */
+#include "gzip.h"
+#include "checksum.h"
+#include <string.h>
+
+#define MIN_MATCH   3
+#define MAX_MATCH   258
+#define END_OF_BLOCK 256
+
+static const uint16_t length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+typedef struct {
+    gzip_stream_t *gz;
+    uint8_t *out;
+    size_t len;
+} bit_writer_t;
+
+static void put_bits(bit_writer_t *w, uint32_t value, unsigned count) {
+    gzip_stream_t *gz = w->gz;
+    gz->bitbuf |= value << gz->bitcount;
+    gz->bitcount += count;
+    while (gz->bitcount >= 8) {
+        w->out[w->len++] = (uint8_t)gz->bitbuf;
+        gz->bitbuf >>= 8;
+        gz->bitcount -= 8;
+    }
+}
+
+static void put_byte(bit_writer_t *w, uint8_t value) {
+    w->out[w->len++] = value;
+}
+
+static void put_le32(bit_writer_t *w, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        put_byte(w, (uint8_t)(value >> (8 * i)));
+    }
+}
+
+/**
+ * [Descrição]: Escreve um código de Huffman (que é definido do bit mais significativo).
+ * [Parâmetros]:
+ *  - bit_writer_t *w: destino;
+ *  - uint32_t code: código;
+ *  - unsigned count: tamanho do código em bits;
+ * [Notas]: O deflate empacota os bits a partir do menos significativo.
+ */
+static void put_code(bit_writer_t *w, uint32_t code, unsigned count) {
+    uint32_t reversed = 0;
+    for (unsigned i = 0; i < count; i++) {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    put_bits(w, reversed, count);
+}
+
+// Códigos fixos de literais/comprimentos (RFC 1951, seção 3.2.6)
+static void put_symbol(bit_writer_t *w, unsigned symbol) {
+    if (symbol < 144) {
+        put_code(w, 0x30 + symbol, 8);
+    } else if (symbol < 256) {
+        put_code(w, 0x190 + (symbol - 144), 9);
+    } else if (symbol < 280) {
+        put_code(w, symbol - 256, 7);
+    } else {
+        put_code(w, 0xC0 + (symbol - 280), 8);
+    }
+}
+
+static void put_match(bit_writer_t *w, unsigned length, unsigned distance) {
+    int code = 28;
+    while (length < length_base[code]) code--;
+    put_symbol(w, 257 + code);
+    put_bits(w, length - length_base[code], length_extra[code]);
+
+    code = 29;
+    while (distance < dist_base[code]) code--;
+    put_code(w, code, 5);
+    put_bits(w, distance - dist_base[code], dist_extra[code]);
+}
+
+static unsigned hash3(const uint8_t *p) {
+    uint32_t v = (uint32_t)p[0] << 16 | (uint32_t)p[1] << 8 | p[2];
+    return (v * 2654435761u) >> (32 - GZIP_HASH_BITS);
+}
+
+/**
+ * [Descrição]: Descarta o histórico mais antigo para abrir espaço no buffer.
+ * [Parâmetros]:
+ *  - gzip_stream_t *gz: compressor;
+ * [Notas]: Mantém os últimos GZIP_WINDOW_SIZE bytes e ajusta a tabela de hash.
+ */
+static void slide(gzip_stream_t *gz) {
+    uint16_t shift = gz->fill - GZIP_WINDOW_SIZE;
+    memmove(gz->buf, gz->buf + shift, GZIP_WINDOW_SIZE);
+    gz->fill = GZIP_WINDOW_SIZE;
+    for (size_t i = 0; i < sizeof(gz->head) / sizeof(gz->head[0]); i++) {
+        gz->head[i] = gz->head[i] > shift ? gz->head[i] - shift : 0;
+    }
+}
+
+/**
+ * [Descrição]: Comprime um trecho que já está em `buf`.
+ * [Parâmetros]:
+ *  - gzip_stream_t *gz: compressor;
+ *  - bit_writer_t *w: destino;
+ *  - uint16_t start: início do trecho;
+ *  - uint16_t end: fim do trecho;
+ * [Notas]: Repetições não atravessam o fim do trecho atual.
+ */
+static void compress_range(gzip_stream_t *gz, bit_writer_t *w, uint16_t start, uint16_t end) {
+    uint16_t p = start;
+    while (p < end) {
+        if (end - p >= MIN_MATCH) {
+            unsigned h = hash3(gz->buf + p);
+            uint16_t candidate = gz->head[h];
+            gz->head[h] = p + 1;
+
+            if (candidate > 0) {
+                const uint8_t *a = gz->buf + candidate - 1;
+                const uint8_t *b = gz->buf + p;
+                unsigned limit = end - p < MAX_MATCH ? end - p : MAX_MATCH;
+                unsigned len = 0;
+                while (len < limit && a[len] == b[len]) len++;
+
+                if (len >= MIN_MATCH) {
+                    put_match(w, len, p - (candidate - 1));
+                    // Registra as posições cobertas pela repetição
+                    for (unsigned k = 1; k < len && p + k + MIN_MATCH <= end; k++) {
+                        gz->head[hash3(gz->buf + p + k)] = p + k + 1;
+                    }
+                    p += len;
+                    continue;
+                }
+            }
+        }
+        put_symbol(w, gz->buf[p]);
+        p++;
+    }
+}
+
+/**
+ * [Descrição]: Inicializa o compressor.
+ * [Parâmetros]:
+ *  - gzip_stream_t *gz: compressor;
+ * [Notas]: A estrutura tem ~3 KiB; costuma ser alocada só quando usada.
+ */
+void gzip_init(gzip_stream_t *gz) {
+    memset(gz->head, 0, sizeof(gz->head));
+    gz->fill = 0;
+    gz->bitbuf = 0;
+    gz->bitcount = 0;
+    gz->started = false;
+    gz->crc = CRC32_INIT;
+    gz->total_in = 0;
+}
+
+/**
+ * [Descrição]: Maior saída possível de `gzip_compress` para `len` bytes.
+ * [Parâmetros]:
+ *  - size_t len: bytes de entrada da chamada;
+ * [Notas]: Inclui cabeçalho, blocos e trailer; no pior caso uma
+ *          repetição de 3 bytes custa 31 bits.
+ */
+size_t gzip_bound(size_t len) {
+    return (len * 31 + 2) / 24 + 10 + 8 + 4;
+}
+
+/**
+ * [Descrição]: Comprime mais um trecho da resposta.
+ * [Parâmetros]:
+ *  - gzip_stream_t *gz: compressor;
+ *  - const uint8_t *in: dados;
+ *  - size_t len: tamanho dos dados;
+ *  - uint8_t *out: destino, com pelo menos `gzip_bound(len)` bytes;
+ *  - bool finish: true no último trecho (fecha o deflate e grava o trailer);
+ * [Notas]:
+ *  - Retorna quantos bytes foram escritos em `out` (pode ser 0).
+ *  - Até 7 bits ficam pendentes entre chamadas e saem no próximo trecho.
+ */
+size_t gzip_compress(gzip_stream_t *gz, const uint8_t *in, size_t len, uint8_t *out, bool finish) {
+    bit_writer_t w = { .gz = gz, .out = out, .len = 0 };
+
+    if (!gz->started) {
+        static const uint8_t header[10] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff };
+        memcpy(out, header, sizeof(header));
+        w.len = sizeof(header);
+        put_bits(&w, 0, 1);     // BFINAL = 0: o bloco final vazio vem no fim
+        put_bits(&w, 1, 2);     // BTYPE = 01 (Huffman fixo)
+        gz->started = true;
+    }
+
+    gz->crc = crc32_update(gz->crc, in, len);
+    gz->total_in += len;
+
+    while (len > 0) {
+        size_t n = len < GZIP_WINDOW_SIZE ? len : GZIP_WINDOW_SIZE;
+        if (gz->fill + n > sizeof(gz->buf)) {
+            slide(gz);
+        }
+        memcpy(gz->buf + gz->fill, in, n);
+        compress_range(gz, &w, gz->fill, gz->fill + n);
+        gz->fill += n;
+        in += n;
+        len -= n;
+    }
+
+    if (finish) {
+        put_symbol(&w, END_OF_BLOCK);
+        put_bits(&w, 1, 1);     // Bloco final vazio
+        put_bits(&w, 1, 2);
+        put_symbol(&w, END_OF_BLOCK);
+        if (gz->bitcount > 0) {
+            put_bits(&w, 0, 8 - gz->bitcount);
+        }
+        put_le32(&w, crc32_final(gz->crc));
+        put_le32(&w, gz->total_in);
+    }
+    return w.len;
+}
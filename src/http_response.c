@@ -31,9 +31,31 @@ void init_http_response(http_response_t *response) {
         response->headers_len = 0;
         response->body = NULL;
         response->body_len = 0;
+        response->borrowed_body = NULL;
+        response->body_release = NULL;
+        response->body_release_ctx = NULL;
+        response->stream_fill = NULL;
+        response->stream_ctx = NULL;
+        response->stream_key = 0;
+        response->tpl = NULL;
     }
 }
 
+/**
+ * [Descrição]: Devolve o corpo emprestado, se houver, ao seu dono.
+ * [Parâmetros]: 
+ *  - http_response_t *response: ponteiro para a resposta;
+ * [Notas]: O servidor assume a devolução ao enviar o corpo (campo zerado).
+ */
+static void release_borrowed_body(http_response_t *response) {
+    if (response->body_release) {
+        response->body_release(response->body_release_ctx);
+    }
+    response->borrowed_body = NULL;
+    response->body_release = NULL;
+    response->body_release_ctx = NULL;
+}
+
 /**
  * [Descrição]: Define o status da resposta HTTP.
  * [Parâmetros]: 
@@ -96,6 +118,8 @@ void add_response_header(http_response_t *response, const char *key, const char
  */
 void set_response_body(http_response_t *response, const char *body) {
     if (response) {
+        release_borrowed_body(response);
+
         // Liberar corpo anterior, se houver, para evitar vazamento
         if (response->body) {
             free(response->body);
@@ -119,12 +143,92 @@ void set_response_body(http_response_t *response, const char *body) {
     }
 }
 
+/**
+ * [Descrição]: Define um corpo emprestado, enviado sem cópia.
+ * [Parâmetros]: 
+ *  - http_response_t *response: ponteiro para a resposta;
+ *  - const char *body: corpo, que deve permanecer inalterado até `release`;
+ *  - size_t len: tamanho do corpo;
+ *  - void (*release)(void *ctx): chamada quando o corpo não for mais usado (pode ser NULL);
+ *  - void *ctx: contexto repassado a `release`;
+ * [Notas]: 
+ *  - O servidor envia o corpo direto da memória do dono e só chama
+ *    `release` quando a conexão é encerrada (dados confirmados ou erro).
+ *  - Substitui o corpo anterior, se houver.
+ */
+void set_response_borrowed_body(http_response_t *response, const char *body, size_t len,
+                                void (*release)(void *ctx), void *ctx) {
+    if (response) {
+        set_response_body(response, NULL);
+        response->borrowed_body = body;
+        response->body_len = len;
+        response->body_release = release;
+        response->body_release_ctx = ctx;
+    }
+}
+
+/**
+ * [Descrição]: Define que o corpo da resposta será gerado sob demanda.
+ * [Parâmetros]: 
+ *  - http_response_t *response: ponteiro para a resposta;
+ *  - http_stream_fill_fn fill: gerador chamado sempre que houver espaço para enviar;
+ *  - void *ctx: contexto repassado ao gerador;
+ * [Notas]: 
+ *  - O servidor envia a resposta com `Transfer-Encoding: chunked`
+ *    (ou delimitada pelo fechamento, em HTTP/1.0), sem Content-Length.
+ *  - Substitui o corpo anterior, se houver.
+ */
+void set_response_stream(http_response_t *response, http_stream_fill_fn fill, void *ctx) {
+    if (response) {
+        set_response_body(response, NULL);
+        response->stream_fill = fill;
+        response->stream_ctx = ctx;
+    }
+}
+
+/**
+ * [Descrição]: Permite que requisições idênticas simultâneas compartilhem o stream.
+ * [Parâmetros]: 
+ *  - http_response_t *response: resposta com gerador definido;
+ *  - uint32_t key: chave da requisição (ex: `response_cache_key`); 0 desativa;
+ * [Notas]: 
+ *  - Enquanto uma geração com a mesma chave estiver em andamento, a
+ *    conexão recebe os mesmos blocos em vez de executar o gerador.
+ *  - Só deve ser usado quando o conteúdo depende apenas da chave.
+ */
+void set_response_stream_key(http_response_t *response, uint32_t key) {
+    if (response) {
+        response->stream_key = key;
+    }
+}
+
+/**
+ * [Descrição]: Define que o corpo da resposta é um template compilado.
+ * [Parâmetros]: 
+ *  - http_response_t *response: ponteiro para a resposta;
+ *  - const template_t *tpl: template gerado a partir de `pages/`;
+ * [Notas]: 
+ *  - Retorna o vetor de valores dos slots, indexado pelo enum do
+ *    template (ex: TEMPLATE_INDEX_CLIENTS), ou NULL se `response` for NULL.
+ *  - Strings devem continuar válidas após o retorno da rota (ex: literais).
+ *  - Substitui o corpo anterior, se houver.
+ */
+template_value_t *set_response_template(http_response_t *response, const template_t *tpl) {
+    if (!response) {
+        return NULL;
+    }
+    set_response_body(response, NULL);
+    response->tpl = tpl;
+    return response->tpl_values;
+}
+
 /**
  * [Descrição]: Libera os recursos associados a uma resposta HTTP.
  * [Parâmetros]: 
  *  - http_response_t *response: ponteiro para a resposta a ser limpa;
  * [Notas]: 
- *  - Libera apenas o campo `body`, que pode ter sido alocado dinamicamente.
+ *  - Libera o campo `body`, que pode ter sido alocado dinamicamente,
+ *    e devolve o corpo emprestado que o servidor não assumiu.
  *  - Redefine os demais campos para valores seguros.
  */
 void free_http_response(http_response_t *response) {
@@ -134,11 +238,16 @@ void free_http_response(http_response_t *response) {
             free(response->body);
             response->body = NULL;
         }
+        release_borrowed_body(response);
         // Redefinir outros campos para um estado inicial seguro
         response->status_code = 0;
         response->status_message = NULL;
         response->headers[0] = '\0';
         response->headers_len = 0;
         response->body_len = 0;
+        response->stream_fill = NULL;
+        response->stream_ctx = NULL;
+        response->stream_key = 0;
+        response->tpl = NULL;
     }
 }
\ No newline at end of file
@@ -11,30 +11,207 @@
  *      Ele processa requisições TCP recebidas na porta 80,
  *      analisa os headers HTTP, trata as rotas e envia
  *      respostas com base no conteúdo definido em `routes.c`.
+ *      Corpos de requisição (ex: uploads) são repassados ao
+ *      handler da rota conforme chegam, sem serem armazenados,
+ *      e respostas geradas sob demanda são enviadas em chunks.
+ *      Páginas compiladas de `pages/` e arquivos da ROMFS são enviados
+ *      direto da flash; para clientes que aceitam gzip, templates e
+ *      corpos em RAM acima de GZIP_MIN_INPUT são comprimidos antes.
+ *
+ *      Uma segunda porta (TCP_CONTROL_PORT) atende só as rotas de
+ *      controle, com vagas de conexão reservadas e prioridade maior no
+ *      lwIP: um comando ao alarme é aceito mesmo com a porta 80 cheia.
+ *
+ *      Os segmentos TCP (MEMP_NUM_TCP_SEG) e o heap do lwIP (MEM_SIZE)
+ *      são compartilhados por todas as conexões. Quando a folga de um
+ *      deles cai abaixo da reserva (HTTP_MIN_HEADROOM segmentos,
+ *      HTTP_MIN_HEAP_HEADROOM bytes) ou um `tcp_write` falha por falta
+ *      de memória, respostas grandes (bulk) param de enfileirar e as
+ *      pequenas seguem; as adiadas são retomadas conforme os ACKs
+ *      liberam espaço.
+ *
+ *      Cada cliente (IP) mantém no máximo HTTP_MAX_CLIENT_CONNECTIONS
+ *      conexões. As últimas HTTP_FAIR_RESERVE vagas de cada porta ficam
+ *      para clientes sem conexão aberta; com a porta cheia, um cliente
+ *      novo toma a vaga de uma conexão ociosa de quem tem mais conexões.
  */
 
 #include "http_server.h"
 #include "http_utils.h"
+#include "http_stream.h"
+#include "template.h"
 #include "routes.h"
+#include "middleware.h"
+#include "single_flight.h"
+#include "client_limit.h"
+#include "gzip.h"
+#include "dnsserver.h"
 #include "pico/cyw43_arch.h"
+#include "pico/time.h"
 #include "lwip/tcp.h"
+#include "lwip/stats.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdbool.h>
+
+#define DEBUG_printf(...)
 
 #define TCP_PORT 80
+#define TCP_CONTROL_PORT 8080
+#define HTTP_CONTROL_SLOTS 2    // Conexões reservadas à porta de controle
+#define HTTP_MAX_PUBLIC_CONNECTIONS (MEMP_NUM_TCP_PCB - HTTP_CONTROL_SLOTS - DNS_TCP_MAX)
+#define HTTP_MAX_CLIENT_CONNECTIONS 2      // Conexões paralelas por IP (navegadores abrem 6+)
+#define HTTP_FAIR_RESERVE 1                 // Vagas finais reservadas a clientes sem conexão
+#define HTTP_BULK_BODY_MIN (2 * TCP_MSS)          // Corpos maiores (ou em stream) são bulk
+#define HTTP_MIN_HEADROOM (MEMP_NUM_TCP_SEG / 4)  // Segmentos livres reservados às respostas pequenas
+#define HTTP_MIN_HEAP_HEADROOM (MEM_SIZE / 4)     // Bytes do heap do lwIP reservados às respostas pequenas
+#define HTTP_MAX_REQUEST_HEADERS 1024
+
+#define HTTP_CHUNK_TERMINATOR "0\r\n\r\n"
+#define HTTP_CRLF "\r\n"
+#define POLL_TIME_S 1
+#define HTTP_IDLE_POLLS 10      // Polls (1 s) sem receber nem ter ACK até abortar a conexão
 
 typedef struct {
+    u16_t port;
+    bool control;                       // Rotas de controle e vagas reservadas
+    u8_t prio;                          // Prioridade das conexões no lwIP (TCP_PRIO_*)
+    u8_t max_connections;
+    u8_t connections;                   // Conexões abertas
+} http_listener_t;
+
+typedef struct connection_state {
     struct tcp_pcb *client_pcb;
-    char headers[512];
+    struct connection_state *next;      // Lista de conexões abertas
+    http_listener_t *listener;          // Porta que aceitou a conexão
+    uint8_t client;                     // Índice do cliente (`client_limit_index`)
+    char headers[HTTP_MAX_REQUEST_HEADERS];
     int header_len;
-    const char *body;
-    int body_len;
+    http_context_t ctx;                 // Rota e dados usados pelo middleware
+    bool responded;                     // Resposta já enfileirada
+    bool body_active;                   // Corpo sendo entregue ao handler
+    size_t body_remaining;
+    http_body_handler_t body_handler;
+    u32_t unacked;                      // Bytes enfileirados ainda sem ACK
+    uint8_t idle_polls;                 // Polls seguidos sem atividade do cliente
+    bool bulk;                          // Corpo grande: cede a vez sob pressão de memória
+    bool deferred;                      // Envio adiado por falta de folga
+    void (*body_release)(void *ctx);    // Devolve o corpo emprestado enviado sem cópia
+    void *body_release_ctx;
+    const char *borrowed_next;          // Trecho do corpo emprestado ainda não enfileirado
+    size_t borrowed_remaining;
+    http_stream_fill_fn stream_fill;    // Gerador da resposta em stream, se houver
+    void *stream_ctx;
+    bool stream_done;
+    bool template_active;               // Template compilado em envio
+    flight_t *flight;                   // Geração compartilhada com requisições idênticas
+    uint16_t flight_sent;               // Segmentos enfileirados
+    uint16_t flight_released;           // Segmentos confirmados e devolvidos à geração
+    bool flight_active;
+    bool flight_chunked;
+    union {
+        http_stream_t stream;
+        template_render_t render;
+    } source;
 } connection_state_t;
 
+// Com o pool de PCBs cheio, o lwIP descarta conexões de prioridade menor
+// para aceitar as da porta de controle
+static http_listener_t listeners[] = {
+    { .port = TCP_PORT, .control = false, .prio = TCP_PRIO_MIN,
+      .max_connections = HTTP_MAX_PUBLIC_CONNECTIONS },
+    { .port = TCP_CONTROL_PORT, .control = true, .prio = TCP_PRIO_MAX,
+      .max_connections = HTTP_CONTROL_SLOTS },
+};
+
+// Estados das conexões de controle: não dependem do heap estar livre
+static connection_state_t control_slots[HTTP_CONTROL_SLOTS];
+static bool control_slot_used[HTTP_CONTROL_SLOTS];
+
+static connection_state_t *connections;
+static http_send_stats_t send_stats = { .min_headroom = MEMP_NUM_TCP_SEG, .min_heap_headroom = MEM_SIZE };
+
 static err_t tcp_server_sent(void *arg, struct tcp_pcb *tpcb, u16_t len);
 static err_t tcp_server_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err);
+static err_t tcp_server_poll(void *arg, struct tcp_pcb *tpcb);
 static err_t tcp_server_accept(void *arg, struct tcp_pcb *newpcb, err_t err);
+static void tcp_server_err(void *arg, err_t err);
+
+/**
+ * [Descrição]: Reserva o estado de uma nova conexão.
+ * [Parâmetros]: 
+ *  - http_listener_t *listener: porta que aceitou a conexão;
+ *  - unsigned client: índice do cliente (`client_limit_index`);
+ * [Notas]: 
+ *  - Retorna NULL se a porta já tiver `max_connections` conexões.
+ *  - A porta de controle usa `control_slots`; a pública, o heap.
+ *  - Só as conexões da porta pública contam no limite por cliente.
+ */
+static connection_state_t *alloc_connection_state(http_listener_t *listener, unsigned client) {
+    if (listener->connections >= listener->max_connections) {
+        return NULL;
+    }
+
+    connection_state_t *state = NULL;
+    if (listener->control) {
+        for (int i = 0; i < HTTP_CONTROL_SLOTS && !state; i++) {
+            if (!control_slot_used[i]) {
+                control_slot_used[i] = true;
+                state = &control_slots[i];
+                memset(state, 0, sizeof(*state));
+            }
+        }
+    } else {
+        state = calloc(1, sizeof(connection_state_t));
+    }
+
+    if (state) {
+        state->listener = listener;
+        state->client = (uint8_t)client;
+        listener->connections++;
+        if (!listener->control) {
+            client_limit_open(client);
+        }
+        state->next = connections;
+        connections = state;
+    }
+    return state;
+}
+
+/**
+ * [Descrição]: Libera o estado da conexão, cancelando um corpo em andamento.
+ * [Parâmetros]: 
+ *  - connection_state_t *state: ponteiro para estado da conexão (pode ser NULL);
+ * [Notas]: 
+ *  - O handler do corpo recebe `on_abort` se ainda não terminou.
+ *  - Um corpo emprestado ou geração compartilhada é devolvido: o lwIP
+ *    não referencia mais os dados enviados sem cópia.
+ */
+static void free_connection_state(connection_state_t *state) {
+    if (!state) return;
+    if (state->body_active && state->body_handler.on_abort) {
+        state->body_handler.on_abort(state->body_handler.ctx);
+    }
+    if (state->body_release) {
+        state->body_release(state->body_release_ctx);
+    }
+    single_flight_leave(state->flight, state->flight_released);
+
+    for (connection_state_t **link = &connections; *link; link = &(*link)->next) {
+        if (*link == state) {
+            *link = state->next;
+            break;
+        }
+    }
+    state->listener->connections--;
+    if (state->listener->control) {
+        control_slot_used[state - control_slots] = false;
+    } else {
+        client_limit_close(state->client);
+        free(state);
+    }
+}
 
 /**
  * [Descrição]: Fecha uma conexão TCP e libera a memória alocada para o estado.
@@ -44,100 +221,562 @@ static err_t tcp_server_accept(void *arg, struct tcp_pcb *newpcb, err_t err);
  * [Notas]: A função também limpa os argumentos de callback.
  */
 static void close_connection(struct tcp_pcb *tpcb, connection_state_t *state) {
-    if (state) free(state);
+    free_connection_state(state);
     tcp_arg(tpcb, NULL);
+    tcp_recv(tpcb, NULL);
+    tcp_sent(tpcb, NULL);
+    tcp_poll(tpcb, NULL, 0);
+    tcp_err(tpcb, NULL);
     tcp_close(tpcb);
 }
 
 /**
- * [Descrição]: Callback executado após envio completo dos dados.
+ * [Descrição]: Enfileira dados para envio contabilizando os bytes sem ACK.
  * [Parâmetros]: 
- *  - void *arg: ponteiro para o estado da conexão;
- *  - struct tcp_pcb *tpcb: ponteiro para o socket TCP;
- *  - u16_t len: número de bytes enviados;
- * [Notas]: Fecha a conexão após finalização do envio.
+ *  - struct tcp_pcb *tpcb: socket do cliente;
+ *  - connection_state_t *state: estado da conexão;
+ *  - const void *data: dados a enviar;
+ *  - u16_t len: quantidade de bytes;
+ *  - u8_t flags: flags de `tcp_write` (ex: TCP_WRITE_FLAG_COPY);
+ * [Notas]: 
+ *  - A conexão só é fechada quando todos os bytes forem confirmados.
+ *  - Numa resposta bulk, ERR_MEM adia a conexão como a falta de folga
+ *    (contado em `deferrals`); a próxima escrita aceita a retoma.
+ */
+static err_t queue_write(struct tcp_pcb *tpcb, connection_state_t *state, const void *data, u16_t len, u8_t flags) {
+    err_t err = tcp_write(tpcb, data, len, flags);
+    if (err == ERR_OK) {
+        state->unacked += len;
+        if (state->deferred) {
+            state->deferred = false;
+            send_stats.resumes++;
+        }
+    } else if (err == ERR_MEM && state->bulk && !state->deferred) {
+        state->deferred = true;
+        send_stats.deferrals++;
+    }
+    return err;
+}
+
+/**
+ * [Descrição]: Informa quantos segmentos TCP ainda estão livres.
+ * [Parâmetros]: nenhum
+ * [Notas]: 
+ *  - Com MEMP_STATS, lê o pool MEMP_TCP_SEG (inclui o DNS over TCP);
+ *    sem, soma a fila de envio das conexões HTTP abertas (no máximo
+ *    MEMP_NUM_TCP_PCB) e desconta de MEMP_NUM_TCP_SEG.
+ *  - Atualiza a menor folga observada.
+ */
+static int send_headroom(void) {
+#if MEMP_STATS
+    const struct stats_mem *segs = lwip_stats.memp[MEMP_TCP_SEG];
+    int headroom = (int)segs->avail - (int)segs->used;
+#else
+    int queued = 0;
+    for (connection_state_t *s = connections; s; s = s->next) {
+        queued += tcp_sndqueuelen(s->client_pcb);
+    }
+    int headroom = MEMP_NUM_TCP_SEG - queued;
+#endif
+    if (headroom < (int)send_stats.min_headroom) {
+        send_stats.min_headroom = headroom > 0 ? headroom : 0;
+    }
+    return headroom;
+}
+
+/**
+ * [Descrição]: Decide se há folga para as respostas bulk enfileirarem.
+ * [Parâmetros]: nenhum
+ * [Notas]: 
+ *  - Exige HTTP_MIN_HEADROOM segmentos livres e, com MEM_STATS sobre o
+ *    heap próprio do lwIP, HTTP_MIN_HEAP_HEADROOM bytes livres nele:
+ *    cabeçalhos e trechos copiados vêm do heap, não do pool.
+ *  - Atualiza a menor folga de heap observada.
+ */
+static bool send_allowed(void) {
+    bool allowed = send_headroom() >= HTTP_MIN_HEADROOM;
+#if MEM_STATS && !MEM_LIBC_MALLOC
+    int heap = (int)lwip_stats.mem.avail - (int)lwip_stats.mem.used;
+    if (heap < (int)send_stats.min_heap_headroom) {
+        send_stats.min_heap_headroom = heap > 0 ? heap : 0;
+    }
+    allowed = allowed && heap >= HTTP_MIN_HEAP_HEADROOM;
+#endif
+    return allowed;
+}
+
+/**
+ * [Descrição]: Decide se a conexão pode enfileirar mais um trecho do corpo.
+ * [Parâmetros]: 
+ *  - struct tcp_pcb *tpcb: socket do cliente;
+ *  - connection_state_t *state: estado da conexão;
+ *  - int reserve: entradas da fila do próprio PCB a manter livres;
+ * [Notas]: 
+ *  - Respostas bulk só enfileiram com folga global (`send_allowed`);
+ *    sem ela a conexão fica adiada (contada em `deferrals`) até uma
+ *    escrita ser aceita.
+ */
+static bool can_queue(struct tcp_pcb *tpcb, connection_state_t *state, int reserve) {
+    if (tcp_sndqueuelen(tpcb) >= TCP_SND_QUEUELEN - reserve) {
+        return false;
+    }
+    if (!state->bulk) {
+        return true;
+    }
+
+    bool allowed = send_allowed();
+    if (!allowed && !state->deferred) {
+        state->deferred = true;
+        send_stats.deferrals++;
+    }
+    return allowed;
+}
+
+/**
+ * [Descrição]: Gera e enfileira blocos de uma resposta em stream.
+ * [Parâmetros]: 
+ *  - struct tcp_pcb *tpcb: socket do cliente;
+ *  - connection_state_t *state: estado da conexão com gerador ativo;
+ * [Notas]: 
+ *  - Só chama o gerador quando o buffer de envio comporta um bloco
+ *    inteiro; o restante é gerado conforme os ACKs liberam espaço,
+ *    mantendo a memória usada constante.
+ */
+static void pump_stream(struct tcp_pcb *tpcb, connection_state_t *state) {
+    while (state->stream_fill) {
+        if (tcp_sndbuf(tpcb) < sizeof(state->source.stream.frame) ||
+            !can_queue(tpcb, state, 2)) {
+            break; // Aguarda ACKs liberarem espaço no buffer de envio
+        }
+
+        if (!state->stream_done) {
+            state->stream_done = state->stream_fill(&state->source.stream, state->stream_ctx);
+        }
+
+        if (state->source.stream.len > 0) {
+            size_t frame_len;
+            const char *frame = http_stream_frame(&state->source.stream, &frame_len);
+            if (queue_write(tpcb, state, frame, frame_len, TCP_WRITE_FLAG_COPY) != ERR_OK) {
+                break; // Sem memória no lwIP: tenta de novo no próximo ACK ou poll
+            }
+            http_stream_consume(&state->source.stream);
+        } else if (!state->stream_done) {
+            break; // Gerador ainda sem dados disponíveis
+        }
+
+        if (state->stream_done) {
+            if (state->source.stream.chunked &&
+                queue_write(tpcb, state, HTTP_CHUNK_TERMINATOR, sizeof(HTTP_CHUNK_TERMINATOR) - 1, 0) != ERR_OK) {
+                break;
+            }
+            state->stream_fill = NULL;
+        }
+    }
+}
+
+/**
+ * [Descrição]: Enfileira os segmentos de um template compilado.
+ * [Parâmetros]: 
+ *  - struct tcp_pcb *tpcb: socket do cliente;
+ *  - connection_state_t *state: estado da conexão com template ativo;
+ * [Notas]: 
+ *  - Segmentos estáticos são enviados direto da flash, sem
+ *    TCP_WRITE_FLAG_COPY; apenas os slots formatados são copiados.
+ */
+static void pump_template(struct tcp_pcb *tpcb, connection_state_t *state) {
+    const char *data;
+    size_t len;
+    bool copy;
+
+    while (can_queue(tpcb, state, 2) &&
+           template_render_peek(&state->source.render, tcp_sndbuf(tpcb), &data, &len, &copy)) {
+        if (queue_write(tpcb, state, data, len, copy ? TCP_WRITE_FLAG_COPY : 0) != ERR_OK) {
+            break; // Sem memória no lwIP: tenta de novo no próximo ACK ou poll
+        }
+        template_render_advance(&state->source.render, len);
+    }
+
+    if (!template_render_peek(&state->source.render, 1, &data, &len, &copy)) {
+        state->template_active = false;
+    }
+}
+
+/**
+ * [Descrição]: Enfileira um corpo emprestado (cache ou arquivo da ROMFS).
+ * [Parâmetros]: 
+ *  - struct tcp_pcb *tpcb: socket do cliente;
+ *  - connection_state_t *state: estado da conexão com corpo emprestado;
+ * [Notas]: 
+ *  - Enviado sem TCP_WRITE_FLAG_COPY, um segmento (TCP_MSS) por
+ *    `tcp_write`: sem memória no lwIP só o trecho atual espera, e os
+ *    já enfileirados seguem. Arquivos maiores que o buffer de envio
+ *    continuam conforme os ACKs.
+ */
+static void pump_borrowed(struct tcp_pcb *tpcb, connection_state_t *state) {
+    while (state->borrowed_remaining > 0 && can_queue(tpcb, state, 2)) {
+        size_t len = LWIP_MIN(tcp_sndbuf(tpcb), TCP_MSS);
+        if (len == 0) {
+            break; // Aguarda ACKs liberarem espaço no buffer de envio
+        }
+        if (len > state->borrowed_remaining) {
+            len = state->borrowed_remaining;
+        }
+        if (queue_write(tpcb, state, state->borrowed_next, len, 0) != ERR_OK) {
+            break; // Sem memória no lwIP: tenta de novo no próximo ACK ou poll
+        }
+        state->borrowed_next += len;
+        state->borrowed_remaining -= len;
+    }
+}
+
+/**
+ * [Descrição]: Enfileira os segmentos de uma geração compartilhada.
+ * [Parâmetros]: 
+ *  - struct tcp_pcb *tpcb: socket do cliente;
+ *  - connection_state_t *state: estado da conexão inscrita em uma geração;
+ * [Notas]: 
+ *  - Os segmentos são imutáveis e enviados sem cópia; apenas o tamanho
+ *    do chunk é formatado por conexão.
+ *  - Se a geração falhar ou um chunk ficar pela metade, a resposta
+ *    termina sem o terminador do chunked (o cliente vê o erro).
  */
-static err_t on_sent_close_connection(void *arg, struct tcp_pcb *tpcb, u16_t len) {
-    close_connection(tpcb, (connection_state_t *)arg);
+static void pump_flight(struct tcp_pcb *tpcb, connection_state_t *state) {
+    while (state->flight_active && can_queue(tpcb, state, 4)) {
+        const flight_segment_t *seg = single_flight_next(state->flight, state->flight_sent);
+        if (!seg) {
+            if (!single_flight_finished(state->flight)) {
+                break; // Gerador sem dados ou geração aguardando ACKs das outras conexões
+            }
+            if (!single_flight_failed(state->flight) && state->flight_chunked &&
+                queue_write(tpcb, state, HTTP_CHUNK_TERMINATOR, sizeof(HTTP_CHUNK_TERMINATOR) - 1, 0) != ERR_OK) {
+                break;
+            }
+            state->flight_active = false;
+            break;
+        }
+        if (tcp_sndbuf(tpcb) < seg->len + HTTP_STREAM_HEADROOM + HTTP_STREAM_TAILROOM) {
+            break; // Aguarda ACKs liberarem espaço no buffer de envio
+        }
+
+        if (!state->flight_chunked) {
+            if (queue_write(tpcb, state, seg->data, seg->len, 0) != ERR_OK) {
+                break;
+            }
+        } else {
+            char size_line[HTTP_STREAM_HEADROOM + 1];
+            int n = snprintf(size_line, sizeof(size_line), "%X\r\n", (unsigned)seg->len);
+            if (queue_write(tpcb, state, size_line, n, TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE) != ERR_OK) {
+                break;
+            }
+            if (queue_write(tpcb, state, seg->data, seg->len, TCP_WRITE_FLAG_MORE) != ERR_OK ||
+                queue_write(tpcb, state, HTTP_CRLF, sizeof(HTTP_CRLF) - 1, 0) != ERR_OK) {
+                state->flight_active = false; // Chunk incompleto: encerra a resposta
+                break;
+            }
+        }
+        state->flight_sent++;
+    }
+}
+
+/**
+ * [Descrição]: Informa se ainda há corpo a gerar ou enfileirar.
+ * [Parâmetros]: 
+ *  - const connection_state_t *state: estado da conexão;
+ * [Notas]: Cobre stream, template, geração compartilhada e corpo emprestado.
+ */
+static bool body_pending(const connection_state_t *state) {
+    return state->stream_fill || state->template_active || state->flight_active ||
+           state->borrowed_remaining > 0;
+}
+
+/**
+ * [Descrição]: Continua o envio de um corpo gerado aos poucos.
+ * [Parâmetros]: 
+ *  - struct tcp_pcb *tpcb: socket do cliente;
+ *  - connection_state_t *state: estado da conexão;
+ * [Notas]: Fecha a conexão quando o corpo termina e tudo foi confirmado.
+ */
+static err_t body_pump(struct tcp_pcb *tpcb, connection_state_t *state) {
+    if (state->stream_fill) {
+        pump_stream(tpcb, state);
+    } else if (state->template_active) {
+        pump_template(tpcb, state);
+    } else if (state->flight_active) {
+        pump_flight(tpcb, state);
+    } else if (state->borrowed_remaining > 0) {
+        pump_borrowed(tpcb, state);
+    }
+
+    tcp_output(tpcb);
+    if (!body_pending(state) && state->unacked == 0) {
+        close_connection(tpcb, state);
+    }
     return ERR_OK;
 }
 
+/**
+ * [Descrição]: Devolve à geração os segmentos que o cliente já confirmou.
+ * [Parâmetros]: 
+ *  - connection_state_t *state: estado da conexão inscrita em uma geração;
+ * [Notas]: 
+ *  - Só com tudo confirmado (`unacked` zerado): o lwIP referencia os
+ *    segmentos enviados sem cópia até o ACK.
+ *  - Os segmentos liberados deixam o gerador continuar; as outras
+ *    conexões da geração, paradas à espera dele, são retomadas.
+ */
+static void release_flight(connection_state_t *state) {
+    if (!state->flight || state->unacked > 0 || state->flight_released == state->flight_sent) {
+        return;
+    }
+    single_flight_release(state->flight, state->flight_released, state->flight_sent);
+    state->flight_released = state->flight_sent;
+
+    connection_state_t *s = connections;
+    while (s) {
+        connection_state_t *next = s->next;
+        if (s != state && s->flight == state->flight && s->flight_active) {
+            body_pump(s->client_pcb, s);
+        }
+        s = next;
+    }
+}
+
+/**
+ * [Descrição]: Retoma as respostas adiadas enquanto houver folga.
+ * [Parâmetros]: nenhum
+ * [Notas]: Chamada quando ACKs liberam segmentos; cada conexão retomada
+ *          pode ser fechada por `body_pump`, então o próximo é guardado antes.
+ */
+static void resume_deferred(void) {
+    connection_state_t *s = connections;
+    while (s && send_allowed()) {
+        connection_state_t *next = s->next;
+        if (s->deferred) {
+            body_pump(s->client_pcb, s);
+        }
+        s = next;
+    }
+}
+
+/**
+ * [Descrição]: Retorna os contadores do escalonamento de envio.
+ * [Parâmetros]: nenhum
+ * [Notas]: Acumulados desde o boot.
+ */
+const http_send_stats_t *http_server_send_stats(void) {
+    return &send_stats;
+}
+
 /**
  * [Descrição]: Callback de envio TCP quando o pacote foi entregue com sucesso.
  * [Parâmetros]: 
  *  - void *arg: ponteiro para o estado da conexão;
  *  - struct tcp_pcb *tpcb: socket do cliente;
  *  - u16_t len: número de bytes enviados;
- * [Notas]: Envia o corpo da resposta, se ainda não tiver sido enviado.
+ * [Notas]: 
+ *  - Continua uma resposta em stream ou template, se houver.
+ *  - Fecha a conexão depois que todos os dados forem confirmados.
+ *  - Os segmentos liberados podem retomar respostas adiadas de outras conexões.
  */
 static err_t tcp_server_sent(void *arg, struct tcp_pcb *tpcb, u16_t len) {
     connection_state_t *state = (connection_state_t *)arg;
-    // Em seu routes.c, o body é uma string literal.
-    // Se você estivesse alocando o body dinamicamente, você o liberaria aqui.
-    // Para literais de string, definir como NULL é bom.
-    if (state->body) {
-        err_t err = tcp_write(tpcb, state->body, state->body_len, TCP_WRITE_FLAG_COPY);
-        state->body = NULL;
-        return err;
+    if (!state) {
+        return ERR_OK;
+    }
+
+    state->idle_polls = 0;
+    state->unacked = len < state->unacked ? state->unacked - len : 0;
+    release_flight(state);
+    if (body_pending(state)) {
+        body_pump(tpcb, state);
+    } else if (state->responded && state->unacked == 0) {
+        close_connection(tpcb, state); // Fechar a conexão depois que todos os dados forem enviados
     }
-    close_connection(tpcb, state); // Fechar a conexão depois que todos os dados forem enviados
+    resume_deferred();
     return ERR_OK;
 }
 
 /**
- * [Descrição]: Callback chamado quando dados são recebidos do cliente.
+ * [Descrição]: Informa se a conexão está parada à espera do cliente.
+ * [Parâmetros]: 
+ *  - const connection_state_t *state: estado da conexão;
+ * [Notas]: 
+ *  - Sem corpo a enviar, espera a requisição, o corpo dela ou o ACK
+ *    final; com corpo, só se há bytes sem ACK (o `sent` zera a conta).
+ *  - Adiada por falta de memória, ou com o gerador (ou a geração
+ *    compartilhada) ainda sem dados, a espera é do servidor.
+ */
+static bool waiting_on_client(const connection_state_t *state) {
+    return !state->deferred && (!body_pending(state) || state->unacked > 0);
+}
+
+/**
+ * [Descrição]: Callback periódico da conexão.
  * [Parâmetros]: 
  *  - void *arg: ponteiro para o estado da conexão;
  *  - struct tcp_pcb *tpcb: socket do cliente;
- *  - struct pbuf *p: buffer contendo os dados recebidos;
- *  - err_t err: código de erro, se houver;
- * [Notas]: Trata a requisição HTTP, prepara e envia a resposta.
+ * [Notas]: 
+ *  - Retoma geradores que estavam sem dados ou sem memória.
+ *  - Aborta a conexão após HTTP_IDLE_POLLS polls sem dados nem ACKs:
+ *    uma conexão muda ou um corpo parado no meio não prende a vaga
+ *    (inclusive as de controle) nem o handler do corpo, que recebe
+ *    `on_abort` e libera sua flag de ocupado.
+ *  - Só conta enquanto espera o cliente (`waiting_on_client`): uma
+ *    resposta adiada ou à espera do gerador não é ociosidade dele.
+ *  - `tcp_abort` chama `tcp_server_err`, que libera o estado.
  */
-static err_t tcp_server_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err) {
-    if (!p) {
-        // Conexão fechada pelo cliente
-        close_connection(tpcb, (connection_state_t *)arg);
-        return ERR_OK;
+static err_t tcp_server_poll(void *arg, struct tcp_pcb *tpcb) {
+    connection_state_t *state = (connection_state_t *)arg;
+    if (state && !waiting_on_client(state)) {
+        state->idle_polls = 0;
+    } else if (state && ++state->idle_polls >= HTTP_IDLE_POLLS) {
+        DEBUG_printf("Idle connection on port %d aborted\n", state->listener->port);
+        tcp_abort(tpcb);
+        return ERR_ABRT;
     }
+    if (state && body_pending(state)) {
+        return body_pump(tpcb, state);
+    }
+    return ERR_OK;
+}
 
-    if (err != ERR_OK) {
-        pbuf_free(p);
-        return err;
+/**
+ * [Descrição]: Verifica se a requisição usa HTTP/1.0 (sem suporte a chunked).
+ * [Parâmetros]: 
+ *  - const char *request: requisição terminada em '\0';
+ * [Notas]: Analisa apenas a linha inicial.
+ */
+static bool is_http10_request(const char *request) {
+    const char *line_end = strstr(request, "\r\n");
+    return line_end && line_end - request >= 8 && strncmp(line_end - 8, "HTTP/1.0", 8) == 0;
+}
+
+/**
+ * [Descrição]: Comprime com gzip o corpo de um template ou em RAM.
+ * [Parâmetros]: 
+ *  - connection_state_t *state: estado da conexão (template já iniciado em `source.render`);
+ *  - http_response_t *response: resposta; recebe o corpo comprimido, emprestado;
+ *  - size_t *body_len: tamanho do corpo; recebe o tamanho comprimido;
+ * [Notas]: 
+ *  - O corpo inteiro é comprimido de uma vez: o Content-Length continua
+ *    conhecido (inclusive em HTTP/1.0) e o compressor (~3 KiB) é
+ *    liberado antes do envio. O resultado é liberado ao fechar a conexão.
+ *  - Sem memória, ou se não ficar menor, a resposta segue sem compressão.
+ */
+static bool gzip_body(connection_state_t *state, http_response_t *response, size_t *body_len) {
+    gzip_stream_t *gz = malloc(sizeof(gzip_stream_t));
+    uint8_t *out = gz ? malloc(gzip_bound(*body_len)) : NULL;
+    if (!out) {
+        free(gz);
+        return false;
     }
 
-    connection_state_t *state = (connection_state_t *)arg;
+    gzip_init(gz);
+    size_t out_len = 0;
+    if (response->tpl) {
+        template_render_t *render = &state->source.render;
+        const char *data;
+        size_t len;
+        bool copy;
+        while (template_render_peek(render, *body_len, &data, &len, &copy)) {
+            out_len += gzip_compress(gz, (const uint8_t *)data, len, out + out_len, false);
+            template_render_advance(render, len);
+        }
+        out_len += gzip_compress(gz, NULL, 0, out + out_len, true);
+    } else {
+        out_len = gzip_compress(gz, (const uint8_t *)response->body, *body_len, out, true);
+    }
+    free(gz);
 
-    // Assegurar que o buffer de cabeçalhos não fique cheio
-    size_t copy_len = p->tot_len < sizeof(state->headers) ? p->tot_len : sizeof(state->headers) - 1;
-    pbuf_copy_partial(p, state->headers, copy_len, 0);
-    state->headers[copy_len] = '\0'; // Null-terminate the received data
+    if (out_len >= *body_len) {
+        free(out);
+        if (response->tpl) {
+            template_render_begin(&state->source.render, response->tpl, response->tpl_values);
+        }
+        return false;
+    }
 
-    http_response_t response;
-    init_http_response(&response);
-    
-    handle_route(state->headers, &response);
+    uint8_t *shrunk = realloc(out, out_len);
+    out = shrunk ? shrunk : out;
+    response->tpl = NULL;
+    set_response_borrowed_body(response, (const char *)out, out_len, free, out);
+    *body_len = out_len;
+    return true;
+}
 
+/**
+ * [Descrição]: Monta a linha de status e os cabeçalhos e enfileira a resposta.
+ * [Parâmetros]: 
+ *  - struct tcp_pcb *tpcb: socket do cliente;
+ *  - connection_state_t *state: estado da conexão;
+ *  - http_response_t *response: resposta preenchida pela rota;
+ * [Notas]: 
+ *  - Retorna o erro de `tcp_write`, se houver.
+ *  - Respostas em stream não têm Content-Length: usam chunked em
+ *    HTTP/1.1 ou são delimitadas pelo fechamento em HTTP/1.0.
+ *  - Streams compartilhados, templates e corpos em RAM são comprimidos
+ *    com gzip quando o cliente aceita e a resposta passa de GZIP_MIN_INPUT.
+ */
+static err_t send_response(struct tcp_pcb *tpcb, connection_state_t *state, http_response_t *response) {
      // Buffer temporário para a linha de status e cabeçalhos
     char http_response_buffer[MAX_HEADERS_SIZE + 256]; // Cabeçalhos + Linha de Status + \r\n\r\n
     int offset = 0;
     size_t buffer_total_size = sizeof(http_response_buffer);
+    bool chunked = response->stream_fill && !is_http10_request(state->headers);
+    size_t body_len = response->body_len;
+    bool gzip = false;
+
+    // Streams com chave entram na geração compartilhada; o primeiro bloco
+    // é produzido já aqui para decidir a compressão antes dos cabeçalhos
+    if (response->stream_fill && response->stream_key) {
+        state->flight = single_flight_join(response->stream_key, response->stream_fill, response->stream_ctx,
+                                           http_accepts_encoding(state->headers, "gzip"));
+        gzip = state->flight && single_flight_compressed(state->flight);
+    }
+
+    // Templates: os slots são formatados agora para conhecer o Content-Length
+    if (response->tpl) {
+        long template_len = template_render_begin(&state->source.render, response->tpl, response->tpl_values);
+        if (template_len < 0) {
+            printf("WARNING: Template slot values exceed TEMPLATE_SLOT_BUFFER.\n");
+            return ERR_VAL;
+        }
+        body_len = template_len;
+    }
+
+    // Templates e corpos em RAM: comprimidos inteiros, com Content-Length
+    if (!response->stream_fill && (response->tpl || response->body) && body_len >= GZIP_MIN_INPUT &&
+        !strstr(response->headers, "Content-Length") && !strstr(response->headers, "Content-Encoding") &&
+        http_accepts_encoding(state->headers, "gzip")) {
+        gzip = gzip_body(state, response, &body_len);
+    }
 
     // 1. Linha de Status
     offset += snprintf(http_response_buffer + offset, buffer_total_size - offset,
                       "HTTP/1.1 %d %s\r\n",
-                      response.status_code, response.status_message);
+                      response->status_code, response->status_message);
 
     // 2. Adicionar cabeçalhos coletados em http_response.headers
     if (offset < buffer_total_size) {
         offset += snprintf(http_response_buffer + offset, buffer_total_size - offset,
-                          "%s", response.headers);
+                          "%s", response->headers);
     }
 
     // 3. Adicionar Content-Length (se não foi explicitamente adicionado em routes.c)
-    if (!strstr(response.headers, "Content-Length")) {
+    //    ou o modo de transferência das respostas em stream
+    if (response->stream_fill) {
         if (offset < buffer_total_size) {
             offset += snprintf(http_response_buffer + offset, buffer_total_size - offset,
-                              "Content-Length: %zu\r\n", response.body_len);
+                              "%s%s%sConnection: close\r\n",
+                              chunked ? "Transfer-Encoding: chunked\r\n" : "",
+                              gzip ? "Content-Encoding: gzip\r\n" : "",
+                              response->stream_key ? "Vary: Accept-Encoding\r\n" : "");
+        }
+    } else if (!strstr(response->headers, "Content-Length")) {
+        if (offset < buffer_total_size) {
+            offset += snprintf(http_response_buffer + offset, buffer_total_size - offset,
+                              "%sContent-Length: %zu\r\n",
+                              gzip ? "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n" : "", body_len);
         }
     }
 
@@ -155,82 +794,420 @@ static err_t tcp_server_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, er
     }
 
     // Enviar cabeçalhos e a linha de status
-    err_t wr_err = tcp_write(tpcb, http_response_buffer, offset, TCP_WRITE_FLAG_COPY);
+    err_t wr_err = queue_write(tpcb, state, http_response_buffer, offset, TCP_WRITE_FLAG_COPY);
     if (wr_err != ERR_OK) {
         printf("Error writing HTTP headers: %d\n", wr_err);
-        free_http_response(&response); // <<< IMPORTANTE: Liberar memória em caso de erro
-        close_connection(tpcb, state);
-        pbuf_free(p);
         return wr_err;
     }
 
+    // Respostas grandes cedem a vez às pequenas quando falta memória (exceto na porta de controle)
+    state->bulk = !state->listener->control &&
+                  (response->stream_fill || body_len > HTTP_BULK_BODY_MIN);
+
+    // Corpos em stream, template, geração compartilhada ou emprestados são enviados por `body_pump`
+    if (response->tpl) {
+        state->template_active = true;
+        return ERR_OK;
+    }
+    if (state->flight) {
+        state->flight_active = true;
+        state->flight_chunked = chunked;
+        state->flight_sent = 0;
+        state->flight_released = 0;
+        return ERR_OK;
+    }
+    // Sem chave ou sem vaga para compartilhar: gera sozinha, sem compressão
+    if (response->stream_fill) {
+        http_stream_init(&state->source.stream, chunked);
+        state->stream_fill = response->stream_fill;
+        state->stream_ctx = response->stream_ctx;
+        state->stream_done = false;
+        return ERR_OK;
+    }
+
+    // Corpo emprestado: enviado sem cópia por `body_pump` e devolvido ao fechar a conexão
+    if (response->borrowed_body && response->body_len > 0) {
+        state->body_release = response->body_release;
+        state->body_release_ctx = response->body_release_ctx;
+        response->body_release = NULL;
+        state->borrowed_next = response->borrowed_body;
+        state->borrowed_remaining = response->body_len;
+        return ERR_OK;
+    }
+
     // Enviar o corpo
-    if (response.body && response.body_len > 0) {
-        wr_err = tcp_write(tpcb, response.body, response.body_len, TCP_WRITE_FLAG_COPY);
+    if (response->body && response->body_len > 0) {
+        wr_err = queue_write(tpcb, state, response->body, response->body_len, TCP_WRITE_FLAG_COPY);
         if (wr_err != ERR_OK) {
             printf("Error writing HTTP body: %d\n", wr_err);
-            free_http_response(&response); // <<< IMPORTANTE: Liberar memória em caso de erro
-            close_connection(tpcb, state);
-            pbuf_free(p);
             return wr_err;
         }
     }
 
-    tcp_output(tpcb);
+    return tcp_output(tpcb);
+}
+
+/**
+ * [Descrição]: Envia a resposta; a conexão fecha quando tudo for confirmado.
+ * [Parâmetros]: 
+ *  - struct tcp_pcb *tpcb: socket do cliente;
+ *  - connection_state_t *state: estado da conexão;
+ *  - http_response_t *response: resposta a enviar (liberada aqui);
+ * [Notas]: 
+ *  - As etapas pós do middleware observam a resposta antes do envio.
+ *  - Em caso de erro a conexão é fechada imediatamente.
+ */
+static err_t respond(struct tcp_pcb *tpcb, connection_state_t *state, http_response_t *response) {
+    middleware_post(&state->ctx, response);
+    err_t wr_err = send_response(tpcb, state, response);
 
     // Limpeza: Liberar a memória alocada para o corpo da resposta
-    free_http_response(&response);
+    free_http_response(response);
+
+    if (wr_err != ERR_OK) {
+        close_connection(tpcb, state);
+        return ERR_OK;
+    }
+
+    state->responded = true;
+    if (body_pending(state)) {
+        return body_pump(tpcb, state);
+    }
+    return ERR_OK;
+}
+
+/**
+ * [Descrição]: Entrega ao handler o trecho do corpo contido em um pbuf.
+ * [Parâmetros]: 
+ *  - connection_state_t *state: estado da conexão com corpo ativo;
+ *  - struct pbuf *p: cadeia de pbufs recebida;
+ *  - u16_t offset: início do corpo dentro de `p`;
+ * [Notas]: 
+ *  - Os dados são entregues direto do payload de cada pbuf, sem cópia.
+ *  - Bytes além do Content-Length são descartados.
+ *  - Retorna 0 ou o erro informado pelo handler.
+ */
+static int feed_body(connection_state_t *state, struct pbuf *p, u16_t offset) {
+    for (struct pbuf *q = p; q && state->body_remaining > 0; q = q->next) {
+        if (offset >= q->len) {
+            offset -= q->len;
+            continue;
+        }
+        size_t n = q->len - offset;
+        if (n > state->body_remaining) {
+            n = state->body_remaining;
+        }
+        int status = state->body_handler.on_data(state->body_handler.ctx,
+                                                 (const uint8_t *)q->payload + offset, n);
+        offset = 0;
+        state->body_remaining -= n;
+        if (status) {
+            return status;
+        }
+    }
+    return 0;
+}
+
+/**
+ * [Descrição]: Processa um trecho do corpo e responde quando ele termina.
+ * [Parâmetros]: 
+ *  - struct tcp_pcb *tpcb: socket do cliente;
+ *  - connection_state_t *state: estado da conexão com corpo ativo;
+ *  - struct pbuf *p: dados recebidos;
+ *  - u16_t offset: início do corpo dentro de `p`;
+ * [Notas]: Um erro do handler encerra o corpo antecipadamente.
+ */
+static err_t process_body(struct tcp_pcb *tpcb, connection_state_t *state, struct pbuf *p, u16_t offset) {
+    int status = feed_body(state, p, offset);
+    if (status == 0 && state->body_remaining > 0) {
+        return ERR_OK; // Aguarda o restante do corpo
+    }
+
+    http_response_t response;
+    init_http_response(&response);
+    state->body_active = false;
+    state->body_handler.on_end(state->body_handler.ctx, status, &response);
+    return respond(tpcb, state, &response);
+}
+
+/**
+ * [Descrição]: Acumula os cabeçalhos da requisição e despacha a rota.
+ * [Parâmetros]: 
+ *  - struct tcp_pcb *tpcb: socket do cliente;
+ *  - connection_state_t *state: estado da conexão;
+ *  - struct pbuf *p: dados recebidos;
+ * [Notas]: 
+ *  - Os cabeçalhos podem chegar divididos em vários pbufs.
+ *  - Bytes após "\r\n\r\n" são o início do corpo da requisição.
+ *  - As etapas pré do middleware rodam antes da rota e podem respondê-la.
+ */
+static err_t process_headers(struct tcp_pcb *tpcb, connection_state_t *state, struct pbuf *p) {
+    // Assegurar que o buffer de cabeçalhos não fique cheio
+    int previous_len = state->header_len;
+    if (previous_len == 0) {
+        state->ctx.start_us = time_us_32();
+    }
+    size_t space = sizeof(state->headers) - 1 - previous_len;
+    size_t copy_len = p->tot_len < space ? p->tot_len : space;
+    pbuf_copy_partial(p, state->headers + previous_len, copy_len, 0);
+    state->header_len += copy_len;
+    state->headers[state->header_len] = '\0'; // Null-terminate the received data
+
+    http_response_t response;
+    init_http_response(&response);
+
+    // O terminador pode ter começado no pedaço anterior
+    char *end = strstr(state->headers + (previous_len > 3 ? previous_len - 3 : 0), "\r\n\r\n");
+    if (!end) {
+        if (state->header_len < (int)sizeof(state->headers) - 1) {
+            return ERR_OK; // Aguarda o restante dos cabeçalhos
+        }
+        set_response_status(&response, 431, "Request Header Fields Too Large");
+        add_response_header(&response, "Content-Type", "text/plain");
+        return respond(tpcb, state, &response);
+    }
+
+    int header_end = (end - state->headers) + 4;
+    state->headers[header_end] = '\0';
+    u16_t body_offset = header_end - previous_len;
+
+    state->ctx.route = state->listener->control ? route_match_control(state->headers)
+                                                : route_match(state->headers);
+    if (!middleware_pre(&state->ctx, &response)) {
+        return respond(tpcb, state, &response);
+    }
+
+    switch (handle_body_route(state->ctx.route, state->headers, &state->body_handler, &response)) {
+        case BODY_ROUTE_ACCEPTED: {
+            long length = http_content_length(state->headers);
+            if (length < 0) {
+                state->body_handler.on_abort(state->body_handler.ctx);
+                set_response_status(&response, 411, "Length Required");
+                add_response_header(&response, "Content-Type", "text/plain");
+                break;
+            }
+            state->body_remaining = length;
+            state->body_active = true;
+            return process_body(tpcb, state, p, body_offset);
+        }
+        case BODY_ROUTE_REJECTED:
+            break;
+        case BODY_ROUTE_NONE:
+        default:
+            handle_route(state->ctx.route, state->headers, &response);
+            break;
+    }
+    return respond(tpcb, state, &response);
+}
+
+/**
+ * [Descrição]: Callback chamado quando dados são recebidos do cliente.
+ * [Parâmetros]: 
+ *  - void *arg: ponteiro para o estado da conexão;
+ *  - struct tcp_pcb *tpcb: socket do cliente;
+ *  - struct pbuf *p: buffer contendo os dados recebidos;
+ *  - err_t err: código de erro, se houver;
+ * [Notas]: 
+ *  - Acumula os cabeçalhos, repassa o corpo (se houver) e envia a resposta.
+ *  - Dados recebidos após a resposta são descartados.
+ */
+static err_t tcp_server_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err) {
+    if (!p) {
+        // Conexão fechada pelo cliente
+        close_connection(tpcb, (connection_state_t *)arg);
+        return ERR_OK;
+    }
+
+    if (err != ERR_OK) {
+        pbuf_free(p);
+        return err;
+    }
+
+    connection_state_t *state = (connection_state_t *)arg;
+    state->idle_polls = 0;
 
-    // Definir retorno de chamada para fechar a conexão depois que os dados forem enviados
-    tcp_sent(tpcb, on_sent_close_connection);
     // Importante: Confirme os dados recebidos
     tcp_recved(tpcb, p->tot_len);
 
+    err_t result = ERR_OK;
+    if (state->body_active) {
+        result = process_body(tpcb, state, p, 0);
+    } else if (!state->responded) {
+        result = process_headers(tpcb, state, p);
+    }
+
+    pbuf_free(p);
+    return result;
+}
+
+/**
+ * [Descrição]: Callback de erro fatal da conexão (reset ou falta de memória).
+ * [Parâmetros]: 
+ *  - void *arg: ponteiro para o estado da conexão;
+ *  - err_t err: código do erro;
+ * [Notas]: O pcb já foi liberado pelo lwIP; resta liberar o estado.
+ */
+static void tcp_server_err(void *arg, err_t err) {
+    DEBUG_printf("TCP connection error: %d\n", err);
+    free_connection_state((connection_state_t *)arg);
+}
+
+/**
+ * [Descrição]: Libera uma vaga da porta derrubando uma conexão ociosa.
+ * [Parâmetros]: 
+ *  - http_listener_t *listener: porta cheia;
+ * [Notas]: 
+ *  - Só considera conexões que ainda não enviaram nada (ex: conexões
+ *    abertas antecipadamente pelo navegador), do cliente com mais conexões,
+ *    e apenas se ele tiver mais de uma.
+ *  - `tcp_abort` chama `tcp_server_err`, que libera o estado na hora.
+ */
+static bool evict_idle_connection(http_listener_t *listener) {
+    connection_state_t *victim = NULL;
+    unsigned victim_held = 1;
+    for (connection_state_t *s = connections; s; s = s->next) {
+        unsigned held = client_limit_connections(s->client);
+        if (s->listener == listener && s->header_len == 0 && !s->responded && held > victim_held) {
+            victim = s;
+            victim_held = held;
+        }
+    }
+    if (!victim) {
+        return false;
+    }
+    tcp_abort(victim->client_pcb);
+    return true;
+}
+
+/**
+ * [Descrição]: Decide se um cliente pode abrir mais uma conexão na porta.
+ * [Parâmetros]: 
+ *  - http_listener_t *listener: porta que recebeu a conexão;
+ *  - unsigned client: índice do cliente (`client_limit_index`);
+ * [Notas]: 
+ *  - Recusa acima de HTTP_MAX_CLIENT_CONNECTIONS conexões do cliente.
+ *  - Com poucas vagas, só aceita clientes sem conexão aberta, para
+ *    que um usuário novo sempre consiga entrar.
+ *  - A porta de controle não entra nesse limite: tem vagas próprias,
+ *    e conexões abertas na porta 80 não podem impedir o controle.
+ */
+static bool admit_client(http_listener_t *listener, unsigned client) {
+    if (listener->control) {
+        return true;
+    }
+    unsigned held = client_limit_connections(client);
+    if (held >= HTTP_MAX_CLIENT_CONNECTIONS) {
+        return false;
+    }
+    unsigned free_slots = listener->max_connections - listener->connections;
+    if (free_slots > HTTP_FAIR_RESERVE) {
+        return true;
+    }
+    if (held > 0) {
+        return false;
+    }
+    return free_slots > 0 || evict_idle_connection(listener);
+}
+
+// Resposta pronta para clientes acima do limite de conexões, enviada da flash
+static const char connection_limited_reply[] =
+    "HTTP/1.1 429 Too Many Requests\r\n"
+    "Retry-After: 1\r\n"
+    "Content-Length: 0\r\n"
+    "Connection: close\r\n\r\n";
+
+static err_t rejected_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err) {
+    if (!p) {
+        tcp_close(tpcb);
+        return ERR_OK;
+    }
+    tcp_recved(tpcb, p->tot_len);
     pbuf_free(p);
     return ERR_OK;
 }
 
+static err_t rejected_poll(void *arg, struct tcp_pcb *tpcb) {
+    tcp_abort(tpcb);
+    return ERR_ABRT;
+}
+
+/**
+ * [Descrição]: Responde 429 a uma conexão recusada, sem alocar estado.
+ * [Parâmetros]: 
+ *  - struct tcp_pcb *pcb: conexão recém-aceita;
+ * [Notas]: 
+ *  - A resposta pronta segue sem cópia e com FIN; a requisição que
+ *    chegar é descartada, para o cliente não receber RST antes de ler.
+ *  - Se o cliente não fechar, a conexão é abortada no próximo poll.
+ */
+static err_t reject_connection(struct tcp_pcb *pcb) {
+    tcp_arg(pcb, NULL);
+    tcp_recv(pcb, rejected_recv);
+    tcp_poll(pcb, rejected_poll, POLL_TIME_S * 4);
+    if (tcp_write(pcb, connection_limited_reply, sizeof(connection_limited_reply) - 1, 0) != ERR_OK ||
+        tcp_shutdown(pcb, 0, 1) != ERR_OK) {
+        tcp_abort(pcb);
+        return ERR_ABRT;
+    }
+    return ERR_OK;
+}
+
 /**
  * [Descrição]: Callback chamado ao aceitar uma nova conexão TCP.
  * [Parâmetros]: 
- *  - void *arg: argumento opcional (não usado aqui);
+ *  - void *arg: porta que aceitou a conexão (`http_listener_t`);
  *  - struct tcp_pcb *newpcb: novo socket para a conexão aceita;
  *  - err_t err: código de erro, se houver;
- * [Notas]: Aloca e inicializa o estado da conexão, registrando os callbacks.
+ * [Notas]: 
+ *  - Aloca e inicializa o estado da conexão, registrando os callbacks.
+ *  - Sem vaga na porta, a conexão é recusada (RST) em vez de ficar
+ *    ocupando um PCB sem ser atendida.
+ *  - Clientes acima do limite de conexões recebem 429 antes de qualquer alocação.
+ *  - Conexões paralelas demais do mesmo IP são recusadas (RST), ver `admit_client`.
+ *  - A porta de controle não consome o balde de conexões: o limite dela
+ *    é por requisição (CLIENT_CLASS_CONTROL, no middleware).
  */
 static err_t tcp_server_accept(void *arg, struct tcp_pcb *newpcb, err_t err) {
+    http_listener_t *listener = (http_listener_t *)arg;
     if (err != ERR_OK) {
         printf("TCP accept error: %d\n", err);
         return err;
     }
 
-    connection_state_t *state = calloc(1, sizeof(connection_state_t));
+    if (!listener->control && !middleware_accept(&newpcb->remote_ip)) {
+        return reject_connection(newpcb);
+    }
+
+    unsigned client = client_limit_index(&newpcb->remote_ip);
+    connection_state_t *state = admit_client(listener, client) ? alloc_connection_state(listener, client) : NULL;
     if (!state) {
-        printf("Failed to allocate connection state\n");
-        return ERR_MEM;
+        DEBUG_printf("No connection slot on port %d\n", listener->port);
+        tcp_abort(newpcb);
+        return ERR_ABRT;
     }
 
     state->client_pcb = newpcb;
+    state->ctx.request = state->headers;
+    state->ctx.route = ROUTE_NOT_FOUND;
+    state->ctx.remote = &newpcb->remote_ip;
+    state->ctx.control = listener->control;
     tcp_arg(newpcb, state);
     tcp_recv(newpcb, tcp_server_recv);
     tcp_sent(newpcb, tcp_server_sent);
-    // Caso queira um poll callback quanto a timeouts
-    // tcp_poll(newpcb, tcp_server_poll, POLL_TIME_S * 2);
-    // E o Callback de Erro
-    // tcp_err(newpcb, tcp_server_err);
+    tcp_err(newpcb, tcp_server_err);
+    // Retoma respostas em stream que aguardam dados ou memória e fecha conexões ociosas
+    tcp_poll(newpcb, tcp_server_poll, POLL_TIME_S * 2);
     return ERR_OK;
 }
 
 /**
- * [Descrição]: Inicia o servidor HTTP e escuta por conexões na porta 80.
+ * [Descrição]: Abre uma porta de escuta do servidor.
  * [Parâmetros]: 
- *  - nenhum
- * [Notas]: 
- *      - Deve ser chamado após a inicialização da rede no modo AP.
- *      - Usa `tcp_accept` para registrar o callback de conexões.
+ *  - http_listener_t *listener: porta, prioridade e limite de conexões;
+ * [Notas]: As conexões aceitas herdam a prioridade do PCB de escuta.
  */
-void http_server_start(void) {
-    printf("HTTP server starting on port %d\n", TCP_PORT);
+static void start_listener(http_listener_t *listener) {
+    printf("HTTP server starting on port %d\n", listener->port);
 
     struct tcp_pcb *pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
     if (!pcb) {
@@ -238,7 +1215,8 @@ void http_server_start(void) {
         return;
     }
 
-    if (tcp_bind(pcb, IP_ANY_TYPE, TCP_PORT) != ERR_OK) {
+    tcp_setprio(pcb, listener->prio);
+    if (tcp_bind(pcb, IP_ANY_TYPE, listener->port) != ERR_OK) {
         printf("Failed to bind TCP\n");
         tcp_close(pcb);
         return;
@@ -251,5 +1229,20 @@ void http_server_start(void) {
         return;
     }
 
+    tcp_arg(listen_pcb, listener);
     tcp_accept(listen_pcb, tcp_server_accept);
+}
+
+/**
+ * [Descrição]: Inicia o servidor HTTP na porta 80 e na porta de controle.
+ * [Parâmetros]: 
+ *  - nenhum
+ * [Notas]: 
+ *      - Deve ser chamado após a inicialização da rede no modo AP.
+ *      - Usa `tcp_accept` para registrar o callback de conexões.
+ */
+void http_server_start(void) {
+    for (size_t i = 0; i < sizeof(listeners) / sizeof(listeners[0]); i++) {
+        start_listener(&listeners[i]);
+    }
 }
\ No newline at end of file
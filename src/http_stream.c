@@ -0,0 +1,152 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: http_stream.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Este módulo implementa o escritor usado pelas respostas
+ *      geradas sob demanda. O handler escreve em um buffer fixo
+ *      e o servidor envia cada bloco como um chunk de
+ *      `Transfer-Encoding: chunked`, de modo que a memória usada
+ *      não depende do tamanho total da resposta.
+ */
+#include "http_stream.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+/**
+ * [Descrição]: Inicializa o escritor de uma resposta em stream.
+ * [Parâmetros]:
+ *  - http_stream_t *stream: escritor a ser inicializado;
+ *  - bool chunked: true para HTTP/1.1 (chunked), false para HTTP/1.0;
+ * [Notas]: Zera o cursor do gerador.
+ */
+void http_stream_init(http_stream_t *stream, bool chunked) {
+    stream->len = 0;
+    stream->cursor = 0;
+    stream->chunked = chunked;
+}
+
+/**
+ * [Descrição]: Informa quantos bytes ainda cabem no bloco atual.
+ * [Parâmetros]:
+ *  - const http_stream_t *stream: escritor;
+ * [Notas]: Útil para geradores que escrevem itens de tamanho variável.
+ */
+size_t http_stream_space(const http_stream_t *stream) {
+    return HTTP_STREAM_BUFFER_SIZE - stream->len;
+}
+
+/**
+ * [Descrição]: Acrescenta dados ao bloco atual.
+ * [Parâmetros]:
+ *  - http_stream_t *stream: escritor;
+ *  - const void *data: dados a escrever;
+ *  - size_t len: quantidade de bytes;
+ * [Notas]:
+ *  - A escrita é atômica: se os dados não couberem, nada é escrito
+ *    e a função retorna false. O gerador deve parar e retomar o
+ *    mesmo item na próxima chamada.
+ */
+bool http_stream_write(http_stream_t *stream, const void *data, size_t len) {
+    if (len > http_stream_space(stream)) {
+        return false;
+    }
+    memcpy(stream->frame + HTTP_STREAM_HEADROOM + stream->len, data, len);
+    stream->len += len;
+    return true;
+}
+
+/**
+ * [Descrição]: Acrescenta texto formatado ao bloco atual.
+ * [Parâmetros]:
+ *  - http_stream_t *stream: escritor;
+ *  - const char *format: string de formatação (como printf);
+ *  - ...: argumentos adicionais para a formatação;
+ * [Notas]: Atômica como `http_stream_write`; formata direto no bloco.
+ */
+bool http_stream_printf(http_stream_t *stream, const char *format, ...) {
+    size_t space = http_stream_space(stream);
+    char *dest = stream->frame + HTTP_STREAM_HEADROOM + stream->len;
+
+    va_list args;
+    va_start(args, format);
+    // +1: vsnprintf precisa de espaço para o '\0', sobreposto pelo CRLF final
+    int written = vsnprintf(dest, space + 1, format, args);
+    va_end(args);
+
+    if (written < 0 || (size_t)written > space) {
+        return false;
+    }
+    stream->len += written;
+    return true;
+}
+
+/**
+ * [Descrição]: Expõe o espaço livre do bloco para escrita direta.
+ * [Parâmetros]:
+ *  - http_stream_t *stream: escritor;
+ *  - size_t *space: recebe quantos bytes podem ser escritos;
+ * [Notas]:
+ *  - Permite que outro escritor (ex: `json_writer_t`) grave direto
+ *    no bloco, sem buffer intermediário.
+ *  - Nada é enviado até `http_stream_commit`; descartar é só não confirmar.
+ */
+char *http_stream_reserve(http_stream_t *stream, size_t *space) {
+    *space = http_stream_space(stream);
+    return stream->frame + HTTP_STREAM_HEADROOM + stream->len;
+}
+
+/**
+ * [Descrição]: Confirma bytes escritos no espaço obtido com `http_stream_reserve`.
+ * [Parâmetros]:
+ *  - http_stream_t *stream: escritor;
+ *  - size_t len: bytes escritos;
+ * [Notas]: `len` é limitado ao espaço livre.
+ */
+void http_stream_commit(http_stream_t *stream, size_t len) {
+    size_t space = http_stream_space(stream);
+    stream->len += len < space ? len : space;
+}
+
+/**
+ * [Descrição]: Enquadra o bloco atual para envio.
+ * [Parâmetros]:
+ *  - http_stream_t *stream: escritor com dados pendentes;
+ *  - size_t *frame_len: recebe o tamanho do bloco enquadrado;
+ * [Notas]:
+ *  - Em modo chunked, escreve o tamanho em hexa no espaço reservado
+ *    antes dos dados e o CRLF depois deles, sem mover os dados.
+ *  - Pode ser chamada de novo se o envio falhar; após enviar,
+ *    chame `http_stream_consume` para liberar o bloco.
+ */
+const char *http_stream_frame(http_stream_t *stream, size_t *frame_len) {
+    char *data = stream->frame + HTTP_STREAM_HEADROOM;
+    size_t len = stream->len;
+
+    if (!stream->chunked) {
+        *frame_len = len;
+        return data;
+    }
+
+    char size_line[HTTP_STREAM_HEADROOM + 1];
+    int n = snprintf(size_line, sizeof(size_line), "%X\r\n", (unsigned)len);
+    memcpy(data - n, size_line, n);
+    data[len] = '\r';
+    data[len + 1] = '\n';
+    *frame_len = n + len + HTTP_STREAM_TAILROOM;
+    return data - n;
+}
+
+/**
+ * [Descrição]: Descarta o bloco atual depois de enviado.
+ * [Parâmetros]:
+ *  - http_stream_t *stream: escritor;
+ * [Notas]: O gerador volta a ter o bloco inteiro disponível.
+ */
+void http_stream_consume(http_stream_t *stream) {
+    stream->len = 0;
+}
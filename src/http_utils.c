@@ -8,10 +8,14 @@
  * Descrição: 
  *      Este módulo fornece utilitários auxiliares para 
  *      formatação e geração de respostas HTTP.
- *      Atualmente, implementa a função de construção de cabeçalhos HTTP.
+ *      Implementa a construção de cabeçalhos HTTP e a leitura
+ *      de cabeçalhos da requisição recebida.
  */
 #include "http_utils.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
 
 /**
  * [Descrição]: Constrói os cabeçalhos HTTP padrão para uma resposta.
@@ -33,3 +37,96 @@ int build_http_headers(char *buffer, size_t max_len, int status_code, const char
         "Connection: close\n\n",
         status_code, content_length, content_type);
 }
+
+/**
+ * [Descrição]: Localiza um cabeçalho na requisição HTTP recebida.
+ * [Parâmetros]:
+ *  - const char *request: requisição terminada em '\0' (linha inicial + cabeçalhos);
+ *  - const char *name: nome do cabeçalho, sem ':' (ex: "Content-Type");
+ *  - size_t *value_len: recebe o tamanho do valor encontrado;
+ * [Notas]:
+ *  - A comparação do nome ignora maiúsculas/minúsculas.
+ *  - Retorna ponteiro para o valor dentro de `request` ou NULL.
+ */
+const char *http_find_header(const char *request, const char *name, size_t *value_len) {
+    size_t name_len = strlen(name);
+    const char *line = strstr(request, "\r\n");
+
+    while (line && line[2] != '\0' && line[2] != '\r') {
+        line += 2;
+        if (strncasecmp(line, name, name_len) == 0 && line[name_len] == ':') {
+            const char *value = line + name_len + 1;
+            while (*value == ' ' || *value == '\t') value++;
+            const char *end = strstr(value, "\r\n");
+            *value_len = end ? (size_t)(end - value) : strlen(value);
+            return value;
+        }
+        line = strstr(line, "\r\n");
+    }
+    return NULL;
+}
+
+/**
+ * [Descrição]: Lê o valor do cabeçalho Content-Length.
+ * [Parâmetros]:
+ *  - const char *request: requisição terminada em '\0';
+ * [Notas]: Retorna -1 se o cabeçalho não existir ou for inválido.
+ */
+long http_content_length(const char *request) {
+    size_t len;
+    const char *value = http_find_header(request, "Content-Length", &len);
+    if (!value || len == 0) {
+        return -1;
+    }
+
+    char *end;
+    long length = strtol(value, &end, 10);
+    if (end == value || length < 0) {
+        return -1;
+    }
+    return length;
+}
+
+/**
+ * [Descrição]: Verifica se o cliente aceita uma codificação de conteúdo.
+ * [Parâmetros]:
+ *  - const char *request: requisição terminada em '\0';
+ *  - const char *encoding: codificação (ex: "gzip");
+ * [Notas]:
+ *  - Lê o cabeçalho Accept-Encoding; `*` também aceita a codificação.
+ *  - Itens com `q=0` são tratados como recusa.
+ */
+bool http_accepts_encoding(const char *request, const char *encoding) {
+    size_t len;
+    const char *value = http_find_header(request, "Accept-Encoding", &len);
+    const char *end = value ? value + len : NULL;
+    size_t enc_len = strlen(encoding);
+
+    while (value && value < end) {
+        while (value < end && (*value == ' ' || *value == ',')) value++;
+        const char *item = value;
+        while (value < end && *value != ',') value++;
+
+        size_t name_len = strcspn(item, " ;,\r");
+        if (item + name_len > value) {
+            name_len = value - item;
+        }
+        bool matches = (name_len == enc_len && strncasecmp(item, encoding, enc_len) == 0) ||
+                       (name_len == 1 && *item == '*');
+        if (!matches) {
+            continue;
+        }
+
+        // Peso zero ("q=0", "q=0.0", ...) recusa a codificação
+        const char *q = item + name_len;
+        while (q < value && (*q == ' ' || *q == ';')) q++;
+        if (q + 2 <= value && (q[0] == 'q' || q[0] == 'Q') && q[1] == '=') {
+            char *q_end;
+            if (strtod(q + 2, &q_end) == 0.0 && q_end > q + 2) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
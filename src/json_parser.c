@@ -0,0 +1,434 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: json_parser.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Este módulo implementa um tokenizador JSON no estilo do jsmn:
+ *      o texto é percorrido uma única vez e cada valor vira um token
+ *      (tipo, início, fim, filhos) em um array fornecido pelo chamador.
+ *      Não há alocação nem recursão, então a pilha usada é constante.
+ *      Funções de acesso leem campos de objetos já tokenizados.
+ */
+#include "json_parser.h"
+#include <string.h>
+#include <limits.h>
+
+// O que o tokenizador aceita a seguir
+typedef enum {
+    EXPECT_VALUE,
+    EXPECT_VALUE_OR_CLOSE,          // Logo após '['
+    EXPECT_KEY,
+    EXPECT_KEY_OR_CLOSE,            // Logo após '{'
+    EXPECT_COLON,
+    EXPECT_COMMA_OR_CLOSE,
+    EXPECT_END                      // Valor raiz concluído
+} json_expect_t;
+
+typedef struct {
+    json_token_t *tokens;
+    unsigned max_tokens;
+    int next;
+    int super;                      // Contêiner (ou chave) atual; -1 na raiz
+    json_expect_t expect;
+} json_state_t;
+
+static json_token_t *new_token(json_state_t *st, json_type_t type, size_t start) {
+    if ((unsigned)st->next >= st->max_tokens) {
+        return NULL;
+    }
+    json_token_t *t = &st->tokens[st->next++];
+    t->type = type;
+    t->start = (uint16_t)start;
+    t->end = 0;
+    t->size = 0;
+    t->parent = (int16_t)st->super;
+    if (st->super >= 0) {
+        st->tokens[st->super].size++;
+    }
+    return t;
+}
+
+/**
+ * [Descrição]: Atualiza o estado após um valor completo.
+ * [Parâmetros]:
+ *  - json_state_t *st: estado do tokenizador;
+ * [Notas]: Se o valor pertencia a uma chave, volta ao objeto dono dela.
+ */
+static void value_done(json_state_t *st) {
+    if (st->super >= 0 && st->tokens[st->super].type == JSON_STRING) {
+        st->super = st->tokens[st->super].parent;
+    }
+    st->expect = st->super < 0 ? EXPECT_END : EXPECT_COMMA_OR_CLOSE;
+}
+
+static bool is_hex(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * [Descrição]: Procura o fim de uma string, validando os escapes.
+ * [Parâmetros]:
+ *  - const char *js: texto;
+ *  - size_t len: tamanho do texto;
+ *  - size_t pos: posição logo após a aspa de abertura;
+ * [Notas]: Retorna a posição da aspa de fechamento, ou um erro negativo.
+ */
+static long scan_string(const char *js, size_t len, size_t pos) {
+    for (; pos < len; pos++) {
+        unsigned char c = (unsigned char)js[pos];
+        if (c == '"') {
+            return (long)pos;
+        }
+        if (c < 0x20) {
+            return JSON_ERR_INVAL;
+        }
+        if (c != '\\') {
+            continue;
+        }
+        if (++pos >= len) {
+            return JSON_ERR_PART;
+        }
+        switch (js[pos]) {
+            case '"': case '\\': case '/': case 'b':
+            case 'f': case 'n': case 'r': case 't':
+                break;
+            case 'u':
+                for (int i = 0; i < 4; i++) {
+                    if (++pos >= len) return JSON_ERR_PART;
+                    if (!is_hex(js[pos])) return JSON_ERR_INVAL;
+                }
+                break;
+            default:
+                return JSON_ERR_INVAL;
+        }
+    }
+    return JSON_ERR_PART;
+}
+
+/**
+ * [Descrição]: Valida um primitivo (número, true, false ou null).
+ * [Parâmetros]:
+ *  - const char *s: início do primitivo;
+ *  - size_t n: tamanho;
+ * [Notas]: Números seguem a gramática da RFC 8259.
+ */
+static bool valid_primitive(const char *s, size_t n) {
+    if ((n == 4 && memcmp(s, "true", 4) == 0) || (n == 5 && memcmp(s, "false", 5) == 0) ||
+        (n == 4 && memcmp(s, "null", 4) == 0)) {
+        return true;
+    }
+
+    size_t i = 0;
+    if (i < n && s[i] == '-') i++;
+    if (i >= n) return false;
+    if (s[i] == '0') {
+        i++;
+    } else if (is_digit(s[i])) {
+        while (i < n && is_digit(s[i])) i++;
+    } else {
+        return false;
+    }
+    if (i < n && s[i] == '.') {
+        if (++i >= n || !is_digit(s[i])) return false;
+        while (i < n && is_digit(s[i])) i++;
+    }
+    if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+        i++;
+        if (i < n && (s[i] == '+' || s[i] == '-')) i++;
+        if (i >= n || !is_digit(s[i])) return false;
+        while (i < n && is_digit(s[i])) i++;
+    }
+    return i == n;
+}
+
+static json_type_t container_type(const json_state_t *st) {
+    return st->super >= 0 ? (json_type_t)st->tokens[st->super].type : JSON_UNDEFINED;
+}
+
+/**
+ * [Descrição]: Tokeniza um documento JSON.
+ * [Parâmetros]:
+ *  - const char *js: texto (não precisa terminar em '\0');
+ *  - size_t len: tamanho do texto;
+ *  - json_token_t *tokens: array de tokens do chamador;
+ *  - unsigned max_tokens: capacidade do array;
+ * [Notas]:
+ *  - Retorna o número de tokens ou um JSON_ERR_*.
+ *  - O texto não é modificado; os tokens apontam para ele por posição.
+ *  - Aceita exatamente um valor na raiz, cercado ou não de espaços.
+ */
+int json_parse(const char *js, size_t len, json_token_t *tokens, unsigned max_tokens) {
+    if (len > UINT16_MAX) {
+        return JSON_ERR_SIZE;
+    }
+    if (max_tokens > INT16_MAX) {
+        max_tokens = INT16_MAX;
+    }
+
+    json_state_t st = {
+        .tokens = tokens,
+        .max_tokens = max_tokens,
+        .next = 0,
+        .super = -1,
+        .expect = EXPECT_VALUE
+    };
+
+    for (size_t pos = 0; pos < len; pos++) {
+        char c = js[pos];
+        json_token_t *t;
+
+        switch (c) {
+            case ' ': case '\t': case '\r': case '\n':
+                break;
+
+            case '{': case '[':
+                if (st.expect != EXPECT_VALUE && st.expect != EXPECT_VALUE_OR_CLOSE) {
+                    return JSON_ERR_INVAL;
+                }
+                t = new_token(&st, c == '{' ? JSON_OBJECT : JSON_ARRAY, pos);
+                if (!t) return JSON_ERR_NOMEM;
+                st.super = st.next - 1;
+                st.expect = c == '{' ? EXPECT_KEY_OR_CLOSE : EXPECT_VALUE_OR_CLOSE;
+                break;
+
+            case '}': case ']':
+                if (c == '}' && st.expect != EXPECT_KEY_OR_CLOSE && st.expect != EXPECT_COMMA_OR_CLOSE) {
+                    return JSON_ERR_INVAL;
+                }
+                if (c == ']' && st.expect != EXPECT_VALUE_OR_CLOSE && st.expect != EXPECT_COMMA_OR_CLOSE) {
+                    return JSON_ERR_INVAL;
+                }
+                if (container_type(&st) != (c == '}' ? JSON_OBJECT : JSON_ARRAY)) {
+                    return JSON_ERR_INVAL;
+                }
+                t = &tokens[st.super];
+                t->end = (uint16_t)(pos + 1);
+                st.super = t->parent;
+                value_done(&st);
+                break;
+
+            case ':':
+                if (st.expect != EXPECT_COLON) return JSON_ERR_INVAL;
+                st.expect = EXPECT_VALUE;
+                break;
+
+            case ',':
+                if (st.expect != EXPECT_COMMA_OR_CLOSE) return JSON_ERR_INVAL;
+                st.expect = container_type(&st) == JSON_OBJECT ? EXPECT_KEY : EXPECT_VALUE;
+                break;
+
+            case '"': {
+                bool is_key = st.expect == EXPECT_KEY || st.expect == EXPECT_KEY_OR_CLOSE;
+                if (!is_key && st.expect != EXPECT_VALUE && st.expect != EXPECT_VALUE_OR_CLOSE) {
+                    return JSON_ERR_INVAL;
+                }
+                long end = scan_string(js, len, pos + 1);
+                if (end < 0) return (int)end;
+                t = new_token(&st, JSON_STRING, pos + 1);
+                if (!t) return JSON_ERR_NOMEM;
+                t->end = (uint16_t)end;
+                pos = (size_t)end;
+                if (is_key) {
+                    st.super = st.next - 1;
+                    st.expect = EXPECT_COLON;
+                } else {
+                    value_done(&st);
+                }
+                break;
+            }
+
+            default: {
+                if (st.expect != EXPECT_VALUE && st.expect != EXPECT_VALUE_OR_CLOSE) {
+                    return JSON_ERR_INVAL;
+                }
+                size_t end = pos;
+                while (end < len && strchr(" \t\r\n,]}:", js[end]) == NULL) {
+                    end++;
+                }
+                if (end == len && st.super >= 0) {
+                    return JSON_ERR_PART;
+                }
+                if (!valid_primitive(js + pos, end - pos)) {
+                    return JSON_ERR_INVAL;
+                }
+                t = new_token(&st, JSON_PRIMITIVE, pos);
+                if (!t) return JSON_ERR_NOMEM;
+                t->end = (uint16_t)end;
+                pos = end - 1;
+                value_done(&st);
+                break;
+            }
+        }
+    }
+
+    return st.expect == EXPECT_END ? st.next : JSON_ERR_PART;
+}
+
+/**
+ * [Descrição]: Pula um token e todos os seus descendentes.
+ * [Parâmetros]:
+ *  - const json_token_t *tokens: tokens de `json_parse`;
+ *  - int count: número de tokens;
+ *  - int index: token a pular;
+ * [Notas]: Retorna o índice do próximo irmão (ou `count`).
+ */
+int json_skip(const json_token_t *tokens, int count, int index) {
+    int pending = 1;
+    while (pending > 0 && index < count) {
+        pending += tokens[index].size - 1;
+        index++;
+    }
+    return index;
+}
+
+/**
+ * [Descrição]: Compara o texto de um token com uma string.
+ * [Parâmetros]:
+ *  - const char *js: texto original;
+ *  - const json_token_t *token: token;
+ *  - const char *str: texto esperado;
+ * [Notas]: Comparação literal, sem interpretar escapes.
+ */
+bool json_token_equals(const char *js, const json_token_t *token, const char *str) {
+    size_t n = token->end - token->start;
+    return strlen(str) == n && memcmp(js + token->start, str, n) == 0;
+}
+
+/**
+ * [Descrição]: Procura o valor de uma chave em um objeto.
+ * [Parâmetros]:
+ *  - const char *js: texto original;
+ *  - const json_token_t *tokens: tokens de `json_parse`;
+ *  - int count: número de tokens;
+ *  - int object: índice do objeto (0 para a raiz);
+ *  - const char *key: chave procurada;
+ * [Notas]: Retorna o índice do token de valor, ou -1 se não existir.
+ */
+int json_find_key(const char *js, const json_token_t *tokens, int count, int object, const char *key) {
+    if (object < 0 || object >= count || tokens[object].type != JSON_OBJECT) {
+        return -1;
+    }
+    int index = object + 1;
+    for (unsigned i = 0; i < tokens[object].size && index + 1 < count; i++) {
+        if (json_token_equals(js, &tokens[index], key)) {
+            return index + 1;
+        }
+        index = json_skip(tokens, count, index + 1);
+    }
+    return -1;
+}
+
+/**
+ * [Descrição]: Lê um campo inteiro de 32 bits.
+ * [Parâmetros]:
+ *  - (ver `json_find_key`);
+ *  - int32_t *out: recebe o valor;
+ * [Notas]: Falha se o campo não existir, não for inteiro ou não couber em int32_t.
+ */
+bool json_get_int(const char *js, const json_token_t *tokens, int count, int object,
+                  const char *key, int32_t *out) {
+    int index = json_find_key(js, tokens, count, object, key);
+    if (index < 0 || tokens[index].type != JSON_PRIMITIVE) {
+        return false;
+    }
+
+    const char *s = js + tokens[index].start;
+    const char *end = js + tokens[index].end;
+    bool negative = *s == '-';
+    if (negative) s++;
+    if (s == end || !is_digit(*s)) {
+        return false;
+    }
+
+    uint32_t limit = negative ? (uint32_t)INT32_MAX + 1 : INT32_MAX;
+    uint32_t value = 0;
+    for (; s < end; s++) {
+        if (!is_digit(*s)) return false;     // Frações e expoentes
+        uint32_t digit = (uint32_t)(*s - '0');
+        if (value > (limit - digit) / 10) return false;
+        value = value * 10 + digit;
+    }
+    *out = negative ? (int32_t)(0 - value) : (int32_t)value;
+    return true;
+}
+
+/**
+ * [Descrição]: Lê um campo booleano.
+ * [Parâmetros]:
+ *  - (ver `json_find_key`);
+ *  - bool *out: recebe o valor;
+ * [Notas]: Aceita apenas `true` e `false`.
+ */
+bool json_get_bool(const char *js, const json_token_t *tokens, int count, int object,
+                   const char *key, bool *out) {
+    int index = json_find_key(js, tokens, count, object, key);
+    if (index < 0 || tokens[index].type != JSON_PRIMITIVE) {
+        return false;
+    }
+    if (json_token_equals(js, &tokens[index], "true")) {
+        *out = true;
+        return true;
+    }
+    if (json_token_equals(js, &tokens[index], "false")) {
+        *out = false;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * [Descrição]: Copia um campo string, interpretando os escapes.
+ * [Parâmetros]:
+ *  - (ver `json_find_key`);
+ *  - char *out: destino (terminado em '\0');
+ *  - size_t out_size: tamanho do destino;
+ * [Notas]:
+ *  - Retorna o tamanho copiado, ou -1 se o campo não existir,
+ *    não for string ou não couber.
+ *  - `\uXXXX` fora do ASCII é substituído por '?'.
+ */
+int json_get_string(const char *js, const json_token_t *tokens, int count, int object,
+                    const char *key, char *out, size_t out_size) {
+    int index = json_find_key(js, tokens, count, object, key);
+    if (index < 0 || tokens[index].type != JSON_STRING || out_size == 0) {
+        return -1;
+    }
+
+    size_t n = 0;
+    for (size_t i = tokens[index].start; i < tokens[index].end; i++) {
+        char c = js[i];
+        if (c == '\\') {
+            c = js[++i];
+            switch (c) {
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'u': {
+                    unsigned code = 0;
+                    for (int k = 0; k < 4; k++) {
+                        char h = js[++i];
+                        code = code * 16 + (unsigned)(h <= '9' ? h - '0' : (h | 0x20) - 'a' + 10);
+                    }
+                    c = (code > 0 && code < 0x80) ? (char)code : '?';
+                    break;
+                }
+                default: break;  // '"', '\\' e '/'
+            }
+        }
+        if (n + 1 >= out_size) {
+            return -1;
+        }
+        out[n++] = c;
+    }
+    out[n] = '\0';
+    return (int)n;
+}
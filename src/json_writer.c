@@ -0,0 +1,247 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: json_writer.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Este módulo implementa um escritor JSON que grava direto
+ *      em um buffer fornecido pelo chamador (um buffer de rascunho
+ *      ou o bloco livre de um `http_stream_t`), sem `malloc` e sem
+ *      `printf`. Vírgulas, escape de strings e profundidade de
+ *      aninhamento são controlados pelo escritor; qualquer estouro
+ *      marca o erro e as escritas seguintes são ignoradas.
+ */
+#include "json_writer.h"
+#include <string.h>
+
+/**
+ * [Descrição]: Inicializa o escritor sobre um buffer.
+ * [Parâmetros]:
+ *  - json_writer_t *w: escritor;
+ *  - char *buf: buffer de destino;
+ *  - size_t cap: tamanho do buffer;
+ * [Notas]: O resultado não é terminado em '\0'; use o tamanho de `json_writer_finish`.
+ */
+void json_writer_init(json_writer_t *w, char *buf, size_t cap) {
+    w->buf = buf;
+    w->cap = cap;
+    w->len = 0;
+    w->depth = 0;
+    w->has_items = 0;
+    w->in_object = 0;
+    w->after_key = false;
+    w->error = false;
+}
+
+/**
+ * [Descrição]: Encerra a escrita e valida o documento.
+ * [Parâmetros]:
+ *  - json_writer_t *w: escritor;
+ * [Notas]: Retorna o tamanho escrito ou 0 se houve erro ou aninhamento aberto.
+ */
+size_t json_writer_finish(json_writer_t *w) {
+    if (w->error || w->depth != 0 || w->after_key) {
+        return 0;
+    }
+    return w->len;
+}
+
+static void put(json_writer_t *w, const char *data, size_t len) {
+    if (w->error || len > w->cap - w->len) {
+        w->error = true;
+        return;
+    }
+    memcpy(w->buf + w->len, data, len);
+    w->len += len;
+}
+
+static void put_char(json_writer_t *w, char c) {
+    if (w->error || w->len >= w->cap) {
+        w->error = true;
+        return;
+    }
+    w->buf[w->len++] = c;
+}
+
+/**
+ * [Descrição]: Prepara a escrita de um valor no nível atual.
+ * [Parâmetros]:
+ *  - json_writer_t *w: escritor;
+ * [Notas]:
+ *  - Insere a vírgula entre itens.
+ *  - Dentro de objetos, um valor só é aceito logo após `json_key`.
+ */
+static void begin_value(json_writer_t *w) {
+    if (w->depth > 0) {
+        uint8_t bit = 1u << (w->depth - 1);
+        if (w->in_object & bit) {
+            if (!w->after_key) {
+                w->error = true;
+                return;
+            }
+            w->after_key = false;
+            return; // A vírgula foi escrita junto com a chave
+        }
+        if (w->has_items & bit) {
+            put_char(w, ',');
+        }
+        w->has_items |= bit;
+    }
+}
+
+static void open_level(json_writer_t *w, char c, bool object) {
+    begin_value(w);
+    if (w->depth >= JSON_WRITER_MAX_DEPTH) {
+        w->error = true;
+        return;
+    }
+    put_char(w, c);
+    uint8_t bit = 1u << w->depth;
+    w->has_items &= ~bit;
+    w->in_object = object ? (w->in_object | bit) : (w->in_object & ~bit);
+    w->depth++;
+}
+
+static void close_level(json_writer_t *w, char c, bool object) {
+    if (w->depth == 0 || w->after_key ||
+        (bool)(w->in_object & (1u << (w->depth - 1))) != object) {
+        w->error = true;
+        return;
+    }
+    w->depth--;
+    put_char(w, c);
+}
+
+void json_begin_object(json_writer_t *w) { open_level(w, '{', true); }
+void json_end_object(json_writer_t *w) { close_level(w, '}', true); }
+void json_begin_array(json_writer_t *w) { open_level(w, '[', false); }
+void json_end_array(json_writer_t *w) { close_level(w, ']', false); }
+
+/**
+ * [Descrição]: Escreve uma string JSON com escape.
+ * [Parâmetros]:
+ *  - json_writer_t *w: escritor;
+ *  - const char *str: texto em UTF-8;
+ * [Notas]: Escapa aspas, barra invertida e caracteres de controle.
+ */
+static void put_string(json_writer_t *w, const char *str) {
+    static const char hex[] = "0123456789abcdef";
+
+    put_char(w, '"');
+    const char *run = str;
+    for (; *str; str++) {
+        unsigned char c = (unsigned char)*str;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        put(w, run, str - run);
+        char esc[6] = { '\\', 0 };
+        size_t esc_len = 2;
+        switch (c) {
+            case '"':  esc[1] = '"'; break;
+            case '\\': esc[1] = '\\'; break;
+            case '\n': esc[1] = 'n'; break;
+            case '\r': esc[1] = 'r'; break;
+            case '\t': esc[1] = 't'; break;
+            default:
+                memcpy(esc + 1, "u00", 3);
+                esc[4] = hex[c >> 4];
+                esc[5] = hex[c & 0xF];
+                esc_len = 6;
+                break;
+        }
+        put(w, esc, esc_len);
+        run = str + 1;
+    }
+    put(w, run, str - run);
+    put_char(w, '"');
+}
+
+/**
+ * [Descrição]: Escreve a chave do próximo par em um objeto.
+ * [Parâmetros]:
+ *  - json_writer_t *w: escritor;
+ *  - const char *key: nome do campo;
+ * [Notas]: Deve ser seguida de exatamente um valor.
+ */
+void json_key(json_writer_t *w, const char *key) {
+    if (w->depth == 0 || !(w->in_object & (1u << (w->depth - 1))) || w->after_key) {
+        w->error = true;
+        return;
+    }
+    uint8_t bit = 1u << (w->depth - 1);
+    if (w->has_items & bit) {
+        put_char(w, ',');
+    }
+    w->has_items |= bit;
+    put_string(w, key);
+    put_char(w, ':');
+    w->after_key = true;
+}
+
+void json_string(json_writer_t *w, const char *str) {
+    begin_value(w);
+    put_string(w, str ? str : "");
+}
+
+/**
+ * [Descrição]: Escreve um número decimal sem sinal.
+ * [Parâmetros]:
+ *  - json_writer_t *w: escritor;
+ *  - uint32_t value: valor;
+ * [Notas]: Converte sem usar `printf`.
+ */
+static void put_decimal(json_writer_t *w, uint32_t value) {
+    char digits[10];
+    size_t n = sizeof(digits);
+    do {
+        digits[--n] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    put(w, digits + n, sizeof(digits) - n);
+}
+
+void json_uint(json_writer_t *w, uint32_t value) {
+    begin_value(w);
+    put_decimal(w, value);
+}
+
+void json_int(json_writer_t *w, int32_t value) {
+    begin_value(w);
+    if (value < 0) {
+        put_char(w, '-');
+        put_decimal(w, (uint32_t)(-(int64_t)value));
+    } else {
+        put_decimal(w, (uint32_t)value);
+    }
+}
+
+void json_bool(json_writer_t *w, bool value) {
+    begin_value(w);
+    if (value) {
+        put(w, "true", 4);
+    } else {
+        put(w, "false", 5);
+    }
+}
+
+void json_null(json_writer_t *w) {
+    begin_value(w);
+    put(w, "null", 4);
+}
+
+/**
+ * [Descrição]: Escreve texto já formatado, sem validação.
+ * [Parâmetros]:
+ *  - json_writer_t *w: escritor;
+ *  - const char *text: texto;
+ *  - size_t len: tamanho do texto;
+ * [Notas]:
+ *  - Não insere vírgulas nem altera o aninhamento; serve para unir
+ *    documentos escritos em blocos separados (ex: itens de um stream).
+ */
+void json_raw(json_writer_t *w, const char *text, size_t len) {
+    put(w, text, len);
+}
@@ -0,0 +1,272 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: middleware.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Este módulo implementa o pipeline de middleware em volta das
+ *      rotas: etapas pré (antes da rota, podendo responder no lugar
+ *      dela) e pós (com a resposta pronta, antes do envio). As etapas
+ *      são escolhidas em `middleware_config.h`: as desabilitadas nem
+ *      são compiladas e cada etapa habilitada custa uma chamada
+ *      indireta por requisição.
+ *
+ *      Etapas disponíveis:
+ *          - Limite de conexões e requisições por cliente (aceite e pré,
+ *            token buckets por IP e classe em `client_limit.c`);
+ *          - Autenticação Basic das rotas de administração (pré);
+ *          - Métricas por rota (pós);
+ *          - Log de acesso (pós).
+ */
+#include "middleware.h"
+#include "client_limit.h"
+#include "pico/time.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#if MIDDLEWARE_ENABLED
+
+#if MIDDLEWARE_METRICS || MIDDLEWARE_ACCESS_LOG
+static uint32_t elapsed_us(const http_context_t *ctx) {
+    return time_us_32() - ctx->start_us;
+}
+#endif
+
+#if MIDDLEWARE_RATE_LIMIT
+static const client_rate_t client_rates[CLIENT_CLASS_COUNT] = {
+    [CLIENT_CLASS_CONNECT] = { RATE_LIMIT_CONNECT_PER_S, RATE_LIMIT_CONNECT_BURST },
+    [CLIENT_CLASS_PROBE]   = { RATE_LIMIT_PROBE_PER_S, RATE_LIMIT_PROBE_BURST },
+    [CLIENT_CLASS_ASSET]   = { RATE_LIMIT_ASSET_PER_S, RATE_LIMIT_ASSET_BURST },
+    [CLIENT_CLASS_CONTROL] = { RATE_LIMIT_CONTROL_PER_S, RATE_LIMIT_CONTROL_BURST },
+};
+
+// Corpo fixo da resposta 429, enviado sem cópia
+static const char rate_limited_body[] = "Muitas requisicoes.";
+
+/**
+ * [Descrição]: Verifica, no aceite da conexão, se o cliente está no limite.
+ * [Parâmetros]:
+ *  - const ip_addr_t *remote: endereço do cliente;
+ * [Notas]: Usa o balde CLIENT_CLASS_CONNECT; o servidor recusa a conexão com 429.
+ */
+bool middleware_accept(const ip_addr_t *remote) {
+    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    return client_limit_take(remote, CLIENT_CLASS_CONNECT, &client_rates[CLIENT_CLASS_CONNECT], now_ms, NULL);
+}
+
+static client_class_t request_class(const http_context_t *ctx) {
+    if (ctx->control || (route_get_info(ctx->route)->flags & ROUTE_FLAG_ADMIN)) {
+        return CLIENT_CLASS_CONTROL;
+    }
+    return ctx->route == ROUTE_NOT_FOUND ? CLIENT_CLASS_PROBE : CLIENT_CLASS_ASSET;
+}
+
+/**
+ * [Descrição]: Recusa requisições de um cliente acima da taxa da classe.
+ * [Parâmetros]:
+ *  - http_context_t *ctx: dados da requisição;
+ *  - http_response_t *response: recebe 429 se o limite for atingido;
+ * [Notas]: 
+ *  - Cada cliente (IP) tem um balde por classe: sondagens de portal
+ *    cativo não consomem as fichas de páginas nem das rotas de controle.
+ *  - Retry-After informa a espera até a próxima ficha da classe.
+ */
+static bool rate_limit_pre(http_context_t *ctx, http_response_t *response) {
+    client_class_t cls = request_class(ctx);
+    uint32_t retry_after_s;
+    if (client_limit_take(ctx->remote, cls, &client_rates[cls], to_ms_since_boot(get_absolute_time()),
+                          &retry_after_s)) {
+        return true;
+    }
+    set_response_status(response, 429, "Too Many Requests");
+    add_response_header(response, "Retry-After", "%lu", (unsigned long)retry_after_s);
+    add_response_header(response, "Content-Type", "text/plain; charset=utf-8");
+    set_response_borrowed_body(response, rate_limited_body, sizeof(rate_limited_body) - 1, NULL, NULL);
+    return false;
+}
+#endif // MIDDLEWARE_RATE_LIMIT
+
+#if MIDDLEWARE_ADMIN_AUTH
+static const char admin_credentials[] = ADMIN_USER ":" ADMIN_PASS;
+
+static int base64_value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+') return 62;
+    if (c == '/') return 63;
+    return -1;
+}
+
+/**
+ * [Descrição]: Decodifica as credenciais Basic e compara com as configuradas.
+ * [Parâmetros]:
+ *  - const char *token: texto base64 após "Basic ";
+ *  - size_t len: tamanho do texto;
+ * [Notas]: A comparação percorre sempre todos os bytes, sem retorno antecipado.
+ */
+static bool credentials_match(const char *token, size_t len) {
+    char decoded[sizeof(admin_credentials) + 3];
+    size_t n = 0;
+    uint32_t bits = 0;
+    int nbits = 0;
+
+    while (len > 0 && (token[len - 1] == ' ' || token[len - 1] == '=')) {
+        len--;
+    }
+    for (size_t i = 0; i < len; i++) {
+        int v = base64_value(token[i]);
+        if (v < 0) return false;
+        bits = bits << 6 | (uint32_t)v;
+        nbits += 6;
+        if (nbits >= 8) {
+            nbits -= 8;
+            if (n >= sizeof(decoded)) return false;
+            decoded[n++] = (char)(bits >> nbits);
+        }
+    }
+
+    if (n != sizeof(admin_credentials) - 1) {
+        return false;
+    }
+    uint8_t diff = 0;
+    for (size_t i = 0; i < n; i++) {
+        diff |= (uint8_t)(decoded[i] ^ admin_credentials[i]);
+    }
+    return diff == 0;
+}
+
+/**
+ * [Descrição]: Exige autenticação Basic nas rotas de administração.
+ * [Parâmetros]:
+ *  - http_context_t *ctx: dados da requisição;
+ *  - http_response_t *response: recebe 401 se as credenciais faltarem ou não conferirem;
+ * [Notas]: Rotas sem ROUTE_FLAG_ADMIN passam direto.
+ */
+static bool admin_auth_pre(http_context_t *ctx, http_response_t *response) {
+    if (!(route_get_info(ctx->route)->flags & ROUTE_FLAG_ADMIN)) {
+        return true;
+    }
+
+    size_t len;
+    const char *value = http_find_header(ctx->request, "Authorization", &len);
+    if (value && len > 6 && strncasecmp(value, "Basic ", 6) == 0 && credentials_match(value + 6, len - 6)) {
+        return true;
+    }
+
+    set_response_status(response, 401, "Unauthorized");
+    add_response_header(response, "WWW-Authenticate", "Basic realm=\"%s\"", ADMIN_REALM);
+    add_response_header(response, "Content-Type", "text/plain; charset=utf-8");
+    set_response_body(response, "Autenticacao necessaria.");
+    return false;
+}
+#endif // MIDDLEWARE_ADMIN_AUTH
+
+#if MIDDLEWARE_METRICS
+static route_metrics_t metrics[ROUTE_COUNT];
+
+/**
+ * [Descrição]: Contabiliza a requisição nas métricas da rota.
+ * [Parâmetros]:
+ *  - const http_context_t *ctx: dados da requisição;
+ *  - const http_response_t *response: resposta pronta;
+ * [Notas]: O tempo medido vai da chegada da requisição até a resposta pronta.
+ */
+static void metrics_post(const http_context_t *ctx, const http_response_t *response) {
+    route_metrics_t *m = &metrics[ctx->route < ROUTE_COUNT ? ctx->route : ROUTE_NOT_FOUND];
+    uint32_t us = elapsed_us(ctx);
+
+    m->requests++;
+    if (response->status_code >= 400) {
+        m->errors++;
+    }
+    m->total_us += us;
+    if (us > m->max_us) {
+        m->max_us = us;
+    }
+}
+
+/**
+ * [Descrição]: Retorna as métricas acumuladas de uma rota.
+ * [Parâmetros]:
+ *  - route_id_t route: identificador da rota;
+ * [Notas]: Requisições sem rota são contadas em ROUTE_NOT_FOUND.
+ */
+const route_metrics_t *middleware_metrics(route_id_t route) {
+    return &metrics[route < ROUTE_COUNT ? route : ROUTE_NOT_FOUND];
+}
+#endif // MIDDLEWARE_METRICS
+
+#if MIDDLEWARE_ACCESS_LOG
+/**
+ * [Descrição]: Registra uma linha de log por requisição.
+ * [Parâmetros]:
+ *  - const http_context_t *ctx: dados da requisição;
+ *  - const http_response_t *response: resposta pronta;
+ * [Notas]: Formato: `<ip> "<linha inicial>" <status> <tempo>us`.
+ */
+static void access_log_post(const http_context_t *ctx, const http_response_t *response) {
+    const char *line_end = strstr(ctx->request, "\r\n");
+    int line_len = line_end ? (int)(line_end - ctx->request) : (int)strlen(ctx->request);
+    if (line_len > 64) {
+        line_len = 64;
+    }
+    printf("%s \"%.*s\" %d %luus\n", ctx->remote ? ipaddr_ntoa(ctx->remote) : "-",
+           line_len, ctx->request, response->status_code, (unsigned long)elapsed_us(ctx));
+}
+#endif // MIDDLEWARE_ACCESS_LOG
+
+// Etapas na ordem de execução; o NULL final evita array vazio e encerra a lista
+static const middleware_pre_fn pre_stages[] = {
+#if MIDDLEWARE_RATE_LIMIT
+    rate_limit_pre,
+#endif
+#if MIDDLEWARE_ADMIN_AUTH
+    admin_auth_pre,
+#endif
+    NULL
+};
+
+static const middleware_post_fn post_stages[] = {
+#if MIDDLEWARE_METRICS
+    metrics_post,
+#endif
+#if MIDDLEWARE_ACCESS_LOG
+    access_log_post,
+#endif
+    NULL
+};
+
+/**
+ * [Descrição]: Executa as etapas pré da requisição.
+ * [Parâmetros]:
+ *  - http_context_t *ctx: dados da requisição (rota já identificada);
+ *  - http_response_t *response: resposta, caso alguma etapa responda;
+ * [Notas]: Retorna false se uma etapa respondeu; as seguintes e a rota não rodam.
+ */
+bool middleware_pre(http_context_t *ctx, http_response_t *response) {
+    for (const middleware_pre_fn *stage = pre_stages; *stage; stage++) {
+        if (!(*stage)(ctx, response)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * [Descrição]: Executa as etapas pós da requisição.
+ * [Parâmetros]:
+ *  - const http_context_t *ctx: dados da requisição;
+ *  - const http_response_t *response: resposta pronta para envio;
+ * [Notas]: Também roda para respostas dadas por etapas pré ou pelo servidor (ex: 431).
+ */
+void middleware_post(const http_context_t *ctx, const http_response_t *response) {
+    for (const middleware_post_fn *stage = post_stages; *stage; stage++) {
+        (*stage)(ctx, response);
+    }
+}
+
+#endif // MIDDLEWARE_ENABLED
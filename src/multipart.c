@@ -0,0 +1,350 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: multipart.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Este módulo implementa um parser incremental de corpos
+ *      `multipart/form-data`. O corpo é entregue em pedaços de
+ *      qualquer tamanho (ex: um pbuf por vez) e nunca é armazenado
+ *      por inteiro: a busca pelo delimitador atravessa as fronteiras
+ *      entre pedaços e os dados de cada parte são repassados
+ *      diretamente ao callback, sem cópia.
+ */
+#include "multipart.h"
+#include <string.h>
+#include <strings.h>
+
+/**
+ * [Descrição]: Monta a tabela de falhas (KMP) do delimitador.
+ * [Parâmetros]:
+ *  - multipart_parser_t *mp: parser com `delim` já preenchido;
+ * [Notas]:
+ *  - `fail[m]` é o tamanho da maior borda própria de `delim[0..m)`.
+ *  - Com ela, ao perder um casamento parcial, os bytes descartados
+ *    são sempre um prefixo do delimitador e podem ser reemitidos a
+ *    partir de `delim`, mesmo que tenham chegado no pedaço anterior.
+ */
+static void build_fail_table(multipart_parser_t *mp) {
+    uint8_t k = 0;
+    mp->fail[0] = 0;
+    mp->fail[1] = 0;
+    for (uint8_t i = 1; i < mp->delim_len; i++) {
+        while (k > 0 && mp->delim[i] != mp->delim[k]) {
+            k = mp->fail[k];
+        }
+        if (mp->delim[i] == mp->delim[k]) {
+            k++;
+        }
+        mp->fail[i + 1] = k;
+    }
+}
+
+/**
+ * [Descrição]: Inicializa o parser para um boundary específico.
+ * [Parâmetros]:
+ *  - multipart_parser_t *mp: parser a ser inicializado;
+ *  - const char *boundary: boundary extraído do Content-Type;
+ *  - size_t boundary_len: tamanho do boundary;
+ *  - const multipart_callbacks_t *cb: callbacks de cabeçalho e dados;
+ *  - void *ctx: contexto repassado aos callbacks;
+ * [Notas]: Retorna MULTIPART_ERR_BOUNDARY se o boundary for inválido.
+ */
+int multipart_init(multipart_parser_t *mp, const char *boundary, size_t boundary_len,
+                   const multipart_callbacks_t *cb, void *ctx) {
+    memset(mp, 0, sizeof(*mp));
+    if (!boundary || boundary_len == 0 || boundary_len > MULTIPART_MAX_BOUNDARY) {
+        mp->state = MULTIPART_STATE_ERROR;
+        return MULTIPART_ERR_BOUNDARY;
+    }
+
+    memcpy(mp->delim, "\r\n--", 4);
+    memcpy(mp->delim + 4, boundary, boundary_len);
+    mp->delim_len = (uint8_t)(boundary_len + 4);
+    build_fail_table(mp);
+
+    mp->cb = cb;
+    mp->ctx = ctx;
+    mp->state = MULTIPART_STATE_PREAMBLE;
+    // O primeiro delimitador não é precedido de CRLF: finge que já foi casado
+    mp->match = 2;
+    return MULTIPART_OK;
+}
+
+/**
+ * [Descrição]: Repassa dados de uma parte ao callback, se houver.
+ * [Parâmetros]:
+ *  - multipart_parser_t *mp: parser;
+ *  - const uint8_t *data: dados da parte;
+ *  - size_t len: quantidade de bytes;
+ * [Notas]: No preâmbulo os dados são descartados.
+ */
+static int emit_data(multipart_parser_t *mp, const uint8_t *data, size_t len) {
+    if (len == 0 || !mp->in_part || !mp->cb->on_part_data) {
+        return MULTIPART_OK;
+    }
+    return mp->cb->on_part_data(mp->ctx, data, len) ? MULTIPART_ERR_ABORTED : MULTIPART_OK;
+}
+
+/**
+ * [Descrição]: Trata uma linha completa de cabeçalho da parte atual.
+ * [Parâmetros]:
+ *  - multipart_parser_t *mp: parser com a linha em `line`;
+ * [Notas]:
+ *  - Linha vazia encerra os cabeçalhos e inicia os dados da parte.
+ *  - Linhas sem ':' são ignoradas.
+ */
+static int process_header_line(multipart_parser_t *mp) {
+    if (mp->line_len == 0) {
+        mp->in_part = true;
+        mp->match = 0;
+        mp->state = MULTIPART_STATE_DATA;
+        if (mp->cb->on_part_begin && mp->cb->on_part_begin(mp->ctx)) {
+            return MULTIPART_ERR_ABORTED;
+        }
+        return MULTIPART_OK;
+    }
+
+    mp->line[mp->line_len] = '\0';
+    mp->line_len = 0;
+
+    char *colon = strchr(mp->line, ':');
+    if (!colon) {
+        return MULTIPART_OK;
+    }
+    *colon = '\0';
+    char *value = colon + 1;
+    while (*value == ' ' || *value == '\t') {
+        value++;
+    }
+
+    if (mp->cb->on_header && mp->cb->on_header(mp->ctx, mp->line, value)) {
+        return MULTIPART_ERR_ABORTED;
+    }
+    return MULTIPART_OK;
+}
+
+/**
+ * [Descrição]: Procura o delimitador em um pedaço de dados.
+ * [Parâmetros]:
+ *  - multipart_parser_t *mp: parser em PREAMBLE ou DATA;
+ *  - const uint8_t *data: pedaço recebido;
+ *  - size_t len: tamanho do pedaço;
+ *  - size_t *consumed: bytes consumidos até o fim do delimitador;
+ *  - int *err: recebe o erro retornado pelo callback de dados;
+ * [Notas]:
+ *  - Retorna 1 se o delimitador foi encontrado, 0 caso contrário.
+ *  - Os trechos que não fazem parte do delimitador são emitidos em
+ *    blocos contíguos apontando para o próprio buffer de entrada.
+ */
+static int scan_delimiter(multipart_parser_t *mp, const uint8_t *data, size_t len,
+                          size_t *consumed, int *err) {
+    size_t run = SIZE_MAX; // Início do trecho de dados pendente neste pedaço
+    *err = MULTIPART_OK;
+
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = data[i];
+
+        while (mp->match > 0 && c != mp->delim[mp->match]) {
+            uint8_t k = mp->fail[mp->match];
+            *err = emit_data(mp, mp->delim, mp->match - k);
+            if (*err) return 0;
+            mp->match = k;
+        }
+
+        if (c == mp->delim[mp->match]) {
+            if (mp->match == 0 && run != SIZE_MAX) {
+                *err = emit_data(mp, data + run, i - run);
+                if (*err) return 0;
+                run = SIZE_MAX;
+            }
+            if (++mp->match == mp->delim_len) {
+                mp->match = 0;
+                *consumed = i + 1;
+                return 1;
+            }
+        } else if (run == SIZE_MAX) {
+            run = i;
+        }
+    }
+
+    if (run != SIZE_MAX) {
+        *err = emit_data(mp, data + run, len - run);
+    }
+    *consumed = len;
+    return 0;
+}
+
+/**
+ * [Descrição]: Alimenta o parser com mais um pedaço do corpo.
+ * [Parâmetros]:
+ *  - multipart_parser_t *mp: parser inicializado;
+ *  - const uint8_t *data: pedaço do corpo;
+ *  - size_t len: tamanho do pedaço;
+ * [Notas]:
+ *  - Aceita pedaços de qualquer tamanho, inclusive de 1 byte.
+ *  - Depois de um erro, todas as chamadas seguintes retornam erro.
+ *  - Dados após o delimitador final (epílogo) são ignorados.
+ */
+int multipart_feed(multipart_parser_t *mp, const uint8_t *data, size_t len) {
+    size_t i = 0;
+    int err = MULTIPART_OK;
+
+    while (i < len) {
+        switch (mp->state) {
+            case MULTIPART_STATE_PREAMBLE:
+            case MULTIPART_STATE_DATA: {
+                size_t consumed;
+                int found = scan_delimiter(mp, data + i, len - i, &consumed, &err);
+                if (err) goto fail;
+                i += consumed;
+                if (found) {
+                    if (mp->in_part) {
+                        mp->in_part = false;
+                        if (mp->cb->on_part_end && mp->cb->on_part_end(mp->ctx)) {
+                            err = MULTIPART_ERR_ABORTED;
+                            goto fail;
+                        }
+                    }
+                    mp->tail_len = 0;
+                    mp->state = MULTIPART_STATE_BOUNDARY_TAIL;
+                }
+                break;
+            }
+
+            case MULTIPART_STATE_BOUNDARY_TAIL: {
+                char c = (char)data[i++];
+                if (mp->tail_len == 0 && (c == ' ' || c == '\t')) {
+                    break; // Espaços permitidos após o boundary (RFC 2046)
+                }
+                mp->tail[mp->tail_len++] = c;
+                if (mp->tail_len < 2) break;
+
+                if (mp->tail[0] == '-' && mp->tail[1] == '-') {
+                    mp->state = MULTIPART_STATE_DONE;
+                } else if (mp->tail[0] == '\r' && mp->tail[1] == '\n') {
+                    mp->line_len = 0;
+                    mp->state = MULTIPART_STATE_HEADERS;
+                } else {
+                    err = MULTIPART_ERR_SYNTAX;
+                    goto fail;
+                }
+                break;
+            }
+
+            case MULTIPART_STATE_HEADERS: {
+                char c = (char)data[i++];
+                if (c == '\n') {
+                    err = process_header_line(mp);
+                    if (err) goto fail;
+                } else if (c != '\r') {
+                    if (mp->line_len >= sizeof(mp->line) - 1) {
+                        err = MULTIPART_ERR_HEADER;
+                        goto fail;
+                    }
+                    mp->line[mp->line_len++] = c;
+                }
+                break;
+            }
+
+            case MULTIPART_STATE_DONE:
+                return MULTIPART_OK;
+
+            case MULTIPART_STATE_ERROR:
+            default:
+                return MULTIPART_ERR_SYNTAX;
+        }
+    }
+    return MULTIPART_OK;
+
+fail:
+    mp->state = MULTIPART_STATE_ERROR;
+    return err;
+}
+
+/**
+ * [Descrição]: Indica se o delimitador final já foi encontrado.
+ * [Parâmetros]:
+ *  - const multipart_parser_t *mp: parser;
+ * [Notas]: Um corpo que termina sem o delimitador final está truncado.
+ */
+bool multipart_is_done(const multipart_parser_t *mp) {
+    return mp->state == MULTIPART_STATE_DONE;
+}
+
+/**
+ * [Descrição]: Extrai o parâmetro `boundary` de um Content-Type.
+ * [Parâmetros]:
+ *  - const char *content_type: valor do cabeçalho Content-Type;
+ *  - size_t len: tamanho do valor;
+ *  - size_t *boundary_len: recebe o tamanho do boundary;
+ * [Notas]:
+ *  - Retorna ponteiro para dentro de `content_type` (sem cópia).
+ *  - Aceita o boundary com ou sem aspas.
+ *  - Retorna NULL se o tipo não for multipart/form-data.
+ */
+const char *multipart_find_boundary(const char *content_type, size_t len, size_t *boundary_len) {
+    static const char type[] = "multipart/form-data";
+    static const char key[] = "boundary=";
+
+    if (len < sizeof(type) - 1 || strncasecmp(content_type, type, sizeof(type) - 1) != 0) {
+        return NULL;
+    }
+
+    for (size_t i = sizeof(type) - 1; i + sizeof(key) - 1 <= len; i++) {
+        if (strncasecmp(content_type + i, key, sizeof(key) - 1) != 0) continue;
+
+        const char *start = content_type + i + sizeof(key) - 1;
+        const char *end = content_type + len;
+        if (start < end && *start == '"') {
+            start++;
+            const char *quote = memchr(start, '"', end - start);
+            if (!quote) return NULL;
+            end = quote;
+        } else {
+            const char *p = start;
+            while (p < end && *p != ';' && *p != ' ' && *p != '\r') p++;
+            end = p;
+        }
+        *boundary_len = end - start;
+        return *boundary_len ? start : NULL;
+    }
+    return NULL;
+}
+
+/**
+ * [Descrição]: Extrai um parâmetro de um valor de cabeçalho de parte.
+ * [Parâmetros]:
+ *  - const char *value: valor (ex: `form-data; name="f"; filename="a.html"`);
+ *  - const char *param: nome do parâmetro (ex: "filename");
+ *  - char *out: buffer de saída;
+ *  - size_t out_size: tamanho do buffer de saída;
+ * [Notas]:
+ *  - Retorna o tamanho copiado ou 0 se o parâmetro não existir.
+ *  - Valores longos demais são truncados para caber em `out`.
+ */
+size_t multipart_header_param(const char *value, const char *param, char *out, size_t out_size) {
+    size_t param_len = strlen(param);
+    const char *p = value;
+
+    while ((p = strchr(p, ';')) != NULL) {
+        p++;
+        while (*p == ' ' || *p == '\t') p++;
+        if (strncasecmp(p, param, param_len) != 0 || p[param_len] != '=') continue;
+
+        p += param_len + 1;
+        bool quoted = (*p == '"');
+        if (quoted) p++;
+
+        size_t n = 0;
+        while (*p && (quoted ? *p != '"' : (*p != ';' && *p != ' ')) && n + 1 < out_size) {
+            out[n++] = *p++;
+        }
+        out[n] = '\0';
+        return n;
+    }
+    if (out_size) out[0] = '\0';
+    return 0;
+}
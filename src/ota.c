@@ -0,0 +1,387 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: ota.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Este módulo recebe uma nova imagem de firmware pela rede
+ *      (`POST /api/ota`, corpo binário) e a grava na área de staging
+ *      da flash, em lotes do tamanho de um setor. O SHA-256 é
+ *      calculado conforme o corpo chega e comparado com o informado
+ *      no cabeçalho OTA_HASH_HEADER. Antes de instalar, o início da
+ *      imagem gravada é conferido (CRC do boot2 e tabela de vetores),
+ *      para não copiar sobre o firmware algo que o RP2040 não inicia
+ *      (ex: um .uf2 ou o .bin de outra placa com o SHA certo).
+ *
+ *      Apagar um setor leva dezenas de ms, então os apagamentos são
+ *      feitos à frente da gravação por `ota_poll`, no laço principal:
+ *      quando um lote enche, o setor de destino normalmente já está
+ *      apagado e o callback de recepção apenas grava (poucos ms).
+ *
+ *      A flash é acessada por um `flash_backend_t`, então o módulo não
+ *      depende do SDK. Exemplo de envio:
+ *          curl -u admin:password --data-binary @firmware.bin \
+ *               -H "X-Firmware-SHA256: $(sha256sum firmware.bin | cut -c1-64)" \
+ *               http://192.168.4.1/api/ota
+ */
+#include "ota.h"
+#include "checksum.h"
+#include "json_writer.h"
+#include <stdio.h>
+#include <string.h>
+
+#define OTA_ERR_FLASH       -1
+
+// Início de uma imagem do RP2040: boot2 (256 bytes, CRC nos 4 últimos)
+// seguido da tabela de vetores (pilha inicial e reset)
+#define BOOT2_SIZE          256
+#define BOOT2_CRC_OFFSET    (BOOT2_SIZE - 4)
+#define IMAGE_MIN_SIZE      (BOOT2_SIZE + 8)
+#define IMAGE_XIP_BASE      0x10000000u
+#define IMAGE_SRAM_BASE     0x20000000u
+#define IMAGE_SRAM_END      0x20042000u
+
+typedef struct {
+    bool busy;
+    bool install_pending;           // Imagem verificada aguardando instalação
+    bool install_armed;
+    uint32_t install_at_ms;
+    bool flash_failed;              // Erro ao apagar à frente (visto no próximo lote)
+    uint32_t size;                  // Tamanho anunciado (Content-Length)
+    uint32_t received;
+    uint32_t written;               // Bytes já gravados (destino do próximo lote)
+    uint32_t erased;                // Fim da região já apagada
+    uint32_t erase_stalls;          // Setores que tiveram de ser apagados na hora
+    uint32_t fill;                  // Bytes no lote atual
+    sha256_t sha;
+    uint8_t expected[SHA256_DIGEST_SIZE];
+    char reply[64];
+    uint8_t batch[FLASH_BACKEND_SECTOR];
+} ota_state_t;
+
+// Uma atualização por vez: o lote ocupa um setor (4 KiB) de RAM
+static ota_state_t ota;
+static const flash_backend_t *backend;
+
+static uint32_t align_up(uint32_t value, uint32_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static void set_error(http_response_t *response, int code, const char *reason, const char *message) {
+    set_response_status(response, code, reason);
+    add_response_header(response, "Content-Type", "text/plain; charset=utf-8");
+    set_response_body(response, message);
+}
+
+/**
+ * [Descrição]: Define a região de flash que recebe as imagens.
+ * [Parâmetros]:
+ *  - const flash_backend_t *flash: região de staging; NULL desabilita a OTA;
+ * [Notas]: Não deve ser trocada durante uma atualização.
+ */
+void ota_set_backend(const flash_backend_t *flash) {
+    backend = flash;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * [Descrição]: Lê o SHA-256 esperado do cabeçalho da requisição.
+ * [Parâmetros]:
+ *  - const char *request: linha inicial e cabeçalhos;
+ *  - uint8_t *digest: recebe os 32 bytes;
+ * [Notas]: Exige exatamente 64 dígitos hexadecimais.
+ */
+static bool parse_expected_hash(const char *request, uint8_t *digest) {
+    size_t len;
+    const char *value = http_find_header(request, OTA_HASH_HEADER, &len);
+    if (!value || len != 2 * SHA256_DIGEST_SIZE) {
+        return false;
+    }
+    for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
+        int high = hex_value(value[2 * i]);
+        int low = hex_value(value[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        digest[i] = (uint8_t)(high << 4 | low);
+    }
+    return true;
+}
+
+static int erase_next_sector(void) {
+    if (backend->erase(backend->ctx, ota.erased, FLASH_BACKEND_SECTOR)) {
+        return OTA_ERR_FLASH;
+    }
+    ota.erased += FLASH_BACKEND_SECTOR;
+    return 0;
+}
+
+/**
+ * [Descrição]: Confere, lendo de volta, o lote recém-gravado.
+ * [Parâmetros]:
+ *  - uint32_t len: bytes gravados a partir de `ota.written`;
+ * [Notas]: Lê em pedaços pequenos para não precisar de outro buffer de setor.
+ */
+static bool verify_batch(uint32_t len) {
+    uint8_t check[64];
+    for (uint32_t pos = 0; pos < len; pos += sizeof(check)) {
+        uint32_t n = len - pos < sizeof(check) ? len - pos : sizeof(check);
+        if (backend->read(backend->ctx, ota.written + pos, check, n) ||
+            memcmp(check, ota.batch + pos, n) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * [Descrição]: Grava o lote atual na área de staging.
+ * [Parâmetros]: nenhum
+ * [Notas]:
+ *  - Um lote incompleto (o último) é completado com 0xFF até a página.
+ *  - Se `ota_poll` ainda não apagou o destino, apaga aqui (conta em
+ *    `erase_stalls`: a recepção fica parada durante o apagamento).
+ */
+static int flush_batch(void) {
+    uint32_t len = align_up(ota.fill, FLASH_BACKEND_PAGE);
+    memset(ota.batch + ota.fill, 0xFF, len - ota.fill);
+
+    if (ota.flash_failed) {
+        return OTA_ERR_FLASH;
+    }
+    while (ota.erased < ota.written + len) {
+        ota.erase_stalls++;
+        if (erase_next_sector()) {
+            return OTA_ERR_FLASH;
+        }
+    }
+    if (backend->program(backend->ctx, ota.written, ota.batch, len) || !verify_batch(len)) {
+        return OTA_ERR_FLASH;
+    }
+    ota.written += len;
+    ota.fill = 0;
+    return 0;
+}
+
+static uint32_t read_le32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/**
+ * [Descrição]: Confere se a imagem gravada no staging inicia no RP2040.
+ * [Parâmetros]: nenhum
+ * [Notas]:
+ *  - O CRC-32/MPEG-2 dos bytes 0..251 deve ser o dos bytes 252..255,
+ *    como a ROM de boot exige; a pilha inicial deve apontar para a SRAM
+ *    e o reset para código Thumb dentro da imagem.
+ *  - Lê da flash (não do que foi recebido): confere o que será copiado.
+ *    Usa o buffer do lote, livre depois da última gravação.
+ */
+static bool image_is_bootable(void) {
+    if (ota.size < IMAGE_MIN_SIZE || backend->read(backend->ctx, 0, ota.batch, IMAGE_MIN_SIZE)) {
+        return false;
+    }
+    if (crc32_mpeg2(ota.batch, BOOT2_CRC_OFFSET) != read_le32(ota.batch + BOOT2_CRC_OFFSET)) {
+        return false;
+    }
+    uint32_t stack = read_le32(ota.batch + BOOT2_SIZE);
+    uint32_t reset = read_le32(ota.batch + BOOT2_SIZE + 4);
+    return stack > IMAGE_SRAM_BASE && stack <= IMAGE_SRAM_END && (stack & 3) == 0 &&
+           (reset & 1) && reset >= IMAGE_XIP_BASE + IMAGE_MIN_SIZE && reset < IMAGE_XIP_BASE + ota.size;
+}
+
+static int ota_on_data(void *ctx, const uint8_t *data, size_t len) {
+    sha256_update(&ota.sha, data, len);
+    ota.received += len;
+
+    while (len > 0) {
+        size_t n = sizeof(ota.batch) - ota.fill;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(ota.batch + ota.fill, data, n);
+        ota.fill += n;
+        data += n;
+        len -= n;
+
+        if (ota.fill == sizeof(ota.batch)) {
+            int err = flush_batch();
+            if (err) {
+                return err;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * [Descrição]: Conclui o recebimento: grava o resto e confere o SHA-256 e a imagem.
+ * [Parâmetros]:
+ *  - int status: 0 ou o erro retornado por `ota_on_data`;
+ *  - http_response_t *response: resposta a preencher;
+ * [Notas]: Com a imagem verificada, a instalação fica agendada para `ota_poll`.
+ */
+static void ota_finish(int status, http_response_t *response) {
+    if (status == 0 && ota.fill > 0) {
+        status = flush_batch();
+    }
+    if (status == OTA_ERR_FLASH) {
+        set_error(response, 500, "Internal Server Error", "Falha ao gravar a flash.");
+        return;
+    }
+    if (status != 0 || ota.received != ota.size) {
+        set_error(response, 400, "Bad Request", "Corpo incompleto.");
+        return;
+    }
+
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    sha256_final(&ota.sha, digest);
+    if (memcmp(digest, ota.expected, sizeof(digest)) != 0) {
+        set_error(response, 422, "Unprocessable Entity", "SHA-256 nao confere.");
+        return;
+    }
+    if (!image_is_bootable()) {
+        set_error(response, 422, "Unprocessable Entity", "Imagem nao e um firmware do RP2040.");
+        return;
+    }
+
+    json_writer_t w;
+    json_writer_init(&w, ota.reply, sizeof(ota.reply) - 1);
+    json_begin_object(&w);
+    json_key(&w, "bytes");
+    json_uint(&w, ota.size);
+    json_key(&w, "reiniciando");
+    json_bool(&w, true);
+    json_end_object(&w);
+    size_t len = json_writer_finish(&w);
+    if (len == 0) {
+        set_error(response, 500, "Internal Server Error", "Erro ao gerar a resposta.");
+        return;
+    }
+    ota.reply[len] = '\0';
+
+    printf("OTA: %lu bytes verificados (%lu apagamentos na recepcao)\n",
+           (unsigned long)ota.size, (unsigned long)ota.erase_stalls);
+    ota.install_pending = true;
+    ota.install_armed = false;
+
+    set_response_status(response, 200, "OK");
+    add_response_header(response, "Content-Type", "application/json");
+    set_response_body(response, ota.reply);
+}
+
+static void ota_on_end(void *ctx, int status, http_response_t *response) {
+    ota_finish(status, response);
+    if (!ota.install_pending) {
+        printf("OTA: atualizacao recusada apos %lu bytes\n", (unsigned long)ota.received);
+        ota.busy = false;
+    }
+}
+
+static void ota_on_abort(void *ctx) {
+    printf("OTA: cancelada apos %lu bytes\n", (unsigned long)ota.received);
+    ota.busy = false;
+}
+
+/**
+ * [Descrição]: Prepara o recebimento de uma imagem de firmware.
+ * [Parâmetros]:
+ *  - const char *request: linha inicial e cabeçalhos da requisição;
+ *  - http_body_handler_t *handler: recebe os callbacks do corpo;
+ *  - http_response_t *response: resposta de erro, se recusado;
+ * [Notas]:
+ *  - Exige Content-Length (até o tamanho da área de staging) e o
+ *    SHA-256 da imagem em OTA_HASH_HEADER.
+ *  - Recusa com 503 se não houver backend ou outra atualização estiver ativa.
+ *  - A autenticação é feita pelo middleware (rota com ROUTE_FLAG_ADMIN).
+ */
+body_route_result_t ota_begin(const char *request, http_body_handler_t *handler, http_response_t *response) {
+    if (!backend) {
+        set_error(response, 503, "Service Unavailable", "OTA indisponivel.");
+        return BODY_ROUTE_REJECTED;
+    }
+    if (ota.busy) {
+        set_error(response, 503, "Service Unavailable", "Outra atualizacao em andamento.");
+        add_response_header(response, "Retry-After", "5");
+        return BODY_ROUTE_REJECTED;
+    }
+
+    long length = http_content_length(request);
+    if (length <= 0) {
+        set_error(response, 411, "Length Required", "Content-Length obrigatorio.");
+        return BODY_ROUTE_REJECTED;
+    }
+    if ((unsigned long)length > backend->size) {
+        set_error(response, 413, "Payload Too Large", "Imagem maior que a area de staging.");
+        return BODY_ROUTE_REJECTED;
+    }
+    if (!parse_expected_hash(request, ota.expected)) {
+        set_error(response, 400, "Bad Request", "Cabecalho " OTA_HASH_HEADER " ausente ou invalido.");
+        return BODY_ROUTE_REJECTED;
+    }
+
+    ota.busy = true;
+    ota.install_pending = false;
+    ota.flash_failed = false;
+    ota.size = (uint32_t)length;
+    ota.received = 0;
+    ota.written = 0;
+    ota.erased = 0;
+    ota.erase_stalls = 0;
+    ota.fill = 0;
+    sha256_init(&ota.sha);
+
+    handler->on_data = ota_on_data;
+    handler->on_end = ota_on_end;
+    handler->on_abort = ota_on_abort;
+    handler->ctx = &ota;
+    return BODY_ROUTE_ACCEPTED;
+}
+
+/**
+ * [Descrição]: Trabalho de fundo da OTA, chamado pelo laço principal.
+ * [Parâmetros]:
+ *  - uint32_t now_ms: instante atual em ms;
+ * [Notas]:
+ *  - Apaga um setor por chamada, até OTA_ERASE_AHEAD à frente da gravação.
+ *  - Instala a imagem verificada OTA_INSTALL_DELAY_MS depois da resposta.
+ *  - Deve rodar com o lwIP travado (`cyw43_arch_lwip_begin`), pois
+ *    divide o estado com os callbacks de recepção.
+ */
+void ota_poll(uint32_t now_ms) {
+    if (!ota.busy) {
+        return;
+    }
+
+    if (ota.install_pending) {
+        if (!ota.install_armed) {
+            ota.install_at_ms = now_ms + OTA_INSTALL_DELAY_MS;
+            ota.install_armed = true;
+        } else if ((int32_t)(now_ms - ota.install_at_ms) >= 0) {
+            printf("OTA: instalando e reiniciando\n");
+            if (backend->install(backend->ctx, ota.size)) {
+                printf("OTA: falha ao instalar\n");
+            }
+            // Só retorna em falha ou em backends sem reinício (ex: arquivo)
+            ota.busy = false;
+            ota.install_pending = false;
+        }
+        return;
+    }
+
+    uint32_t limit = align_up(ota.size, FLASH_BACKEND_SECTOR);
+    if (ota.written + OTA_ERASE_AHEAD < limit) {
+        limit = ota.written + OTA_ERASE_AHEAD;
+    }
+    if (!ota.flash_failed && ota.erased < limit && erase_next_sector()) {
+        ota.flash_failed = true;
+    }
+}
@@ -0,0 +1,315 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: response_cache.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Este módulo guarda respostas de rotas dinâmicas que não mudam
+ *      a cada requisição (ex: status), para que vários clientes
+ *      recebam o mesmo corpo sem gerá-lo de novo. A chave é a rota
+ *      mais a query string normalizada (parâmetros em ordem).
+ *
+ *      Os corpos ficam em uma área de tamanho fixo; quando falta
+ *      espaço, as entradas usadas há mais tempo (LRU) são descartadas.
+ *      Cada entrada tem validade (TTL) e marcadores de invalidação.
+ *      Uma resposta servida do cache é emprestada: a entrada fica
+ *      presa até a conexão terminar de enviá-la, e só então pode ser
+ *      descartada ou reaproveitada.
+ */
+#include "response_cache.h"
+#include "pico/time.h"
+#include <string.h>
+
+#define FNV_OFFSET  2166136261u
+#define FNV_PRIME   16777619u
+
+typedef struct {
+    bool used;
+    bool stale;                     // Invalidada enquanto emprestada
+    uint8_t route;
+    uint8_t tags;
+    uint8_t pins;                   // Conexões enviando este corpo
+    uint16_t offset;
+    uint16_t len;
+    uint32_t key;
+    uint32_t expires_ms;
+    uint32_t last_used;             // Relógio LRU
+    const char *content_type;
+} cache_entry_t;
+
+static uint8_t arena[RESPONSE_CACHE_BYTES];
+static cache_entry_t entries[RESPONSE_CACHE_ENTRIES];
+static uint32_t lru_clock;
+
+static uint32_t fnv1a(uint32_t hash, const char *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)data[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+static int compare_params(const char *a, size_t a_len, const char *b, size_t b_len) {
+    int cmp = memcmp(a, b, a_len < b_len ? a_len : b_len);
+    return cmp ? cmp : (int)a_len - (int)b_len;
+}
+
+/**
+ * [Descrição]: Calcula a chave de cache de uma requisição.
+ * [Parâmetros]:
+ *  - route_id_t route: rota identificada;
+ *  - const char *request: linha inicial e cabeçalhos;
+ * [Notas]:
+ *  - A query é normalizada: parâmetros vazios são ignorados e os demais
+ *    ordenados, então `?b=2&a=1` e `?a=1&b=2&` têm a mesma chave.
+ *  - Acima de RESPONSE_CACHE_MAX_QUERY_PARAMS, os excedentes entram na
+ *    ordem recebida.
+ */
+uint32_t response_cache_key(route_id_t route, const char *request) {
+    uint8_t id = (uint8_t)route;
+    uint32_t hash = fnv1a(FNV_OFFSET, (const char *)&id, 1);
+
+    const char *path = strchr(request, ' ');
+    const char *query = path ? strpbrk(path + 1, "? \r") : NULL;
+    if (!query || *query != '?') {
+        return hash;
+    }
+    query++;
+    size_t query_len = strcspn(query, " \r");
+
+    const char *param[RESPONSE_CACHE_MAX_QUERY_PARAMS];
+    size_t param_len[RESPONSE_CACHE_MAX_QUERY_PARAMS];
+    int count = 0;
+    size_t pos = 0;
+
+    while (pos < query_len && count < RESPONSE_CACHE_MAX_QUERY_PARAMS) {
+        size_t len = strcspn(query + pos, "& \r");
+        if (len > 0) {
+            // Ordenação por inserção: poucos parâmetros
+            int i = count++;
+            while (i > 0 && compare_params(query + pos, len, param[i - 1], param_len[i - 1]) < 0) {
+                param[i] = param[i - 1];
+                param_len[i] = param_len[i - 1];
+                i--;
+            }
+            param[i] = query + pos;
+            param_len[i] = len;
+        }
+        pos += len + 1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        hash = fnv1a(hash, "&", 1);
+        hash = fnv1a(hash, param[i], param_len[i]);
+    }
+    if (pos < query_len) {
+        hash = fnv1a(hash, query + pos - 1, query_len - pos + 1);
+    }
+    return hash;
+}
+
+static bool is_expired(const cache_entry_t *e, uint32_t now) {
+    return (int32_t)(now - e->expires_ms) >= 0;
+}
+
+/**
+ * [Descrição]: Libera a área de uma entrada, se ela não estiver emprestada.
+ * [Parâmetros]:
+ *  - cache_entry_t *e: entrada;
+ * [Notas]: Entradas emprestadas ficam marcadas e são liberadas na devolução.
+ */
+static void drop_entry(cache_entry_t *e) {
+    if (e->pins > 0) {
+        e->stale = true;
+    } else {
+        e->used = false;
+        e->stale = false;
+    }
+}
+
+/**
+ * [Descrição]: Devolve uma entrada emprestada a uma conexão.
+ * [Parâmetros]:
+ *  - void *ctx: entrada (`cache_entry_t`);
+ * [Notas]: Chamada pelo servidor quando a conexão é encerrada.
+ */
+static void release_entry(void *ctx) {
+    cache_entry_t *e = ctx;
+    if (e->pins > 0 && --e->pins == 0 && e->stale) {
+        drop_entry(e);
+    }
+}
+
+/**
+ * [Descrição]: Procura na área um intervalo livre (first fit).
+ * [Parâmetros]:
+ *  - size_t len: tamanho necessário;
+ * [Notas]: Retorna o deslocamento, ou -1 se não houver espaço contíguo.
+ */
+static int find_gap(size_t len) {
+    // Candidatos: início da área e o fim de cada entrada ocupada
+    for (int c = -1; c < RESPONSE_CACHE_ENTRIES; c++) {
+        size_t start = 0;
+        if (c >= 0) {
+            if (!entries[c].used) continue;
+            start = entries[c].offset + entries[c].len;
+        }
+        if (start + len > sizeof(arena)) {
+            continue;
+        }
+
+        bool overlaps = false;
+        for (int i = 0; i < RESPONSE_CACHE_ENTRIES && !overlaps; i++) {
+            const cache_entry_t *e = &entries[i];
+            overlaps = e->used && start < (size_t)e->offset + e->len && e->offset < start + len;
+        }
+        if (!overlaps) {
+            return (int)start;
+        }
+    }
+    return -1;
+}
+
+/**
+ * [Descrição]: Descarta a entrada livre usada há mais tempo.
+ * [Parâmetros]:
+ *  - uint32_t now: instante atual em ms;
+ * [Notas]: Prefere entradas vencidas; retorna false se todas estiverem emprestadas.
+ */
+static bool evict_one(uint32_t now) {
+    cache_entry_t *victim = NULL;
+    for (int i = 0; i < RESPONSE_CACHE_ENTRIES; i++) {
+        cache_entry_t *e = &entries[i];
+        if (!e->used || e->pins > 0) {
+            continue;
+        }
+        if (is_expired(e, now)) {
+            victim = e;
+            break;
+        }
+        if (!victim || (int32_t)(e->last_used - victim->last_used) < 0) {
+            victim = e;
+        }
+    }
+    if (!victim) {
+        return false;
+    }
+    drop_entry(victim);
+    return true;
+}
+
+static cache_entry_t *find_entry(route_id_t route, uint32_t key) {
+    for (int i = 0; i < RESPONSE_CACHE_ENTRIES; i++) {
+        cache_entry_t *e = &entries[i];
+        if (e->used && !e->stale && e->route == route && e->key == key) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * [Descrição]: Responde a requisição com o corpo em cache, se houver.
+ * [Parâmetros]:
+ *  - route_id_t route: rota identificada;
+ *  - const char *request: linha inicial e cabeçalhos;
+ *  - http_response_t *response: resposta a preencher;
+ * [Notas]:
+ *  - O corpo é emprestado (sem cópia) e enviado direto da área do cache;
+ *    a entrada fica presa até a conexão ser encerrada.
+ *  - Retorna false se não houver entrada válida; a rota deve gerar a resposta.
+ */
+bool response_cache_serve(route_id_t route, const char *request, http_response_t *response) {
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    cache_entry_t *e = find_entry(route, response_cache_key(route, request));
+    if (!e) {
+        return false;
+    }
+    if (is_expired(e, now)) {
+        drop_entry(e);
+        return false;
+    }
+    if (e->pins == UINT8_MAX) {
+        return false;
+    }
+
+    e->pins++;
+    e->last_used = ++lru_clock;
+    set_response_status(response, 200, "OK");
+    add_response_header(response, "Content-Type", "%s", e->content_type);
+    add_response_header(response, "Cache-Control", "no-store");
+    set_response_borrowed_body(response, (const char *)arena + e->offset, e->len, release_entry, e);
+    return true;
+}
+
+/**
+ * [Descrição]: Guarda o corpo de uma resposta gerada pela rota.
+ * [Parâmetros]:
+ *  - route_id_t route: rota identificada;
+ *  - const char *request: linha inicial e cabeçalhos;
+ *  - uint8_t tags: marcadores (CACHE_TAG_*) que invalidam a entrada;
+ *  - uint32_t ttl_ms: validade da entrada;
+ *  - const char *content_type: tipo do corpo (deve ser um literal);
+ *  - const http_response_t *response: resposta com corpo em buffer;
+ * [Notas]:
+ *  - Só respostas 200 com corpo comum (sem stream ou template) são guardadas.
+ *  - Descarta entradas LRU até caber; falha se o espaço estiver emprestado.
+ */
+bool response_cache_store(route_id_t route, const char *request, uint8_t tags, uint32_t ttl_ms,
+                          const char *content_type, const http_response_t *response) {
+    if (response->status_code != 200 || !response->body || response->body_len == 0 ||
+        response->body_len > sizeof(arena)) {
+        return false;
+    }
+
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    uint32_t key = response_cache_key(route, request);
+    cache_entry_t *old = find_entry(route, key);
+    if (old) {
+        drop_entry(old);
+    }
+
+    cache_entry_t *slot = NULL;
+    int offset;
+    for (;;) {
+        for (int i = 0; i < RESPONSE_CACHE_ENTRIES && !slot; i++) {
+            if (!entries[i].used) slot = &entries[i];
+        }
+        offset = slot ? find_gap(response->body_len) : -1;
+        if (offset >= 0) {
+            break;
+        }
+        if (!evict_one(now)) {
+            return false;
+        }
+    }
+
+    memcpy(arena + offset, response->body, response->body_len);
+    slot->used = true;
+    slot->stale = false;
+    slot->route = (uint8_t)route;
+    slot->tags = tags;
+    slot->pins = 0;
+    slot->offset = (uint16_t)offset;
+    slot->len = (uint16_t)response->body_len;
+    slot->key = key;
+    slot->expires_ms = now + ttl_ms;
+    slot->last_used = ++lru_clock;
+    slot->content_type = content_type;
+    return true;
+}
+
+/**
+ * [Descrição]: Invalida as entradas que exibem o estado alterado.
+ * [Parâmetros]:
+ *  - uint8_t tags: marcadores alterados (CACHE_TAG_*);
+ * [Notas]: Entradas emprestadas terminam de ser enviadas e depois são descartadas.
+ */
+void response_cache_invalidate(uint8_t tags) {
+    for (int i = 0; i < RESPONSE_CACHE_ENTRIES; i++) {
+        if (entries[i].used && (entries[i].tags & tags)) {
+            drop_entry(&entries[i]);
+        }
+    }
+}
@@ -0,0 +1,147 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: romfs.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Este módulo lê a imagem somente leitura de arquivos estáticos
+ *      gerada por `tools/mkromfs.py` e gravada na flash (ver
+ *      `flash_layout.h`). A imagem é usada no lugar, pelo mapa XIP:
+ *      procurar um arquivo é uma busca binária no diretório e o
+ *      resultado aponta direto para os dados na flash, sem cópia.
+ *
+ *      O módulo não depende do SDK; a imagem pode vir de qualquer
+ *      região de memória (ex: um arquivo mapeado no computador).
+ */
+#include "romfs.h"
+#include <string.h>
+
+// Mesma ordem de MIME_TYPES em tools/mkromfs.py
+static const char *const mime_types[] = {
+    "application/octet-stream",
+    "text/html; charset=utf-8",
+    "text/css",
+    "application/javascript",
+    "application/json",
+    "text/plain; charset=utf-8",
+    "image/svg+xml",
+    "image/png",
+    "image/jpeg",
+    "image/gif",
+    "image/webp",
+    "image/x-icon",
+    "font/woff2",
+};
+
+#define MIME_TYPE_COUNT (sizeof(mime_types) / sizeof(mime_types[0]))
+
+static int compare_names(const char *a, size_t a_len, const char *b, size_t b_len) {
+    int cmp = memcmp(a, b, a_len < b_len ? a_len : b_len);
+    return cmp ? cmp : (int)a_len - (int)b_len;
+}
+
+static const char *entry_name(const romfs_t *fs, const romfs_entry_t *e) {
+    return (const char *)fs->base + e->name_offset;
+}
+
+/**
+ * [Descrição]: Valida uma imagem e prepara a estrutura para buscas.
+ * [Parâmetros]:
+ *  - romfs_t *fs: estrutura a preencher;
+ *  - const void *image: início da imagem (alinhado a 4 bytes);
+ *  - size_t size: tamanho da região que contém a imagem;
+ * [Notas]:
+ *  - Retorna ROMFS_OK ou um ROMFS_ERR_*; em erro, `fs` fica vazio e
+ *    toda busca falha.
+ *  - Todas as entradas são conferidas aqui, uma vez; as buscas
+ *    seguintes não precisam revalidar limites.
+ */
+int romfs_mount(romfs_t *fs, const void *image, size_t size) {
+    const romfs_header_t *header = image;
+    memset(fs, 0, sizeof(*fs));
+
+    if (size < sizeof(*header) || memcmp(header->magic, ROMFS_MAGIC, sizeof(header->magic)) != 0) {
+        return ROMFS_ERR_MAGIC;
+    }
+    if (header->version != ROMFS_VERSION) {
+        return ROMFS_ERR_VERSION;
+    }
+    if (header->image_size > size ||
+        sizeof(*header) + (size_t)header->count * sizeof(romfs_entry_t) > header->image_size) {
+        return ROMFS_ERR_BOUNDS;
+    }
+
+    romfs_t mounted = {
+        .base = image,
+        .size = header->image_size,
+        .count = header->count,
+        .dir = (const romfs_entry_t *)(header + 1),
+    };
+
+    for (uint16_t i = 0; i < mounted.count; i++) {
+        const romfs_entry_t *e = &mounted.dir[i];
+        if ((uint64_t)e->name_offset + e->name_len >= mounted.size ||
+            (uint64_t)e->data_offset + e->data_size > mounted.size ||
+            entry_name(&mounted, e)[e->name_len] != '\0') {
+            return ROMFS_ERR_BOUNDS;
+        }
+        if (i > 0 && compare_names(entry_name(&mounted, e - 1), e[-1].name_len,
+                                   entry_name(&mounted, e), e->name_len) >= 0) {
+            return ROMFS_ERR_ORDER;
+        }
+    }
+
+    *fs = mounted;
+    return ROMFS_OK;
+}
+
+/**
+ * [Descrição]: Procura um arquivo pelo caminho.
+ * [Parâmetros]:
+ *  - const romfs_t *fs: imagem montada;
+ *  - const char *path: caminho, com ou sem '/' inicial (não precisa de '\0');
+ *  - size_t path_len: tamanho do caminho;
+ *  - romfs_file_t *file: recebe ponteiro e tamanho dos dados;
+ * [Notas]: Busca binária: O(log n) comparações, sem alocação.
+ */
+bool romfs_find(const romfs_t *fs, const char *path, size_t path_len, romfs_file_t *file) {
+    if (path_len > 0 && path[0] == '/') {
+        path++;
+        path_len--;
+    }
+    if (path_len == 0 || path_len > ROMFS_MAX_PATH) {
+        return false;
+    }
+
+    size_t low = 0, high = fs->count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        const romfs_entry_t *e = &fs->dir[mid];
+        int cmp = compare_names(path, path_len, entry_name(fs, e), e->name_len);
+        if (cmp == 0) {
+            file->data = fs->base + e->data_offset;
+            file->size = e->data_size;
+            file->mime = e->mime;
+            file->flags = e->flags;
+            return true;
+        }
+        if (cmp < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return false;
+}
+
+/**
+ * [Descrição]: Retorna o Content-Type de um índice gravado na imagem.
+ * [Parâmetros]:
+ *  - uint8_t mime: índice da entrada;
+ * [Notas]: Índices desconhecidos viram application/octet-stream.
+ */
+const char *romfs_mime_type(uint8_t mime) {
+    return mime < MIME_TYPE_COUNT ? mime_types[mime] : mime_types[0];
+}
@@ -9,128 +9,632 @@
  *      Este módulo define as rotas tratadas pelo servidor HTTP.
  *      Ele interpreta o início da requisição HTTP recebida e
  *      define a resposta apropriada em HTML, com status e tipo.
- *      A resposta é montada diretamente a partir de strings C.
+ *      As páginas vêm dos templates compilados de `pages/` e os
+ *      demais arquivos estáticos da imagem ROMFS (`www/`).
  */
 #include "routes.h"
+#include "alarm.h"
+#include "control.h"
+#include "http_server.h"
+#include "json_writer.h"
+#include "ota.h"
+#include "middleware.h"
+#include "response_cache.h"
+#include "romfs.h"
+#include "templates.h"
+#include "upload.h"
+#include "setup.h"
+#include "pico/time.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-//Rota inicial
-static route_info_t root_route = {
-    .path = "GET / ",
-    .length = sizeof("GET / ") - 1
+// Tabela de rotas, indexada por `route_id_t`
+#define ROUTE(p, f) { .path = p, .length = sizeof(p) - 1, .flags = f }
+
+static const route_info_t route_table[ROUTE_COUNT] = {
+    [ROUTE_NOT_FOUND]   = { .path = NULL, .length = 0, .flags = 0 },
+    [ROUTE_ROOT]        = ROUTE("GET / ", 0),
+    // Controle do alarme pelos links da página inicial (o navegador pede o login)
+    [ROUTE_ALARM_ON]    = ROUTE("GET /ligar ", ROUTE_FLAG_ADMIN),
+    [ROUTE_ALARM_OFF]   = ROUTE("GET /desligar ", ROUTE_FLAG_ADMIN),
+    // Lista de clientes conectados (resposta em stream)
+    [ROUTE_CLIENTS]     = ROUTE("GET /clientes ", 0),
+    // API JSON
+    [ROUTE_API_STATUS]  = ROUTE("GET /api/status ", 0),
+    [ROUTE_API_CLIENTS] = ROUTE("GET /api/clientes ", 0),
+    [ROUTE_API_METRICS] = ROUTE("GET /api/metricas ", 0),
+    [ROUTE_API_SEND_METRICS] = ROUTE("GET /api/metricas/envio ", 0),
+    [ROUTE_API_DNS_METRICS] = ROUTE("GET /api/metricas/dns ", 0),
+    [ROUTE_API_ALARM]   = ROUTE("POST /api/alarme ", ROUTE_FLAG_ADMIN),
+    // Upload de arquivos (multipart/form-data)
+    [ROUTE_UPLOAD]      = ROUTE("POST /upload ", ROUTE_FLAG_ADMIN),
+    // Atualização de firmware (corpo binário gravado na área de staging)
+    [ROUTE_OTA]         = ROUTE("POST /api/ota ", ROUTE_FLAG_ADMIN),
+    // Arquivos estáticos da ROMFS: casados por `find_static_file`
+    [ROUTE_STATIC]      = { .path = NULL, .length = 0, .flags = 0 },
+};
+
+// Rotas atendidas pela porta de controle, que não disputa vagas com a porta 80
+static const route_id_t control_routes[] = {
+    ROUTE_API_STATUS,
+    ROUTE_API_ALARM,
 };
 
-// O template HTML fixo
-static const char* HTML_TEMPLATE =
-        "<!DOCTYPE html>\n"
-        "<html lang=\"pt-BR\">\n"
-        "<head>\n"
-        "    <meta charset=\"UTF-8\">\n"
-        "    <meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0\">\n"
-        "    <title>Minha Rota Inicial (Embutida)</title>\n"
-        "    <style>\n"
-        "        body {\n"
-        "            font-family: Arial, sans-serif;\n"
-        "            background-color: #f4f4f4;\n"
-        "            color: #333;\n"
-        "            margin: 0;\n"
-        "            display: flex;\n"
-        "            justify-content: center;\n"
-        "            align-items: center;\n"
-        "            min-height: 100vh;\n"
-        "            flex-direction: column;\n"
-        "        }\n"
-        "        .container {\n"
-        "            background-color: #fff;\n"
-        "            padding: 30px;\n"
-        "            border-radius: 8px;\n"
-        "            box-shadow: 0 4px 8px rgba(0, 0, 0, 0.1);\n"
-        "            text-align: center;\n"
-        "        }\n"
-        "        h1 {\n"
-        "            color: #0056b3;\n"
-        "        }\n"
-        "        p {\n"
-        "            line-height: 1.6;\n"
-        "        }\n"
-        "        .footer {\n"
-        "            margin-top: 20px;\n"
-        "            font-size: 0.8em;\n"
-        "            color: #666;\n"
-        "        }\n"
-        "    </style>\n"
-        "</head>\n"
-        "<body>\n"
-        "    <div class=\"container\">\n"
-        "        <h1>Bem-vindo à Rota Inicial!</h1>\n"
-        "        <p>Este é o conteúdo da sua página inicial, servido diretamente do código C.</p>\n"
-        "        <p>Sem arquivos HTML externos!</p>\n"
-        "    </div>\n"
-        "    <div class=\"footer\">\n"
-        "        <p>&copy; 2025 Minha Aplicação. Todos os direitos reservados.</p>\n"
-        "    </div>\n"
-        "</body>\n"
-        "</html>\n";
-
-/**
- * [Descrição]: Gera e retorna o conteúdo HTML completo como string alocada.
- * [Parâmetros]: 
- *  - nenhum
+// Arquivos estáticos mudam só com uma nova imagem gravada
+#define STATIC_MAX_AGE_S 3600
+
+// Validade do status em cache: o uptime muda a cada segundo
+#define STATUS_CACHE_TTL_MS 1000
+
+// Bit do cursor de `clients_json_fill` que indica item já escrito (vírgula)
+#define CLIENTS_JSON_HAS_ITEMS 0x100
+
+/**
+ * [Descrição]: Procura na ROMFS o arquivo pedido por um GET.
+ * [Parâmetros]: 
+ *  - const char *request: linha inicial e cabeçalhos da requisição;
+ *  - romfs_file_t *file: recebe o arquivo encontrado;
+ * [Notas]: A query string é ignorada.
+ */
+static bool find_static_file(const char *request, romfs_file_t *file) {
+    if (strncmp(request, "GET /", 5) != 0) {
+        return false;
+    }
+    const char *path = request + 4;
+    return romfs_find(&romfs, path, strcspn(path, " ?\r"), file);
+}
+
+/**
+ * [Descrição]: Compara método e caminho da requisição com uma rota da tabela.
+ * [Parâmetros]: 
+ *  - const char *request: linha inicial e cabeçalhos da requisição;
+ *  - route_id_t id: rota a comparar;
+ * [Notas]: O caminho termina no espaço antes da versão ou no início da query.
+ */
+static bool path_matches(const char *request, route_id_t id) {
+    if (!route_table[id].path) {
+        return false;
+    }
+    size_t path_len = route_table[id].length - 1;
+    return strncmp(request, route_table[id].path, path_len) == 0 &&
+           (request[path_len] == ' ' || request[path_len] == '?');
+}
+
+/**
+ * [Descrição]: Identifica a rota de uma requisição.
+ * [Parâmetros]: 
+ *  - const char *request: linha inicial e cabeçalhos da requisição;
+ * [Notas]: 
+ *  - Compara método e caminho, ignorando a query string.
+ *  - Sem rota fixa, um GET pode casar com um arquivo da ROMFS (ROUTE_STATIC).
+ *  - Retorna ROUTE_NOT_FOUND se nenhuma rota casar.
+ */
+route_id_t route_match(const char *request) {
+    for (int id = ROUTE_NOT_FOUND + 1; id < ROUTE_COUNT; id++) {
+        if (path_matches(request, (route_id_t)id)) {
+            return (route_id_t)id;
+        }
+    }
+
+    romfs_file_t file;
+    if (find_static_file(request, &file)) {
+        return ROUTE_STATIC;
+    }
+    return ROUTE_NOT_FOUND;
+}
+
+/**
+ * [Descrição]: Identifica a rota de uma requisição recebida na porta de controle.
+ * [Parâmetros]: 
+ *  - const char *request: linha inicial e cabeçalhos da requisição;
+ * [Notas]: Só as rotas de `control_routes` são aceitas; as demais dão 404.
+ */
+route_id_t route_match_control(const char *request) {
+    for (size_t i = 0; i < sizeof(control_routes) / sizeof(control_routes[0]); i++) {
+        if (path_matches(request, control_routes[i])) {
+            return control_routes[i];
+        }
+    }
+    return ROUTE_NOT_FOUND;
+}
+
+/**
+ * [Descrição]: Retorna a descrição (método, caminho e flags) de uma rota.
+ * [Parâmetros]: 
+ *  - route_id_t route: identificador da rota;
+ * [Notas]: Para ROUTE_NOT_FOUND o caminho é NULL.
+ */
+const route_info_t *route_get_info(route_id_t route) {
+    return &route_table[route < ROUTE_COUNT ? route : ROUTE_NOT_FOUND];
+}
+
+/**
+ * [Descrição]: Verifica se uma concessão DHCP está em uso.
+ * [Parâmetros]: 
+ *  - const dhcp_server_lease_t *lease: concessão;
+ *  - uint32_t now: instante atual em ms desde o boot;
+ *  - int32_t *remaining_ms: recebe o tempo restante da concessão;
+ * [Notas]: Concessões sem MAC ou expiradas estão livres.
+ */
+static bool lease_is_active(const dhcp_server_lease_t *lease, uint32_t now, int32_t *remaining_ms) {
+    const uint8_t *mac = lease->mac;
+    uint32_t expiry = (uint32_t)lease->expiry << 16 | 0xffff;
+    *remaining_ms = (int32_t)(expiry - now);
+    return (mac[0] | mac[1] | mac[2] | mac[3] | mac[4] | mac[5]) != 0 && *remaining_ms >= 0;
+}
+
+/**
+ * [Descrição]: Conta os clientes com concessão DHCP ativa.
+ * [Parâmetros]: 
+ *  - uint32_t now: instante atual em ms desde o boot;
+ * [Notas]: Percorre as DHCPS_MAX_IP concessões do servidor.
+ */
+static unsigned count_active_clients(uint32_t now) {
+    unsigned count = 0;
+    int32_t remaining_ms;
+    for (int i = 0; i < DHCPS_MAX_IP; i++) {
+        if (lease_is_active(&dhcp_server.lease[i], now, &remaining_ms)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * [Descrição]: Define a página inicial, com o estado atual do alarme.
+ * [Parâmetros]: 
+ *  - http_response_t *response: ponteiro para a estrutura de resposta;
+ * [Notas]: 
+ *  - Usa o template compilado de `pages/index.html`: apenas os slots
+ *    (estado dos botões, clientes e tempo ativo) são formatados.
+ */
+static void set_index_response(http_response_t *response) {
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    bool active = alarm_is_active();
+
+    set_response_status(response, 200, "OK");
+    add_response_header(response, "Content-Type", "text/html; charset=utf-8");
+    add_response_header(response, "Cache-Control", "no-store");
+
+    template_value_t *values = set_response_template(response, &TEMPLATE_INDEX);
+    values[TEMPLATE_INDEX_ON_STATE].str = active ? " inative" : "";
+    values[TEMPLATE_INDEX_OFF_STATE].str = active ? " active" : "";
+    values[TEMPLATE_INDEX_CLIENTS].u = count_active_clients(now);
+    values[TEMPLATE_INDEX_UPTIME_S].u = now / 1000;
+}
+
+/**
+ * [Descrição]: Gera, sob demanda, a lista de clientes com concessão DHCP ativa.
+ * [Parâmetros]: 
+ *  - http_stream_t *stream: escritor da resposta;
+ *  - void *ctx: ponteiro para o `dhcp_server_t`;
+ * [Notas]: 
+ *  - `stream->cursor` guarda a próxima linha: 0 é o cabeçalho e
+ *    1..DHCPS_MAX_IP são as concessões.
+ *  - Retorna false quando o bloco enche; a geração continua de onde parou.
+ */
+static bool clients_fill(http_stream_t *stream, void *ctx) {
+    const dhcp_server_t *d = ctx;
+    const ip4_addr_t *ip = ip_2_ip4(&d->ip);
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+
+    if (stream->cursor == 0) {
+        if (!http_stream_printf(stream, "ip\tmac\texpira_s\n")) return false;
+        stream->cursor++;
+    }
+
+    for (; stream->cursor <= DHCPS_MAX_IP; stream->cursor++) {
+        const uint8_t *mac = d->lease[stream->cursor - 1].mac;
+        int32_t remaining_ms;
+
+        if (!lease_is_active(&d->lease[stream->cursor - 1], now, &remaining_ms)) {
+            continue;
+        }
+        if (!http_stream_printf(stream, "%u.%u.%u.%u\t%02x:%02x:%02x:%02x:%02x:%02x\t%ld\n",
+                                ip4_addr1(ip), ip4_addr2(ip), ip4_addr3(ip),
+                                (unsigned)(DHCPS_BASE_IP + stream->cursor - 1),
+                                mac[0], mac[1], mac[2], mac[3], mac[4], mac[5],
+                                (long)(remaining_ms / 1000))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * [Descrição]: Define a resposta JSON com o estado geral do dispositivo.
+ * [Parâmetros]: 
+ *  - http_response_t *response: ponteiro para a estrutura de resposta;
+ * [Notas]: O JSON é montado em buffer na pilha, sem alocação pelo escritor.
+ */
+static void set_status_response(http_response_t *response) {
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    char json[128];
+    json_writer_t w;
+
+    json_writer_init(&w, json, sizeof(json) - 1);
+    json_begin_object(&w);
+    json_key(&w, "alarme");
+    json_bool(&w, alarm_is_active());
+    json_key(&w, "clientes");
+    json_uint(&w, count_active_clients(now));
+    json_key(&w, "uptime_s");
+    json_uint(&w, now / 1000);
+    json_end_object(&w);
+
+    size_t len = json_writer_finish(&w);
+    if (len == 0) {
+        set_response_status(response, 500, "Internal Server Error");
+        add_response_header(response, "Content-Type", "text/plain");
+        set_response_body(response, "Erro ao gerar o status.");
+        return;
+    }
+    json[len] = '\0';
+
+    set_response_status(response, 200, "OK");
+    add_response_header(response, "Content-Type", "application/json");
+    add_response_header(response, "Cache-Control", "no-store");
+    set_response_body(response, json);
+}
+
+#if MIDDLEWARE_METRICS
+/**
+ * [Descrição]: Define a resposta JSON com as métricas de cada rota.
+ * [Parâmetros]: 
+ *  - http_response_t *response: ponteiro para a estrutura de resposta;
+ * [Notas]: Só existe com MIDDLEWARE_METRICS habilitado; sem ele a rota responde 404.
+ */
+static void set_metrics_response(http_response_t *response) {
+    char json[ROUTE_COUNT * 80];
+    json_writer_t w;
+
+    json_writer_init(&w, json, sizeof(json) - 1);
+    json_begin_array(&w);
+    for (int id = 0; id < ROUTE_COUNT; id++) {
+        const route_info_t *info = route_get_info((route_id_t)id);
+        const route_metrics_t *m = middleware_metrics((route_id_t)id);
+        json_begin_object(&w);
+        json_key(&w, "rota");
+        if (info->path) {
+            // Sem o espaço final usado na comparação
+            char path[32];
+            snprintf(path, sizeof(path), "%.*s", (int)info->length - 1, info->path);
+            json_string(&w, path);
+        } else if (id == ROUTE_STATIC) {
+            json_string(&w, "GET /<romfs>");
+        } else {
+            json_null(&w);
+        }
+        json_key(&w, "requisicoes");
+        json_uint(&w, m->requests);
+        json_key(&w, "erros");
+        json_uint(&w, m->errors);
+        json_key(&w, "media_us");
+        json_uint(&w, m->requests ? m->total_us / m->requests : 0);
+        json_key(&w, "max_us");
+        json_uint(&w, m->max_us);
+        json_end_object(&w);
+    }
+    json_end_array(&w);
+
+    size_t len = json_writer_finish(&w);
+    if (len == 0) {
+        set_response_status(response, 500, "Internal Server Error");
+        add_response_header(response, "Content-Type", "text/plain");
+        set_response_body(response, "Erro ao gerar as metricas.");
+        return;
+    }
+    json[len] = '\0';
+
+    set_response_status(response, 200, "OK");
+    add_response_header(response, "Content-Type", "application/json");
+    add_response_header(response, "Cache-Control", "no-store");
+    set_response_body(response, json);
+}
+#endif
+
+/**
+ * [Descrição]: Define a resposta com um arquivo estático da ROMFS.
+ * [Parâmetros]: 
+ *  - const char *request: string contendo os headers HTTP da requisição;
+ *  - http_response_t *response: ponteiro para a estrutura de resposta;
  * [Notas]: 
- *  - A string retornada é alocada dinamicamente com `malloc`.
- *  - O chamador é responsável por liberar a memória alocada com `free`.
+ *  - O corpo é emprestado direto da flash (XIP): nada é copiado para a
+ *    RAM e não há nada a devolver ao fim do envio.
+ *  - Arquivos gravados com gzip exigem `Accept-Encoding: gzip` (406 sem ele).
+ */
+static void set_static_response(const char *request, http_response_t *response) {
+    romfs_file_t file;
+    if (!find_static_file(request, &file)) {
+        set_response_status(response, 404, "Not Found");
+        add_response_header(response, "Content-Type", "text/plain");
+        set_response_body(response, "Página não encontrada.");
+        return;
+    }
+
+    bool gzip = file.flags & ROMFS_FLAG_GZIP;
+    if (gzip && !http_accepts_encoding(request, "gzip")) {
+        set_response_status(response, 406, "Not Acceptable");
+        add_response_header(response, "Content-Type", "text/plain");
+        set_response_body(response, "Arquivo disponivel apenas com gzip.");
+        return;
+    }
+
+    set_response_status(response, 200, "OK");
+    add_response_header(response, "Content-Type", "%s", romfs_mime_type(file.mime));
+    add_response_header(response, "Cache-Control", "max-age=%d", STATIC_MAX_AGE_S);
+    if (gzip) {
+        add_response_header(response, "Content-Encoding", "gzip");
+        add_response_header(response, "Vary", "Accept-Encoding");
+    }
+    set_response_borrowed_body(response, (const char *)file.data, file.size, NULL, NULL);
+}
+
+/**
+ * [Descrição]: Define a resposta JSON com os contadores do escalonamento de envio.
+ * [Parâmetros]: 
+ *  - http_response_t *response: ponteiro para a estrutura de resposta;
+ * [Notas]: Mostra quantas vezes respostas grandes cederam a vez por falta de memória.
  */
-static char* get_html_content() {
-    size_t len = strlen(HTML_TEMPLATE);
-    char* html_content = (char*)malloc(len + 1);
-    if (html_content) {
-        strcpy(html_content, HTML_TEMPLATE);
+static void set_send_metrics_response(http_response_t *response) {
+    const http_send_stats_t *stats = http_server_send_stats();
+    char json[128];
+    json_writer_t w;
+
+    json_writer_init(&w, json, sizeof(json) - 1);
+    json_begin_object(&w);
+    json_key(&w, "adiamentos");
+    json_uint(&w, stats->deferrals);
+    json_key(&w, "retomadas");
+    json_uint(&w, stats->resumes);
+    json_key(&w, "folga_min");
+    json_uint(&w, stats->min_headroom);
+    json_key(&w, "heap_folga_min");
+    json_uint(&w, stats->min_heap_headroom);
+    json_end_object(&w);
+
+    size_t len = json_writer_finish(&w);
+    if (len == 0) {
+        set_response_status(response, 500, "Internal Server Error");
+        add_response_header(response, "Content-Type", "text/plain");
+        set_response_body(response, "Erro ao gerar as metricas de envio.");
+        return;
     }
-    return html_content;
+    json[len] = '\0';
+
+    set_response_status(response, 200, "OK");
+    add_response_header(response, "Content-Type", "application/json");
+    add_response_header(response, "Cache-Control", "no-store");
+    set_response_body(response, json);
 }
 
 /**
- * [Descrição]: Define a resposta HTTP com base no HTML fornecido.
+ * [Descrição]: Define a resposta JSON com os nomes mais consultados no DNS.
  * [Parâmetros]: 
  *  - http_response_t *response: ponteiro para a estrutura de resposta;
- *  - char *html_content: conteúdo HTML alocado dinamicamente;
  * [Notas]: 
- *  - Se o conteúdo for válido, define status 200 e cabeçalhos.
- *  - Em caso de erro, retorna status 500 e corpo com mensagem de erro.
- */
-static void set_response(http_response_t *response, char *html_content){
-    if (html_content) {
-        set_response_status(response, 200, "OK");
-        add_response_header(response, "Content-Type", "text/html; charset=utf-8");
-        add_response_header(response, "Content-Length", "%lu", strlen(html_content));
-        set_response_body(response, html_content);
-    } else {
+ *  - As contagens vêm do count-min sketch do servidor DNS: são
+ *    estimativas que podem superestimar, e caem pela metade a cada
+ *    DNS_SKETCH_DECAY_MS.
+ *  - Inclui os contadores do limite por cliente (RRL) e da lista de bloqueio.
+ */
+static void set_dns_metrics_response(http_response_t *response) {
+    dns_top_t top[DNS_TOP_MAX];
+    size_t count = dns_server_top(&dns_server, top, DNS_TOP_MAX);
+    char json[DNS_TOP_MAX * (DNS_HOST_NAME_MAX + 32) + 96];
+    json_writer_t w;
+
+    json_writer_init(&w, json, sizeof(json) - 1);
+    json_begin_object(&w);
+    json_key(&w, "consultas");
+    json_uint(&w, dns_server.sketch.queries);
+    json_key(&w, "descartadas");
+    json_uint(&w, dns_server.rrl_dropped);
+    json_key(&w, "truncadas");
+    json_uint(&w, dns_server.rrl_slipped);
+    json_key(&w, "bloqueadas");
+    json_uint(&w, dns_server.blocked);
+    json_key(&w, "nomes");
+    json_begin_array(&w);
+    for (size_t i = 0; i < count; i++) {
+        json_begin_object(&w);
+        json_key(&w, "nome");
+        json_string(&w, top[i].name);
+        json_key(&w, "consultas");
+        json_uint(&w, top[i].count);
+        json_end_object(&w);
+    }
+    json_end_array(&w);
+    json_end_object(&w);
+
+    size_t len = json_writer_finish(&w);
+    if (len == 0) {
         set_response_status(response, 500, "Internal Server Error");
         add_response_header(response, "Content-Type", "text/plain");
-        set_response_body(response, "Erro ao carregar a página inicial.");
+        set_response_body(response, "Erro ao gerar as metricas de DNS.");
+        return;
+    }
+    json[len] = '\0';
+
+    set_response_status(response, 200, "OK");
+    add_response_header(response, "Content-Type", "application/json");
+    add_response_header(response, "Cache-Control", "no-store");
+    set_response_body(response, json);
+}
+
+/**
+ * [Descrição]: Gera, sob demanda, a lista de clientes em JSON.
+ * [Parâmetros]: 
+ *  - http_stream_t *stream: escritor da resposta;
+ *  - void *ctx: ponteiro para o `dhcp_server_t`;
+ * [Notas]: 
+ *  - Cada item é escrito pelo `json_writer_t` direto no bloco do stream
+ *    (`http_stream_reserve`) e só é confirmado se couber inteiro.
+ *  - Cursor: 0 abre o array, 1..DHCPS_MAX_IP são as concessões e
+ *    DHCPS_MAX_IP + 1 fecha o array.
+ */
+static bool clients_json_fill(http_stream_t *stream, void *ctx) {
+    const dhcp_server_t *d = ctx;
+    const ip4_addr_t *ip = ip_2_ip4(&d->ip);
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    uintptr_t position = stream->cursor & ~CLIENTS_JSON_HAS_ITEMS;
+
+    if (position == 0) {
+        if (!http_stream_write(stream, "[", 1)) return false;
+        stream->cursor = position = 1;
+    }
+
+    for (; position <= DHCPS_MAX_IP; position++) {
+        const uint8_t *mac = d->lease[position - 1].mac;
+        int32_t remaining_ms;
+        if (!lease_is_active(&d->lease[position - 1], now, &remaining_ms)) {
+            continue;
+        }
+
+        char ip_text[16], mac_text[18];
+        snprintf(ip_text, sizeof(ip_text), "%u.%u.%u.%u", ip4_addr1(ip), ip4_addr2(ip), ip4_addr3(ip),
+                 (unsigned)(DHCPS_BASE_IP + position - 1));
+        snprintf(mac_text, sizeof(mac_text), "%02x:%02x:%02x:%02x:%02x:%02x",
+                 mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+
+        size_t space;
+        json_writer_t w;
+        json_writer_init(&w, http_stream_reserve(stream, &space), space);
+        if (stream->cursor & CLIENTS_JSON_HAS_ITEMS) {
+            json_raw(&w, ",", 1);
+        }
+        json_begin_object(&w);
+        json_key(&w, "ip");
+        json_string(&w, ip_text);
+        json_key(&w, "mac");
+        json_string(&w, mac_text);
+        json_key(&w, "expira_s");
+        json_uint(&w, remaining_ms / 1000);
+        json_end_object(&w);
+
+        size_t len = json_writer_finish(&w);
+        if (len == 0) {
+            return false; // Não coube: retoma este item no próximo bloco
+        }
+        http_stream_commit(stream, len);
+        stream->cursor = (position + 1) | CLIENTS_JSON_HAS_ITEMS;
     }
+    stream->cursor = position | (stream->cursor & CLIENTS_JSON_HAS_ITEMS);
+
+    return http_stream_write(stream, "]", 1);
 }
 
 /**
  * [Descrição]: Manipula a rota com base na requisição HTTP recebida.
  * [Parâmetros]: 
+ *  - route_id_t route: rota identificada por `route_match`;
  *  - const char *request: string contendo os headers HTTP da requisição;
  *  - http_response_t *response: estrutura onde será definida a resposta HTTP;
  * [Notas]: 
  *  - Suporta as seguintes rotas:
- *      - `GET /` ou `GET /index`: retorna a página inicial com HTML embutido.
+ *      - `GET /`: retorna a página inicial com o estado do alarme.
+ *      - `GET /ligar` e `GET /desligar`: alteram o alarme e retornam a página
+ *        inicial (rotas de administração, como `POST /api/alarme`).
+ *      - `GET /clientes`: lista os clientes conectados, gerada em stream
+ *        (compartilhada entre requisições idênticas simultâneas).
+ *      - `GET /api/status`: estado do alarme, clientes e tempo ativo em JSON
+ *        (em cache por STATUS_CACHE_TTL_MS, invalidado quando o alarme muda).
+ *      - `GET /api/clientes`: lista de clientes em JSON, gerada em stream
+ *        (compartilhada entre requisições idênticas simultâneas).
+ *      - `GET /api/metricas`: contadores por rota coletados pelo middleware.
+ *      - `GET /api/metricas/envio`: adiamentos do envio sob pressão de memória.
+ *      - `GET /api/metricas/dns`: nomes mais consultados, limite e bloqueios do DNS.
+ *      - `GET /<arquivo>`: arquivo estático da ROMFS, enviado direto da flash.
  *      - Qualquer outra rota resulta em erro 404 com texto simples.
  */
-void handle_route(const char *request, http_response_t *response) {
-    if (strncmp(request, root_route.path, root_route.length) == 0) {
-        char *html_content = get_html_content();
-        set_response(response, html_content);
+void handle_route(route_id_t route, const char *request, http_response_t *response) {
+    switch (route) {
+        case ROUTE_ROOT:
+            set_index_response(response);
+            break;
 
-    } else {
-        set_response_status(response, 404, "Not Found");
-        add_response_header(response, "Content-Type", "text/plain");
-        set_response_body(response, "Página não encontrada.");
+        case ROUTE_ALARM_ON:
+            alarm_set_active(true);
+            set_index_response(response);
+            break;
+
+        case ROUTE_ALARM_OFF:
+            alarm_set_active(false);
+            set_index_response(response);
+            break;
+
+        case ROUTE_CLIENTS:
+            set_response_status(response, 200, "OK");
+            add_response_header(response, "Content-Type", "text/plain; charset=utf-8");
+            set_response_stream(response, clients_fill, &dhcp_server);
+            set_response_stream_key(response, response_cache_key(route, request));
+            break;
+
+        case ROUTE_API_STATUS:
+            if (!response_cache_serve(route, request, response)) {
+                set_status_response(response);
+                response_cache_store(route, request, CACHE_TAG_ALARM,
+                                     STATUS_CACHE_TTL_MS, "application/json", response);
+            }
+            break;
+
+        case ROUTE_API_CLIENTS:
+            set_response_status(response, 200, "OK");
+            add_response_header(response, "Content-Type", "application/json");
+            set_response_stream(response, clients_json_fill, &dhcp_server);
+            set_response_stream_key(response, response_cache_key(route, request));
+            break;
+
+        case ROUTE_STATIC:
+            set_static_response(request, response);
+            break;
+
+        case ROUTE_API_SEND_METRICS:
+            set_send_metrics_response(response);
+            break;
+
+        case ROUTE_API_DNS_METRICS:
+            set_dns_metrics_response(response);
+            break;
+
+#if MIDDLEWARE_METRICS
+        case ROUTE_API_METRICS:
+            set_metrics_response(response);
+            break;
+#endif
+
+        default:
+            set_response_status(response, 404, "Not Found");
+            add_response_header(response, "Content-Type", "text/plain");
+            set_response_body(response, "Página não encontrada.");
+            break;
+    }
+}
+
+/**
+ * [Descrição]: Verifica se a requisição tem corpo a ser consumido por uma rota.
+ * [Parâmetros]: 
+ *  - route_id_t route: rota identificada por `route_match`;
+ *  - const char *request: string contendo os headers HTTP da requisição;
+ *  - http_body_handler_t *handler: recebe os callbacks que consumirão o corpo;
+ *  - http_response_t *response: resposta de erro, caso a rota recuse o corpo;
+ * [Notas]: 
+ *  - Suporta as seguintes rotas:
+ *      - `POST /upload`: recebe arquivos via multipart/form-data.
+ *      - `POST /api/alarme`: liga/desliga o alarme com um comando JSON.
+ *      - `POST /api/ota`: recebe e instala uma nova imagem de firmware.
+ *  - Retorna BODY_ROUTE_NONE para rotas tratadas por `handle_route`.
+ */
+body_route_result_t handle_body_route(route_id_t route, const char *request, http_body_handler_t *handler, http_response_t *response) {
+    switch (route) {
+        case ROUTE_UPLOAD:
+            return upload_begin(request, handler, response);
+        case ROUTE_API_ALARM:
+            return control_begin(request, handler, response);
+        case ROUTE_OTA:
+            return ota_begin(request, handler, response);
+        default:
+            return BODY_ROUTE_NONE;
     }
 }
@@ -9,17 +9,30 @@
  *      Este módulo centraliza a configuração da interface de rede
  *      no modo Access Point (AP) do Raspberry Pi Pico W, bem como a 
  *      inicialização dos serviços DHCP, DNS e do servidor HTTP.
+ *      Também monta a imagem ROMFS de arquivos estáticos e a lista de
+ *      domínios bloqueados pelo DNS, ambas gravadas na flash.
  */
 #include "setup.h"
 #include "pico/cyw43_arch.h"
 #include "lwip/ip4_addr.h"
 #include "lwip/netif.h"
 #include "http_server.h"
+#include "client_limit.h"
 #include "wifi_config.h"
+#include "dns_config.h"
 #include "cyw43_config.h"
+#include "flash_layout.h"
+#include "flash_pico.h"
+#include "ota.h"
 
 dhcp_server_t dhcp_server;
 dns_server_t dns_server;
+romfs_t romfs;
+blocklist_t blocklist;
+
+static const char *const dns_local_names[] = { DNS_LOCAL_NAMES };
+static const char *const dns_unhijacked_names[] = { DNS_UNHIJACKED_NAMES };
+static const char *const dns_forward_names[] = { DNS_FORWARD_NAMES };
 
 /**
  * [Descrição]: Configura a interface de rede Wi-Fi em modo Access Point,
@@ -30,6 +43,9 @@ dns_server_t dns_server;
  *  - Define o IP 192.168.4.1 como gateway e endereço do servidor.
  *  - Configura a interface de rede via `cyw43_arch_lwip_begin/end`.
  *  - O servidor HTTP é iniciado após DHCP e DNS.
+ *  - A tabela de nomes do DNS vem de `dns_config.h`.
+ *  - Sem imagem ROMFS válida na flash, apenas as rotas compiladas respondem.
+ *  - Sem lista de bloqueio válida na flash, nenhum domínio é bloqueado.
  */
 int network_setup(void) {
     if (cyw43_arch_init()) {
@@ -55,12 +71,47 @@ int network_setup(void) {
 
     // Inicialização do DHCP
     dhcp_server_init(&dhcp_server, &ap_gw, &ap_netmask);
+    client_limit_set_dhcp(&dhcp_server);
     printf("DHCP Server initialized\n");
     
     // Inicialização do DNS
     dns_server_init(&dns_server, &ap_gw);
+    cyw43_arch_lwip_begin();
+    for (size_t i = 0; i < sizeof(dns_local_names) / sizeof(dns_local_names[0]); i++) {
+        dns_server_set_host(&dns_server, dns_local_names[i], DNS_ACTION_ADDRESS, NULL);
+    }
+    for (size_t i = 0; i < sizeof(dns_unhijacked_names) / sizeof(dns_unhijacked_names[0]); i++) {
+        dns_server_set_host(&dns_server, dns_unhijacked_names[i], DNS_ACTION_NXDOMAIN, NULL);
+    }
+    for (size_t i = 0; i < sizeof(dns_forward_names) / sizeof(dns_forward_names[0]); i++) {
+        dns_server_set_host(&dns_server, dns_forward_names[i], DNS_ACTION_FORWARD, NULL);
+    }
+    dns_server_set_fallback(&dns_server, DNS_FALLBACK);
+    cyw43_arch_lwip_end();
     printf("DNS Server initialized\n");
 
+    // Domínios bloqueados, consultados direto da flash pelo mapa XIP
+    int blocklist_err = blocklist_mount(&blocklist, (const void *)FLASH_BLOCKLIST_XIP_ADDR, FLASH_BLOCKLIST_SIZE);
+    if (blocklist_err == BLOCKLIST_OK) {
+        cyw43_arch_lwip_begin();
+        dns_server_set_blocklist(&dns_server, &blocklist);
+        cyw43_arch_lwip_end();
+        printf("Blocklist mounted: %lu names\n", (unsigned long)blocklist.count);
+    } else {
+        printf("Blocklist not mounted (%d)\n", blocklist_err);
+    }
+
+    // Arquivos estáticos, lidos direto da flash pelo mapa XIP
+    int romfs_err = romfs_mount(&romfs, (const void *)FLASH_ROMFS_XIP_ADDR, FLASH_ROMFS_SIZE);
+    if (romfs_err == ROMFS_OK) {
+        printf("ROMFS mounted: %u files\n", romfs.count);
+    } else {
+        printf("ROMFS not mounted (%d)\n", romfs_err);
+    }
+
+    // Atualizações de firmware gravadas na área de staging da flash
+    ota_set_backend(&flash_pico_ota);
+
     // Start HTTP server (moved from main.c)
     http_server_start();
     printf("HTTP Server started\n");
@@ -0,0 +1,348 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: single_flight.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Este módulo agrupa requisições idênticas simultâneas a rotas
+ *      em stream (ex: vários celulares recarregando a lista de
+ *      clientes ao mesmo tempo). A primeira requisição cria a geração
+ *      ("flight"); as que chegam enquanto ela não terminou entram
+ *      nela e recebem os mesmos blocos, em vez de executar o gerador
+ *      de novo.
+ *
+ *      O gerador roda sob demanda, quando a conexão mais adiantada
+ *      precisa do próximo bloco. Cada bloco vira um segmento imutável,
+ *      numerado, enviado sem cópia por todas as conexões.
+ *
+ *      No máximo SINGLE_FLIGHT_MAX_SEGMENTS segmentos existem ao mesmo
+ *      tempo. Ao atingir o limite a geração se fecha: quem chega depois
+ *      começa outra (ou, sem vaga, usa o gerador sozinho), e as conexões
+ *      inscritas continuam em janela, com o gerador só rodando de novo
+ *      depois que todas devolvem (`single_flight_release`) o segmento
+ *      mais antigo. Um gerador que não cabe no limite fica mais lento,
+ *      mas nenhuma resposta é truncada.
+ *
+ *      Gerações de clientes que aceitam gzip comprimem os blocos uma
+ *      única vez, no próprio segmento; o compressor (~3 KiB) só é
+ *      alocado se a resposta passar de GZIP_MIN_INPUT.
+ */
+#include "single_flight.h"
+#include "gzip.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct flight_t_ {
+    uint32_t key;
+    bool open;                          // Aceita novas conexões (registrada em `flights`)
+    bool done;                          // Gerador terminou
+    bool blocked;                       // Bloco pronto aguardando vaga de segmento
+    bool failed;                        // Sem memória para nenhum segmento
+    bool gzip_allowed;                  // Clientes aceitam Content-Encoding: gzip
+    bool started;                       // Compressão já decidida
+    bool compressed;
+    gzip_stream_t *gz;                  // Alocado só enquanto comprime
+    uint8_t refs;                       // Conexões inscritas
+    uint8_t segment_count;              // Segmentos existentes (no máximo SINGLE_FLIGHT_MAX_SEGMENTS)
+    uint16_t next_seq;                  // Número do próximo segmento
+    http_stream_fill_fn fill;
+    void *ctx;
+    flight_segment_t *head;
+    flight_segment_t *tail;
+    http_stream_t stream;               // Área de produção (sem chunked)
+};
+
+// Gerações em andamento, abertas a novas conexões
+static flight_t *flights[SINGLE_FLIGHT_MAX];
+
+static void unregister(flight_t *flight) {
+    flight->open = false;
+    for (int i = 0; i < SINGLE_FLIGHT_MAX; i++) {
+        if (flights[i] == flight) {
+            flights[i] = NULL;
+        }
+    }
+}
+
+/**
+ * [Descrição]: Libera os segmentos iniciais que nenhuma conexão precisa mais.
+ * [Parâmetros]:
+ *  - flight_t *flight: geração;
+ * [Notas]: Só com a geração fechada: enquanto aberta, quem entra recebe
+ *          desde o primeiro segmento.
+ */
+static void reclaim(flight_t *flight) {
+    while (!flight->open && flight->head && flight->head->released >= flight->refs) {
+        flight_segment_t *seg = flight->head;
+        flight->head = seg->next;
+        if (!flight->head) {
+            flight->tail = NULL;
+        }
+        flight->segment_count--;
+        free(seg);
+    }
+}
+
+/**
+ * [Descrição]: Entra na geração em andamento da chave ou cria uma nova.
+ * [Parâmetros]:
+ *  - uint32_t key: chave da requisição (rota + query);
+ *  - http_stream_fill_fn fill: gerador, usado se a geração for criada;
+ *  - void *ctx: contexto do gerador;
+ *  - bool gzip: o cliente aceita gzip (gerações com e sem gzip são distintas);
+ * [Notas]:
+ *  - Quem entra recebe os blocos desde o início, mesmo os já enviados
+ *    às outras conexões.
+ *  - Retorna NULL sem memória ou sem vaga, ou se a geração da chave já
+ *    se fechou; a conexão deve então usar o gerador sozinha.
+ */
+flight_t *single_flight_join(uint32_t key, http_stream_fill_fn fill, void *ctx, bool gzip) {
+    int free_slot = -1;
+    for (int i = 0; i < SINGLE_FLIGHT_MAX; i++) {
+        flight_t *f = flights[i];
+        if (!f) {
+            if (free_slot < 0) free_slot = i;
+        } else if (f->key == key && f->fill == fill && f->gzip_allowed == gzip && f->refs < UINT8_MAX) {
+            f->refs++;
+            return f;
+        }
+    }
+    if (free_slot < 0) {
+        return NULL;
+    }
+
+    flight_t *f = calloc(1, sizeof(flight_t));
+    if (!f) {
+        return NULL;
+    }
+    f->key = key;
+    f->open = true;
+    f->refs = 1;
+    f->fill = fill;
+    f->ctx = ctx;
+    f->gzip_allowed = gzip;
+    http_stream_init(&f->stream, false);
+    flights[free_slot] = f;
+    return f;
+}
+
+/**
+ * [Descrição]: Decide, no primeiro bloco, se a geração será comprimida.
+ * [Parâmetros]:
+ *  - flight_t *flight: geração;
+ * [Notas]: Respostas que terminam no primeiro bloco abaixo de GZIP_MIN_INPUT
+ *          seguem sem compressão, assim como quando falta memória.
+ */
+static void decide_compression(flight_t *flight) {
+    flight->started = true;
+    if (!flight->gzip_allowed || (flight->done && flight->stream.len < GZIP_MIN_INPUT)) {
+        return;
+    }
+    flight->gz = malloc(sizeof(gzip_stream_t));
+    if (flight->gz) {
+        gzip_init(flight->gz);
+        flight->compressed = true;
+    }
+}
+
+/**
+ * [Descrição]: Cria o segmento com o bloco atual do gerador.
+ * [Parâmetros]:
+ *  - flight_t *flight: geração;
+ * [Notas]:
+ *  - Comprimido, o último segmento também leva o trailer gzip.
+ *  - Retorna false, mantendo o bloco, se não houver vaga ou memória
+ *    para o segmento.
+ */
+static bool append_segment(flight_t *flight) {
+    size_t frame_len;
+    const char *frame = http_stream_frame(&flight->stream, &frame_len);
+    size_t capacity = flight->compressed ? gzip_bound(frame_len) : frame_len;
+
+    if (flight->segment_count >= SINGLE_FLIGHT_MAX_SEGMENTS) {
+        return false;
+    }
+    flight_segment_t *seg = malloc(sizeof(flight_segment_t) + capacity);
+    if (!seg) {
+        return false;
+    }
+
+    if (flight->compressed) {
+        seg->len = (uint16_t)gzip_compress(flight->gz, (const uint8_t *)frame, frame_len,
+                                           (uint8_t *)seg->data, flight->done);
+    } else {
+        seg->len = (uint16_t)frame_len;
+        memcpy(seg->data, frame, frame_len);
+    }
+    http_stream_consume(&flight->stream);
+
+    // Um segmento vazio viraria o terminador do chunked
+    if (seg->len == 0) {
+        free(seg);
+        return true;
+    }
+    seg->next = NULL;
+    seg->seq = flight->next_seq++;
+    seg->released = 0;
+    if (flight->tail) {
+        flight->tail->next = seg;
+    } else {
+        flight->head = seg;
+    }
+    flight->tail = seg;
+    flight->segment_count++;
+    return true;
+}
+
+/**
+ * [Descrição]: Executa o gerador e guarda o bloco produzido como segmento.
+ * [Parâmetros]:
+ *  - flight_t *flight: geração;
+ * [Notas]:
+ *  - Ao terminar a geração deixa de aceitar novas conexões.
+ *  - Sem vaga para o segmento, a geração se fecha e o bloco espera as
+ *    conexões devolverem os segmentos antigos; sem memória e sem
+ *    segmento algum a devolver, ela falha.
+ */
+static void produce(flight_t *flight) {
+    if (!flight->done && !flight->blocked) {
+        flight->done = flight->fill(&flight->stream, flight->ctx);
+    }
+    if (!flight->started) {
+        decide_compression(flight);
+    }
+
+    // Bloco do gerador ou, comprimida, o trailer gzip ainda não emitido
+    if (flight->stream.len > 0 || (flight->done && flight->gz)) {
+        flight->blocked = !append_segment(flight);
+        if (flight->blocked) {
+            unregister(flight);
+            reclaim(flight);
+            flight->blocked = !append_segment(flight);
+        }
+        if (flight->blocked && flight->segment_count == 0) {
+            flight->blocked = false;
+            flight->failed = true;
+            flight->done = true;
+        }
+    }
+
+    if (flight->done && !flight->blocked) {
+        free(flight->gz);
+        flight->gz = NULL;
+        unregister(flight);
+    }
+}
+
+/**
+ * [Descrição]: Retorna um segmento da geração pelo número.
+ * [Parâmetros]:
+ *  - flight_t *flight: geração;
+ *  - uint16_t seq: número do segmento (0 no início da resposta);
+ * [Notas]:
+ *  - Se a conexão alcançou o fim do que já foi produzido, o gerador roda.
+ *  - Retorna NULL se ainda não houver dados (ou vaga) ou se a geração
+ *    terminou; use `single_flight_finished` para distinguir.
+ */
+const flight_segment_t *single_flight_next(flight_t *flight, uint16_t seq) {
+    if (seq == flight->next_seq && (!flight->done || flight->blocked)) {
+        produce(flight);
+    }
+    for (const flight_segment_t *seg = flight->head; seg; seg = seg->next) {
+        if (seg->seq == seq) {
+            return seg;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * [Descrição]: Devolve segmentos já confirmados pelo cliente de uma conexão.
+ * [Parâmetros]:
+ *  - flight_t *flight: geração;
+ *  - uint16_t from: primeiro segmento ainda não devolvido pela conexão;
+ *  - uint16_t to: primeiro segmento que a conexão ainda precisa;
+ * [Notas]:
+ *  - Os dados vão ao lwIP sem cópia: só devolva depois do ACK.
+ *  - Segmentos devolvidos por todas as conexões são liberados assim que
+ *    a geração se fecha, abrindo vaga para o gerador continuar.
+ */
+void single_flight_release(flight_t *flight, uint16_t from, uint16_t to) {
+    for (flight_segment_t *seg = flight->head; seg; seg = seg->next) {
+        if ((uint16_t)(seg->seq - from) < (uint16_t)(to - from)) {
+            seg->released++;
+        }
+    }
+    reclaim(flight);
+}
+
+/**
+ * [Descrição]: Informa se o gerador terminou e todos os segmentos existem.
+ * [Parâmetros]:
+ *  - const flight_t *flight: geração;
+ * [Notas]: Verdadeiro também em caso de falha.
+ */
+bool single_flight_finished(const flight_t *flight) {
+    return flight->done && !flight->blocked;
+}
+
+/**
+ * [Descrição]: Informa se a geração falhou (resposta incompleta).
+ * [Parâmetros]:
+ *  - const flight_t *flight: geração;
+ * [Notas]: As conexões devem ser encerradas sem o terminador do chunked.
+ */
+bool single_flight_failed(const flight_t *flight) {
+    return flight->failed;
+}
+
+/**
+ * [Descrição]: Informa se os segmentos estão comprimidos com gzip.
+ * [Parâmetros]:
+ *  - flight_t *flight: geração;
+ * [Notas]: Produz o primeiro bloco, se preciso, para que a decisão
+ *          exista antes do envio dos cabeçalhos.
+ */
+bool single_flight_compressed(flight_t *flight) {
+    if (!flight->started) {
+        produce(flight);
+    }
+    return flight->compressed;
+}
+
+/**
+ * [Descrição]: Retira uma conexão da geração.
+ * [Parâmetros]:
+ *  - flight_t *flight: geração (pode ser NULL);
+ *  - uint16_t released: primeiro segmento não devolvido pela conexão;
+ * [Notas]:
+ *  - Chamada quando a conexão é encerrada: o lwIP não referencia mais
+ *    os segmentos enviados sem cópia.
+ *  - A última conexão libera os segmentos e a geração.
+ */
+void single_flight_leave(flight_t *flight, uint16_t released) {
+    if (!flight) {
+        return;
+    }
+    // Os segmentos que ela devolveu deixam de contar, junto com ela
+    for (flight_segment_t *seg = flight->head; seg; seg = seg->next) {
+        if ((uint16_t)(seg->seq - flight->head->seq) < (uint16_t)(released - flight->head->seq)) {
+            seg->released--;
+        }
+    }
+    if (--flight->refs > 0) {
+        reclaim(flight);
+        return;
+    }
+    unregister(flight);
+    free(flight->gz);
+    flight_segment_t *seg = flight->head;
+    while (seg) {
+        flight_segment_t *next = seg->next;
+        free(seg);
+        seg = next;
+    }
+    free(flight);
+}
@@ -0,0 +1,188 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: template.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Este módulo renderiza os templates compilados a partir de
+ *      `pages/` pelo `tools/compile_templates.py`. Cada template é
+ *      uma sequência de segmentos estáticos (mantidos na flash) e
+ *      slots tipados. Somente os slots são formatados em RAM; o
+ *      servidor envia os segmentos estáticos sem cópia, então o
+ *      custo da renderização depende apenas dos bytes dinâmicos.
+ */
+#include "template.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * [Descrição]: Copia uma string aplicando escape de HTML.
+ * [Parâmetros]:
+ *  - char *out: destino;
+ *  - size_t space: bytes disponíveis em `out`;
+ *  - const char *str: texto de origem;
+ * [Notas]: Retorna o tamanho escrito ou -1 se não couber.
+ */
+static int escape_html(char *out, size_t space, const char *str) {
+    size_t n = 0;
+    for (; *str; str++) {
+        const char *entity = NULL;
+        switch (*str) {
+            case '&': entity = "&amp;"; break;
+            case '<': entity = "&lt;"; break;
+            case '>': entity = "&gt;"; break;
+            case '"': entity = "&quot;"; break;
+            case '\'': entity = "&#39;"; break;
+        }
+        size_t len = entity ? strlen(entity) : 1;
+        if (n + len > space) {
+            return -1;
+        }
+        if (entity) {
+            memcpy(out + n, entity, len);
+        } else {
+            out[n] = *str;
+        }
+        n += len;
+    }
+    return (int)n;
+}
+
+/**
+ * [Descrição]: Formata os slots e prepara o envio de um template.
+ * [Parâmetros]:
+ *  - template_render_t *render: estado de envio a ser preenchido;
+ *  - const template_t *tpl: template compilado;
+ *  - const template_value_t *values: valores indexados pelo enum do template;
+ * [Notas]:
+ *  - Retorna o tamanho total do corpo (para o Content-Length) ou -1
+ *    se os valores não couberem em TEMPLATE_SLOT_BUFFER.
+ *  - Cada slot é formatado uma única vez, mesmo que apareça em
+ *    vários pontos do template.
+ */
+long template_render_begin(template_render_t *render, const template_t *tpl, const template_value_t *values) {
+    if (tpl->slot_count > TEMPLATE_MAX_SLOTS) {
+        return -1;
+    }
+
+    render->tpl = tpl;
+    render->segment = 0;
+    render->offset = 0;
+
+    size_t used = 0;
+    for (uint8_t i = 0; i < tpl->slot_count; i++) {
+        char *out = render->slots + used;
+        size_t space = sizeof(render->slots) - used;
+        int written;
+
+        render->slot_start[i] = used;
+        switch (tpl->slot_types[i]) {
+            case TEMPLATE_SLOT_STR:
+                written = escape_html(out, space, values[i].str ? values[i].str : "");
+                break;
+            case TEMPLATE_SLOT_RAW:
+                written = snprintf(out, space, "%s", values[i].str ? values[i].str : "");
+                break;
+            case TEMPLATE_SLOT_INT:
+                written = snprintf(out, space, "%ld", (long)values[i].i);
+                break;
+            case TEMPLATE_SLOT_UINT:
+            default:
+                written = snprintf(out, space, "%lu", (unsigned long)values[i].u);
+                break;
+        }
+        if (written < 0 || (size_t)written >= space) {
+            return -1;
+        }
+        used += written;
+    }
+    render->slot_start[tpl->slot_count] = used;
+
+    long total = tpl->static_len;
+    for (uint16_t s = 0; s < tpl->segment_count; s++) {
+        const template_segment_t *seg = &tpl->segments[s];
+        if (seg->type != TEMPLATE_SEGMENT_STATIC) {
+            total += render->slot_start[seg->slot + 1] - render->slot_start[seg->slot];
+        }
+    }
+    return total;
+}
+
+/**
+ * [Descrição]: Localiza os dados de um segmento do template.
+ * [Parâmetros]:
+ *  - const template_render_t *render: estado de envio;
+ *  - uint16_t s: índice do segmento;
+ *  - size_t *len: recebe o tamanho do segmento;
+ * [Notas]: Segmentos estáticos apontam para a flash; slots, para `render->slots`.
+ */
+static const char *segment_data(const template_render_t *render, uint16_t s, size_t *len) {
+    const template_segment_t *seg = &render->tpl->segments[s];
+    if (seg->type == TEMPLATE_SEGMENT_STATIC) {
+        *len = seg->len;
+        return seg->data;
+    }
+    *len = render->slot_start[seg->slot + 1] - render->slot_start[seg->slot];
+    return render->slots + render->slot_start[seg->slot];
+}
+
+/**
+ * [Descrição]: Informa o próximo trecho a enviar, sem avançar.
+ * [Parâmetros]:
+ *  - const template_render_t *render: estado de envio;
+ *  - size_t max_len: maior trecho aceito (ex: espaço em `tcp_sndbuf`);
+ *  - const char **data: recebe o ponteiro do trecho;
+ *  - size_t *len: recebe o tamanho do trecho;
+ *  - bool *copy: true se o trecho está em RAM e precisa ser copiado;
+ * [Notas]:
+ *  - Trechos estáticos apontam para a flash e podem ser enviados
+ *    sem cópia (`tcp_write` sem TCP_WRITE_FLAG_COPY).
+ *  - Retorna false quando o template terminou ou `max_len` é 0.
+ */
+bool template_render_peek(const template_render_t *render, size_t max_len,
+                          const char **data, size_t *len, bool *copy) {
+    uint16_t offset = render->offset;
+
+    for (uint16_t s = render->segment; s < render->tpl->segment_count && max_len > 0; s++, offset = 0) {
+        size_t seg_len;
+        const char *base = segment_data(render, s, &seg_len);
+        if (offset >= seg_len) {
+            continue; // Slot vazio
+        }
+
+        *data = base + offset;
+        *len = seg_len - offset < max_len ? seg_len - offset : max_len;
+        *copy = (render->tpl->segments[s].type != TEMPLATE_SEGMENT_STATIC);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * [Descrição]: Avança o envio após um trecho ser enfileirado.
+ * [Parâmetros]:
+ *  - template_render_t *render: estado de envio;
+ *  - size_t len: tamanho enfileirado (o informado por `template_render_peek`);
+ * [Notas]: Pula os segmentos vazios, como `template_render_peek`.
+ */
+void template_render_advance(template_render_t *render, size_t len) {
+    size_t seg_len;
+
+    while (render->segment < render->tpl->segment_count) {
+        segment_data(render, render->segment, &seg_len);
+        if (render->offset < seg_len) break;
+        render->segment++;
+        render->offset = 0;
+    }
+    if (render->segment >= render->tpl->segment_count) {
+        return;
+    }
+
+    render->offset += len;
+    if (render->offset >= seg_len) {
+        render->segment++;
+        render->offset = 0;
+    }
+}
@@ -0,0 +1,229 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: upload.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Este módulo recebe uploads de arquivos via formulário
+ *      `multipart/form-data`. O corpo é processado conforme chega
+ *      pela conexão TCP e cada parte é repassada, em pedaços, a um
+ *      destino configurável (`upload_sink_t`). Por padrão os dados
+ *      apenas têm o CRC-32 calculado e registrado no log.
+ */
+#include "upload.h"
+#include "multipart.h"
+#include "checksum.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+typedef struct {
+    bool busy;
+    multipart_parser_t parser;
+    const upload_sink_t *sink;
+    char field[32];
+    char filename[UPLOAD_MAX_FILENAME];
+    bool part_open;
+    unsigned parts;
+    size_t total_bytes;
+} upload_state_t;
+
+typedef struct {
+    uint32_t crc;
+    size_t bytes;
+    char filename[UPLOAD_MAX_FILENAME];
+} checksum_sink_state_t;
+
+// Há um único upload por vez: o parser ocupa ~450 bytes de RAM
+static upload_state_t upload;
+static checksum_sink_state_t checksum_state;
+
+static int checksum_open(void *ctx, const char *field, const char *filename) {
+    checksum_sink_state_t *cs = ctx;
+    cs->crc = CRC32_INIT;
+    cs->bytes = 0;
+    snprintf(cs->filename, sizeof(cs->filename), "%s", filename);
+    return 0;
+}
+
+static int checksum_write(void *ctx, const uint8_t *data, size_t len) {
+    checksum_sink_state_t *cs = ctx;
+    cs->crc = crc32_update(cs->crc, data, len);
+    cs->bytes += len;
+    return 0;
+}
+
+static int checksum_close(void *ctx, bool ok) {
+    checksum_sink_state_t *cs = ctx;
+    if (ok) {
+        printf("Upload: %s (%u bytes, crc32 %08lx)\n", cs->filename,
+               (unsigned)cs->bytes, (unsigned long)crc32_final(cs->crc));
+    } else {
+        printf("Upload: %s cancelado apos %u bytes\n", cs->filename, (unsigned)cs->bytes);
+    }
+    return 0;
+}
+
+static const upload_sink_t checksum_sink = {
+    .open = checksum_open,
+    .write = checksum_write,
+    .close = checksum_close,
+    .ctx = &checksum_state
+};
+
+static const upload_sink_t *active_sink = &checksum_sink;
+
+/**
+ * [Descrição]: Define o destino dos arquivos recebidos.
+ * [Parâmetros]:
+ *  - const upload_sink_t *sink: destino; NULL restaura o destino padrão (CRC-32);
+ * [Notas]: Vale a partir do próximo upload iniciado.
+ */
+void upload_set_sink(const upload_sink_t *sink) {
+    active_sink = sink ? sink : &checksum_sink;
+}
+
+static int on_part_header(void *ctx, const char *name, const char *value) {
+    upload_state_t *up = ctx;
+    if (strcasecmp(name, "Content-Disposition") == 0) {
+        multipart_header_param(value, "name", up->field, sizeof(up->field));
+        multipart_header_param(value, "filename", up->filename, sizeof(up->filename));
+    }
+    return 0;
+}
+
+static int on_part_begin(void *ctx) {
+    upload_state_t *up = ctx;
+    // Campos simples do formulário (sem filename) são ignorados
+    if (up->filename[0] == '\0') {
+        return 0;
+    }
+    if (up->sink->open && up->sink->open(up->sink->ctx, up->field, up->filename)) {
+        return -1;
+    }
+    up->part_open = true;
+    return 0;
+}
+
+static int on_part_data(void *ctx, const uint8_t *data, size_t len) {
+    upload_state_t *up = ctx;
+    if (!up->part_open) {
+        return 0;
+    }
+    up->total_bytes += len;
+    return up->sink->write ? up->sink->write(up->sink->ctx, data, len) : 0;
+}
+
+static int on_part_end(void *ctx) {
+    upload_state_t *up = ctx;
+    int err = 0;
+    if (up->part_open) {
+        up->part_open = false;
+        up->parts++;
+        if (up->sink->close) {
+            err = up->sink->close(up->sink->ctx, true);
+        }
+    }
+    up->field[0] = '\0';
+    up->filename[0] = '\0';
+    return err;
+}
+
+static const multipart_callbacks_t multipart_callbacks = {
+    .on_header = on_part_header,
+    .on_part_begin = on_part_begin,
+    .on_part_data = on_part_data,
+    .on_part_end = on_part_end
+};
+
+/**
+ * [Descrição]: Libera o upload atual, cancelando a parte em aberto.
+ * [Parâmetros]:
+ *  - upload_state_t *up: estado do upload;
+ * [Notas]: O destino recebe `close(ok = false)` se havia parte aberta.
+ */
+static void upload_release(upload_state_t *up) {
+    if (up->part_open && up->sink->close) {
+        up->sink->close(up->sink->ctx, false);
+    }
+    up->part_open = false;
+    up->busy = false;
+}
+
+static int upload_on_data(void *ctx, const uint8_t *data, size_t len) {
+    upload_state_t *up = ctx;
+    return multipart_feed(&up->parser, data, len);
+}
+
+static void upload_on_end(void *ctx, int status, http_response_t *response) {
+    upload_state_t *up = ctx;
+    char summary[96];
+
+    if (status == 0 && multipart_is_done(&up->parser)) {
+        snprintf(summary, sizeof(summary), "Upload concluido: %u arquivo(s), %u bytes.\n",
+                 up->parts, (unsigned)up->total_bytes);
+        set_response_status(response, 200, "OK");
+        add_response_header(response, "Content-Type", "text/plain; charset=utf-8");
+        set_response_body(response, summary);
+    } else if (status == MULTIPART_ERR_ABORTED) {
+        set_response_status(response, 500, "Internal Server Error");
+        add_response_header(response, "Content-Type", "text/plain; charset=utf-8");
+        set_response_body(response, "Falha ao gravar o arquivo.");
+    } else {
+        set_response_status(response, 400, "Bad Request");
+        add_response_header(response, "Content-Type", "text/plain; charset=utf-8");
+        set_response_body(response, "Upload invalido ou incompleto.");
+    }
+    upload_release(up);
+}
+
+static void upload_on_abort(void *ctx) {
+    upload_release((upload_state_t *)ctx);
+}
+
+/**
+ * [Descrição]: Prepara o recebimento de um upload multipart.
+ * [Parâmetros]:
+ *  - const char *request: linha inicial e cabeçalhos da requisição;
+ *  - http_body_handler_t *handler: recebe os callbacks do corpo;
+ *  - http_response_t *response: resposta de erro, se recusado;
+ * [Notas]:
+ *  - Recusa com 503 se já houver um upload em andamento.
+ *  - Recusa com 415 se o corpo não for multipart/form-data.
+ */
+body_route_result_t upload_begin(const char *request, http_body_handler_t *handler, http_response_t *response) {
+    if (upload.busy) {
+        set_response_status(response, 503, "Service Unavailable");
+        add_response_header(response, "Content-Type", "text/plain; charset=utf-8");
+        add_response_header(response, "Retry-After", "5");
+        set_response_body(response, "Outro upload em andamento.");
+        return BODY_ROUTE_REJECTED;
+    }
+
+    size_t type_len, boundary_len = 0;
+    const char *type = http_find_header(request, "Content-Type", &type_len);
+    const char *boundary = type ? multipart_find_boundary(type, type_len, &boundary_len) : NULL;
+
+    if (multipart_init(&upload.parser, boundary, boundary_len, &multipart_callbacks, &upload) != MULTIPART_OK) {
+        set_response_status(response, 415, "Unsupported Media Type");
+        add_response_header(response, "Content-Type", "text/plain; charset=utf-8");
+        set_response_body(response, "Esperado multipart/form-data.");
+        return BODY_ROUTE_REJECTED;
+    }
+
+    upload.busy = true;
+    upload.sink = active_sink;
+    upload.field[0] = '\0';
+    upload.filename[0] = '\0';
+    upload.part_open = false;
+    upload.parts = 0;
+    upload.total_bytes = 0;
+
+    handler->on_data = upload_on_data;
+    handler->on_end = upload_on_end;
+    handler->on_abort = upload_on_abort;
+    handler->ctx = &upload;
+    return BODY_ROUTE_ACCEPTED;
+}
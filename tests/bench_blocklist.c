@@ -0,0 +1,145 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: bench_blocklist.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Mede a lista de bloqueio do DNS com 10 mil domínios sintéticos
+ *      (`tests/gen_domains.py`): bytes de flash por nome, separados em
+ *      filtro de Bloom, tabela de baldes e nomes, e o tempo de
+ *      `blocklist_contains` para nomes da lista, subdomínios deles e
+ *      nomes fora da lista (o caso comum, resolvido quase sempre só
+ *      pelo filtro). A imagem é gerada no build por `tools/mkblocklist.py`
+ *      e mapeada com mmap, como a flash pelo XIP.
+ *
+ *      Antes de medir, confere que todos os nomes e subdomínios da lista
+ *      são encontrados e nenhum nome da lista negativa é bloqueado.
+ *
+ *      Os tempos são do computador, não do RP2040: servem para comparar
+ *      os tipos de consulta e versões do formato entre si.
+ *
+ *      Uso: bench_blocklist [rodadas]
+ */
+#include "blocklist.h"
+#include "flash_layout.h"
+#include "test.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define NAMES_MAX 10000
+
+typedef struct {
+    uint8_t wire[BLOCKLIST_NAME_MAX];
+    uint8_t len;
+} name_t;
+
+static name_t blocked[NAMES_MAX], subdomains[NAMES_MAX], negatives[NAMES_MAX];
+
+// Texto para formato wire; letras alternadas em maiúscula, como chegam de alguns clientes
+static uint8_t to_wire(const char *text, uint8_t *wire, bool mixed_case) {
+    size_t len = 0;
+    while (*text) {
+        const char *dot = strchr(text, '.');
+        size_t label = dot ? (size_t)(dot - text) : strlen(text);
+        CHECK(label > 0 && len + label + 2 <= BLOCKLIST_NAME_MAX);
+        wire[len++] = (uint8_t)label;
+        for (size_t i = 0; i < label; i++) {
+            char c = text[i];
+            wire[len++] = (mixed_case && i % 2 == 0 && c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+        }
+        text += label + (dot ? 1 : 0);
+    }
+    wire[len++] = 0;
+    return (uint8_t)len;
+}
+
+static size_t read_names(const char *path, name_t *names, const char *prefix, bool mixed_case) {
+    FILE *f = fopen(path, "r");
+    CHECK(f != NULL);
+    char line[300], text[320];
+    size_t count = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0') {
+            continue;
+        }
+        CHECK(count < NAMES_MAX);
+        snprintf(text, sizeof(text), "%s%s", prefix, line);
+        names[count].len = to_wire(text, names[count].wire, mixed_case);
+        count++;
+    }
+    fclose(f);
+    return count;
+}
+
+static const uint8_t *map_image(const char *path, size_t *size) {
+    int fd = open(path, O_RDONLY);
+    CHECK(fd >= 0);
+    struct stat st;
+    CHECK(fstat(fd, &st) == 0);
+    void *image = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    CHECK(image != MAP_FAILED);
+    close(fd);
+    *size = (size_t)st.st_size;
+    return image;
+}
+
+static size_t count_found(const blocklist_t *bl, const name_t *names, size_t count) {
+    size_t found = 0;
+    for (size_t i = 0; i < count; i++) {
+        found += blocklist_contains(bl, names[i].wire, names[i].len);
+    }
+    return found;
+}
+
+// Menor tempo por busca entre as rodadas, para reduzir o ruído
+static double bench(const blocklist_t *bl, const name_t *names, size_t count, long rounds) {
+    double best = 0;
+    volatile size_t sink = 0;
+    for (long round = 0; round < rounds; round++) {
+        double start = test_now();
+        sink += count_found(bl, names, count);
+        double ns = (test_now() - start) * 1e9 / count;
+        if (round == 0 || ns < best) {
+            best = ns;
+        }
+    }
+    (void)sink;
+    return best;
+}
+
+int main(int argc, char **argv) {
+    long rounds = test_iterations(argc, argv, 50);
+    size_t size;
+    const uint8_t *image = map_image(BLOCKLIST_IMAGE, &size);
+    blocklist_t bl;
+    CHECK(blocklist_mount(&bl, image, size) == BLOCKLIST_OK);
+    CHECK(size <= FLASH_BLOCKLIST_SIZE);
+
+    size_t count = read_names(BLOCKLIST_NAMES, blocked, "", true);
+    CHECK(read_names(BLOCKLIST_NAMES, subdomains, "www.", false) == count);
+    size_t negative_count = read_names(BLOCKLIST_NEGATIVES, negatives, "", false);
+    CHECK(bl.count == count);
+    CHECK(count_found(&bl, blocked, count) == count);
+    CHECK(count_found(&bl, subdomains, count) == count);
+    CHECK(count_found(&bl, negatives, negative_count) == 0);
+
+    size_t bloom = bl.bloom_bits / 8;
+    size_t buckets = (bl.bucket_count + 1) * sizeof(uint32_t);
+    size_t names = size - sizeof(blocklist_header_t) - bloom - buckets;
+    printf("%u nomes, %zu bytes (%.1f%% da região): %.2f bytes/nome\n", bl.count, size,
+           100.0 * size / FLASH_BLOCKLIST_SIZE, (double)size / bl.count);
+    printf("  filtro %.2f (%u hashes)  baldes %.2f  nomes %.2f  bytes/nome\n", (double)bloom / bl.count,
+           bl.hash_count, (double)buckets / bl.count, (double)names / bl.count);
+
+    printf("%-12s %8s\n", "busca", "ns");
+    printf("%-12s %8.1f\n", "na lista", bench(&bl, blocked, count, rounds));
+    printf("%-12s %8.1f\n", "subdominio", bench(&bl, subdomains, count, rounds));
+    printf("%-12s %8.1f\n", "fora", bench(&bl, negatives, negative_count, rounds));
+    return 0;
+}
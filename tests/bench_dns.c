@@ -0,0 +1,132 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: bench_dns.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Mede as consultas por segundo do servidor DNS (`dnsserver.c`)
+ *      sobre o lwIP de `tests/host/`. Cada consulta chega num pbuf da
+ *      pool, como o driver Wi-Fi entrega, e a resposta é escrita no
+ *      próprio pbuf. Para comparar, a mesma consulta é entregue num pbuf
+ *      PBUF_RAM do tamanho exato, que obriga o servidor a copiar para
+ *      um pbuf novo antes de responder.
+ *
+ *      O relógio avança 100 ms por consulta, para o limite por cliente
+ *      (RRL) nunca descartar. A primeira resposta de cada consulta é
+ *      conferida; depois, só o número de respostas.
+ *
+ *      Os tempos são do computador, não do RP2040: servem para comparar
+ *      os dois caminhos e os tipos de consulta entre si.
+ *
+ *      Uso: bench_dns [iterações]
+ */
+#include "dnsserver.h"
+#include "lwip/udp.h"
+#include "pico/time.h"
+#include "test.h"
+#include <string.h>
+
+typedef struct {
+    const char *name;
+    const uint8_t *msg;
+    size_t len;
+    uint16_t answers;           // Registros esperados na resposta
+} query_t;
+
+// ID 0x1234, RD, uma pergunta
+#define QUERY_HEADER 0x12, 0x34, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00
+#define EXAMPLE_COM 7, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 3, 'c', 'o', 'm', 0
+
+static const uint8_t query_a[] = { QUERY_HEADER, 0x00, 0x00, EXAMPLE_COM, 0x00, 0x01, 0x00, 0x01 };
+static const uint8_t query_aaaa[] = { QUERY_HEADER, 0x00, 0x00, EXAMPLE_COM, 0x00, 0x1c, 0x00, 0x01 };
+static const uint8_t query_host[] = { QUERY_HEADER, 0x00, 0x00, 6, 'a', 'l', 'a', 'r', 'm', 'e', 3, 'l', 'a',
+                                      'n', 0, 0x00, 0x01, 0x00, 0x01 };
+// A com OPT anunciando 1232 bytes
+static const uint8_t query_edns[] = { QUERY_HEADER, 0x00, 0x01, EXAMPLE_COM, 0x00, 0x01, 0x00, 0x01,
+                                      0x00, 0x00, 0x29, 0x04, 0xd0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+static const query_t queries[] = {
+    { "A fallback", query_a, sizeof(query_a), 1 },
+    { "A tabela", query_host, sizeof(query_host), 1 },
+    { "AAAA (SOA)", query_aaaa, sizeof(query_aaaa), 0 },
+    { "A + EDNS", query_edns, sizeof(query_edns), 1 },
+};
+
+static const query_t *current;
+static long replies;
+static bool check_next;
+
+static err_t count_reply(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *dst, u16_t port) {
+    if (check_next) {
+        const uint8_t *msg = p->payload;
+        CHECK(p->next == NULL && p->len >= 12 && p->len <= DNS_UDP_MSG_MAX);
+        CHECK(msg[0] == 0x12 && msg[1] == 0x34 && (msg[2] & 0x80) && (msg[3] & 0x0f) == 0);
+        CHECK((msg[6] << 8 | msg[7]) == current->answers);
+        check_next = false;
+    }
+    replies++;
+    return ERR_OK;
+}
+
+// Consulta num pbuf PBUF_RAM justo: sem espaço para a resposta no lugar
+static void deliver_ram(dns_server_t *d, const ip_addr_t *client) {
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, (u16_t)current->len, PBUF_RAM);
+    CHECK(p != NULL);
+    memcpy(p->payload, current->msg, current->len);
+    d->udp->recv(d->udp->recv_arg, d->udp, p, client, 5353);
+}
+
+// Menor tempo por consulta em 5 rodadas, para reduzir o ruído
+static double bench(dns_server_t *d, bool in_place, long iterations) {
+    ip_addr_t client;
+    IP4_ADDR(&client, 192, 168, 4, 16);
+    double best = 0;
+
+    for (int round = 0; round < 5; round++) {
+        replies = 0;
+        check_next = true;
+        double start = test_now();
+        for (long i = 0; i < iterations; i++) {
+            host_time_us += 100000;
+            if (in_place) {
+                host_udp_input(53, current->msg, current->len, &client, 5353);
+            } else {
+                deliver_ram(d, &client);
+            }
+        }
+        double ns = (test_now() - start) * 1e9 / iterations;
+        CHECK(replies == iterations && !check_next);
+        CHECK(host_pbuf_count == 0);
+        if (round == 0 || ns < best) {
+            best = ns;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    long iterations = test_iterations(argc, argv, 2000000);
+    static dns_server_t d;
+    ip_addr_t ip;
+    ip4_addr_t host;
+    IP4_ADDR(&ip, 192, 168, 4, 1);
+    IP4_ADDR(&host, 192, 168, 4, 1);
+    dns_server_init(&d, &ip);
+    CHECK(d.udp != NULL);
+    CHECK(dns_server_set_host(&d, "alarme.lan", DNS_ACTION_ADDRESS, &host) == 0);
+    host_udp_output = count_reply;
+
+    printf("%-12s %12s %10s %12s %10s\n", "consulta", "no lugar ns", "Mq/s", "copia ns", "Mq/s");
+    for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); i++) {
+        current = &queries[i];
+        double in_place = bench(&d, true, iterations);
+        double copy = bench(&d, false, iterations);
+        printf("%-12s %12.1f %10.2f %12.1f %10.2f\n", current->name, in_place, 1e3 / in_place, copy,
+               1e3 / copy);
+    }
+
+    dns_server_deinit(&d);
+    return 0;
+}
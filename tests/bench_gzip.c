@@ -0,0 +1,159 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: bench_gzip.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Mede o custo de CPU do gzip contra os bytes economizados nas
+ *      respostas dinâmicas, comprimidas como o servidor faz: os streams
+ *      em blocos de HTTP_STREAM_BUFFER_SIZE (os chunks), e os templates
+ *      e corpos em RAM inteiros, numa chamada só.
+ *      Quando a zlib está disponível, cada saída é descomprimida e
+ *      comparada com a entrada.
+ *
+ *      Os tempos são do computador, não do RP2040: servem para comparar
+ *      as respostas entre si e o custo por KiB economizado.
+ *
+ *      Uso: bench_gzip [iterações]
+ */
+#include "gzip.h"
+#include "http_stream.h"
+#include "test.h"
+#include <string.h>
+#if HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#define INPUT_MAX   8192
+#define CLIENTS     8
+
+typedef struct {
+    const char *name;
+    bool whole;                 // Template ou corpo em RAM: uma chamada só
+    char data[INPUT_MAX];
+    size_t len;
+} sample_t;
+
+static sample_t samples[5];
+
+// Cada bloco cabe em gzip_bound(n), que é o que single_flight.c aloca por segmento
+static size_t compress_blocks(gzip_stream_t *gz, const uint8_t *in, size_t len, uint8_t *out, size_t block) {
+    size_t out_len = 0;
+    gzip_init(gz);
+    for (size_t off = 0; off < len; off += block) {
+        size_t n = len - off < block ? len - off : block;
+        size_t written = gzip_compress(gz, in + off, n, out + out_len, off + n >= len);
+        CHECK(written <= gzip_bound(n));
+        out_len += written;
+    }
+    return out_len;
+}
+
+static void verify(const sample_t *s, const uint8_t *out, size_t out_len) {
+#if HAVE_ZLIB
+    static uint8_t plain[INPUT_MAX];
+    z_stream z = { 0 };
+    CHECK(inflateInit2(&z, 16 + MAX_WBITS) == Z_OK);
+    z.next_in = (uint8_t *)out;
+    z.avail_in = (uInt)out_len;
+    z.next_out = plain;
+    z.avail_out = sizeof(plain);
+    CHECK(inflate(&z, Z_FINISH) == Z_STREAM_END);
+    CHECK(z.total_out == s->len && memcmp(plain, s->data, s->len) == 0);
+    inflateEnd(&z);
+#else
+    (void)s;
+    (void)out;
+    (void)out_len;
+#endif
+}
+
+static void build_samples(void) {
+    sample_t *s = samples;
+
+    // GET /clientes: texto tabulado
+    s->name = "/clientes";
+    s->len = (size_t)sprintf(s->data, "ip\tmac\texpira_s\n");
+    for (int i = 0; i < CLIENTS; i++) {
+        s->len += sprintf(s->data + s->len, "192.168.4.%d\t%02x:%02x:%02x:%02x:%02x:%02x\t%d\n", 16 + i,
+                          0x3c, 0x22, 0xfb, test_rand() & 0xff, test_rand() & 0xff, test_rand() & 0xff,
+                          (int)(test_rand() % 86400));
+    }
+    s++;
+
+    // GET /api/clientes: JSON
+    s->name = "/api/clientes";
+    s->len = (size_t)sprintf(s->data, "[");
+    for (int i = 0; i < CLIENTS; i++) {
+        s->len += sprintf(s->data + s->len, "%s{\"ip\":\"192.168.4.%d\",\"mac\":\"%02x:%02x:%02x:%02x:%02x:%02x\","
+                          "\"expira_s\":%d}", i ? "," : "", 16 + i, 0x3c, 0x22, 0xfb, test_rand() & 0xff,
+                          test_rand() & 0xff, test_rand() & 0xff, (int)(test_rand() % 86400));
+    }
+    s->len += sprintf(s->data + s->len, "]");
+    s++;
+
+    // GET /api/metricas: uma entrada por rota
+    static const char *routes[] = { "GET / ", "GET /ligar ", "GET /desligar ", "GET /clientes ",
+                                     "GET /api/status ", "GET /api/clientes ", "GET /api/metricas ",
+                                     "GET /api/metricas/envio ", "GET /api/metricas/dns ",
+                                     "POST /api/alarme ", "POST /upload ", "POST /api/ota ", "GET /<romfs>" };
+    s->name = "/api/metricas";
+    s->whole = true;
+    s->len = (size_t)sprintf(s->data, "[");
+    for (size_t i = 0; i < sizeof(routes) / sizeof(routes[0]); i++) {
+        s->len += sprintf(s->data + s->len, "%s{\"rota\":\"%s\",\"requisicoes\":%u,\"erros\":%u,"
+                          "\"media_us\":%u,\"max_us\":%u}", i ? "," : "", routes[i], test_rand() % 5000,
+                          test_rand() % 10, test_rand() % 2000, test_rand() % 90000);
+    }
+    s->len += sprintf(s->data + s->len, "]");
+    s++;
+
+    // Template da página inicial (as marcações {{...}} ocupam quase o mesmo que os valores)
+    s->name = "index.html";
+    s->whole = true;
+    FILE *f = fopen(PAGES_DIR "/index.html", "rb");
+    CHECK(f != NULL);
+    s->len = fread(s->data, 1, sizeof(s->data), f);
+    fclose(f);
+    s++;
+
+    // Pior caso: bytes sem repetição
+    s->name = "aleatorio";
+    s->len = 2048;
+    for (size_t i = 0; i < s->len; i++) {
+        s->data[i] = (char)test_rand();
+    }
+}
+
+int main(int argc, char **argv) {
+    long iterations = test_iterations(argc, argv, 20000);
+    static gzip_stream_t gz;
+    static uint8_t out[INPUT_MAX * 2];
+
+    build_samples();
+    printf("%-14s %6s %6s %7s %9s %9s %12s\n", "resposta", "bytes", "gzip", "ganho", "us/resp", "ns/byte",
+           "us/KiB ganho");
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+        const sample_t *s = &samples[i];
+        size_t block = s->whole ? s->len : HTTP_STREAM_BUFFER_SIZE;
+        size_t out_len = compress_blocks(&gz, (const uint8_t *)s->data, s->len, out, block);
+        verify(s, out, out_len);
+
+        double start = test_now();
+        for (long k = 0; k < iterations; k++) {
+            compress_blocks(&gz, (const uint8_t *)s->data, s->len, out, block);
+        }
+        double us = (test_now() - start) * 1e6 / iterations;
+        long saved = (long)s->len - (long)out_len;
+        printf("%-14s %6zu %6zu %6.1f%% %9.2f %9.2f", s->name, s->len, out_len, 100.0 * saved / s->len, us,
+               us * 1000 / s->len);
+        if (saved > 0) {
+            printf(" %12.2f\n", us * 1024 / saved);
+        } else {
+            printf(" %12s\n", "-");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: bench_json_writer.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Compara o escritor JSON com `snprintf` nos dois formatos típicos
+ *      da API: o objeto de status (`/api/status`) e a lista de métricas
+ *      por rota. As duas versões precisam gerar os mesmos bytes; o
+ *      tempo por resposta é medido para cada uma.
+ *
+ *      Uso: bench_json_writer [iterações]
+ */
+#include "json_writer.h"
+#include "test.h"
+#include <string.h>
+
+#define ROUTES 8
+
+typedef struct {
+    const char *path;
+    uint32_t requests;
+    uint32_t errors;
+    uint32_t mean_us;
+    uint32_t max_us;
+} route_metric_t;
+
+static const route_metric_t metrics[ROUTES] = {
+    { "GET / ", 1520, 0, 812, 4210 },
+    { "GET /ligar ", 31, 0, 95, 310 },
+    { "GET /desligar ", 29, 1, 90, 305 },
+    { "GET /api/status ", 20480, 3, 120, 2200 },
+    { "POST /api/alarme ", 12, 2, 240, 980 },
+    { "GET /api/metricas ", 77, 0, 410, 1900 },
+    { "POST /upload ", 4, 1, 150000, 420000 },
+    { "GET /\"quoted\"\\path ", 1, 1, 60, 60 },
+};
+
+static volatile size_t sink;
+
+static size_t status_writer(char *buf, size_t cap, uint32_t i) {
+    json_writer_t w;
+    json_writer_init(&w, buf, cap);
+    json_begin_object(&w);
+    json_key(&w, "alarme");
+    json_bool(&w, i & 1);
+    json_key(&w, "clientes");
+    json_uint(&w, i % 8);
+    json_key(&w, "uptime_s");
+    json_uint(&w, 3600 + i);
+    json_end_object(&w);
+    return json_writer_finish(&w);
+}
+
+static size_t status_snprintf(char *buf, size_t cap, uint32_t i) {
+    int n = snprintf(buf, cap, "{\"alarme\":%s,\"clientes\":%u,\"uptime_s\":%u}",
+                     (i & 1) ? "true" : "false", (unsigned)(i % 8), (unsigned)(3600 + i));
+    return n < 0 || (size_t)n >= cap ? 0 : (size_t)n;
+}
+
+static size_t metrics_writer(char *buf, size_t cap, uint32_t i) {
+    json_writer_t w;
+    json_writer_init(&w, buf, cap);
+    json_begin_array(&w);
+    for (int r = 0; r < ROUTES; r++) {
+        const route_metric_t *m = &metrics[r];
+        json_begin_object(&w);
+        json_key(&w, "rota");
+        json_string(&w, m->path);
+        json_key(&w, "requisicoes");
+        json_uint(&w, m->requests + i);
+        json_key(&w, "erros");
+        json_uint(&w, m->errors);
+        json_key(&w, "media_us");
+        json_uint(&w, m->mean_us);
+        json_key(&w, "max_us");
+        json_uint(&w, m->max_us);
+        json_end_object(&w);
+    }
+    json_end_array(&w);
+    return json_writer_finish(&w);
+}
+
+// Escape mínimo (aspas e barra) que a versão com snprintf precisa fazer à parte
+static void escape(char *out, const char *in) {
+    while (*in) {
+        if (*in == '"' || *in == '\\') {
+            *out++ = '\\';
+        }
+        *out++ = *in++;
+    }
+    *out = '\0';
+}
+
+static size_t metrics_snprintf(char *buf, size_t cap, uint32_t i) {
+    size_t len = 0;
+    buf[len++] = '[';
+    for (int r = 0; r < ROUTES; r++) {
+        const route_metric_t *m = &metrics[r];
+        char path[64];
+        escape(path, m->path);
+        int n = snprintf(buf + len, cap - len,
+                         "%s{\"rota\":\"%s\",\"requisicoes\":%u,\"erros\":%u,\"media_us\":%u,\"max_us\":%u}",
+                         r ? "," : "", path, (unsigned)(m->requests + i), (unsigned)m->errors,
+                         (unsigned)m->mean_us, (unsigned)m->max_us);
+        if (n < 0 || (size_t)n >= cap - len) {
+            return 0;
+        }
+        len += (size_t)n;
+    }
+    if (len + 1 >= cap) {
+        return 0;
+    }
+    buf[len++] = ']';
+    buf[len] = '\0';
+    return len;
+}
+
+typedef size_t (*render_fn)(char *buf, size_t cap, uint32_t i);
+
+static double bench(render_fn fn, long iterations) {
+    char buf[1024];
+    size_t total = 0;
+    double start = test_now();
+    for (long i = 0; i < iterations; i++) {
+        total += fn(buf, sizeof(buf), (uint32_t)i);
+    }
+    double elapsed = test_now() - start;
+    sink = total;
+    return elapsed * 1e9 / iterations;
+}
+
+static void compare(const char *name, render_fn writer, render_fn reference, long iterations) {
+    char a[1024], b[1024];
+    for (uint32_t i = 0; i < 4; i++) {
+        size_t la = writer(a, sizeof(a), i);
+        size_t lb = reference(b, sizeof(b), i);
+        CHECK(la > 0 && la == lb && memcmp(a, b, la) == 0);
+    }
+    double ns_writer = bench(writer, iterations);
+    double ns_snprintf = bench(reference, iterations);
+    printf("%-10s %4zu bytes  json_writer %7.1f ns  snprintf %7.1f ns  (%.2fx)\n",
+           name, writer(a, sizeof(a), 0), ns_writer, ns_snprintf, ns_snprintf / ns_writer);
+}
+
+int main(int argc, char **argv) {
+    long iterations = test_iterations(argc, argv, 2000000);
+    compare("status", status_writer, status_snprintf, iterations);
+    compare("metricas", metrics_writer, metrics_snprintf, iterations / 8 + 1);
+    return 0;
+}
@@ -0,0 +1,160 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: fuzz_dns.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Alvo de fuzzing da leitura e da montagem de mensagens do servidor
+ *      DNS (libFuzzer, AFL ou `fuzz_main.c`). Inclui `dnsserver.c` para
+ *      chegar às funções estáticas, sobre o lwIP de `tests/host/`.
+ *
+ *      Cada entrada é lida como nome a partir dos primeiros deslocamentos
+ *      (`dns_read_name`), respondida por `dns_build_reply` com vários
+ *      tamanhos de buffer, via UDP e TCP, respondida com TC
+ *      (`dns_truncated_reply`) e guardada no cache como se viesse do
+ *      upstream. O buffer da resposta tem o tamanho exato do limite, para
+ *      o AddressSanitizer acusar qualquer escrita além dele.
+ *
+ *      Toda resposta é lida de novo por um leitor independente dos
+ *      contadores: as perguntas e os registros anunciados no cabeçalho
+ *      devem terminar exatamente no fim da resposta, com o ID e a seção
+ *      de perguntas da consulta.
+ */
+#include "dnsserver.c"
+#include "pico/time.h"
+#include "test.h"
+
+static dns_server_t ap;         // Só ponto de acesso: repasse vira endereço
+static dns_server_t sta;        // Com upstream: repasse e cache
+
+// Nome lido a partir de `off`: só rótulos até 63 e um único 0 no fim
+static void check_name(const uint8_t *msg, size_t len, size_t off) {
+    uint8_t name[DNS_NAME_MAX + 8];
+    dns_reader_t r = { .msg = msg, .len = len, .off = off };
+    size_t name_len = dns_read_name(&r, name);
+    if (r.error) {
+        CHECK(name_len == 0);
+        return;
+    }
+    CHECK(name_len >= 1 && name_len <= DNS_NAME_MAX && r.off > off && r.off <= len);
+    size_t pos = 0;
+    while (name[pos] != 0) {
+        CHECK(name[pos] <= 63);
+        pos += name[pos] + 1;
+        CHECK(pos < name_len);
+    }
+    CHECK(pos + 1 == name_len);
+}
+
+// Perguntas e registros anunciados no cabeçalho terminam no fim da resposta
+static void check_reply(const uint8_t *msg, size_t len) {
+    CHECK(len >= sizeof(dns_header_t));
+    CHECK(msg[2] & 0x80);
+    uint16_t questions = dns_get16(msg + offsetof(dns_header_t, question_count));
+    unsigned records = dns_get16(msg + offsetof(dns_header_t, answer_record_count))
+                     + dns_get16(msg + offsetof(dns_header_t, authority_record_count))
+                     + dns_get16(msg + offsetof(dns_header_t, additional_record_count));
+    dns_reader_t r = { .msg = msg, .len = len, .off = sizeof(dns_header_t) };
+    for (uint16_t i = 0; i < questions; i++) {
+        CHECK(dns_read_name(&r, NULL) > 0);
+        dns_read_skip(&r, 4);
+    }
+    for (unsigned i = 0; i < records; i++) {
+        dns_read_name(&r, NULL);
+        dns_read_skip(&r, 8);
+        dns_read_skip(&r, dns_read16(&r));
+    }
+    CHECK(!r.error && r.off == len);
+}
+
+static void init(void) {
+    ip_addr_t ip, upstream;
+    IP4_ADDR(&ip, 192, 168, 4, 1);
+    IP4_ADDR(&upstream, 10, 0, 0, 53);
+    dns_server_t *servers[] = { &ap, &sta };
+    for (int i = 0; i < 2; i++) {
+        dns_server_t *d = servers[i];
+        dns_server_init(d, &ip);
+        dns_server_set_host(d, "admin.lan", DNS_ACTION_ADDRESS, NULL);
+        dns_server_set_host(d, "*.com", DNS_ACTION_NXDOMAIN, NULL);
+        dns_server_set_host(d, "fwd.net", DNS_ACTION_FORWARD, NULL);
+        dns_server_set_host(d, "*.gov.br", DNS_ACTION_FORWARD, NULL);
+    }
+    dns_server_set_upstream(&sta, &upstream);
+}
+
+// Resposta montada num buffer de exatamente `cap` bytes
+static void build(dns_server_t *d, const uint8_t *data, size_t size, size_t cap, bool udp) {
+    if (size > cap) {
+        return;
+    }
+    uint8_t *msg = malloc(cap);
+    CHECK(msg != NULL);
+    memcpy(msg, data, size);
+    dns_question_t q;
+    memset(&q, 0xa5, sizeof(q));            // Como a pilha do caminho TCP: lixo
+    size_t len = dns_build_reply(d, msg, size, cap, udp, &q);
+    if (len > 0) {
+        CHECK(!q.forward && len <= cap);
+        CHECK(!udp || len <= DNS_EDNS_PAYLOAD_MAX);
+        CHECK(!udp || q.edns || len <= DNS_UDP_MSG_MAX);
+        check_reply(msg, len);
+        CHECK(memcmp(msg, data, 2) == 0);
+        CHECK(memcmp(msg + sizeof(dns_header_t), data + sizeof(dns_header_t), q.end - sizeof(dns_header_t)) == 0);
+    }
+    free(msg);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static bool ready;
+    if (!ready) {
+        init();
+        ready = true;
+    }
+    host_time_us += 1000;
+
+    for (size_t off = 0; off < size && off < 64; off++) {
+        check_name(data, size, off);
+    }
+
+    static const size_t caps[] = { DNS_UDP_MSG_MAX, DNS_EDNS_PAYLOAD_MAX, PBUF_POOL_BUFSIZE };
+    dns_server_t *servers[] = { &ap, &sta };
+    for (int s = 0; s < 2; s++) {
+        build(servers[s], data, size, size, true);
+        for (size_t i = 0; i < sizeof(caps) / sizeof(caps[0]); i++) {
+            build(servers[s], data, size, caps[i], true);
+        }
+        build(servers[s], data, size, DNS_TCP_MSG_MAX, false);
+    }
+
+    uint8_t *msg = malloc(size + 1);
+    CHECK(msg != NULL);
+    memcpy(msg, data, size);
+    size_t len = dns_truncated_reply(msg, size);
+    if (len > 0) {
+        CHECK(len <= size);
+        check_reply(msg, len);
+    }
+
+    // Os mesmos bytes como resposta do upstream, com os filtros de dns_upstream_recv
+    memcpy(msg, data, size);
+    if (size >= sizeof(dns_header_t) && (msg[2] & 0x80) && dns_get16(msg + offsetof(dns_header_t, question_count)) == 1) {
+        dns_reader_t r = { .msg = msg, .len = size, .off = sizeof(dns_header_t) };
+        uint8_t name[DNS_NAME_MAX];
+        size_t name_len = dns_read_name(&r, name);
+        uint16_t qtype = dns_read16(&r);
+        uint16_t qclass = dns_read16(&r);
+        if (!r.error) {
+            dns_pending_t pending = { .qhash = dns_name_hash(name, name_len), .qtype = qtype, .qclass = qclass };
+            dns_cache_store(&sta, msg, size, &pending, r.off);
+        }
+    }
+    for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+        const dns_cache_entry_t *e = &sta.cache[i];
+        CHECK(e->qhash == 0 || (e->len <= DNS_CACHE_MSG_MAX && e->question_end <= e->len));
+    }
+    free(msg);
+    return 0;
+}
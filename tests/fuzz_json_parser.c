@@ -0,0 +1,83 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: fuzz_json_parser.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Alvo de fuzzing do tokenizador JSON (libFuzzer, AFL ou
+ *      `fuzz_main.c`). Além de procurar acessos fora do texto, confere
+ *      a árvore de tokens: limites dentro do texto, pais antes dos
+ *      filhos e `json_skip` da raiz consumindo todos os tokens. As
+ *      funções de acesso são chamadas em todos os objetos, com chaves
+ *      fixas e com a primeira chave de cada um.
+ */
+#include "json_parser.h"
+#include "test.h"
+#include <string.h>
+
+static void check_tree(const json_token_t *tokens, int count, size_t len) {
+    for (int i = 0; i < count; i++) {
+        const json_token_t *t = &tokens[i];
+        CHECK(t->type >= JSON_OBJECT && t->type <= JSON_PRIMITIVE);
+        CHECK(t->start <= t->end && t->end <= len);
+        CHECK(i == 0 ? t->parent == -1 : (t->parent >= 0 && t->parent < i));
+        if (t->type == JSON_STRING || t->type == JSON_PRIMITIVE) {
+            CHECK(t->size <= 1);
+        }
+    }
+    if (count > 0) {
+        CHECK(json_skip(tokens, count, 0) == count);
+    }
+}
+
+static void read_fields(const char *js, const json_token_t *tokens, int count, int object) {
+    static const char *keys[] = { "siren", "duration", "nome", "" };
+    char out[16];
+    int32_t value;
+    bool flag;
+
+    for (size_t k = 0; k < sizeof(keys) / sizeof(keys[0]); k++) {
+        json_get_int(js, tokens, count, object, keys[k], &value);
+        json_get_bool(js, tokens, count, object, keys[k], &flag);
+        int n = json_get_string(js, tokens, count, object, keys[k], out, sizeof(out));
+        CHECK(n < (int)sizeof(out) && (n < 0 || strlen(out) <= (size_t)n));
+    }
+
+    // A primeira chave do objeto, copiada como texto, deve ser encontrada
+    if (tokens[object].size > 0 && object + 1 < count) {
+        const json_token_t *key = &tokens[object + 1];
+        char name[32];
+        size_t n = key->end - key->start;
+        if (n < sizeof(name) && memchr(js + key->start, '\0', n) == NULL) {
+            memcpy(name, js + key->start, n);
+            name[n] = '\0';
+            CHECK(json_find_key(js, tokens, count, object, name) == object + 2);
+            json_get_string(js, tokens, count, object, name, out, 1);
+            json_get_int(js, tokens, count, object, name, &value);
+        }
+    }
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    const char *js = (const char *)data;
+    json_token_t tokens[64];
+    static const unsigned limits[] = { 1, 4, 64 };
+
+    for (size_t l = 0; l < sizeof(limits) / sizeof(limits[0]); l++) {
+        int count = json_parse(js, size, tokens, limits[l]);
+        CHECK(count <= (int)limits[l]);
+        if (count < 0) {
+            CHECK(count >= JSON_ERR_SIZE);
+            continue;
+        }
+        check_tree(tokens, count, size);
+        for (int i = 0; i < count; i++) {
+            if (tokens[i].type == JSON_OBJECT) {
+                read_fields(js, tokens, count, i);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,149 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: fuzz_main.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Executor dos alvos de fuzzing (`LLVMFuzzerTestOneInput`) quando
+ *      não há libFuzzer, ex: compilando com gcc:
+ *
+ *          fuzz_x arquivo...           executa cada entrada uma vez
+ *          fuzz_x -n N arquivo...      N mutações aleatórias das entradas
+ *          fuzz_x < entrada            uma entrada pela stdin (AFL:
+ *                                      afl-fuzz -i corpus -o saida -- fuzz_x)
+ *
+ *      Cada entrada vai para um buffer do tamanho exato, para que o
+ *      AddressSanitizer acuse qualquer leitura além do fim. Com clang,
+ *      compile os alvos com -DLIBFUZZER=ON e este arquivo não é usado.
+ */
+#include "test.h"
+#include <string.h>
+
+#define FUZZ_MAX_INPUT  4096
+#define FUZZ_MAX_SEEDS  64
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+} fuzz_input_t;
+
+static size_t read_all(FILE *f, uint8_t *buf, size_t cap) {
+    size_t len = 0, n;
+    while (len < cap && (n = fread(buf + len, 1, cap - len, f)) > 0) {
+        len += n;
+    }
+    return len;
+}
+
+// Executa uma entrada a partir de uma cópia com o tamanho exato
+static void run_one(const uint8_t *data, size_t len) {
+    uint8_t *copy = malloc(len ? len : 1);
+    CHECK(copy != NULL);
+    memcpy(copy, data, len);
+    LLVMFuzzerTestOneInput(copy, len);
+    free(copy);
+}
+
+// Bytes que mudam a estrutura da maioria dos formatos testados
+static const uint8_t interesting[] = { 0x00, 0xff, 0x7f, 0x80, 0xc0, 0x3f, 0x40, '{', '}', '[', ']', '"',
+                                       ':', ',', '\\', '-', '0', '9', 'e', '.' };
+
+static size_t mutate(uint8_t *buf, size_t len, const fuzz_input_t *seeds, int seed_count) {
+    int rounds = 1 + test_rand() % 8;
+    for (int k = 0; k < rounds; k++) {
+        size_t pos = len ? test_rand() % len : 0;
+        switch (test_rand() % 7) {
+            case 0:     // Inverte um bit
+                if (len) buf[pos] ^= (uint8_t)(1u << (test_rand() % 8));
+                break;
+            case 1:     // Byte aleatório ou interessante
+                if (len) buf[pos] = test_rand() % 2 ? (uint8_t)test_rand()
+                                                    : interesting[test_rand() % sizeof(interesting)];
+                break;
+            case 2:     // Insere um byte
+                if (len < FUZZ_MAX_INPUT) {
+                    memmove(buf + pos + 1, buf + pos, len - pos);
+                    buf[pos] = interesting[test_rand() % sizeof(interesting)];
+                    len++;
+                }
+                break;
+            case 3:     // Remove um trecho
+                if (len) {
+                    size_t n = 1 + test_rand() % (len - pos);
+                    memmove(buf + pos, buf + pos + n, len - pos - n);
+                    len -= n;
+                }
+                break;
+            case 4:     // Trunca
+                len = pos;
+                break;
+            case 5: {   // Duplica um trecho
+                size_t n = len ? 1 + test_rand() % (len - pos) : 0;
+                if (len + n <= FUZZ_MAX_INPUT) {
+                    memmove(buf + pos + n, buf + pos, len - pos);
+                    len += n;
+                }
+                break;
+            }
+            case 6: {   // Enxerta um trecho de outra entrada
+                const fuzz_input_t *s = &seeds[test_rand() % seed_count];
+                if (s->len) {
+                    size_t from = test_rand() % s->len;
+                    size_t n = 1 + test_rand() % (s->len - from);
+                    if (pos + n > FUZZ_MAX_INPUT) n = FUZZ_MAX_INPUT - pos;
+                    memcpy(buf + pos, s->data + from, n);
+                    if (pos + n > len) len = pos + n;
+                }
+                break;
+            }
+        }
+    }
+    return len;
+}
+
+int main(int argc, char **argv) {
+    static uint8_t storage[FUZZ_MAX_SEEDS][FUZZ_MAX_INPUT];
+    static uint8_t buf[FUZZ_MAX_INPUT];
+    fuzz_input_t seeds[FUZZ_MAX_SEEDS];
+    int seed_count = 0;
+    long mutations = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            mutations = atol(argv[++i]);
+            continue;
+        }
+        CHECK(seed_count < FUZZ_MAX_SEEDS);
+        FILE *f = fopen(argv[i], "rb");
+        if (!f) {
+            fprintf(stderr, "%s: não foi possível abrir\n", argv[i]);
+            return 1;
+        }
+        seeds[seed_count].data = storage[seed_count];
+        seeds[seed_count].len = read_all(f, storage[seed_count], FUZZ_MAX_INPUT);
+        fclose(f);
+        seed_count++;
+    }
+
+    if (seed_count == 0) {
+        size_t len = read_all(stdin, buf, sizeof(buf));
+        run_one(buf, len);
+        return 0;
+    }
+
+    for (int i = 0; i < seed_count; i++) {
+        run_one(seeds[i].data, seeds[i].len);
+    }
+    for (long i = 0; i < mutations; i++) {
+        const fuzz_input_t *s = &seeds[test_rand() % seed_count];
+        memcpy(buf, s->data, s->len);
+        size_t len = mutate(buf, s->len, seeds, seed_count);
+        run_one(buf, len);
+    }
+    printf("%s: %d entradas, %ld mutações\n", argv[0], seed_count, mutations);
+    return 0;
+}
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""
+Gera listas sintéticas de domínios para o benchmark da lista de bloqueio
+(tests/bench_blocklist.c).
+
+A lista de bloqueio tem `--count` domínios distintos, nenhum subdomínio
+de outro (mkblocklist.py descartaria os cobertos), com rótulos e TLDs no
+formato das listas de rastreadores. A lista negativa tem nomes do mesmo
+formato que não são bloqueados por nenhum deles, nem como subdomínio.
+A semente é fixa: as listas são iguais em todo build.
+
+Uso: gen_domains.py --count 10000 -o bloqueados.txt --negatives livres.txt
+"""
+import argparse
+import random
+
+SYLLABLES = ["ad", "an", "ap", "be", "bi", "cd", "cl", "co", "da", "di", "ev", "fl", "go", "hub",
+             "ic", "in", "ka", "lo", "ly", "ma", "me", "mo", "net", "ob", "pi", "pix", "ra", "re",
+             "sa", "si", "sta", "tag", "te", "tic", "tr", "um", "up", "va", "xo", "zo"]
+TLDS = ["com", "net", "io", "co", "org", "info", "tv", "com.br", "de", "ru"]
+PREFIXES = ["ads", "cdn", "metrics", "pixel", "stats", "track", "telemetry", "sdk"]
+
+
+def label(rng):
+    text = "".join(rng.choice(SYLLABLES) for _ in range(rng.randint(2, 5)))
+    if rng.random() < 0.3:
+        text += str(rng.randint(0, 999))
+    return text
+
+
+def domain(rng):
+    base = "%s.%s" % (label(rng), rng.choice(TLDS))
+    if rng.random() < 0.3:
+        return "%s.%s" % (rng.choice(PREFIXES), base)
+    return base
+
+
+def covered(name, names):
+    parts = name.split(".")
+    return any(".".join(parts[i:]) in names for i in range(len(parts)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--count", type=int, default=10000)
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("--negatives", required=True)
+    args = parser.parse_args()
+
+    rng = random.Random(1)
+    blocked = set()
+    parents = set()             # Sufixos dos nomes já escolhidos
+    while len(blocked) < args.count:
+        name = domain(rng)
+        if covered(name, blocked) or name in parents:
+            continue
+        blocked.add(name)
+        parts = name.split(".")
+        parents.update(".".join(parts[i:]) for i in range(1, len(parts)))
+
+    free = []
+    while len(free) < args.count:
+        name = domain(rng)
+        if not covered(name, blocked):
+            free.append(name)
+
+    with open(args.output, "w") as f:
+        f.write("\n".join(sorted(blocked)) + "\n")
+    with open(args.negatives, "w") as f:
+        f.write("\n".join(free) + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,25 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: host.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Implementação, no computador, das funções do SDK e do lwIP
+ *      declaradas em `tests/host/`.
+ */
+#include "lwip/ip_addr.h"
+#include "pico/time.h"
+#include <stdio.h>
+
+uint64_t host_time_us;
+
+const ip_addr_t ip_addr_any;
+
+char *ipaddr_ntoa(const ip_addr_t *addr) {
+    static char text[16];
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", ip4_addr1(addr), ip4_addr2(addr), ip4_addr3(addr),
+             ip4_addr4(addr));
+    return text;
+}
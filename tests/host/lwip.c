@@ -0,0 +1,466 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: lwip.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Implementação, no computador, da parte do lwIP usada pelo
+ *      servidor DNS (pbufs, UDP e TCP raw), declarada em
+ *      `tests/host/lwip/`. Não há rede: o teste entrega os pacotes
+ *      recebidos e lê os enviados pelas funções `host_*`.
+ */
+#include "lwip/dns.h"
+#include "lwip/tcp.h"
+#include "lwip/udp.h"
+#include "pico/time.h"
+#include <string.h>
+
+#define HOST_PCBS 8
+#define UDP_HLEN 8
+#define POOL_BUFSIZE_ALIGNED LWIP_MEM_ALIGN_SIZE(PBUF_POOL_BUFSIZE)
+#define STRUCT_PBUF_SIZE LWIP_MEM_ALIGN_SIZE(sizeof(struct pbuf))
+// Heap por segmento além dos dados: cabeçalho do bloco (struct mem) e pbuf com os cabeçalhos
+#define HOST_SEGMENT_HEAP (LWIP_MEM_ALIGN_SIZE(8) + STRUCT_PBUF_SIZE + LWIP_MEM_ALIGN_SIZE(PBUF_TRANSPORT))
+
+int host_pbuf_count;
+static struct stats_mem tcp_seg_stats = { .name = "TCP_SEG", .avail = MEMP_NUM_TCP_SEG };
+struct stats_ lwip_stats = {
+    .mem = { .name = "HEAP", .avail = MEM_SIZE },
+    .memp = { [MEMP_TCP_SEG] = &tcp_seg_stats },
+};
+host_udp_output_fn host_udp_output;
+ip_addr_t host_dns_server;
+
+static struct udp_pcb *udp_pcbs[HOST_PCBS];
+static struct tcp_pcb *tcp_listeners[HOST_PCBS];
+static u16_t udp_next_port = 0xc000;    // Portas efêmeras, como udp_new_port
+
+u32_t sys_now(void) {
+    return (u32_t)(host_time_us / 1000);
+}
+
+const ip_addr_t *dns_getserver(u8_t numdns) {
+    return &host_dns_server;
+}
+
+// ---------------------------------------------------------------- pbufs
+
+static struct pbuf *pbuf_new(size_t size, u16_t offset, u16_t len, pbuf_type type) {
+    struct pbuf *p = malloc(size);
+    if (!p) {
+        return NULL;
+    }
+    memset(p, 0, sizeof(*p));
+    p->payload = (u8_t *)p + STRUCT_PBUF_SIZE + LWIP_MEM_ALIGN_SIZE(offset);
+    p->len = p->tot_len = len;
+    p->type_internal = (u8_t)type;
+    p->ref = 1;
+    host_pbuf_count++;
+    return p;
+}
+
+struct pbuf *pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type) {
+    if (type == PBUF_RAM) {
+        // Tamanho exato: o AddressSanitizer acusa acessos além de `length`
+        return pbuf_new(STRUCT_PBUF_SIZE + LWIP_MEM_ALIGN_SIZE(layer) + length, layer, length, type);
+    }
+
+    // Pool: cadeia de buffers de PBUF_POOL_BUFSIZE; só o primeiro reserva `layer`
+    struct pbuf *head = NULL, *last = NULL;
+    u16_t offset = layer;
+    u16_t remaining = length;
+    do {
+        u16_t room = POOL_BUFSIZE_ALIGNED - LWIP_MEM_ALIGN_SIZE(offset);
+        u16_t len = remaining < room ? remaining : room;
+        struct pbuf *q = pbuf_new(STRUCT_PBUF_SIZE + POOL_BUFSIZE_ALIGNED, offset, len, type);
+        if (!q) {
+            pbuf_free(head);
+            return NULL;
+        }
+        q->tot_len = remaining;
+        if (last) {
+            last->next = q;
+        } else {
+            head = q;
+        }
+        last = q;
+        remaining -= len;
+        offset = 0;
+    } while (remaining > 0);
+    return head;
+}
+
+u8_t pbuf_free(struct pbuf *p) {
+    u8_t count = 0;
+    while (p && --p->ref == 0) {
+        struct pbuf *next = p->next;
+        free(p);
+        host_pbuf_count--;
+        count++;
+        p = next;
+    }
+    return count;
+}
+
+void pbuf_ref(struct pbuf *p) {
+    p->ref++;
+}
+
+void pbuf_cat(struct pbuf *head, struct pbuf *tail) {
+    struct pbuf *p = head;
+    for (; p->next; p = p->next) {
+        p->tot_len += tail->tot_len;
+    }
+    p->tot_len += tail->tot_len;
+    p->next = tail;
+}
+
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len, u16_t offset) {
+    u16_t copied = 0;
+    for (; p && copied < len; p = p->next) {
+        if (offset >= p->len) {
+            offset -= p->len;
+            continue;
+        }
+        u16_t n = p->len - offset;
+        if (n > len - copied) {
+            n = len - copied;
+        }
+        memcpy((u8_t *)dataptr + copied, (const u8_t *)p->payload + offset, n);
+        copied += n;
+        offset = 0;
+    }
+    return copied;
+}
+
+static const struct pbuf *pbuf_skip_const(const struct pbuf *p, u16_t offset, u16_t *in_offset) {
+    while (p && offset >= p->len) {
+        offset -= p->len;
+        p = p->next;
+    }
+    *in_offset = offset;
+    return p;
+}
+
+u8_t pbuf_get_at(const struct pbuf *p, u16_t offset) {
+    u16_t in;
+    const struct pbuf *q = pbuf_skip_const(p, offset, &in);
+    return q ? ((const u8_t *)q->payload)[in] : 0;
+}
+
+void pbuf_put_at(struct pbuf *p, u16_t offset, u8_t data) {
+    u16_t in;
+    struct pbuf *q = (struct pbuf *)pbuf_skip_const(p, offset, &in);
+    if (q) {
+        ((u8_t *)q->payload)[in] = data;
+    }
+}
+
+void *pbuf_get_contiguous(const struct pbuf *p, void *buffer, size_t bufsize, u16_t len, u16_t offset) {
+    u16_t in;
+    const struct pbuf *q = pbuf_skip_const(p, offset, &in);
+    if (!q || q->tot_len - in < len) {
+        return NULL;
+    }
+    if (q->len - in >= len) {
+        return (u8_t *)q->payload + in;
+    }
+    if (bufsize < len) {
+        return NULL;
+    }
+    pbuf_copy_partial(q, buffer, len, in);
+    return buffer;
+}
+
+struct pbuf *pbuf_free_header(struct pbuf *q, u16_t size) {
+    while (q && size > 0) {
+        if (size >= q->len) {
+            struct pbuf *next = q->next;
+            size -= q->len;
+            q->next = NULL;
+            pbuf_free(q);
+            q = next;
+        } else {
+            q->payload = (u8_t *)q->payload + size;
+            q->len -= size;
+            q->tot_len -= size;
+            size = 0;
+        }
+    }
+    return q;
+}
+
+struct pbuf *host_pbuf_pool(u16_t header_room, const void *data, size_t len) {
+    struct pbuf *p = pbuf_alloc((pbuf_layer)header_room, (u16_t)len, PBUF_POOL);
+    if (p) {
+        size_t copied = 0;
+        for (struct pbuf *q = p; q; q = q->next) {
+            memcpy(q->payload, (const u8_t *)data + copied, q->len);
+            copied += q->len;
+        }
+    }
+    return p;
+}
+
+// ---------------------------------------------------------------- UDP
+
+struct udp_pcb *udp_new(void) {
+    for (int i = 0; i < HOST_PCBS; i++) {
+        if (!udp_pcbs[i]) {
+            udp_pcbs[i] = calloc(1, sizeof(struct udp_pcb));
+            return udp_pcbs[i];
+        }
+    }
+    return NULL;
+}
+
+void udp_remove(struct udp_pcb *pcb) {
+    for (int i = 0; i < HOST_PCBS; i++) {
+        if (udp_pcbs[i] == pcb) {
+            udp_pcbs[i] = NULL;
+        }
+    }
+    free(pcb);
+}
+
+err_t udp_bind(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port) {
+    ip_addr_copy(pcb->local_ip, *ipaddr);
+    pcb->local_port = port ? port : udp_next_port++;
+    return ERR_OK;
+}
+
+void udp_recv(struct udp_pcb *pcb, udp_recv_fn recv, void *recv_arg) {
+    pcb->recv = recv;
+    pcb->recv_arg = recv_arg;
+}
+
+err_t udp_sendto(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *dst_ip, u16_t dst_port) {
+    return host_udp_output ? host_udp_output(pcb, p, dst_ip, dst_port) : ERR_OK;
+}
+
+bool host_udp_input(u16_t port, const void *data, size_t len, const ip_addr_t *src, u16_t src_port) {
+    for (int i = 0; i < HOST_PCBS; i++) {
+        struct udp_pcb *pcb = udp_pcbs[i];
+        if (pcb && pcb->local_port == port && pcb->recv) {
+            struct pbuf *p = host_pbuf_pool(PBUF_LINK_HLEN + PBUF_IP_HLEN + UDP_HLEN, data, len);
+            if (!p) {
+                return false;
+            }
+            pcb->recv(pcb->recv_arg, pcb, p, src, src_port);
+            return true;
+        }
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------- TCP
+
+struct tcp_pcb *tcp_new_ip_type(u8_t type) {
+    struct tcp_pcb *pcb = calloc(1, sizeof(struct tcp_pcb));
+    if (pcb) {
+        pcb->prio = TCP_PRIO_NORMAL;
+        pcb->snd_buf = TCP_SND_BUF;
+    }
+    return pcb;
+}
+
+err_t tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port) {
+    ip_addr_copy(pcb->local_ip, *ipaddr);
+    pcb->local_port = port;
+    return ERR_OK;
+}
+
+struct tcp_pcb *tcp_listen_with_backlog(struct tcp_pcb *pcb, u8_t backlog) {
+    for (int i = 0; i < HOST_PCBS; i++) {
+        if (!tcp_listeners[i]) {
+            tcp_listeners[i] = pcb;
+            pcb->listening = true;
+            return pcb;
+        }
+    }
+    return NULL;
+}
+
+void tcp_setprio(struct tcp_pcb *pcb, u8_t prio) {
+    pcb->prio = prio;
+}
+
+void tcp_arg(struct tcp_pcb *pcb, void *arg) {
+    pcb->callback_arg = arg;
+}
+
+void tcp_accept(struct tcp_pcb *pcb, tcp_accept_fn accept) {
+    pcb->accept = accept;
+}
+
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn recv) {
+    pcb->recv = recv;
+}
+
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn sent) {
+    pcb->sent = sent;
+}
+
+void tcp_poll(struct tcp_pcb *pcb, tcp_poll_fn poll, u8_t interval) {
+    pcb->poll = poll;
+    pcb->pollinterval = interval;
+}
+
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn err) {
+    pcb->errf = err;
+}
+
+/**
+ * Cada escrita ocupa ceil(len / TCP_MSS) segmentos do pool MEMP_TCP_SEG (o
+ * lwIP às vezes junta escritas pequenas num segmento; aqui, nunca) e é
+ * recusada inteira, como no lwIP, se não couber. Com cópia (forçada por
+ * LWIP_NETIF_TX_SINGLE_PBUF) cada segmento é um pbuf PBUF_RAM com os
+ * dados, alocado no heap de MEM_SIZE bytes; sem cópia, só o pbuf do
+ * cabeçalho vem do heap e os dados ficam num segundo pbuf, que aponta
+ * para o buffer de quem chamou.
+ */
+err_t tcp_write(struct tcp_pcb *pcb, const void *dataptr, u16_t len, u8_t apiflags) {
+#if LWIP_NETIF_TX_SINGLE_PBUF
+    apiflags |= TCP_WRITE_FLAG_COPY;
+#endif
+    bool copy = apiflags & TCP_WRITE_FLAG_COPY;
+    u16_t segments = len ? (len + TCP_MSS - 1) / TCP_MSS : 1;
+    u16_t pbufs = copy ? segments : 2 * segments;
+    size_t heap = segments * HOST_SEGMENT_HEAP + (copy ? len + segments * (MEM_ALIGNMENT - 1) : 0);
+    if (pcb->listening || pcb->closed || pcb->aborted) {
+        return ERR_CONN;
+    }
+    if (len > pcb->snd_buf || pcb->snd_queuelen + pbufs > TCP_SND_QUEUELEN ||
+        lwip_stats.mem.used + heap > lwip_stats.mem.avail ||
+        tcp_seg_stats.used + segments > tcp_seg_stats.avail) {
+        return ERR_MEM;
+    }
+    u8_t *out = realloc(pcb->host_out, pcb->host_out_len + len + 1);
+    if (!out) {
+        return ERR_MEM;
+    }
+    memcpy(out + pcb->host_out_len, dataptr, len);
+    pcb->host_out = out;
+    pcb->host_out_len += len;
+    pcb->snd_buf -= len;
+    pcb->snd_queuelen += pbufs;
+    pcb->host_heap += heap;
+    pcb->host_segs += segments;
+    lwip_stats.mem.used += heap;
+    tcp_seg_stats.used += segments;
+    return ERR_OK;
+}
+
+err_t tcp_output(struct tcp_pcb *pcb) {
+    return ERR_OK;
+}
+
+void tcp_recved(struct tcp_pcb *pcb, u16_t len) {
+    pcb->host_recved += len;
+}
+
+err_t tcp_shutdown(struct tcp_pcb *pcb, int shut_rx, int shut_tx) {
+    if (pcb->listening || pcb->closed || pcb->aborted) {
+        return ERR_CONN;
+    }
+    pcb->host_shut_tx = pcb->host_shut_tx || shut_tx;
+    return ERR_OK;
+}
+
+err_t tcp_close(struct tcp_pcb *pcb) {
+    if (pcb->listening) {
+        for (int i = 0; i < HOST_PCBS; i++) {
+            if (tcp_listeners[i] == pcb) {
+                tcp_listeners[i] = NULL;
+            }
+        }
+        free(pcb);
+        return ERR_OK;
+    }
+    pcb->closed = true;
+    return ERR_OK;
+}
+
+// Como no lwIP, o callback de erro recebe ERR_ABRT
+void tcp_abort(struct tcp_pcb *pcb) {
+    pcb->aborted = true;
+    if (pcb->errf) {
+        pcb->errf(pcb->callback_arg, ERR_ABRT);
+    }
+}
+
+struct tcp_pcb *host_tcp_connect(u16_t port, const ip_addr_t *remote, u16_t remote_port) {
+    for (int i = 0; i < HOST_PCBS; i++) {
+        struct tcp_pcb *listener = tcp_listeners[i];
+        if (!listener || listener->local_port != port || !listener->accept) {
+            continue;
+        }
+        struct tcp_pcb *pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+        if (!pcb) {
+            return NULL;
+        }
+        ip_addr_copy(pcb->local_ip, listener->local_ip);
+        ip_addr_copy(pcb->remote_ip, *remote);
+        pcb->local_port = port;
+        pcb->remote_port = remote_port;
+        pcb->prio = listener->prio;
+        pcb->callback_arg = listener->callback_arg;
+        listener->accept(listener->callback_arg, pcb, ERR_OK);
+        return pcb;
+    }
+    return NULL;
+}
+
+err_t host_tcp_input(struct tcp_pcb *pcb, const void *data, size_t len) {
+    if (pcb->closed || pcb->aborted || !pcb->recv) {
+        return ERR_CLSD;
+    }
+    struct pbuf *p = NULL;
+    if (data) {
+        p = host_pbuf_pool(PBUF_TRANSPORT, data, len);
+        if (!p) {
+            return ERR_MEM;
+        }
+    }
+    err_t err = pcb->recv(pcb->callback_arg, pcb, p, ERR_OK);
+    if (err != ERR_OK && err != ERR_ABRT && p) {
+        pbuf_free(p);       // Recusado: o lwIP guardaria para entregar de novo
+    }
+    return err;
+}
+
+// Devolve ao heap e ao pool os segmentos sem ACK do PCB
+static void release_segments(struct tcp_pcb *pcb) {
+    lwip_stats.mem.used -= pcb->host_heap;
+    tcp_seg_stats.used -= pcb->host_segs;
+    pcb->host_heap = 0;
+    pcb->host_segs = 0;
+}
+
+err_t host_tcp_ack(struct tcp_pcb *pcb) {
+    // Também confirma o que o teste marcou como ocupado em snd_buf/snd_queuelen
+    bool outstanding = pcb->snd_buf < TCP_SND_BUF || pcb->snd_queuelen > 0;
+    u16_t len = TCP_SND_BUF - pcb->snd_buf;
+    pcb->snd_buf = TCP_SND_BUF;
+    pcb->snd_queuelen = 0;
+    release_segments(pcb);
+    if (!outstanding || !pcb->sent || pcb->closed || pcb->aborted) {
+        return ERR_OK;
+    }
+    return pcb->sent(pcb->callback_arg, pcb, len);
+}
+
+err_t host_tcp_poll(struct tcp_pcb *pcb) {
+    if (!pcb->poll || pcb->closed || pcb->aborted) {
+        return ERR_OK;
+    }
+    return pcb->poll(pcb->callback_arg, pcb);
+}
+
+void host_tcp_free(struct tcp_pcb *pcb) {
+    release_segments(pcb);
+    free(pcb->host_out);
+    free(pcb);
+}
@@ -0,0 +1,21 @@
+#ifndef HOST_LWIP_DEF_H
+#define HOST_LWIP_DEF_H
+
+// Substituto do lwIP para os testes no computador: tipos e macros básicos
+
+#include <stddef.h>
+#include <stdint.h>
+#include "lwip/opt.h"
+
+typedef uint8_t u8_t;
+typedef int8_t s8_t;
+typedef uint16_t u16_t;
+typedef int16_t s16_t;
+typedef uint32_t u32_t;
+typedef int32_t s32_t;
+
+#define LWIP_MIN(x, y)              ((x) < (y) ? (x) : (y))
+#define LWIP_MAX(x, y)              ((x) > (y) ? (x) : (y))
+#define LWIP_MEM_ALIGN_SIZE(size)   (((size) + MEM_ALIGNMENT - 1U) & ~(MEM_ALIGNMENT - 1U))
+
+#endif // HOST_LWIP_DEF_H
@@ -0,0 +1,12 @@
+#ifndef HOST_LWIP_DNS_H
+#define HOST_LWIP_DNS_H
+
+#include "lwip/ip_addr.h"
+#include "lwip/def.h"
+
+// Servidor DNS da rede (o que o DHCP da estação informaria)
+extern ip_addr_t host_dns_server;
+
+const ip_addr_t *dns_getserver(u8_t numdns);
+
+#endif // HOST_LWIP_DNS_H
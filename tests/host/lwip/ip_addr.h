@@ -0,0 +1,52 @@
+#ifndef HOST_LWIP_IP_ADDR_H
+#define HOST_LWIP_IP_ADDR_H
+
+// Substituto do lwIP para os testes no computador: só IPv4, como no
+// firmware (LWIP_IPV6 desligado). O endereço fica em ordem de rede.
+
+#include <stdint.h>
+
+typedef struct ip4_addr {
+    uint32_t addr;
+} ip4_addr_t;
+
+typedef ip4_addr_t ip_addr_t;
+
+#define IPADDR_TYPE_V4          0U
+#define IPADDR_TYPE_ANY         46U
+
+extern const ip_addr_t ip_addr_any;
+#define IP_ADDR_ANY             (&ip_addr_any)
+#define IP_ANY_TYPE             IP_ADDR_ANY
+
+#define IP_IS_V4(a)             1
+#define ip_2_ip4(a)             (a)
+#define ip4_addr_get_u32(a)     ((a)->addr)
+#define ip4_addr_set_u32(a, v)  ((a)->addr = (v))
+#define ip4_addr_copy(a, b)     ((a).addr = (b).addr)
+#define ip_addr_copy(a, b)      ((a) = (b))
+#define ip_addr_cmp(a, b)       ((a)->addr == (b)->addr)
+#define ip_addr_isany(a)        ((a) == NULL || (a)->addr == 0)
+#define ip_addr_set_zero(a)     ((a)->addr = 0)
+#define ip4_addr_netcmp(a, b, m) (((a)->addr & (m)->addr) == ((b)->addr & (m)->addr))
+
+#define ip4_addr1(a)            ((uint8_t)((const uint8_t *)&(a)->addr)[0])
+#define ip4_addr2(a)            ((uint8_t)((const uint8_t *)&(a)->addr)[1])
+#define ip4_addr3(a)            ((uint8_t)((const uint8_t *)&(a)->addr)[2])
+#define ip4_addr4(a)            ((uint8_t)((const uint8_t *)&(a)->addr)[3])
+
+#define IP4_ADDR(a, b, c, d, e) ((a)->addr = host_ip4(b, c, d, e))
+
+static inline uint32_t host_ip4(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+    uint32_t addr;
+    uint8_t *p = (uint8_t *)&addr;
+    p[0] = a;
+    p[1] = b;
+    p[2] = c;
+    p[3] = d;
+    return addr;
+}
+
+char *ipaddr_ntoa(const ip_addr_t *addr);
+
+#endif // HOST_LWIP_IP_ADDR_H
@@ -0,0 +1,6 @@
+#ifndef HOST_LWIP_MEM_H
+#define HOST_LWIP_MEM_H
+
+#include "lwip/def.h"
+
+#endif // HOST_LWIP_MEM_H
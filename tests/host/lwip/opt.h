@@ -0,0 +1,20 @@
+#ifndef HOST_LWIP_OPT_H
+#define HOST_LWIP_OPT_H
+
+// Opções do firmware (lib/lwipopts.h) e os padrões do lwIP que dependem delas
+
+#include <stdlib.h>
+#include "lwipopts.h"
+
+#define PBUF_LINK_HLEN              14
+#define PBUF_LINK_ENCAPSULATION_HLEN 0
+#define PBUF_IP_HLEN                20
+#define PBUF_TRANSPORT_HLEN         20
+
+#ifndef PBUF_POOL_BUFSIZE
+#define PBUF_POOL_BUFSIZE           LWIP_MEM_ALIGN_SIZE(TCP_MSS + 40 + PBUF_LINK_ENCAPSULATION_HLEN + PBUF_LINK_HLEN)
+#endif
+
+#define LWIP_RAND()                 ((u32_t)rand())
+
+#endif // HOST_LWIP_OPT_H
@@ -0,0 +1,64 @@
+#ifndef HOST_LWIP_PBUF_H
+#define HOST_LWIP_PBUF_H
+
+// Substituto dos pbufs do lwIP: mesma estrutura e mesmos tipos de alocação.
+// Um pbuf da pool ocupa LWIP_MEM_ALIGN_SIZE(sizeof(struct pbuf)) +
+// PBUF_POOL_BUFSIZE, como no firmware, para o AddressSanitizer acusar
+// qualquer escrita além do buffer.
+
+#include <stdbool.h>
+#include "lwip/def.h"
+#include "lwip/err.h"
+
+typedef enum {
+    PBUF_TRANSPORT = PBUF_LINK_ENCAPSULATION_HLEN + PBUF_LINK_HLEN + PBUF_IP_HLEN + PBUF_TRANSPORT_HLEN,
+    PBUF_IP = PBUF_LINK_ENCAPSULATION_HLEN + PBUF_LINK_HLEN + PBUF_IP_HLEN,
+    PBUF_LINK = PBUF_LINK_ENCAPSULATION_HLEN + PBUF_LINK_HLEN,
+    PBUF_RAW_TX = PBUF_LINK_ENCAPSULATION_HLEN,
+    PBUF_RAW = 0
+} pbuf_layer;
+
+#define PBUF_TYPE_FLAG_STRUCT_DATA_CONTIGUOUS       0x80
+#define PBUF_ALLOC_FLAG_DATA_CONTIGUOUS             0x0200
+#define PBUF_TYPE_ALLOC_SRC_MASK                    0x0F
+#define PBUF_TYPE_ALLOC_SRC_MASK_STD_HEAP           0x00
+#define PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL 0x02
+
+// Só PBUF_RAM e PBUF_POOL são usados pelo firmware
+typedef enum {
+    PBUF_RAM = PBUF_ALLOC_FLAG_DATA_CONTIGUOUS | PBUF_TYPE_FLAG_STRUCT_DATA_CONTIGUOUS |
+               PBUF_TYPE_ALLOC_SRC_MASK_STD_HEAP,
+    PBUF_POOL = PBUF_TYPE_FLAG_STRUCT_DATA_CONTIGUOUS | PBUF_TYPE_ALLOC_SRC_MASK_STD_MEMP_PBUF_POOL
+} pbuf_type;
+
+struct pbuf {
+    struct pbuf *next;
+    void *payload;
+    u16_t tot_len;
+    u16_t len;
+    u8_t type_internal;
+    u8_t flags;
+    u8_t ref;
+    u8_t if_idx;
+};
+
+#define pbuf_get_allocsrc(p)    ((p)->type_internal & PBUF_TYPE_ALLOC_SRC_MASK)
+
+struct pbuf *pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type);
+u8_t pbuf_free(struct pbuf *p);
+void pbuf_ref(struct pbuf *p);
+void pbuf_cat(struct pbuf *head, struct pbuf *tail);
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len, u16_t offset);
+u8_t pbuf_get_at(const struct pbuf *p, u16_t offset);
+void pbuf_put_at(struct pbuf *p, u16_t offset, u8_t data);
+void *pbuf_get_contiguous(const struct pbuf *p, void *buffer, size_t bufsize, u16_t len, u16_t offset);
+struct pbuf *pbuf_free_header(struct pbuf *q, u16_t size);
+
+// Só no computador: pbufs alocados e ainda não liberados
+extern int host_pbuf_count;
+
+// Só no computador: cópia de `data` em pbufs da pool, como a recepção entrega
+// (payload depois dos `header_room` bytes dos cabeçalhos já removidos)
+struct pbuf *host_pbuf_pool(u16_t header_room, const void *data, size_t len);
+
+#endif // HOST_LWIP_PBUF_H
@@ -0,0 +1,32 @@
+#ifndef HOST_LWIP_STATS_H
+#define HOST_LWIP_STATS_H
+
+// Substituto das estatísticas do lwIP (MEM_STATS e MEMP_STATS): só o heap
+// e o pool de segmentos TCP, mantidos pelo `tcp_write` de `tests/host/`
+
+#include "lwip/def.h"
+
+typedef size_t mem_size_t;
+
+struct stats_mem {
+    const char *name;
+    u16_t err;
+    mem_size_t avail;
+    mem_size_t used;
+    mem_size_t max;
+    u16_t illegal;
+};
+
+typedef enum {
+    MEMP_TCP_SEG,
+    MEMP_MAX
+} memp_t;
+
+struct stats_ {
+    struct stats_mem mem;
+    struct stats_mem *memp[MEMP_MAX];
+};
+
+extern struct stats_ lwip_stats;
+
+#endif // HOST_LWIP_STATS_H
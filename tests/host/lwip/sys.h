@@ -0,0 +1,9 @@
+#ifndef HOST_LWIP_SYS_H
+#define HOST_LWIP_SYS_H
+
+#include "lwip/def.h"
+
+// Milissegundos de `host_time_us` (pico/time.h)
+u32_t sys_now(void);
+
+#endif // HOST_LWIP_SYS_H
@@ -0,0 +1,91 @@
+#ifndef HOST_LWIP_TCP_H
+#define HOST_LWIP_TCP_H
+
+// Substituto da API raw de TCP do lwIP. `tcp_write` segue os limites do
+// firmware: recusa com ERR_MEM acima de `snd_buf`, quando os pbufs novos
+// passariam de TCP_SND_QUEUELEN ou quando não cabem no heap de MEM_SIZE
+// bytes ou nos MEMP_NUM_TCP_SEG segmentos (`lwip_stats`), sem enfileirar
+// nada. Os bytes aceitos ficam em `host_out` até o teste confirmá-los
+// (`host_tcp_ack`).
+
+#include <stdbool.h>
+#include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
+#include "lwip/stats.h"
+#include "lwip/sys.h"
+
+struct tcp_pcb;
+
+typedef err_t (*tcp_accept_fn)(void *arg, struct tcp_pcb *newpcb, err_t err);
+typedef err_t (*tcp_recv_fn)(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err);
+typedef err_t (*tcp_sent_fn)(void *arg, struct tcp_pcb *tpcb, u16_t len);
+typedef err_t (*tcp_poll_fn)(void *arg, struct tcp_pcb *tpcb);
+typedef void (*tcp_err_fn)(void *arg, err_t err);
+
+#define TCP_WRITE_FLAG_COPY 0x01
+#define TCP_WRITE_FLAG_MORE 0x02
+
+#define TCP_PRIO_MIN        1
+#define TCP_PRIO_NORMAL     64
+#define TCP_PRIO_MAX        127
+
+struct tcp_pcb {
+    ip_addr_t local_ip;
+    ip_addr_t remote_ip;
+    u16_t local_port;
+    u16_t remote_port;
+    u8_t prio;
+    u16_t snd_buf;
+    u16_t snd_queuelen;
+    void *callback_arg;
+    tcp_accept_fn accept;
+    tcp_recv_fn recv;
+    tcp_sent_fn sent;
+    tcp_poll_fn poll;
+    tcp_err_fn errf;
+    u8_t pollinterval;
+    // Só no computador
+    bool listening;
+    bool closed;                        // tcp_close chamado
+    bool aborted;                       // tcp_abort chamado (RST)
+    u8_t *host_out;                     // Bytes enfileirados por tcp_write
+    size_t host_out_len;
+    u32_t host_recved;                  // Soma de tcp_recved
+    size_t host_heap;                   // Heap ocupado pelos segmentos sem ACK
+    u16_t host_segs;                    // Segmentos sem ACK (MEMP_TCP_SEG)
+    bool host_shut_tx;                  // tcp_shutdown do envio (FIN)
+};
+
+#define tcp_sndbuf(pcb)         ((pcb)->snd_buf)
+#define tcp_sndqueuelen(pcb)    ((pcb)->snd_queuelen)
+
+struct tcp_pcb *tcp_new_ip_type(u8_t type);
+err_t tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port);
+struct tcp_pcb *tcp_listen_with_backlog(struct tcp_pcb *pcb, u8_t backlog);
+void tcp_setprio(struct tcp_pcb *pcb, u8_t prio);
+void tcp_arg(struct tcp_pcb *pcb, void *arg);
+void tcp_accept(struct tcp_pcb *pcb, tcp_accept_fn accept);
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn recv);
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn sent);
+void tcp_poll(struct tcp_pcb *pcb, tcp_poll_fn poll, u8_t interval);
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn err);
+err_t tcp_write(struct tcp_pcb *pcb, const void *dataptr, u16_t len, u8_t apiflags);
+err_t tcp_output(struct tcp_pcb *pcb);
+void tcp_recved(struct tcp_pcb *pcb, u16_t len);
+err_t tcp_shutdown(struct tcp_pcb *pcb, int shut_rx, int shut_tx);
+err_t tcp_close(struct tcp_pcb *pcb);
+void tcp_abort(struct tcp_pcb *pcb);
+
+// Só no computador: bytes do heap do lwIP (MEM_SIZE) ocupados pelos segmentos
+// Só no computador: abre uma conexão na pcb que escuta `port`
+struct tcp_pcb *host_tcp_connect(u16_t port, const ip_addr_t *remote, u16_t remote_port);
+// Entrega bytes recebidos (NULL = FIN); retorna o err_t do callback
+err_t host_tcp_input(struct tcp_pcb *pcb, const void *data, size_t len);
+// Confirma a fila de envio inteira (inclusive o que o teste ocupou em
+// snd_buf/snd_queuelen) e chama o callback `sent`
+err_t host_tcp_ack(struct tcp_pcb *pcb);
+err_t host_tcp_poll(struct tcp_pcb *pcb);
+// Libera a pcb depois de fechada ou abortada
+void host_tcp_free(struct tcp_pcb *pcb);
+
+#endif // HOST_LWIP_TCP_H
@@ -0,0 +1,37 @@
+#ifndef HOST_LWIP_UDP_H
+#define HOST_LWIP_UDP_H
+
+// Substituto da API raw de UDP do lwIP. O envio é entregue ao teste por
+// `host_udp_output`; a recepção é simulada por `host_udp_input`.
+
+#include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
+#include "lwip/sys.h"
+
+struct udp_pcb;
+
+typedef void (*udp_recv_fn)(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port);
+
+struct udp_pcb {
+    ip_addr_t local_ip;
+    u16_t local_port;
+    udp_recv_fn recv;
+    void *recv_arg;
+};
+
+struct udp_pcb *udp_new(void);
+void udp_remove(struct udp_pcb *pcb);
+err_t udp_bind(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port);
+void udp_recv(struct udp_pcb *pcb, udp_recv_fn recv, void *recv_arg);
+err_t udp_sendto(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *dst_ip, u16_t dst_port);
+
+// Só no computador: recebe cada datagrama enviado (sem tomar posse do pbuf);
+// NULL descarta
+typedef err_t (*host_udp_output_fn)(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *dst, u16_t port);
+extern host_udp_output_fn host_udp_output;
+
+// Só no computador: entrega um datagrama à pcb ligada a `port` num pbuf da
+// pool (payload depois dos cabeçalhos Ethernet, IP e UDP); false se não houver
+bool host_udp_input(u16_t port, const void *data, size_t len, const ip_addr_t *src, u16_t src_port);
+
+#endif // HOST_LWIP_UDP_H
@@ -0,0 +1,9 @@
+#ifndef HOST_PICO_CYW43_ARCH_H
+#define HOST_PICO_CYW43_ARCH_H
+
+// Substituto do pico/cyw43_arch.h para os testes no computador: o
+// servidor HTTP só o inclui; não há rádio nem travas do lwIP
+
+#include "lwip/tcp.h"
+
+#endif // HOST_PICO_CYW43_ARCH_H
@@ -0,0 +1,42 @@
+#ifndef HOST_PICO_TIME_H
+#define HOST_PICO_TIME_H
+
+// Substituto do pico/time.h para os testes no computador: o relógio é a
+// variável `host_time_us`, avançada pelo próprio teste
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef uint64_t absolute_time_t;
+
+extern uint64_t host_time_us;
+
+static inline absolute_time_t get_absolute_time(void) {
+    return host_time_us;
+}
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000);
+}
+
+static inline uint32_t time_us_32(void) {
+    return (uint32_t)host_time_us;
+}
+
+static inline uint64_t time_us_64(void) {
+    return host_time_us;
+}
+
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) {
+    return host_time_us + (uint64_t)ms * 1000;
+}
+
+static inline bool time_reached(absolute_time_t t) {
+    return host_time_us >= t;
+}
+
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+    return (int64_t)(to - from);
+}
+
+#endif // HOST_PICO_TIME_H
@@ -0,0 +1,40 @@
+#ifndef TEST_H
+#define TEST_H
+
+// Apoio comum aos testes e benchmarks que rodam no computador (ver tests/CMakeLists.txt)
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Encerra o teste com a linha e a condição que falharam
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: falhou: %s\n", __FILE__, __LINE__, #cond); \
+        exit(1); \
+    } \
+} while (0)
+
+// Gerador xorshift: sequências reprodutíveis entre execuções e plataformas
+static inline uint32_t test_rand(void) {
+    static uint64_t s = 88172645463325252ull;
+    s ^= s << 13;
+    s ^= s >> 7;
+    s ^= s << 17;
+    return (uint32_t)s;
+}
+
+// Relógio monotônico em segundos, para os benchmarks
+static inline double test_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Iterações de um benchmark: argv[1], ou o padrão (o ctest passa poucas)
+static inline long test_iterations(int argc, char **argv, long fallback) {
+    return argc > 1 ? atol(argv[1]) : fallback;
+}
+
+#endif // TEST_H
@@ -0,0 +1,76 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: test_client_limit.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Testa o índice de cliente de client_limit.c: só um IP da sub-rede
+ *      do DHCP, dentro do bloco de concessões, ocupa a entrada da
+ *      concessão; os demais se espalham pelas entradas por hash, sem
+ *      gastar as fichas de um cliente do AP.
+ */
+#include "client_limit.h"
+#include "test.h"
+
+static ip_addr_t addr(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+    ip_addr_t ip;
+    IP4_ADDR(&ip, a, b, c, d);
+    return ip;
+}
+
+static void test_index(void) {
+    ip_addr_t leased = addr(192, 168, 4, DHCPS_BASE_IP);
+    ip_addr_t last = addr(192, 168, 4, DHCPS_BASE_IP + DHCPS_MAX_IP - 1);
+    ip_addr_t outside_block = addr(192, 168, 4, DHCPS_BASE_IP + DHCPS_MAX_IP);
+    ip_addr_t other_subnet = addr(192, 168, 7, DHCPS_BASE_IP);
+
+    // Sem servidor DHCP definido, nenhum IP é de concessão
+    CHECK(client_limit_index(&leased) >= DHCPS_MAX_IP);
+
+    static dhcp_server_t dhcp;
+    dhcp.ip = addr(192, 168, 4, 1);
+    dhcp.nm = addr(255, 255, 255, 0);
+    client_limit_set_dhcp(&dhcp);
+    CHECK(client_limit_index(&leased) == 0);
+    CHECK(client_limit_index(&last) == DHCPS_MAX_IP - 1);
+    CHECK(client_limit_index(&outside_block) >= DHCPS_MAX_IP);
+    CHECK(client_limit_index(&other_subnet) >= DHCPS_MAX_IP);
+    CHECK(client_limit_index(NULL) >= DHCPS_MAX_IP);
+
+    // Fora da sub-rede: mais de uma entrada, todas dentro da tabela
+    bool used[CLIENT_LIMIT_ENTRIES] = { false };
+    unsigned distinct = 0;
+    for (int i = 1; i <= 64; i++) {
+        ip_addr_t ip = addr(10, 0, i / 8, i);
+        unsigned index = client_limit_index(&ip);
+        CHECK(index >= DHCPS_MAX_IP && index < CLIENT_LIMIT_ENTRIES);
+        distinct += !used[index];
+        used[index] = true;
+    }
+    CHECK(distinct > 1);
+}
+
+// Um IP de outra sub-rede com o mesmo último octeto não gasta as fichas da concessão
+static void test_buckets(void) {
+    ip_addr_t leased = addr(192, 168, 4, DHCPS_BASE_IP);
+    ip_addr_t other_subnet = addr(192, 168, 7, DHCPS_BASE_IP);
+    const client_rate_t rate = { .per_s = 1, .burst = 3 };
+    for (int i = 0; i < rate.burst; i++) {
+        CHECK(client_limit_take(&other_subnet, CLIENT_CLASS_CONNECT, &rate, 1000, NULL));
+    }
+    CHECK(!client_limit_take(&other_subnet, CLIENT_CLASS_CONNECT, &rate, 1000, NULL));
+    CHECK(client_limit_take(&leased, CLIENT_CLASS_CONNECT, &rate, 1000, NULL));
+
+    client_limit_open(client_limit_index(&other_subnet));
+    CHECK(client_limit_connections(client_limit_index(&leased)) == 0);
+    client_limit_close(client_limit_index(&other_subnet));
+}
+
+int main(void) {
+    test_index();
+    test_buckets();
+    printf("client_limit: ok\n");
+    return 0;
+}
@@ -0,0 +1,282 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: test_dns_forward.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Testes do repasse ao upstream do servidor DNS, sobre o lwIP de
+ *      `tests/host/`. O upstream é um resolvedor local de verdade: um
+ *      socket UDP em 127.0.0.1 que lê a consulta repassada e responde.
+ *      Os datagramas do socket do upstream do servidor saem por outro
+ *      socket local, e as respostas voltam por `host_udp_input` como se
+ *      viessem do upstream configurado, porta 53.
+ *
+ *      Confere a troca do ID, o cache (TTL descontado, caixa das letras
+ *      do cliente, validade), o timeout com SERVFAIL, a tabela de
+ *      pendentes cheia e o descarte de respostas forjadas.
+ */
+#include "dnsserver.h"
+#include "lwip/dns.h"
+#include "lwip/udp.h"
+#include "pico/time.h"
+#include "test.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define FLAGS_RESPONSE  0x8180  // QR, RD, RA, NOERROR
+#define RCODE_SERVFAIL  2
+#define TTL             100
+
+static dns_server_t d;
+static ip_addr_t client, upstream;
+
+static int resolver_fd;                 // Resolvedor local (o "upstream")
+static int wire_fd;                     // Saída do socket do upstream do servidor
+static struct sockaddr_in resolver_addr;
+static int forwarded;                   // Datagramas enviados ao upstream
+
+// Última resposta enviada ao cliente
+static uint8_t reply[DNS_UDP_MSG_MAX];
+static size_t reply_len;
+static int replies;
+
+static uint16_t get16(const uint8_t *p) {
+    return p[0] << 8 | p[1];
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return (uint32_t)get16(p) << 16 | get16(p + 2);
+}
+
+static int open_socket(struct sockaddr_in *addr) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    CHECK(fd >= 0);
+    struct sockaddr_in local = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    CHECK(bind(fd, (struct sockaddr *)&local, sizeof(local)) == 0);
+    struct timeval timeout = { .tv_sec = 1 };
+    CHECK(setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0);
+    if (addr) {
+        socklen_t len = sizeof(*addr);
+        CHECK(getsockname(fd, (struct sockaddr *)addr, &len) == 0);
+    }
+    return fd;
+}
+
+static err_t output(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *dst, u16_t port) {
+    uint8_t buf[DNS_EDNS_PAYLOAD_MAX];
+    CHECK(p->tot_len <= sizeof(buf));
+    u16_t len = pbuf_copy_partial(p, buf, p->tot_len, 0);
+
+    if (pcb == d.upstream_udp) {
+        CHECK(ip_addr_cmp(dst, &upstream) && port == 53);
+        CHECK(sendto(wire_fd, buf, len, 0, (struct sockaddr *)&resolver_addr, sizeof(resolver_addr)) == len);
+        forwarded++;
+    } else {
+        CHECK(pcb == d.udp && ip_addr_cmp(dst, &client) && port == 5353);
+        memcpy(reply, buf, len);
+        reply_len = len;
+        replies++;
+    }
+    return ERR_OK;
+}
+
+static size_t build_query(uint8_t *msg, uint16_t id, const char *name, uint16_t qtype) {
+    static const uint8_t header[] = { 0x01, 0x00, 0x00, 0x01, 0, 0, 0, 0, 0, 0 };
+    msg[0] = id >> 8;
+    msg[1] = id & 0xff;
+    memcpy(msg + 2, header, sizeof(header));
+    size_t len = 12;
+    while (*name) {
+        const char *dot = strchr(name, '.');
+        size_t label = dot ? (size_t)(dot - name) : strlen(name);
+        msg[len++] = (uint8_t)label;
+        memcpy(msg + len, name, label);
+        len += label;
+        name += label + (dot ? 1 : 0);
+    }
+    msg[len++] = 0;
+    msg[len++] = qtype >> 8;
+    msg[len++] = qtype & 0xff;
+    msg[len++] = 0;
+    msg[len++] = 1;
+    return len;
+}
+
+// Envia a consulta à porta 53; retorna quantas respostas o cliente recebeu
+static int query(uint16_t id, const char *name) {
+    uint8_t msg[256];
+    size_t len = build_query(msg, id, name, 1);
+    int before = replies;
+    host_time_us += 1000;
+    CHECK(host_udp_input(53, msg, len, &client, 5353));
+    return replies - before;
+}
+
+// O resolvedor lê a próxima consulta; retorna o tamanho (0 se não houver)
+static size_t resolver_read(uint8_t *msg, size_t cap, struct sockaddr_in *from) {
+    socklen_t from_len = sizeof(*from);
+    ssize_t n = recvfrom(resolver_fd, msg, cap, MSG_DONTWAIT, (struct sockaddr *)from, &from_len);
+    if (n < 0) {
+        CHECK(errno == EAGAIN || errno == EWOULDBLOCK);
+        return 0;
+    }
+    return (size_t)n;
+}
+
+// Resposta A com um registro (ponteiro para a pergunta)
+static size_t resolver_answer(uint8_t *msg, size_t len, uint32_t ttl) {
+    static const uint8_t address[] = { 93, 184, 216, 34 };
+    msg[2] = FLAGS_RESPONSE >> 8;
+    msg[3] = FLAGS_RESPONSE & 0xff;
+    msg[7] = 1;
+    uint8_t rr[] = { 0xc0, 12, 0, 1, 0, 1, ttl >> 24, ttl >> 16, ttl >> 8, ttl, 0, 4 };
+    memcpy(msg + len, rr, sizeof(rr));
+    memcpy(msg + len + sizeof(rr), address, sizeof(address));
+    return len + sizeof(rr) + sizeof(address);
+}
+
+// Entrega ao servidor o que chegou ao socket do upstream, vindo de `src`
+static void deliver(const ip_addr_t *src, u16_t src_port) {
+    uint8_t msg[DNS_UDP_MSG_MAX];
+    ssize_t n = recv(wire_fd, msg, sizeof(msg), 0);
+    CHECK(n > 0);
+    CHECK(host_udp_input(d.upstream_udp->local_port, msg, (size_t)n, src, src_port));
+}
+
+// Confere a resposta A repassada ao cliente
+static void check_answer(uint16_t id, const char *qname_wire, uint32_t ttl) {
+    CHECK(reply_len >= 12 + strlen(qname_wire) + 1 + 4 + 16);
+    CHECK(get16(reply) == id && get16(reply + 2) == FLAGS_RESPONSE);
+    CHECK(get16(reply + 4) == 1 && get16(reply + 6) == 1);
+    CHECK(memcmp(reply + 12, qname_wire, strlen(qname_wire) + 1) == 0);
+    const uint8_t *rr = reply + reply_len - 16;
+    CHECK(get16(rr + 2) == 1 && get32(rr + 6) == ttl && rr[12] == 93 && rr[15] == 34);
+}
+
+static void test_without_upstream(void) {
+    // Sem upstream, os nomes de repasse recebem o endereço do servidor
+    CHECK(query(0x1111, "www.gov.br") == 1);
+    CHECK(forwarded == 0 && get16(reply) == 0x1111 && get16(reply + 6) == 1);
+    CHECK(memcmp(reply + reply_len - 4, &d.ip.addr, 4) == 0);
+}
+
+static void test_forward_and_cache(void) {
+    uint8_t msg[DNS_UDP_MSG_MAX];
+    struct sockaddr_in from;
+    replies = 0;
+
+    // O upstream recebe a consulta com outro ID; a resposta volta com o do cliente
+    CHECK(query(0x2222, "www.gov.br") == 0 && forwarded == 1);
+    size_t len = resolver_read(msg, sizeof(msg), &from);
+    CHECK(len > 12 && get16(msg) != 0x2222);
+    uint8_t forged[DNS_UDP_MSG_MAX];
+    size_t forged_len = resolver_answer(msg, len, TTL);
+    memcpy(forged, msg, forged_len);
+    CHECK(sendto(resolver_fd, msg, forged_len, 0, (struct sockaddr *)&from, sizeof(from)) == (ssize_t)forged_len);
+    deliver(&upstream, 53);
+    CHECK(replies == 1);
+    check_answer(0x2222, "\3www\3gov\2br", TTL);
+
+    // A mesma resposta, já atendida, ou de outro endereço ou porta: descartada
+    ip_addr_t other;
+    IP4_ADDR(&other, 10, 0, 0, 66);
+    CHECK(host_udp_input(d.upstream_udp->local_port, forged, forged_len, &upstream, 53));
+    CHECK(host_udp_input(d.upstream_udp->local_port, forged, forged_len, &other, 53));
+    CHECK(host_udp_input(d.upstream_udp->local_port, forged, forged_len, &upstream, 5353));
+    CHECK(replies == 1);
+
+    // 5 s depois: do cache, com o TTL descontado e a caixa do cliente
+    host_time_us += 5000000;
+    CHECK(query(0x3333, "WwW.gOv.BR") == 1 && forwarded == 1);
+    check_answer(0x3333, "\3WwW\3gOv\2BR", TTL - 5);
+    CHECK(resolver_read(msg, sizeof(msg), &from) == 0);
+
+    // Vencido o TTL, volta ao upstream
+    host_time_us += (TTL - 5) * 1000000ull;
+    CHECK(query(0x4444, "www.gov.br") == 0 && forwarded == 2);
+    len = resolver_read(msg, sizeof(msg), &from);
+    CHECK(len > 12);
+
+    // Resposta com o ID certo e outra pergunta: descartada; o cliente recebe SERVFAIL no timeout
+    len = resolver_answer(msg, len, TTL);
+    msg[13] = 'x';
+    CHECK(sendto(resolver_fd, msg, len, 0, (struct sockaddr *)&from, sizeof(from)) == (ssize_t)len);
+    deliver(&upstream, 53);
+    CHECK(replies == 2);
+    host_time_us += (DNS_FORWARD_TIMEOUT_MS - 1) * 1000ull;
+    dns_server_poll(&d, sys_now());
+    CHECK(replies == 2);
+    host_time_us += 1000;
+    dns_server_poll(&d, sys_now());
+    CHECK(replies == 3 && reply_len == 12 && get16(reply) == 0x4444 && (reply[3] & 0x0f) == RCODE_SERVFAIL);
+}
+
+static void test_pending_full(void) {
+    uint8_t msg[DNS_UDP_MSG_MAX];
+    struct sockaddr_in from;
+    char name[32];
+
+    // Sem resposta do upstream, a tabela de pendentes enche e a próxima recebe SERVFAIL na hora
+    for (int i = 0; i < DNS_PENDING_MAX; i++) {
+        snprintf(name, sizeof(name), "n%d.gov.br", i);
+        CHECK(query(0x5000 + i, name) == 0);
+    }
+    CHECK(query(0x5fff, "cheia.gov.br") == 1);
+    CHECK(get16(reply) == 0x5fff && (reply[3] & 0x0f) == RCODE_SERVFAIL);
+
+    // IDs do upstream distintos entre as pendentes
+    uint16_t ids[DNS_PENDING_MAX];
+    for (int i = 0; i < DNS_PENDING_MAX; i++) {
+        CHECK(resolver_read(msg, sizeof(msg), &from) > 12);
+        ids[i] = get16(msg);
+        for (int j = 0; j < i; j++) {
+            CHECK(ids[j] != ids[i]);
+        }
+    }
+    CHECK(resolver_read(msg, sizeof(msg), &from) == 0);
+
+    int before = replies;
+    host_time_us += DNS_FORWARD_TIMEOUT_MS * 1000ull;
+    dns_server_poll(&d, sys_now());
+    CHECK(replies == before + DNS_PENDING_MAX);
+}
+
+int main(void) {
+    resolver_fd = open_socket(&resolver_addr);
+    wire_fd = open_socket(NULL);
+    host_udp_output = output;
+    host_time_us = 1000000;
+
+    ip_addr_t ip;
+    IP4_ADDR(&ip, 192, 168, 4, 1);
+    IP4_ADDR(&client, 192, 168, 4, 16);
+    IP4_ADDR(&upstream, 10, 0, 0, 53);
+    dns_server_init(&d, &ip);
+    CHECK(d.udp != NULL && d.upstream_udp != NULL);
+    CHECK(dns_server_set_host(&d, "*.gov.br", DNS_ACTION_FORWARD, NULL) == 0);
+
+    test_without_upstream();
+
+    // O upstream vem do servidor DNS que a estação recebeu por DHCP
+    host_dns_server = upstream;
+    dns_server_poll(&d, sys_now());
+    CHECK(ip_addr_cmp(&d.upstream, &upstream));
+
+    test_forward_and_cache();
+    test_pending_full();
+
+    // Nomes fora da tabela não passam pelo upstream
+    CHECK(query(0x6666, "exemplo.com") == 1 && get16(reply + 6) == 1);
+
+    dns_server_deinit(&d);
+    CHECK(host_pbuf_count == 0);
+    close(resolver_fd);
+    close(wire_fd);
+    puts("test_dns_forward: ok");
+    return 0;
+}
@@ -0,0 +1,352 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: test_dns_tcp.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Testes do DNS over TCP do servidor DNS, sobre o lwIP de
+ *      `tests/host/`. Tudo o que o servidor enfileira com tcp_write é
+ *      lido de volta como uma sequência de mensagens com o prefixo de 2
+ *      bytes: um prefixo sem a mensagem inteira falha o teste.
+ *
+ *      A fila de envio é limitada por bytes e por segmentos
+ *      (TCP_SND_QUEUELEN), como no firmware: sem espaço, o servidor
+ *      espera o `sent` ou, para uma resposta que não pode esperar (do
+ *      upstream ou SERVFAIL), aborta a conexão em vez de truncá-la.
+ *
+ *      Consultas repassadas ao upstream (via UDP) levam um OPT com
+ *      DNS_TCP_MSG_MAX; uma resposta truncada mesmo assim vira SERVFAIL.
+ */
+#include "dnsserver.h"
+#include "lwip/dns.h"
+#include "lwip/tcp.h"
+#include "lwip/udp.h"
+#include "pico/time.h"
+#include "test.h"
+#include <string.h>
+
+static dns_server_t d;
+static ip_addr_t client, upstream;
+
+// Última consulta repassada ao upstream
+static uint8_t forwarded[DNS_UDP_MSG_MAX];
+static size_t forwarded_len;
+
+static uint16_t get16(const uint8_t *p) {
+    return p[0] << 8 | p[1];
+}
+
+static err_t output(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *dst, u16_t port) {
+    CHECK(pcb == d.upstream_udp && ip_addr_cmp(dst, &upstream) && port == 53);
+    forwarded_len = pbuf_copy_partial(p, forwarded, sizeof(forwarded), 0);
+    return ERR_OK;
+}
+
+// Consulta A com o prefixo de tamanho; retorna o tamanho total
+static size_t build_frame(uint8_t *frame, uint16_t id, const char *name) {
+    static const uint8_t header[] = { 0x01, 0x00, 0x00, 0x01, 0, 0, 0, 0, 0, 0 };
+    uint8_t *msg = frame + 2;
+    msg[0] = id >> 8;
+    msg[1] = id & 0xff;
+    memcpy(msg + 2, header, sizeof(header));
+    size_t len = 12;
+    while (*name) {
+        const char *dot = strchr(name, '.');
+        size_t label = dot ? (size_t)(dot - name) : strlen(name);
+        msg[len++] = (uint8_t)label;
+        memcpy(msg + len, name, label);
+        len += label;
+        name += label + (dot ? 1 : 0);
+    }
+    static const uint8_t tail[] = { 0, 0, 1, 0, 1 };
+    memcpy(msg + len, tail, sizeof(tail));
+    len += sizeof(tail);
+    frame[0] = len >> 8;
+    frame[1] = len & 0xff;
+    return len + 2;
+}
+
+static struct tcp_pcb *connect(void) {
+    struct tcp_pcb *pcb = host_tcp_connect(53, &client, 40000);
+    CHECK(pcb != NULL && !pcb->aborted);
+    return pcb;
+}
+
+static void send_query(struct tcp_pcb *pcb, uint16_t id, const char *name) {
+    uint8_t frame[256];
+    CHECK(host_tcp_input(pcb, frame, build_frame(frame, id, name)) == ERR_OK);
+}
+
+// Consulta com OPT (EDNS(0)) anunciando `payload`
+static void send_query_edns(struct tcp_pcb *pcb, uint16_t id, const char *name, uint16_t payload) {
+    uint8_t frame[256];
+    size_t len = build_frame(frame, id, name);
+    const uint8_t opt[] = { 0, 0, 41, payload >> 8, payload & 0xff, 0, 0, 0, 0, 0, 0 };
+    memcpy(frame + len, opt, sizeof(opt));
+    len += sizeof(opt);
+    frame[2 + 11] = 1;
+    frame[0] = (len - 2) >> 8;
+    frame[1] = (len - 2) & 0xff;
+    CHECK(host_tcp_input(pcb, frame, len) == ERR_OK);
+}
+
+// Fim da pergunta (única) de uma mensagem
+static size_t question_end(const uint8_t *msg) {
+    size_t off = 12;
+    while (msg[off]) {
+        off += msg[off] + 1;
+    }
+    return off + 5;
+}
+
+// OPT no fim da consulta repassada: retorna o payload anunciado (0 = sem OPT)
+static uint16_t forwarded_payload(void) {
+    const uint8_t *opt = forwarded + forwarded_len - 11;
+    if (get16(forwarded + 10) == 0 || opt[0] != 0 || get16(opt + 1) != 41) {
+        return 0;
+    }
+    return get16(opt + 3);
+}
+
+// Última mensagem enfileirada na conexão
+static const uint8_t *last_reply(const struct tcp_pcb *pcb) {
+    size_t off = 0;
+    const uint8_t *msg = NULL;
+    while (off + 2 <= pcb->host_out_len) {
+        msg = pcb->host_out + off + 2;
+        off += 2 + get16(pcb->host_out + off);
+    }
+    return msg;
+}
+
+/**
+ * Lê as mensagens enfileiradas na conexão, conferindo o enquadramento:
+ * cada prefixo é seguido da mensagem inteira. Guarda os IDs e os RCODEs
+ * e retorna quantas mensagens havia.
+ */
+static int read_replies(const struct tcp_pcb *pcb, uint16_t *ids, uint8_t *rcodes, int max) {
+    int count = 0;
+    size_t off = 0;
+    while (off < pcb->host_out_len) {
+        CHECK(off + 2 <= pcb->host_out_len);
+        size_t len = get16(pcb->host_out + off);
+        CHECK(len >= 12 && off + 2 + len <= pcb->host_out_len);
+        const uint8_t *msg = pcb->host_out + off + 2;
+        CHECK(msg[2] & 0x80);
+        CHECK(count < max);
+        ids[count] = get16(msg);
+        rcodes[count] = msg[3] & 0x0f;
+        count++;
+        off += 2 + len;
+    }
+    return count;
+}
+
+static void test_pipelined(void) {
+    struct tcp_pcb *pcb = connect();
+    uint8_t stream[512];
+    size_t len = build_frame(stream, 0x0101, "a.lan");
+    len += build_frame(stream + len, 0x0102, "b.lan");
+    size_t third = build_frame(stream + len, 0x0103, "c.lan");
+
+    // Duas consultas num segmento, e a terceira em pedaços (o prefixo partido ao meio)
+    CHECK(host_tcp_input(pcb, stream, len + 1) == ERR_OK);
+    CHECK(host_tcp_input(pcb, stream + len + 1, 5) == ERR_OK);
+    CHECK(host_tcp_input(pcb, stream + len + 6, third - 6) == ERR_OK);
+
+    uint16_t ids[4];
+    uint8_t rcodes[4];
+    CHECK(read_replies(pcb, ids, rcodes, 4) == 3);
+    CHECK(ids[0] == 0x0101 && ids[1] == 0x0102 && ids[2] == 0x0103 && rcodes[2] == 0);
+    CHECK(pcb->host_recved == len + third);
+
+    // FIN do cliente: o servidor fecha e libera a vaga
+    CHECK(host_tcp_input(pcb, NULL, 0) == ERR_OK);
+    CHECK(pcb->closed && d.tcp[0].pcb == NULL);
+    host_tcp_free(pcb);
+}
+
+static void test_queue_full_waits(void) {
+    struct tcp_pcb *pcb = connect();
+
+    // Segmentos não confirmados ocupam a fila: a consulta espera o `sent`
+    pcb->snd_queuelen = TCP_SND_QUEUELEN;
+    send_query(pcb, 0x0201, "a.lan");
+    CHECK(pcb->host_out_len == 0 && !pcb->aborted);
+    CHECK(host_tcp_ack(pcb) == ERR_OK);
+
+    uint16_t ids[2];
+    uint8_t rcodes[2];
+    CHECK(read_replies(pcb, ids, rcodes, 2) == 1 && ids[0] == 0x0201);
+
+    // O mesmo com pouco espaço em bytes
+    pcb->snd_buf = DNS_TCP_MSG_MAX;
+    send_query(pcb, 0x0202, "b.lan");
+    CHECK(read_replies(pcb, ids, rcodes, 2) == 1);
+    pcb->snd_buf = TCP_SND_BUF;
+    CHECK(host_tcp_ack(pcb) == ERR_OK);
+    CHECK(read_replies(pcb, ids, rcodes, 2) == 2 && ids[1] == 0x0202);
+
+    CHECK(host_tcp_input(pcb, NULL, 0) == ERR_OK);
+    host_tcp_free(pcb);
+}
+
+// Resposta do upstream à última consulta repassada, com `extra` bytes de
+// registros TXT, ou só a pergunta com TC; o OPT, se a consulta tinha, vai por último
+static void upstream_reply(size_t extra, bool truncated) {
+    uint8_t msg[2048];
+    size_t len = question_end(forwarded);
+    memcpy(msg, forwarded, len);
+    msg[2] = truncated ? 0x83 : 0x81;
+    msg[3] = 0x80;
+    memset(msg + 6, 0, 6);
+    if (!truncated) {
+        static const uint8_t rr[] = { 0xc0, 12, 0, 1, 0, 1, 0, 0, 0, 60, 0, 4, 93, 184, 216, 34 };
+        msg[7] = 1;
+        memcpy(msg + len, rr, sizeof(rr));
+        len += sizeof(rr);
+    }
+    if (extra > 0) {
+        // Um TXT grande na seção adicional
+        uint8_t txt[] = { 0xc0, 12, 0, 16, 0, 1, 0, 0, 0, 60, extra >> 8, extra & 0xff };
+        msg[11]++;
+        memcpy(msg + len, txt, sizeof(txt));
+        len += sizeof(txt);
+        memset(msg + len, 'x', extra);
+        len += extra;
+    }
+    if (forwarded_payload() != 0) {
+        static const uint8_t opt[] = { 0, 0, 41, 0x04, 0xd0, 0, 0, 0, 0, 0, 0 };
+        msg[11]++;
+        memcpy(msg + len, opt, sizeof(opt));
+        len += sizeof(opt);
+    }
+    CHECK(len <= sizeof(msg));
+    CHECK(host_udp_input(d.upstream_udp->local_port, msg, len, &upstream, 53));
+}
+
+static void test_forwarded(void) {
+    uint16_t ids[2];
+    uint8_t rcodes[2];
+
+    // Resposta do upstream com espaço na fila: enquadrada, com o ID do cliente
+    // e sem o OPT que o repasse acrescentou
+    struct tcp_pcb *pcb = connect();
+    send_query(pcb, 0x0301, "www.gov.br");
+    CHECK(forwarded_len > 0 && get16(forwarded) != 0x0301);
+    CHECK(forwarded_payload() == DNS_TCP_MSG_MAX);
+    upstream_reply(0, false);
+    CHECK(read_replies(pcb, ids, rcodes, 2) == 1 && ids[0] == 0x0301 && rcodes[0] == 0);
+    CHECK(get16(last_reply(pcb) + 10) == 0 && get16(pcb->host_out) == question_end(forwarded) + 16);
+
+    // Maior que DNS_TCP_MSG_MAX: SERVFAIL no lugar
+    send_query(pcb, 0x0302, "big.gov.br");
+    upstream_reply(DNS_TCP_MSG_MAX, false);
+    CHECK(read_replies(pcb, ids, rcodes, 2) == 2 && ids[1] == 0x0302 && rcodes[1] == 2);
+    CHECK(host_tcp_input(pcb, NULL, 0) == ERR_OK);
+    host_tcp_free(pcb);
+
+    // Truncada pelo upstream mesmo com o OPT: SERVFAIL, não um TC para quem já está no TCP
+    uint16_t more_ids[4];
+    uint8_t more_rcodes[4];
+    pcb = connect();
+    send_query(pcb, 0x0306, "tc.gov.br");
+    upstream_reply(0, true);
+    CHECK(read_replies(pcb, more_ids, more_rcodes, 4) == 1 && more_ids[0] == 0x0306 && more_rcodes[0] == 2);
+    CHECK(!(last_reply(pcb)[2] & 0x02));
+
+    // OPT do cliente: o tamanho anunciado ao upstream é o do TCP, e a resposta mantém o OPT
+    send_query_edns(pcb, 0x0307, "edns.gov.br", 512);
+    CHECK(forwarded_payload() == DNS_TCP_MSG_MAX);
+    upstream_reply(600, false);
+    CHECK(read_replies(pcb, more_ids, more_rcodes, 4) == 2 && more_ids[1] == 0x0307 && more_rcodes[1] == 0);
+    CHECK(get16(last_reply(pcb) + 10) == 2);
+    CHECK(host_tcp_input(pcb, NULL, 0) == ERR_OK);
+    host_tcp_free(pcb);
+
+    // Fila cheia quando a resposta chega: conexão abortada, sem prefixo solto
+    pcb = connect();
+    send_query(pcb, 0x0303, "www2.gov.br");
+    pcb->snd_queuelen = TCP_SND_QUEUELEN;
+    upstream_reply(0, false);
+    CHECK(pcb->aborted && pcb->host_out_len == 0 && d.tcp[0].pcb == NULL);
+    for (int i = 0; i < DNS_PENDING_MAX; i++) {
+        CHECK(!d.pending[i].used);
+    }
+    host_tcp_free(pcb);
+
+    // Timeout do upstream com a fila cheia: também abortada
+    pcb = connect();
+    send_query(pcb, 0x0304, "www3.gov.br");
+    pcb->snd_queuelen = TCP_SND_QUEUELEN;
+    host_time_us += DNS_FORWARD_TIMEOUT_MS * 1000ull;
+    dns_server_poll(&d, sys_now());
+    CHECK(pcb->aborted && pcb->host_out_len == 0);
+    host_tcp_free(pcb);
+
+    // Timeout com espaço: SERVFAIL enquadrado
+    pcb = connect();
+    send_query(pcb, 0x0305, "www4.gov.br");
+    host_time_us += DNS_FORWARD_TIMEOUT_MS * 1000ull;
+    dns_server_poll(&d, sys_now());
+    CHECK(read_replies(pcb, ids, rcodes, 2) == 1 && ids[0] == 0x0305 && rcodes[0] == 2);
+    CHECK(host_tcp_input(pcb, NULL, 0) == ERR_OK);
+    host_tcp_free(pcb);
+}
+
+static void test_limits(void) {
+    // Prefixo maior que DNS_TCP_MSG_MAX: conexão abortada
+    struct tcp_pcb *pcb = connect();
+    uint8_t huge[2] = { (DNS_TCP_MSG_MAX + 1) >> 8, (DNS_TCP_MSG_MAX + 1) & 0xff };
+    CHECK(host_tcp_input(pcb, huge, sizeof(huge)) == ERR_ABRT);
+    CHECK(pcb->aborted && d.tcp[0].pcb == NULL);
+    host_tcp_free(pcb);
+
+    // Acima de DNS_TCP_MAX conexões, a nova é recusada
+    struct tcp_pcb *open[DNS_TCP_MAX];
+    for (int i = 0; i < DNS_TCP_MAX; i++) {
+        open[i] = connect();
+    }
+    struct tcp_pcb *extra = host_tcp_connect(53, &client, 40001);
+    CHECK(extra != NULL && extra->aborted);
+    host_tcp_free(extra);
+
+    // Ociosas por DNS_TCP_IDLE_POLLS ciclos: fechadas
+    for (int poll = 0; poll < DNS_TCP_IDLE_POLLS; poll++) {
+        for (int i = 0; i < DNS_TCP_MAX; i++) {
+            CHECK(!open[i]->closed);
+            host_tcp_poll(open[i]);
+        }
+    }
+    for (int i = 0; i < DNS_TCP_MAX; i++) {
+        CHECK(open[i]->closed && d.tcp[i].pcb == NULL);
+        host_tcp_free(open[i]);
+    }
+}
+
+int main(void) {
+    host_udp_output = output;
+    host_time_us = 1000000;
+
+    ip_addr_t ip;
+    IP4_ADDR(&ip, 192, 168, 4, 1);
+    IP4_ADDR(&client, 192, 168, 4, 16);
+    IP4_ADDR(&upstream, 10, 0, 0, 53);
+    dns_server_init(&d, &ip);
+    CHECK(d.tcp_listen != NULL);
+    CHECK(dns_server_set_host(&d, "*.gov.br", DNS_ACTION_FORWARD, NULL) == 0);
+    host_dns_server = upstream;
+    dns_server_poll(&d, sys_now());
+
+    test_pipelined();
+    test_queue_full_waits();
+    test_forwarded();
+    test_limits();
+
+    dns_server_deinit(&d);
+    CHECK(host_pbuf_count == 0);
+    puts("test_dns_tcp: ok");
+    return 0;
+}
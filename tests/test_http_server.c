@@ -0,0 +1,194 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: test_http_server.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Testes do envio do servidor HTTP (http_server.c) sobre o lwIP de
+ *      `tests/host/`, que recusa com ERR_MEM o `tcp_write` que não cabe
+ *      no heap do lwIP (MEM_SIZE), como no firmware.
+ *
+ *      As rotas são do próprio teste: um corpo emprestado maior que o
+ *      heap inteiro precisa chegar completo, segmento a segmento, sem a
+ *      conexão parar esperando uma memória que nunca sobra, e espera
+ *      (adiado) enquanto o heap está sem folga, sem que os polls dessa
+ *      espera contem como ociosidade do cliente.
+ */
+#include "http_server.h"
+#include "routes.h"
+#include "lwip/tcp.h"
+#include "pico/time.h"
+#include "test.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Maior que o heap do lwIP e que o buffer de envio
+#define BIG_SIZE (5 * MEM_SIZE + 123)
+
+static char big[BIG_SIZE];
+
+route_id_t route_match(const char *request) {
+    return strncmp(request, "GET /grande.js ", 15) == 0 ? ROUTE_STATIC : ROUTE_NOT_FOUND;
+}
+
+route_id_t route_match_control(const char *request) {
+    return ROUTE_NOT_FOUND;
+}
+
+void handle_route(route_id_t route, const char *request, http_response_t *response) {
+    if (route != ROUTE_STATIC) {
+        set_response_status(response, 404, "Not Found");
+        set_response_body(response, "nada");
+        return;
+    }
+    set_response_status(response, 200, "OK");
+    add_response_header(response, "Content-Type", "application/javascript");
+    set_response_borrowed_body(response, big, sizeof(big), NULL, NULL);
+}
+
+body_route_result_t handle_body_route(route_id_t route, const char *request, http_body_handler_t *handler,
+                                      http_response_t *response) {
+    return BODY_ROUTE_NONE;
+}
+
+static const char request[] = "GET /grande.js HTTP/1.1\r\nHost: 192.168.4.1\r\n\r\n";
+
+static struct tcp_pcb *connect(uint8_t last_octet, u16_t port) {
+    ip_addr_t client;
+    IP4_ADDR(&client, 192, 168, 4, last_octet);
+    struct tcp_pcb *pcb = host_tcp_connect(80, &client, port);
+    CHECK(pcb != NULL);
+    CHECK(host_tcp_input(pcb, request, sizeof(request) - 1) == ERR_OK);
+    return pcb;
+}
+
+// Confirma o que foi enviado; sem nada pendente, o poll do lwIP tenta de novo
+static void step(struct tcp_pcb *pcb) {
+    if (pcb->closed || pcb->aborted) {
+        return;
+    }
+    if (pcb->snd_buf < TCP_SND_BUF) {
+        host_tcp_ack(pcb);
+    } else {
+        host_tcp_poll(pcb);
+    }
+}
+
+static const char *find(const char *haystack, size_t len, const char *needle) {
+    size_t n = strlen(needle);
+    for (size_t i = 0; i + n <= len; i++) {
+        if (memcmp(haystack + i, needle, n) == 0) {
+            return haystack + i;
+        }
+    }
+    return NULL;
+}
+
+// Cabeçalhos com Content-Length e o corpo inteiro, sem nada além
+static void check_response(const struct tcp_pcb *pcb) {
+    CHECK(pcb->closed && !pcb->aborted);
+    const char *out = (const char *)pcb->host_out;
+    size_t len = pcb->host_out_len;
+    CHECK(len > 12 && memcmp(out, "HTTP/1.1 200", 12) == 0);
+
+    const char *end = find(out, len, "\r\n\r\n");
+    CHECK(end != NULL);
+    size_t header_len = end + 4 - out;
+    const char *cl = find(out, header_len, "Content-Length: ");
+    CHECK(cl != NULL && strtoul(cl + 16, NULL, 10) == BIG_SIZE);
+    CHECK(len - header_len == BIG_SIZE);
+    CHECK(memcmp(out + header_len, big, BIG_SIZE) == 0);
+}
+
+// Sozinha: o corpo atravessa o heap várias vezes, conforme os ACKs
+static void test_borrowed_larger_than_heap(void) {
+    struct tcp_pcb *pcb = connect(10, 40000);
+    int rounds = 0;
+    while (!pcb->closed && !pcb->aborted && rounds++ < 1000) {
+        step(pcb);
+    }
+    check_response(pcb);
+    // Sem poll: cada ACK já libera memória para o trecho seguinte
+    CHECK(rounds < 2 * BIG_SIZE / TCP_MSS);
+    host_tcp_free(pcb);
+    CHECK(lwip_stats.mem.used == 0 && lwip_stats.memp[MEMP_TCP_SEG]->used == 0);
+}
+
+// Duas conexões disputando o mesmo heap: ambas terminam
+static void test_two_downloads(void) {
+    struct tcp_pcb *a = connect(11, 40001);
+    struct tcp_pcb *b = connect(12, 40002);
+    int rounds = 0;
+    while ((!a->closed || !b->closed) && !a->aborted && !b->aborted && rounds++ < 1000) {
+        step(a);
+        step(b);
+    }
+    check_response(a);
+    check_response(b);
+    host_tcp_free(a);
+    host_tcp_free(b);
+    CHECK(lwip_stats.mem.used == 0 && lwip_stats.memp[MEMP_TCP_SEG]->used == 0);
+}
+
+// Heap do lwIP quase todo ocupado por outro (ex: DNS over TCP): os
+// cabeçalhos saem, o corpo espera folga e segue quando ela volta
+static void test_deferred_without_heap(void) {
+    const http_send_stats_t *stats = http_server_send_stats();
+    uint32_t deferrals = stats->deferrals;
+    uint32_t resumes = stats->resumes;
+    mem_size_t taken = lwip_stats.mem.avail - 600;
+    lwip_stats.mem.used += taken;
+
+    struct tcp_pcb *pcb = connect(13, 40003);
+    size_t headers = pcb->host_out_len;
+    CHECK(headers > 0 && stats->deferrals == deferrals + 1);
+    // Mais polls que HTTP_IDLE_POLLS: a espera é do servidor, não do cliente
+    for (int i = 0; i < 30; i++) {
+        step(pcb);
+    }
+    CHECK(pcb->host_out_len == headers && !pcb->closed && !pcb->aborted);
+    CHECK(stats->deferrals == deferrals + 1 && stats->resumes == resumes);
+    CHECK(stats->min_heap_headroom < 600);
+
+    lwip_stats.mem.used -= taken;
+    int rounds = 0;
+    while (!pcb->closed && !pcb->aborted && rounds++ < 1000) {
+        step(pcb);
+    }
+    check_response(pcb);
+    CHECK(stats->resumes == resumes + 1);
+    host_tcp_free(pcb);
+}
+
+// Cliente mudo ou que não confirma nada: abortado pelos polls
+static void test_idle_client(void) {
+    ip_addr_t client;
+    IP4_ADDR(&client, 192, 168, 4, 14);
+    struct tcp_pcb *mute = host_tcp_connect(80, &client, 40004);
+    CHECK(mute != NULL);
+    struct tcp_pcb *stalled = connect(15, 40005);
+    CHECK(stalled->host_out_len > 0);
+    for (int i = 0; i < 30; i++) {
+        host_tcp_poll(mute);
+        host_tcp_poll(stalled);
+    }
+    CHECK(mute->aborted && stalled->aborted);
+    host_tcp_free(mute);
+    host_tcp_free(stalled);
+    CHECK(lwip_stats.mem.used == 0 && lwip_stats.memp[MEMP_TCP_SEG]->used == 0);
+}
+
+int main(void) {
+    for (size_t i = 0; i < sizeof(big); i++) {
+        big[i] = (char)('a' + i % 26);
+    }
+    http_server_start();
+    test_borrowed_larger_than_heap();
+    test_two_downloads();
+    test_deferred_without_heap();
+    test_idle_client();
+    printf("http_server: ok\n");
+    return 0;
+}
@@ -0,0 +1,200 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: test_multipart.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Testes do parser `multipart/form-data`. Cada corpo é entregue
+ *      em pedaços de tamanho aleatório (de 1 byte até mais que o
+ *      corpo), como chegariam os pbufs, e o resultado deve ser o mesmo
+ *      de uma entrega única. Os dados das partes misturam bytes do
+ *      delimitador para exercitar casamentos parciais entre pedaços.
+ */
+#include "multipart.h"
+#include "test.h"
+#include <string.h>
+#include <strings.h>
+
+#define BOUNDARY    "----WebKitFormBoundaryABC"
+#define PART_MAX    100000
+#define PARTS       2
+
+typedef struct {
+    uint8_t data[PARTS][PART_MAX];
+    size_t len[PARTS];
+    char filename[PARTS][32];
+    int begins;
+    int ends;
+    int abort_at;           // Aborta no n-ésimo bloco de dados (0: nunca)
+    int data_calls;
+} capture_t;
+
+static int on_header(void *ctx, const char *name, const char *value) {
+    capture_t *c = ctx;
+    if (strcasecmp(name, "Content-Disposition") == 0 && c->begins < PARTS) {
+        multipart_header_param(value, "filename", c->filename[c->begins], sizeof(c->filename[0]));
+    }
+    return 0;
+}
+
+static int on_part_begin(void *ctx) {
+    capture_t *c = ctx;
+    c->begins++;
+    return 0;
+}
+
+static int on_part_data(void *ctx, const uint8_t *data, size_t len) {
+    capture_t *c = ctx;
+    int part = c->begins - 1;
+    CHECK(part >= 0 && part < PARTS && c->len[part] + len <= PART_MAX);
+    memcpy(c->data[part] + c->len[part], data, len);
+    c->len[part] += len;
+    return c->abort_at && ++c->data_calls == c->abort_at;
+}
+
+static int on_part_end(void *ctx) {
+    capture_t *c = ctx;
+    c->ends++;
+    return 0;
+}
+
+static const multipart_callbacks_t callbacks = { on_header, on_part_begin, on_part_data, on_part_end };
+
+// Conteúdo de parte com muitos '\r', '\n', '-' e trechos do boundary
+static void random_payload(uint8_t *out, size_t len) {
+    static const char boundary[] = BOUNDARY;
+    for (size_t i = 0; i < len; i++) {
+        uint32_t r = test_rand() % 10;
+        if (r < 3) {
+            out[i] = "\r\n--"[test_rand() % 4];
+        } else if (r < 5) {
+            out[i] = boundary[test_rand() % (sizeof(boundary) - 1)];
+        } else {
+            out[i] = (uint8_t)test_rand();
+        }
+    }
+}
+
+// Entrega `body` em pedaços de 1 a `max_chunk` bytes; retorna o último código
+static int feed_split(multipart_parser_t *mp, const uint8_t *body, size_t len, size_t max_chunk) {
+    int rc = MULTIPART_OK;
+    for (size_t i = 0; i < len && rc == MULTIPART_OK;) {
+        size_t n = 1 + test_rand() % max_chunk;
+        if (n > len - i) {
+            n = len - i;
+        }
+        rc = multipart_feed(mp, body + i, n);
+        i += n;
+    }
+    return rc;
+}
+
+static size_t build_body(uint8_t *body, uint8_t payload[PARTS][PART_MAX], const size_t *len) {
+    size_t off = (size_t)sprintf((char *)body, "preambulo\r\n");
+    for (int p = 0; p < PARTS; p++) {
+        off += sprintf((char *)body + off,
+                       "--" BOUNDARY "\r\nContent-Disposition: form-data; name=\"f%d\"; filename=\"p%d.bin\"\r\n"
+                       "Content-Type: application/octet-stream\r\n\r\n", p, p);
+        memcpy(body + off, payload[p], len[p]);
+        off += len[p];
+        off += sprintf((char *)body + off, "\r\n");
+    }
+    off += sprintf((char *)body + off, "--" BOUNDARY "--\r\nepilogo");
+    return off;
+}
+
+static void test_random_splits(void) {
+    static uint8_t payload[PARTS][PART_MAX];
+    static uint8_t body[PARTS * PART_MAX + 1024];
+    static capture_t c;
+    static const size_t max_chunks[] = { 1, 3, 64, 1460, 1 << 20 };
+
+    for (int iter = 0; iter < 200; iter++) {
+        size_t len[PARTS];
+        for (int p = 0; p < PARTS; p++) {
+            len[p] = iter % 7 == 0 ? 0 : test_rand() % (PART_MAX - 1000);
+            random_payload(payload[p], len[p]);
+        }
+        size_t body_len = build_body(body, payload, len);
+        size_t max_chunk = max_chunks[iter % (sizeof(max_chunks) / sizeof(max_chunks[0]))];
+
+        multipart_parser_t mp;
+        memset(&c, 0, sizeof(c));
+        CHECK(multipart_init(&mp, BOUNDARY, strlen(BOUNDARY), &callbacks, &c) == MULTIPART_OK);
+        CHECK(feed_split(&mp, body, body_len, max_chunk) == MULTIPART_OK);
+        CHECK(multipart_is_done(&mp));
+        CHECK(c.begins == PARTS && c.ends == PARTS);
+        for (int p = 0; p < PARTS; p++) {
+            char expected[32];
+            sprintf(expected, "p%d.bin", p);
+            CHECK(strcmp(c.filename[p], expected) == 0);
+            CHECK(c.len[p] == len[p] && memcmp(c.data[p], payload[p], len[p]) == 0);
+        }
+    }
+}
+
+static void test_errors(void) {
+    static capture_t c;
+    multipart_parser_t mp;
+    char body[1024];
+
+    // Boundary vazio ou maior que o limite da RFC
+    CHECK(multipart_init(&mp, "", 0, &callbacks, &c) == MULTIPART_ERR_BOUNDARY);
+    memset(body, 'b', MULTIPART_MAX_BOUNDARY + 1);
+    CHECK(multipart_init(&mp, body, MULTIPART_MAX_BOUNDARY + 1, &callbacks, &c) == MULTIPART_ERR_BOUNDARY);
+
+    // Lixo depois do boundary
+    memset(&c, 0, sizeof(c));
+    multipart_init(&mp, BOUNDARY, strlen(BOUNDARY), &callbacks, &c);
+    strcpy(body, "--" BOUNDARY "xx\r\n");
+    CHECK(feed_split(&mp, (uint8_t *)body, strlen(body), 2) == MULTIPART_ERR_SYNTAX);
+    CHECK(multipart_feed(&mp, (const uint8_t *)"\r\n", 2) == MULTIPART_ERR_SYNTAX);
+
+    // Linha de cabeçalho maior que MULTIPART_MAX_HEADER_LINE
+    memset(&c, 0, sizeof(c));
+    multipart_init(&mp, BOUNDARY, strlen(BOUNDARY), &callbacks, &c);
+    size_t n = (size_t)sprintf(body, "--" BOUNDARY "\r\nX: ");
+    memset(body + n, 'a', MULTIPART_MAX_HEADER_LINE);
+    CHECK(feed_split(&mp, (uint8_t *)body, n + MULTIPART_MAX_HEADER_LINE, 7) == MULTIPART_ERR_HEADER);
+
+    // Corpo sem o delimitador final: sem erro, mas incompleto
+    memset(&c, 0, sizeof(c));
+    multipart_init(&mp, BOUNDARY, strlen(BOUNDARY), &callbacks, &c);
+    strcpy(body, "--" BOUNDARY "\r\n\r\ndados\r\n--" BOUNDARY "-");
+    CHECK(feed_split(&mp, (uint8_t *)body, strlen(body), 5) == MULTIPART_OK);
+    CHECK(!multipart_is_done(&mp) && c.ends == 1 && c.len[0] == 5);
+
+    // Callback de dados pede o cancelamento
+    memset(&c, 0, sizeof(c));
+    c.abort_at = 1;
+    multipart_init(&mp, BOUNDARY, strlen(BOUNDARY), &callbacks, &c);
+    strcpy(body, "--" BOUNDARY "\r\n\r\ndados\r\n--" BOUNDARY "--");
+    CHECK(multipart_feed(&mp, (uint8_t *)body, strlen(body)) == MULTIPART_ERR_ABORTED);
+    CHECK(multipart_feed(&mp, (uint8_t *)body, 1) == MULTIPART_ERR_SYNTAX);
+}
+
+static void test_find_boundary(void) {
+    size_t len = 0;
+    const char *ct = "multipart/form-data; boundary=abc123";
+    const char *b = multipart_find_boundary(ct, strlen(ct), &len);
+    CHECK(b && len == 6 && memcmp(b, "abc123", 6) == 0);
+
+    ct = "Multipart/Form-Data; charset=utf-8; boundary=\"a b;c\"";
+    b = multipart_find_boundary(ct, strlen(ct), &len);
+    CHECK(b && len == 5 && memcmp(b, "a b;c", 5) == 0);
+
+    ct = "application/json; boundary=abc";
+    CHECK(multipart_find_boundary(ct, strlen(ct), &len) == NULL);
+    ct = "multipart/form-data; boundary=\"abc";
+    CHECK(multipart_find_boundary(ct, strlen(ct), &len) == NULL);
+}
+
+int main(void) {
+    test_random_splits();
+    test_errors();
+    test_find_boundary();
+    puts("test_multipart: ok");
+    return 0;
+}
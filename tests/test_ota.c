@@ -0,0 +1,321 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: test_ota.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Teste de carga da OTA sobre um `flash_backend_t` em arquivo, do
+ *      tamanho da área de staging. O arquivo se comporta como flash NOR:
+ *      apagar deixa 0xFF e gravar só limpa bits; gravar sobre bytes não
+ *      apagados falha o teste.
+ *
+ *      As imagens têm boot2 com CRC e tabela de vetores válidos e são
+ *      enviadas em pedaços de tamanho aleatório, como os segmentos TCP,
+ *      com `ota_poll` chamado entre eles como o laço principal faz.
+ */
+#include "ota.h"
+#include "checksum.h"
+#include "flash_layout.h"
+#include "test.h"
+#include <string.h>
+#include <unistd.h>
+
+typedef struct {
+    FILE *file;
+    bool receiving;             // Dentro de on_data/on_end (apagar aqui trava a recepção)
+    bool fail_erase;
+    int erases;
+    int stalls;
+    uint32_t installed;
+} file_flash_t;
+
+static file_flash_t flash;
+
+static void file_read(uint32_t offset, uint8_t *data, uint32_t len) {
+    CHECK(pread(fileno(flash.file), data, len, offset) == (ssize_t)len);
+}
+
+static void file_write(uint32_t offset, const uint8_t *data, uint32_t len) {
+    CHECK(pwrite(fileno(flash.file), data, len, offset) == (ssize_t)len);
+}
+
+static int flash_erase(void *ctx, uint32_t offset, uint32_t len) {
+    CHECK(offset % FLASH_BACKEND_SECTOR == 0 && len % FLASH_BACKEND_SECTOR == 0);
+    CHECK(offset + len <= FLASH_OTA_SIZE);
+    if (flash.fail_erase) {
+        return -1;
+    }
+    uint8_t erased[FLASH_BACKEND_SECTOR];
+    memset(erased, 0xFF, sizeof(erased));
+    for (uint32_t pos = 0; pos < len; pos += sizeof(erased)) {
+        file_write(offset + pos, erased, sizeof(erased));
+    }
+    flash.erases++;
+    flash.stalls += flash.receiving;
+    return 0;
+}
+
+static int flash_program(void *ctx, uint32_t offset, const uint8_t *data, uint32_t len) {
+    CHECK(offset % FLASH_BACKEND_PAGE == 0 && len % FLASH_BACKEND_PAGE == 0);
+    CHECK(offset + len <= FLASH_OTA_SIZE);
+    uint8_t page[FLASH_BACKEND_PAGE];
+    for (uint32_t pos = 0; pos < len; pos += sizeof(page)) {
+        file_read(offset + pos, page, sizeof(page));
+        for (size_t i = 0; i < sizeof(page); i++) {
+            CHECK(page[i] == 0xFF);
+            page[i] &= data[pos + i];
+        }
+        file_write(offset + pos, page, sizeof(page));
+    }
+    return 0;
+}
+
+static int flash_read(void *ctx, uint32_t offset, uint8_t *data, uint32_t len) {
+    CHECK(offset + len <= FLASH_OTA_SIZE);
+    file_read(offset, data, len);
+    return 0;
+}
+
+static int flash_install(void *ctx, uint32_t size) {
+    flash.installed = size;
+    return 0;
+}
+
+static const flash_backend_t file_backend = {
+    .size = FLASH_OTA_SIZE,
+    .erase = flash_erase,
+    .program = flash_program,
+    .read = flash_read,
+    .install = flash_install,
+    .ctx = NULL
+};
+
+static void store_le32(uint8_t *p, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+// Imagem aleatória com o início de um firmware do RP2040
+static uint8_t *make_image(size_t size) {
+    uint8_t *image = malloc(size);
+    CHECK(image != NULL && size >= 512);
+    for (size_t i = 0; i < size; i++) {
+        image[i] = (uint8_t)test_rand();
+    }
+    store_le32(image + 252, crc32_mpeg2(image, 252));
+    store_le32(image + 256, 0x20042000u);
+    store_le32(image + 260, 0x100001f7u);
+    return image;
+}
+
+static void format_request(char *request, size_t cap, size_t length, const uint8_t *image, size_t size) {
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    sha256_t sha;
+    sha256_init(&sha);
+    sha256_update(&sha, image, size);
+    sha256_final(&sha, digest);
+
+    int n = snprintf(request, cap, "POST /api/ota HTTP/1.1\r\nContent-Length: %zu\r\n" OTA_HASH_HEADER ": ",
+                     length);
+    for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
+        n += snprintf(request + n, cap - n, "%02x", digest[i]);
+    }
+    snprintf(request + n, cap - n, "\r\n\r\n");
+}
+
+typedef struct {
+    size_t send;                // Bytes do corpo enviados (menos que o tamanho = corpo incompleto)
+    int poll_every;             // Pedaços entre chamadas de ota_poll; 0 = nunca
+    int status;
+} upload_t;
+
+static uint32_t now_ms;
+
+/**
+ * Envia `image` como corpo de `request` e retorna o status da resposta.
+ * Com 200, confere o conteúdo do arquivo e a instalação pelo ota_poll.
+ */
+static int upload(const char *request, const uint8_t *image, size_t size, upload_t *up) {
+    http_body_handler_t handler;
+    http_response_t response;
+    init_http_response(&response);
+    if (ota_begin(request, &handler, &response) != BODY_ROUTE_ACCEPTED) {
+        up->status = response.status_code;
+        free_http_response(&response);
+        return up->status;
+    }
+
+    flash.erases = 0;
+    flash.stalls = 0;
+    flash.installed = 0;
+    int err = 0;
+    size_t pos = 0;
+    for (int chunk = 1; pos < up->send && err == 0; chunk++) {
+        size_t n = 1 + test_rand() % 1460;
+        if (n > up->send - pos) {
+            n = up->send - pos;
+        }
+        flash.receiving = true;
+        err = handler.on_data(handler.ctx, image + pos, n);
+        flash.receiving = false;
+        pos += n;
+        if (up->poll_every && chunk % up->poll_every == 0) {
+            ota_poll(now_ms++);
+        }
+    }
+    flash.receiving = true;
+    handler.on_end(handler.ctx, err, &response);
+    flash.receiving = false;
+    up->status = response.status_code;
+    CHECK(response.body_len > 0);
+
+    if (up->status == 200) {
+        CHECK(strstr(response.body, "\"reiniciando\":true") != NULL);
+        uint8_t *stored = malloc(size);
+        CHECK(stored != NULL);
+        file_read(0, stored, size);
+        CHECK(memcmp(stored, image, size) == 0);
+        free(stored);
+
+        // Instala só depois de OTA_INSTALL_DELAY_MS
+        ota_poll(now_ms);
+        ota_poll(now_ms + OTA_INSTALL_DELAY_MS - 1);
+        CHECK(flash.installed == 0);
+        ota_poll(now_ms + OTA_INSTALL_DELAY_MS);
+        CHECK(flash.installed == size);
+        now_ms += OTA_INSTALL_DELAY_MS;
+    }
+    free_http_response(&response);
+    return up->status;
+}
+
+static int upload_image(const uint8_t *image, size_t size, int poll_every) {
+    char request[256];
+    format_request(request, sizeof(request), size, image, size);
+    upload_t up = { .send = size, .poll_every = poll_every };
+    return upload(request, image, size, &up);
+}
+
+static void test_load(void) {
+    static const size_t sizes[] = { 512, 4096, 4097, 100000, FLASH_OTA_SIZE - 1, FLASH_OTA_SIZE };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        uint8_t *image = make_image(sizes[i]);
+
+        // Com ota_poll a cada pedaço, os apagamentos ficam à frente da gravação
+        CHECK(upload_image(image, sizes[i], 1) == 200);
+        CHECK(flash.stalls == 0);
+        CHECK(flash.erases == (int)((sizes[i] + FLASH_BACKEND_SECTOR - 1) / FLASH_BACKEND_SECTOR));
+
+        // Sem ota_poll, a recepção apaga na hora, mas o resultado é o mesmo
+        CHECK(upload_image(image, sizes[i], 0) == 200);
+        CHECK(flash.stalls == flash.erases);
+        free(image);
+    }
+}
+
+static void test_rejected_images(void) {
+    size_t size = 20000;
+    uint8_t *image = make_image(size);
+    char request[256];
+
+    // SHA-256 de outra imagem
+    uint8_t *other = make_image(size);
+    format_request(request, sizeof(request), size, other, size);
+    upload_t up = { .send = size, .poll_every = 3 };
+    CHECK(upload(request, image, size, &up) == 422 && flash.installed == 0);
+    free(other);
+
+    // SHA-256 certo, mas o CRC do boot2 não confere
+    image[10] ^= 1;
+    CHECK(upload_image(image, size, 3) == 422 && flash.installed == 0);
+    image[10] ^= 1;
+    CHECK(upload_image(image, size, 3) == 200);
+
+    // Pilha inicial fora da SRAM e reset fora da imagem ou sem o bit Thumb
+    static const uint32_t vectors[][2] = {
+        { 0xFFFFFFFFu, 0x100001f7u }, { 0x20000000u, 0x100001f7u }, { 0x20042002u, 0x100001f7u },
+        { 0x20042000u, 0x100001f6u }, { 0x20042000u, 0x10000001u }, { 0x20042000u, 0x10004e21u },
+    };
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+        store_le32(image + 256, vectors[i][0]);
+        store_le32(image + 260, vectors[i][1]);
+        CHECK(upload_image(image, size, 3) == 422);
+    }
+
+    // Menor que boot2 mais os dois vetores
+    CHECK(upload_image(image, 263, 1) == 422);
+
+    // Corpo incompleto
+    format_request(request, sizeof(request), size, image, size);
+    up = (upload_t){ .send = size - 1, .poll_every = 1 };
+    CHECK(upload(request, image, size, &up) == 400);
+
+    // Falha ao apagar: na recepção ou à frente, por ota_poll
+    flash.fail_erase = true;
+    CHECK(upload_image(image, size, 0) == 500);
+    CHECK(upload_image(image, size, 1) == 500);
+    flash.fail_erase = false;
+    free(image);
+}
+
+static void test_begin_errors(void) {
+    http_body_handler_t handler;
+    http_response_t response;
+    char request[256];
+    uint8_t *image = make_image(1000);
+
+    static const struct {
+        const char *request;
+        int status;
+    } cases[] = {
+        { "POST /api/ota HTTP/1.1\r\n" OTA_HASH_HEADER ": 00\r\n\r\n", 411 },
+        { "POST /api/ota HTTP/1.1\r\nContent-Length: 720897\r\n\r\n", 413 },
+        { "POST /api/ota HTTP/1.1\r\nContent-Length: 10\r\n\r\n", 400 },
+        { "POST /api/ota HTTP/1.1\r\nContent-Length: 10\r\n" OTA_HASH_HEADER ": 0123\r\n\r\n", 400 },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        init_http_response(&response);
+        CHECK(ota_begin(cases[i].request, &handler, &response) == BODY_ROUTE_REJECTED);
+        CHECK(response.status_code == cases[i].status);
+        free_http_response(&response);
+    }
+
+    // Uma atualização por vez; cancelar libera para a próxima
+    format_request(request, sizeof(request), 1000, image, 1000);
+    init_http_response(&response);
+    CHECK(ota_begin(request, &handler, &response) == BODY_ROUTE_ACCEPTED);
+    CHECK(handler.on_data(handler.ctx, image, 500) == 0);
+    http_body_handler_t second;
+    CHECK(ota_begin(request, &second, &response) == BODY_ROUTE_REJECTED && response.status_code == 503);
+    free_http_response(&response);
+    handler.on_abort(handler.ctx);
+    CHECK(upload_image(image, 1000, 1) == 200);
+
+    // Sem backend, a OTA fica desabilitada
+    ota_set_backend(NULL);
+    init_http_response(&response);
+    CHECK(ota_begin(request, &handler, &response) == BODY_ROUTE_REJECTED && response.status_code == 503);
+    free_http_response(&response);
+    ota_set_backend(&file_backend);
+    free(image);
+}
+
+int main(void) {
+    // Valor de referência do CRC-32/MPEG-2
+    CHECK(crc32_mpeg2((const uint8_t *)"123456789", 9) == 0x0376E6E7u);
+
+    flash.file = tmpfile();
+    CHECK(flash.file != NULL);
+    ota_set_backend(&file_backend);
+
+    test_load();
+    test_rejected_images();
+    test_begin_errors();
+
+    fclose(flash.file);
+    puts("test_ota: ok");
+    return 0;
+}
@@ -0,0 +1,198 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: test_romfs.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Testes da ROMFS sobre uma imagem mapeada com mmap, como a flash
+ *      pelo XIP. A imagem é gerada no build por `tools/mkromfs.py --gzip`
+ *      a partir de tests/romfs/, cujos nomes exercitam a ordem de memcmp
+ *      (maiúsculas, '.' antes de '/', bytes UTF-8 por último).
+ *
+ *      Cópias alteradas da imagem conferem os erros de montagem.
+ */
+#include "romfs.h"
+#include "test.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MIME_TEXT   5
+#define MIME_HTML   1
+#define MIME_FONT   12
+
+typedef struct {
+    const char *path;
+    uint8_t mime;
+} fixture_t;
+
+// Em ordem de memcmp, como o diretório da imagem
+static const fixture_t fixtures[] = {
+    { "Z.txt", MIME_TEXT },
+    { "css.txt", MIME_TEXT },
+    { "css/a.css", 2 },
+    { "css/b.css", 2 },
+    { "fonte.woff2", MIME_FONT },
+    { "img/logo.svg", 6 },
+    { "index.html", MIME_HTML },
+    { "ção.txt", MIME_TEXT },
+};
+
+#define FIXTURE_COUNT (sizeof(fixtures) / sizeof(fixtures[0]))
+
+static const uint8_t *map_image(const char *path, size_t *size) {
+    int fd = open(path, O_RDONLY);
+    CHECK(fd >= 0);
+    struct stat st;
+    CHECK(fstat(fd, &st) == 0);
+    void *image = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    CHECK(image != MAP_FAILED);
+    close(fd);
+    *size = (size_t)st.st_size;
+    return image;
+}
+
+static size_t read_source(const char *path, uint8_t *buf, size_t cap) {
+    char full[256];
+    snprintf(full, sizeof(full), "%s/%s", ROMFS_SOURCE_DIR, path);
+    FILE *f = fopen(full, "rb");
+    CHECK(f != NULL);
+    size_t len = fread(buf, 1, cap, f);
+    fclose(f);
+    return len;
+}
+
+static void test_lookup(const romfs_t *fs) {
+    CHECK(fs->count == FIXTURE_COUNT);
+    for (size_t i = 0; i < FIXTURE_COUNT; i++) {
+        const fixture_t *fx = &fixtures[i];
+        char slash[ROMFS_MAX_PATH + 2];
+        snprintf(slash, sizeof(slash), "/%s", fx->path);
+
+        romfs_file_t a, b;
+        CHECK(romfs_find(fs, fx->path, strlen(fx->path), &a));
+        CHECK(romfs_find(fs, slash, strlen(slash), &b));
+        CHECK(a.data == b.data && a.size == b.size);
+        CHECK(a.mime == fx->mime);
+        CHECK((uintptr_t)a.data % ROMFS_ALIGN == 0);
+        CHECK(a.data >= fs->base && a.data + a.size <= fs->base + fs->size);
+
+        // Guardado comprimido só quando o gzip fica menor que o original
+        uint8_t source[4096];
+        size_t len = read_source(fx->path, source, sizeof(source));
+        if (a.flags & ROMFS_FLAG_GZIP) {
+            CHECK(a.size < len && a.data[0] == 0x1f && a.data[1] == 0x8b);
+        } else {
+            CHECK(a.size == len && memcmp(a.data, source, len) == 0);
+        }
+    }
+
+    romfs_file_t file;
+    CHECK(romfs_find(fs, "/index.html", 11, &file) && (file.flags & ROMFS_FLAG_GZIP));
+    CHECK(romfs_find(fs, "/css.txt", 8, &file) && !(file.flags & ROMFS_FLAG_GZIP));
+    CHECK(romfs_find(fs, "/fonte.woff2", 12, &file) && !(file.flags & ROMFS_FLAG_GZIP));
+    CHECK(strcmp(romfs_mime_type(MIME_HTML), "text/html; charset=utf-8") == 0);
+    CHECK(strcmp(romfs_mime_type(200), "application/octet-stream") == 0);
+
+    // O caminho não precisa terminar em '\0': a busca usa só `path_len`
+    CHECK(romfs_find(fs, "/index.html?v=1", 11, &file));
+
+    static const char *missing[] = { "", "/", "css", "/css/", "index.htm", "index.html2", "z.txt",
+                                     "/css/c.css", "//index.html", "\xff" };
+    for (size_t i = 0; i < sizeof(missing) / sizeof(missing[0]); i++) {
+        CHECK(!romfs_find(fs, missing[i], strlen(missing[i]), &file));
+    }
+    char long_path[ROMFS_MAX_PATH + 2];
+    memset(long_path, 'a', sizeof(long_path));
+    CHECK(!romfs_find(fs, long_path, sizeof(long_path), &file));
+}
+
+// Monta uma cópia da imagem alterada por `mutate`; retorna o código de romfs_mount
+static int mount_modified(const uint8_t *image, size_t size, size_t mount_size,
+                          void (*mutate)(uint8_t *copy)) {
+    uint8_t *copy = malloc(size);
+    CHECK(copy != NULL);
+    memcpy(copy, image, size);
+    if (mutate) {
+        mutate(copy);
+    }
+    romfs_t fs;
+    romfs_file_t file;
+    int rc = romfs_mount(&fs, copy, mount_size);
+    if (rc != ROMFS_OK) {
+        CHECK(fs.count == 0 && !romfs_find(&fs, "/index.html", 11, &file));
+    }
+    free(copy);
+    return rc;
+}
+
+static romfs_entry_t *entries(uint8_t *image) {
+    return (romfs_entry_t *)(image + sizeof(romfs_header_t));
+}
+
+static void bad_magic(uint8_t *image) { image[0] = 'X'; }
+static void bad_version(uint8_t *image) { ((romfs_header_t *)image)->version = ROMFS_VERSION + 1; }
+static void huge_count(uint8_t *image) { ((romfs_header_t *)image)->count = 0xffff; }
+static void huge_image_size(uint8_t *image) { ((romfs_header_t *)image)->image_size += 4; }
+static void data_past_end(uint8_t *image) { entries(image)[2].data_size = 0x7fffffff; }
+static void data_offset_wraps(uint8_t *image) {
+    entries(image)[1].data_offset = 0xfffffff0;
+    entries(image)[1].data_size = 0x20;
+}
+static void name_past_end(uint8_t *image) { entries(image)[0].name_offset = 0xffffffff; }
+static void name_not_terminated(uint8_t *image) { entries(image)[3].name_len -= 1; }
+
+// Troca duas entradas vizinhas: a busca binária deixaria de achar arquivos
+static void swapped(uint8_t *image) {
+    romfs_entry_t tmp = entries(image)[4];
+    entries(image)[4] = entries(image)[5];
+    entries(image)[5] = tmp;
+}
+
+static void duplicated(uint8_t *image) { entries(image)[5] = entries(image)[4]; }
+
+static void test_mount_errors(const uint8_t *image, size_t size) {
+    CHECK(mount_modified(image, size, size, NULL) == ROMFS_OK);
+    CHECK(mount_modified(image, size, sizeof(romfs_header_t) - 1, NULL) == ROMFS_ERR_MAGIC);
+    CHECK(mount_modified(image, size, size - 1, NULL) == ROMFS_ERR_BOUNDS);
+    CHECK(mount_modified(image, size, size, bad_magic) == ROMFS_ERR_MAGIC);
+    CHECK(mount_modified(image, size, size, bad_version) == ROMFS_ERR_VERSION);
+    CHECK(mount_modified(image, size, size, huge_count) == ROMFS_ERR_BOUNDS);
+    CHECK(mount_modified(image, size, size, huge_image_size) == ROMFS_ERR_BOUNDS);
+    CHECK(mount_modified(image, size, size, data_past_end) == ROMFS_ERR_BOUNDS);
+    CHECK(mount_modified(image, size, size, data_offset_wraps) == ROMFS_ERR_BOUNDS);
+    CHECK(mount_modified(image, size, size, name_past_end) == ROMFS_ERR_BOUNDS);
+    CHECK(mount_modified(image, size, size, name_not_terminated) == ROMFS_ERR_BOUNDS);
+    CHECK(mount_modified(image, size, size, swapped) == ROMFS_ERR_ORDER);
+    CHECK(mount_modified(image, size, size, duplicated) == ROMFS_ERR_ORDER);
+
+    // Flash apagada (0xff), como antes da primeira gravação da imagem
+    uint8_t erased[4096];
+    memset(erased, 0xff, sizeof(erased));
+    romfs_t fs;
+    CHECK(romfs_mount(&fs, erased, sizeof(erased)) == ROMFS_ERR_MAGIC);
+}
+
+int main(void) {
+    size_t size;
+    const uint8_t *image = map_image(ROMFS_TEST_IMAGE, &size);
+
+    romfs_t fs;
+    CHECK(romfs_mount(&fs, image, size) == ROMFS_OK);
+    test_lookup(&fs);
+    test_mount_errors(image, size);
+
+    // A imagem de www/ gerada pelo build do firmware também monta
+    size_t www_size;
+    const uint8_t *www = map_image(ROMFS_WWW_IMAGE, &www_size);
+    romfs_file_t file;
+    CHECK(romfs_mount(&fs, www, www_size) == ROMFS_OK);
+    CHECK(romfs_find(&fs, "/robots.txt", 11, &file) && file.size > 0);
+
+    puts("test_romfs: ok");
+    return 0;
+}
@@ -0,0 +1,156 @@
+/**
+ * -----------------------------------------------
+ * Author: Mayron Martins da Silva
+ * Arquivo: test_single_flight.c
+ * Projeto: pico_access_point_with_routes
+ * -----------------------------------------------
+ *
+ * Descrição:
+ *      Testa a geração compartilhada (single_flight.c) com um gerador
+ *      maior que SINGLE_FLIGHT_MAX_SEGMENTS blocos: uma conexão sozinha
+ *      e duas em velocidades diferentes recebem o corpo inteiro, nunca
+ *      com mais segmentos guardados que o limite, e quem chega depois
+ *      que a geração se fechou começa outra.
+ *
+ *      As conexões são simuladas como em `pump_flight`: pedem o próximo
+ *      segmento pelo número e devolvem os enviados quando "recebem o ACK".
+ */
+#include "single_flight.h"
+#include "test.h"
+#include <string.h>
+
+#define BODY_SIZE (SINGLE_FLIGHT_MAX_SEGMENTS * HTTP_STREAM_BUFFER_SIZE * 3 + 100)
+
+static int fill_calls;
+
+// Bytes em sequência, em blocos cheios; o cursor guarda a posição
+static bool fill(http_stream_t *stream, void *ctx) {
+    fill_calls++;
+    size_t space;
+    char *dest = http_stream_reserve(stream, &space);
+    size_t n = BODY_SIZE - stream->cursor < space ? BODY_SIZE - stream->cursor : space;
+    for (size_t i = 0; i < n; i++) {
+        dest[i] = (char)('a' + (stream->cursor + i) % 26);
+    }
+    http_stream_commit(stream, n);
+    stream->cursor += n;
+    return stream->cursor == BODY_SIZE;
+}
+
+typedef struct {
+    flight_t *flight;
+    uint16_t sent;
+    uint16_t released;
+    char body[BODY_SIZE];
+    size_t len;
+} subscriber_t;
+
+// Envia até `max` segmentos; retorna quantos havia
+static int pump(subscriber_t *sub, int max) {
+    int count = 0;
+    const flight_segment_t *seg;
+    while (count < max && (seg = single_flight_next(sub->flight, sub->sent)) != NULL) {
+        CHECK(sub->len + seg->len <= BODY_SIZE);
+        memcpy(sub->body + sub->len, seg->data, seg->len);
+        sub->len += seg->len;
+        sub->sent++;
+        count++;
+    }
+    return count;
+}
+
+static void ack(subscriber_t *sub) {
+    single_flight_release(sub->flight, sub->released, sub->sent);
+    sub->released = sub->sent;
+}
+
+static void check_body(const subscriber_t *sub) {
+    CHECK(sub->len == BODY_SIZE);
+    for (size_t i = 0; i < BODY_SIZE; i++) {
+        CHECK(sub->body[i] == (char)('a' + i % 26));
+    }
+}
+
+static subscriber_t a, b, c;
+
+// Sozinha: a janela fecha a cada SINGLE_FLIGHT_MAX_SEGMENTS blocos e reabre no ACK
+static void test_alone(void) {
+    memset(&a, 0, sizeof(a));
+    a.flight = single_flight_join(1, fill, NULL, false);
+    CHECK(a.flight != NULL);
+    while (!single_flight_finished(a.flight) || pump(&a, 1) > 0) {
+        CHECK(pump(&a, 1000) <= SINGLE_FLIGHT_MAX_SEGMENTS);
+        ack(&a);
+    }
+    CHECK(!single_flight_failed(a.flight));
+    check_body(&a);
+    single_flight_leave(a.flight, a.released);
+}
+
+// Duas conexões: a adiantada espera a lenta devolver o segmento mais antigo
+static void test_slow_subscriber(void) {
+    memset(&a, 0, sizeof(a));
+    memset(&b, 0, sizeof(b));
+    memset(&c, 0, sizeof(c));
+    a.flight = single_flight_join(2, fill, NULL, false);
+    b.flight = single_flight_join(2, fill, NULL, false);
+    CHECK(a.flight == b.flight);
+
+    // A lenta ainda não recebeu nada: a adiantada para no limite
+    CHECK(pump(&a, 1000) == SINGLE_FLIGHT_MAX_SEGMENTS);
+    ack(&a);
+    CHECK(pump(&a, 1000) == 0);
+    CHECK(!single_flight_finished(a.flight));
+
+    // Fechada: quem chega agora começa outra geração, do início
+    c.flight = single_flight_join(2, fill, NULL, false);
+    CHECK(c.flight != NULL && c.flight != a.flight);
+    CHECK(pump(&c, 1) == 1);
+    CHECK(memcmp(c.body, "abcdef", 6) == 0);
+
+    // Cada segmento devolvido pela lenta abre vaga para um novo
+    while (b.len < BODY_SIZE) {
+        CHECK(pump(&b, 1) == 1);
+        ack(&b);
+        pump(&a, 1000);
+        ack(&a);
+        CHECK(a.sent - b.released <= SINGLE_FLIGHT_MAX_SEGMENTS);
+    }
+    CHECK(single_flight_finished(a.flight) && !single_flight_failed(a.flight));
+    check_body(&a);
+    check_body(&b);
+
+    single_flight_leave(a.flight, a.released);
+    single_flight_leave(b.flight, b.released);
+    single_flight_leave(c.flight, c.released);
+}
+
+// Uma conexão que sai sem devolver nada não prende a janela das outras
+static void test_leave_unreleased(void) {
+    memset(&a, 0, sizeof(a));
+    memset(&b, 0, sizeof(b));
+    a.flight = single_flight_join(3, fill, NULL, false);
+    b.flight = single_flight_join(3, fill, NULL, false);
+    CHECK(pump(&a, 1000) == SINGLE_FLIGHT_MAX_SEGMENTS);
+    ack(&a);
+    CHECK(pump(&b, 2) == 2);
+    single_flight_leave(b.flight, b.released);
+
+    while (!single_flight_finished(a.flight) || pump(&a, 1) > 0) {
+        pump(&a, 1000);
+        ack(&a);
+    }
+    check_body(&a);
+    single_flight_leave(a.flight, a.released);
+}
+
+int main(void) {
+    test_alone();
+    int alone_calls = fill_calls;
+    test_slow_subscriber();
+    test_leave_unreleased();
+    // Em janela, o gerador roda uma vez por bloco, sem repetir os que esperaram vaga
+    CHECK(alone_calls == (BODY_SIZE + HTTP_STREAM_BUFFER_SIZE - 1) / HTTP_STREAM_BUFFER_SIZE);
+    printf("single_flight: ok\n");
+    return 0;
+}
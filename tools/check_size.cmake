@@ -0,0 +1,14 @@
+# Fails the build when a firmware image does not fit its flash region.
+#
+#   cmake -DIMAGE=<file.bin> -DLIMIT=<bytes> -P check_size.cmake
+
+if(NOT EXISTS "${IMAGE}")
+    message(FATAL_ERROR "${IMAGE} not found")
+endif()
+
+file(SIZE "${IMAGE}" image_size)
+if(image_size GREATER LIMIT)
+    math(EXPR excess "${image_size} - ${LIMIT}")
+    message(FATAL_ERROR "${IMAGE} is ${image_size} bytes, ${excess} over the ${LIMIT}-byte flash region")
+endif()
+message(STATUS "${IMAGE}: ${image_size} of ${LIMIT} bytes")
@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""
+Compila os templates HTML de `pages/` em segmentos C.
+
+Cada arquivo vira um `template_t` (ver lib/template.h): o texto fixo
+fica em arrays `const` (mantidos na flash) e cada marcador
+`{{nome}}` / `{{nome:tipo}}` vira um slot tipado, preenchido em tempo
+de execução. Tipos aceitos: str (padrão, com escape HTML), raw, int, uint.
+
+Uso: compile_templates.py -o <dir_saida> pages/index.html [...]
+Gera <dir_saida>/templates.h e <dir_saida>/templates.c.
+"""
+import argparse
+import os
+import re
+import sys
+
+SLOT_RE = re.compile(r"\{\{\s*([A-Za-z_][A-Za-z0-9_]*)\s*(?::\s*([a-z]+)\s*)?\}\}")
+SLOT_TYPES = {
+    "str": "TEMPLATE_SLOT_STR",
+    "raw": "TEMPLATE_SLOT_RAW",
+    "int": "TEMPLATE_SLOT_INT",
+    "uint": "TEMPLATE_SLOT_UINT",
+}
+MAX_SLOTS = 8
+MAX_SEGMENT = 0xFFFF
+
+
+def c_identifier(path):
+    name = os.path.splitext(os.path.basename(path))[0]
+    return "TEMPLATE_" + re.sub(r"[^A-Za-z0-9]", "_", name).upper()
+
+
+def c_string(data):
+    """Quebra o texto em literais C, uma linha do HTML por linha do fonte."""
+    lines = []
+    for line in data.splitlines(keepends=True):
+        escaped = (line.replace("\\", "\\\\").replace("\"", "\\\"")
+                   .replace("\n", "\\n").replace("\r", "\\r").replace("\t", "\\t"))
+        # Evita trígrafos
+        escaped = escaped.replace("??", "?\\?")
+        lines.append("    \"%s\"" % escaped)
+    return "\n".join(lines) if lines else "    \"\""
+
+
+def parse(path):
+    with open(path, encoding="utf-8") as f:
+        text = f.read()
+
+    segments = []       # ("static", texto) ou ("slot", indice)
+    slots = []          # [(nome, tipo)]
+    pos = 0
+    for match in SLOT_RE.finditer(text):
+        if match.start() > pos:
+            segments.append(("static", text[pos:match.start()]))
+        name, slot_type = match.group(1), match.group(2) or "str"
+        if slot_type not in SLOT_TYPES:
+            sys.exit("%s: tipo de slot desconhecido '%s' em '%s'" % (path, slot_type, name))
+        known = [i for i, (n, _) in enumerate(slots) if n == name]
+        if known:
+            if slots[known[0]][1] != slot_type:
+                sys.exit("%s: slot '%s' usado com tipos diferentes" % (path, name))
+            index = known[0]
+        else:
+            index = len(slots)
+            slots.append((name, slot_type))
+        segments.append(("slot", index))
+        pos = match.end()
+    if pos < len(text):
+        segments.append(("static", text[pos:]))
+
+    if len(slots) > MAX_SLOTS:
+        sys.exit("%s: mais de %d slots" % (path, MAX_SLOTS))
+
+    # Segmentos estáticos são medidos em bytes UTF-8 e limitados a 64 KiB
+    result = []
+    for kind, value in segments:
+        if kind == "static":
+            data = value.encode("utf-8")
+            while data:
+                cut = min(len(data), MAX_SEGMENT)
+                while cut < len(data) and (data[cut] & 0xC0) == 0x80:
+                    cut -= 1  # Não separa um caractere UTF-8 no meio
+                result.append(("static", data[:cut]))
+                data = data[cut:]
+        else:
+            result.append((kind, value))
+    return result, slots
+
+
+def emit(templates, out_dir):
+    os.makedirs(out_dir, exist_ok=True)
+
+    header = [
+        "// Gerado por tools/compile_templates.py. Não edite.",
+        "#ifndef TEMPLATES_H",
+        "#define TEMPLATES_H",
+        "",
+        "#include \"template.h\"",
+        "",
+    ]
+    source = [
+        "// Gerado por tools/compile_templates.py. Não edite.",
+        "#include \"templates.h\"",
+        "",
+    ]
+
+    for path, (segments, slots) in templates:
+        ident = c_identifier(path)
+        header.append("// %s" % os.path.basename(path))
+        header.append("enum {")
+        for name, _ in slots:
+            header.append("    %s_%s," % (ident, name.upper()))
+        header.append("    %s_SLOT_COUNT" % ident)
+        header.append("};")
+        header.append("extern const template_t %s;" % ident)
+        header.append("")
+
+        entries = []
+        static_len = 0
+        for i, (kind, value) in enumerate(segments):
+            if kind == "static":
+                source.append("static const char %s_S%d[] =" % (ident, i))
+                source.append(c_string(value.decode("utf-8")) + ";")
+                source.append("")
+                entries.append("    { %s_S%d, %d, TEMPLATE_SEGMENT_STATIC, 0 }," % (ident, i, len(value)))
+                static_len += len(value)
+            else:
+                name, slot_type = slots[value]
+                entries.append("    { 0, 0, %s, %s_%s }," % (SLOT_TYPES[slot_type], ident, name.upper()))
+
+        source.append("static const template_segment_t %s_SEGMENTS[] = {" % ident)
+        source.extend(entries)
+        source.append("};")
+        source.append("")
+        if slots:
+            source.append("static const uint8_t %s_SLOT_TYPES[] = { %s };" %
+                          (ident, ", ".join(SLOT_TYPES[t] for _, t in slots)))
+        source.append("const template_t %s = {" % ident)
+        source.append("    .segments = %s_SEGMENTS," % ident)
+        source.append("    .segment_count = %d," % len(segments))
+        source.append("    .slot_count = %d," % len(slots))
+        source.append("    .slot_types = %s," % ("%s_SLOT_TYPES" % ident if slots else "0"))
+        source.append("    .static_len = %d" % static_len)
+        source.append("};")
+        source.append("")
+
+    header.append("#endif // TEMPLATES_H")
+    header.append("")
+
+    write_if_changed(os.path.join(out_dir, "templates.h"), "\n".join(header))
+    write_if_changed(os.path.join(out_dir, "templates.c"), "\n".join(source))
+
+
+def write_if_changed(path, content):
+    if os.path.exists(path):
+        with open(path, encoding="utf-8") as f:
+            if f.read() == content:
+                return
+    with open(path, "w", encoding="utf-8") as f:
+        f.write(content)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("-o", "--output", required=True, help="diretório de saída")
+    parser.add_argument("pages", nargs="+", help="templates HTML")
+    args = parser.parse_args()
+
+    templates = [(path, parse(path)) for path in sorted(args.pages)]
+    emit(templates, args.output)
+
+
+if __name__ == "__main__":
+    main()
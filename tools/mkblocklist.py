@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""
+Gera a imagem da lista de domínios bloqueados pelo DNS.
+
+A imagem (ver lib/blocklist.h) é gravada na região FLASH_BLOCKLIST_OFFSET
+da flash e lida no lugar pelo mapa XIP:
+
+    cabeçalho (24 bytes): "BLK1", versão u16, hashes u8, reservado u8,
+                          nomes u32, bits do filtro u32, baldes u32,
+                          tamanho total u32
+    filtro de Bloom       bits em palavras u32 (bit i: palavra i/32, bit i%32)
+    baldes                (baldes + 1) deslocamentos u32 dos nomes
+    nomes                 formato wire minúsculo, agrupados por balde
+
+As listas de entrada têm um domínio por linha; linhas no formato de
+arquivo hosts ("0.0.0.0 dominio"), "*." inicial e comentários (#) são
+aceitos. Bloquear um domínio bloqueia seus subdomínios, então nomes
+cobertos por outro da lista são descartados.
+
+Uso: mkblocklist.py -o blocklist.bin [--max-size N] lista.txt [...]
+Gravação: picotool load -o 0x10160000 blocklist.bin
+"""
+import argparse
+import math
+import os
+import struct
+import sys
+
+MAGIC = b"BLK1"
+VERSION = 1
+HEADER = struct.Struct("<4sHBBIIII")
+MAX_HASHES = 16
+NAME_MAX = 255
+
+
+def name_hash(wire):
+    h = 2166136261
+    for c in wire:
+        h = ((h ^ c) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def hash_range(h, n):
+    return (h * n) >> 32
+
+
+def bloom_positions(h, hash_count, bits):
+    step = ((h >> 17) | (h << 15) & 0xFFFFFFFF) | 1
+    g = h
+    for _ in range(hash_count):
+        yield hash_range(g, bits)
+        g = (g + step) & 0xFFFFFFFF
+
+
+def to_wire(name):
+    wire = bytearray()
+    for label in name.split("."):
+        if not 0 < len(label) <= 63:
+            return None
+        wire.append(len(label))
+        wire += label.encode("ascii")
+    wire.append(0)
+    return bytes(wire) if len(wire) <= NAME_MAX else None
+
+
+def read_names(paths):
+    names = set()
+    for path in paths:
+        with open(path, encoding="utf-8") as f:
+            for number, line in enumerate(f, 1):
+                fields = line.split("#", 1)[0].split()
+                if not fields:
+                    continue
+                name = fields[-1].lower().rstrip(".")
+                if name.startswith("*."):
+                    name = name[2:]
+                if name in ("localhost", "0.0.0.0") or not name.isascii():
+                    continue
+                if to_wire(name) is None:
+                    sys.exit("%s:%d: nome inválido: %s" % (path, number, name))
+                names.add(name)
+
+    # Subdomínios de um nome já bloqueado não precisam de entrada própria
+    def covered(name):
+        labels = name.split(".")
+        return any(".".join(labels[i:]) in names for i in range(1, len(labels)))
+
+    return sorted(name for name in names if not covered(name))
+
+
+def build(names, bits_per_entry, hash_count, bucket_size):
+    count = len(names)
+    bits = max(32, math.ceil(count * bits_per_entry / 32) * 32)
+    bucket_count = max(1, math.ceil(count / bucket_size))
+
+    bloom = [0] * (bits // 32)
+    buckets = [[] for _ in range(bucket_count)]
+    for name in names:
+        wire = to_wire(name)
+        h = name_hash(wire)
+        for bit in bloom_positions(h, hash_count, bits):
+            bloom[bit >> 5] |= 1 << (bit & 31)
+        buckets[hash_range(h, bucket_count)].append(wire)
+
+    names_offset = HEADER.size + bits // 8 + (bucket_count + 1) * 4
+    offsets = []
+    data = bytearray()
+    for bucket in buckets:
+        offsets.append(names_offset + len(data))
+        for wire in bucket:
+            data += wire
+    image_size = names_offset + len(data)
+    offsets.append(image_size)
+
+    image = bytearray(HEADER.pack(MAGIC, VERSION, hash_count, 0, count, bits, bucket_count, image_size))
+    image += struct.pack("<%dI" % len(bloom), *bloom)
+    image += struct.pack("<%dI" % len(offsets), *offsets)
+    image += data
+    return image
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("--bits-per-entry", type=float, default=10.0, help="bits do filtro por nome (padrão 10)")
+    parser.add_argument("--hashes", type=int, default=0, help="posições por nome (padrão: ótimo para os bits)")
+    parser.add_argument("--bucket-size", type=int, default=4, help="nomes por balde, em média (padrão 4)")
+    parser.add_argument("--max-size", type=int, default=0, help="tamanho da região na flash")
+    parser.add_argument("lists", nargs="+")
+    args = parser.parse_args()
+
+    hash_count = args.hashes or max(1, round(args.bits_per_entry * math.log(2)))
+    if not 1 <= hash_count <= MAX_HASHES:
+        sys.exit("--hashes deve estar entre 1 e %d" % MAX_HASHES)
+    if args.bits_per_entry <= 0 or args.bucket_size < 1:
+        sys.exit("--bits-per-entry e --bucket-size devem ser positivos")
+
+    names = read_names(args.lists)
+    image = build(names, args.bits_per_entry, hash_count, args.bucket_size)
+    if args.max_size and len(image) > args.max_size:
+        sys.exit("imagem com %d bytes não cabe na região de %d bytes" % (len(image), args.max_size))
+
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output, "wb") as f:
+        f.write(image)
+    per_entry = len(image) / len(names) if names else 0
+    print("blocklist: %d nomes, %d bytes (%.1f bytes/nome)" % (len(names), len(image), per_entry))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""
+Gera a imagem ROMFS com os arquivos estáticos servidos pelo HTTP.
+
+A imagem (ver lib/romfs.h) é gravada na região FLASH_ROMFS_OFFSET da
+flash e lida no lugar pelo mapa XIP:
+
+    cabeçalho (16 bytes): "RFS1", versão u16, quantidade u16,
+                          tamanho total u32, reservado u32
+    diretório (16 bytes por arquivo, ordenado pelo nome):
+                          nome_off u32, nome_len u16, mime u8, flags u8,
+                          dados_off u32, dados_len u32
+    nomes                 caminhos relativos sem '/' inicial, com '\\0'
+    dados                 cada arquivo alinhado a --align bytes
+
+Com --gzip, arquivos de texto são guardados comprimidos quando isso
+reduz o tamanho (flag ROMFS_FLAG_GZIP).
+
+Uso: mkromfs.py -o romfs.bin [--gzip] [--max-size N] www/
+Gravação: picotool load -o 0x101C0000 romfs.bin
+"""
+import argparse
+import gzip
+import os
+import struct
+import sys
+
+MAGIC = b"RFS1"
+VERSION = 1
+HEADER = struct.Struct("<4sHHII")
+ENTRY = struct.Struct("<IHBBII")
+FLAG_GZIP = 0x01
+MAX_PATH = 128
+
+# Mesma ordem de `mime_types` em src/romfs.c
+MIME_TYPES = [
+    ("application/octet-stream", ()),
+    ("text/html; charset=utf-8", (".html", ".htm")),
+    ("text/css", (".css",)),
+    ("application/javascript", (".js", ".mjs")),
+    ("application/json", (".json",)),
+    ("text/plain; charset=utf-8", (".txt",)),
+    ("image/svg+xml", (".svg",)),
+    ("image/png", (".png",)),
+    ("image/jpeg", (".jpg", ".jpeg")),
+    ("image/gif", (".gif",)),
+    ("image/webp", (".webp",)),
+    ("image/x-icon", (".ico",)),
+    ("font/woff2", (".woff2",)),
+]
+COMPRESSIBLE = {1, 2, 3, 4, 5, 6}
+
+
+def mime_index(path):
+    ext = os.path.splitext(path)[1].lower()
+    for index, (_, extensions) in enumerate(MIME_TYPES):
+        if ext in extensions:
+            return index
+    return 0
+
+
+def collect(root):
+    files = []
+    for directory, _, names in os.walk(root):
+        for name in names:
+            full = os.path.join(directory, name)
+            rel = os.path.relpath(full, root).replace(os.sep, "/")
+            if len(rel.encode("utf-8")) > MAX_PATH:
+                sys.exit("%s: caminho maior que %d bytes" % (rel, MAX_PATH))
+            files.append((rel.encode("utf-8"), full))
+    # Mesma ordem de memcmp usada na busca binária do firmware
+    files.sort(key=lambda item: item[0])
+    return files
+
+
+def align(value, alignment):
+    return (value + alignment - 1) // alignment * alignment
+
+
+def build(root, alignment, use_gzip):
+    files = collect(root)
+    if len(files) > 0xFFFF:
+        sys.exit("arquivos demais: %d" % len(files))
+
+    names = bytearray()
+    name_offsets = []
+    names_start = HEADER.size + ENTRY.size * len(files)
+    for name, _ in files:
+        name_offsets.append(names_start + len(names))
+        names += name + b"\0"
+
+    data = bytearray()
+    data_start = align(names_start + len(names), alignment)
+    entries = []
+    for (name, full), name_offset in zip(files, name_offsets):
+        with open(full, "rb") as f:
+            content = f.read()
+        mime = mime_index(full)
+        flags = 0
+        if use_gzip and mime in COMPRESSIBLE:
+            packed = gzip.compress(content, compresslevel=9, mtime=0)
+            if len(packed) < len(content):
+                content, flags = packed, FLAG_GZIP
+
+        data += b"\0" * (align(len(data), alignment) - len(data))
+        entries.append(ENTRY.pack(name_offset, len(name), mime, flags, data_start + len(data), len(content)))
+        data += content
+
+    image_size = data_start + len(data)
+    image = bytearray(HEADER.pack(MAGIC, VERSION, len(files), image_size, 0))
+    for entry in entries:
+        image += entry
+    image += names
+    image += b"\0" * (data_start - len(image))
+    image += data
+    return image, len(files)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("--align", type=int, default=4, help="alinhamento dos dados (padrão 4)")
+    parser.add_argument("--gzip", action="store_true", help="comprime arquivos de texto")
+    parser.add_argument("--max-size", type=int, default=0, help="tamanho da região na flash")
+    parser.add_argument("root")
+    args = parser.parse_args()
+
+    if args.align < 4 or args.align & (args.align - 1):
+        sys.exit("--align deve ser potência de 2 e >= 4")
+
+    image, count = build(args.root, args.align, args.gzip)
+    if args.max_size and len(image) > args.max_size:
+        sys.exit("imagem com %d bytes não cabe na região de %d bytes" % (len(image), args.max_size))
+
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output, "wb") as f:
+        f.write(image)
+    print("romfs: %d arquivos, %d bytes" % (count, len(image)))
+
+
+if __name__ == "__main__":
+    main()